@@ -12,10 +12,17 @@
 #include "constraints/OffsetConstraint.h"
 #include "constraints/ClauseConstraint.h"
 #include "constraints/TableConstraint.h"
+#include "constraints/MDDConstraint.h"
+#include "constraints/RegularConstraint.h"
 #include "constraints/CardinalityConstraint.h"
 #include "constraints/DisjunctionConstraint.h"
 #include "constraints/IffConstraint.h"
 #include "constraints/SumConstraint.h"
+#include "constraints/LinearConstraint.h"
+#include "constraints/DifferenceConstraint.h"
+#include "constraints/ElementConstraint.h"
+#include "constraints/WindowCardinalityConstraint.h"
+#include "constraints/ConnectedConstraint.h"
 #include "SignedClause.h"
 #include "variable/BooleanVariablePropagator.h"
 #include "variable/GenericVariablePropagator.h"
@@ -44,8 +51,6 @@ static constexpr bool GRAPH_LEARNING_ENABLED = true;
 // Whether we should test that graph promotions are valid. Happens after solve is complete (SAT or UNSAT).
 // Can be used even if GRAPH_LEARNING_ENABLED = false, to verify that graph constraints *would've* been (in)correct
 static constexpr bool TEST_GRAPH_PROMOTIONS = true;
-// How many constraints promoted from a graph constraint should be queued before we restart solving and initialize them.
-static constexpr int NUM_PENDING_PROMOTIONS_BEFORE_RESTART = 500;
 
 // Whether we attempt to simplify clause constraints prior to solving.
 static constexpr bool SIMPLIFY_CONSTRAINTS = true;
@@ -63,13 +68,6 @@ static constexpr bool LOG_GRAPH_PROMOTIONS = false;
 // Log the set of variables that remain unsolved after initialization
 static constexpr bool LOG_INITIAL_UNSOLVED_VARIABLES = false;
 
-// The literal block distance (LBD) for learned constraints where we put them in the permanent constraint pool.
-// Permanent constraints will remain forever.
-static constexpr int MAX_PERMANENT_CONSTRAINT_LBD = 5;
-// The size of the temporary constraint pool, as a function of the number of initial constraints.
-static constexpr float MAX_LEARNED_CONSTRAINTS_SCALAR = 2.f;
-// The percent (0.0-1.0) of temporary learned constraints we should purge whenever the pool becomes too large.
-static constexpr float CONSTRAINT_PURGE_PERCENT = 0.5f;
 // How much to decay activity of constraints each time we backtrack.
 static constexpr float CONSTRAINT_ACTIVITY_DECAY = 1.0f / 0.95f;
 // Maximum value for constraint activities. If this value is reached, all constraint activities are rescaled by MAX_CONFLICT_ACTIVITY_RESCALE.
@@ -87,17 +85,15 @@ static constexpr bool USE_SPECIAL_VARIABLE_PROPAGATORS = true;
 // it will potentially take more time to find due to exploring very different search spaces.
 static constexpr bool RESET_VARIABLE_MEMOS_ON_SOLUTION = true;
 
-// The base heuristic used for deciding which variable/value to pick next.
-using DEFAULT_BASE_HEURISTIC = CoarseLRBHeuristic;
-
 const VarID VarID::INVALID = VarID();
 const GraphConstraintID GraphConstraintID::INVALID = GraphConstraintID();
 
 ConstraintSolver* ConstraintSolver::s_currentSolver = nullptr;
 
-ConstraintSolver::ConstraintSolver(const wstring& name, int seed, const shared_ptr<ISolverDecisionHeuristic>& baseHeuristic)
+ConstraintSolver::ConstraintSolver(const wstring& name, int seed, const shared_ptr<ISolverDecisionHeuristic>& baseHeuristic, const SolverConfig& config)
 	: m_variableDB(this)
-	, m_restartPolicy(*this)
+	, m_phaseManager(*this)
+	, m_config(config)
 	, m_decisionLogFrequency(DECISION_LOG_FREQUENCY)
 	, m_initialSeed(seed == 0 ? TimeUtils::getCycles() : seed)
 	, m_random(m_initialSeed)
@@ -105,13 +101,33 @@ ConstraintSolver::ConstraintSolver(const wstring& name, int seed, const shared_p
 	, m_stats(*this)
 	, m_name(name)
 {
+	if (m_config.enableModeSwitching)
+	{
+		// Always start in focused mode
+		m_restartPolicy = createRestartPolicy(m_config.focusedRestartPolicy);
+		m_inactiveRestartPolicy = createRestartPolicy(m_config.stableRestartPolicy);
+		m_modeLength = float(m_config.modeSwitchInitialConflicts);
+	}
+	else
+	{
+		m_restartPolicy = createRestartPolicy(m_config.restartPolicy);
+	}
+
 	if (baseHeuristic.get() != nullptr)
 	{
 		m_heuristicStack.push_back(baseHeuristic);
 	}
+	else if (m_config.enableModeSwitching)
+	{
+		m_modeSwitchingHeuristic = make_shared<ModeSwitchingHeuristic>(
+			createHeuristic(m_config.focusedHeuristic),
+			createHeuristic(m_config.stableHeuristic)
+		);
+		m_heuristicStack.push_back(m_modeSwitchingHeuristic);
+	}
 	else
 	{
-		m_heuristicStack.push_back(make_shared<DEFAULT_BASE_HEURISTIC>(*this));
+		m_heuristicStack.push_back(createHeuristic(m_config.heuristic));
 	}
 
 	// Dummy variable at index 0
@@ -119,6 +135,7 @@ ConstraintSolver::ConstraintSolver(const wstring& name, int seed, const shared_p
 	m_variableToDecisionLevel.push_back(0);
 	m_variablePropagators.push_back(nullptr);
 	m_variableToGraphs.push_back({});
+	m_variableToVertex.push_back(-1);
 
 	// Literals that are always true/false
 	m_trueLiteral = Literal(makeBoolean(TEXT("TRUE")), SolverVariableDomain(0,1).getBitsetForValue(1));
@@ -180,6 +197,7 @@ VarID ConstraintSolver::makeVariable(const wstring& varName, const SolverVariabl
 
 	vxy_assert(m_variableToGraphs.size() == varId.raw());
 	m_variableToGraphs.push_back({});
+	m_variableToVertex.push_back(-1);
 
 	return varId;
 }
@@ -208,18 +226,24 @@ shared_ptr<TTopologyVertexData<VarID>> ConstraintSolver::makeVariableGraph(const
 void ConstraintSolver::fillVariableGraph(const shared_ptr<TTopologyVertexData<VarID>>& data, const SolverVariableDomain& variableDomain, const wstring& namePrefix)
 {
 	shared_ptr<ITopology> graph = data->getSource();
+
+	int graphID = indexOf(m_graphs.begin(), m_graphs.end(), graph);
+	if (graphID < 0)
+	{
+		graphID = m_graphs.size();
+		m_graphs.push_back(graph);
+		m_variableGraphs.push_back({});
+	}
+	m_variableGraphs[graphID].push_back(data);
+
 	for (int i = 0; i < graph->getNumVertices(); ++i)
 	{
 		wstring varName = namePrefix + graph->vertexIndexToString(i);
 		VarID varID = makeVariable(varName, variableDomain);
 		data->set(i, varID);
 
-		m_variableToGraphs[varID.raw()].push_back(m_graphs.size());
-	}
-
-	if (!contains(m_graphs.begin(), m_graphs.end(), data->getSource()))
-	{
-		m_graphs.push_back(data->getSource());
+		m_variableToGraphs[varID.raw()].push_back(graphID);
+		m_variableToVertex[varID.raw()] = i;
 	}
 }
 
@@ -236,12 +260,30 @@ void ConstraintSolver::setInitialValues(VarID varID, const vector<int>& potentia
 	m_variableDB.setInitialValue(varID, values);
 }
 
+void ConstraintSolver::setValueWeights(VarID varID, const shared_ptr<const vector<float>>& weights)
+{
+	vxy_assert(!m_initialArcConsistencyEstablished);
+	vxy_assert_msg(weights->size() >= m_variableDomains[varID.raw()].getDomainSize(), "Not enough weights for variable %s", getVariableName(varID).c_str());
+	m_valueSampler.setWeights(varID, weights);
+}
+
+void ConstraintSolver::setValueWeights(const shared_ptr<TTopologyVertexData<VarID>>& graphData, const shared_ptr<const vector<float>>& weights)
+{
+	for (VarID varID : graphData->getData())
+	{
+		if (varID.isValid())
+		{
+			setValueWeights(varID, weights);
+		}
+	}
+}
+
 IConstraint* ConstraintSolver::registerConstraint(IConstraint* constraint)
 {
 	m_constraints.push_back(unique_ptr<IConstraint>(move(constraint)));
 	m_constraintIsChild.push_back(false);
 	
-	if (constraint->needsBacktracking())
+	if (constraint->needsBacktracking() && static_cast<IBacktrackingSolverConstraint*>(constraint)->wantsEveryBacktrack())
 	{
 		m_backtrackingConstraints.push_back(static_cast<IBacktrackingSolverConstraint*>(constraint));
 	}
@@ -272,16 +314,36 @@ AllDifferentConstraint* ConstraintSolver::allDifferent(const vector<VarID>& vari
 	return makeConstraint<AllDifferentConstraint>(variables, useWeakPropagation);
 }
 
+AllDifferentConstraint* ConstraintSolver::allDifferent(const vector<VarID>& variables, EAllDifferentPropagation propagation)
+{
+	return makeConstraint<AllDifferentConstraint>(variables, propagation);
+}
+
 CardinalityConstraint* ConstraintSolver::cardinality(const vector<VarID>& variables, const hash_map<int, tuple<int, int>>& cardinalitiesForValues)
 {
 	return makeConstraint<CardinalityConstraint>(variables, cardinalitiesForValues);
 }
 
+WindowCardinalityConstraint* ConstraintSolver::windowCardinality(const shared_ptr<PlanarGridTopology>& grid, const shared_ptr<TTopologyVertexData<VarID>>& cellVariables, const vector<int>& countedValues, EWindowShape shape, int size, int minCount, int maxCount)
+{
+	return makeConstraint<WindowCardinalityConstraint>(grid, cellVariables, countedValues, shape, size, minCount, maxCount);
+}
+
 TableConstraint* ConstraintSolver::table(const TableConstraintDataPtr& data, const vector<VarID>& variables)
 {
 	return makeConstraint<TableConstraint>(data, variables);
 }
 
+MDDConstraint* ConstraintSolver::mdd(const MDDConstraintDataPtr& data, const vector<VarID>& variables)
+{
+	return makeConstraint<MDDConstraint>(data, variables);
+}
+
+RegularConstraint* ConstraintSolver::regular(const RegularConstraintDataPtr& automaton, const vector<VarID>& variables)
+{
+	return makeConstraint<RegularConstraint>(automaton, variables);
+}
+
 ClauseConstraint* ConstraintSolver::clause(const vector<SignedClause>& clauses)
 {
 	return makeConstraint<ClauseConstraint>(clauses);
@@ -321,6 +383,16 @@ SumConstraint* ConstraintSolver::sum(const VarID sum, const vector<VarID>& vars)
 	return makeConstraint<SumConstraint>(sum, var1, var2);
 }
 
+LinearConstraint* ConstraintSolver::linear(const vector<VarID>& vars, const vector<int>& coefficients, EConstraintOperator op, int rhs)
+{
+	return makeConstraint<LinearConstraint>(vars, coefficients, op, rhs);
+}
+
+LinearConstraint* ConstraintSolver::linear(const vector<VarID>& vars, const vector<int>& coefficients, int lowerBound, int upperBound)
+{
+	return makeConstraint<LinearConstraint>(vars, coefficients, lowerBound, upperBound);
+}
+
 IffConstraint* ConstraintSolver::iff(const SignedClause& head, const vector<SignedClause>& body)
 {
 	if (REPLACE_IFF_WITH_CLAUSES)
@@ -361,11 +433,36 @@ InequalityConstraint* ConstraintSolver::inequality(VarID leftHandSide, EConstrai
 	return makeConstraint<InequalityConstraint>(leftHandSide, op, rightHandSide);
 }
 
+ElementConstraint* ConstraintSolver::element(VarID result, VarID index, const vector<VarID>& array)
+{
+	return makeConstraint<ElementConstraint>(result, index, array);
+}
+
+ElementConstraint* ConstraintSolver::element(VarID result, VarID index, const vector<int>& constants)
+{
+	return makeConstraint<ElementConstraint>(result, index, constants);
+}
+
+DifferenceConstraint* ConstraintSolver::difference(const vector<DifferenceEdge>& edges)
+{
+	return makeConstraint<DifferenceConstraint>(edges);
+}
+
+ConnectedConstraint* ConstraintSolver::connected(const shared_ptr<TTopologyVertexData<VarID>>& vertexData, const vector<int>& connectedValues)
+{
+	return makeConstraint<ConnectedConstraint>(vertexData, connectedValues);
+}
+
 DisjunctionConstraint* ConstraintSolver::disjunction(IConstraint* consA, IConstraint* consB)
 {
 	return makeConstraint<DisjunctionConstraint>(consA, consB);
 }
 
+DisjunctionConstraint* ConstraintSolver::disjunction(const vector<IConstraint*>& constraints)
+{
+	return makeConstraint<DisjunctionConstraint>(constraints);
+}
+
 vector<VarID> ConstraintSolver::unifyVariableDomains(const vector<VarID>& variables, int* outNewMinDomain)
 {
 	// Unify all input variables so that their first index in ValueSet all align.
@@ -901,10 +998,32 @@ EConstraintSolverResult ConstraintSolver::startSolving()
 		m_numUserConstraints = m_stats.numInitialConstraints;
 		m_initialArcConsistencyEstablished = false;
 
+		m_phaseManager.initialize();
+		m_immediateNotifyHeuristics.clear();
+		m_batchedNotifyHeuristics.clear();
+		m_conflictActivityHeuristics.clear();
 		for (int i = m_heuristicStack.size() - 1; i >= 0; --i)
 		{
-			m_heuristicStack[i]->initialize();
+			auto heuristic = m_heuristicStack[i].get();
+			heuristic->initialize();
+
+			if (heuristic->wantsVariableNotifications())
+			{
+				if (heuristic->wantsBatchedNotifications())
+				{
+					m_batchedNotifyHeuristics.push_back(heuristic);
+				}
+				else
+				{
+					m_immediateNotifyHeuristics.push_back(heuristic);
+				}
+			}
+			if (heuristic->wantsConflictActivity())
+			{
+				m_conflictActivityHeuristics.push_back(heuristic);
+			}
 		}
+		m_lastBatchedNotifyTime = m_variableDB.getTimestamp();
 		m_heuristicsInitialized = true;
 
 		for (int i = 0; i < m_constraints.size(); ++i)
@@ -960,7 +1079,10 @@ EConstraintSolverResult ConstraintSolver::startSolving()
 			}
 		}
 
+		// The assignment stack is reset after initial arc consistency, so make sure everything is flushed first.
+		flushHeuristicNotifications();
 		m_variableDB.onInitialArcConsistency();
+		m_lastBatchedNotifyTime = m_variableDB.getTimestamp();
 
 		m_initialArcConsistencyEstablished = true;
 		m_currentStatus = EConstraintSolverResult::Unsolved;
@@ -994,6 +1116,7 @@ EConstraintSolverResult ConstraintSolver::startSolving()
 		if constexpr (RESET_VARIABLE_MEMOS_ON_SOLUTION)
 		{
 			m_variableDB.clearLastSolvedValues();
+			m_phaseManager.reset();
 		}
 
 		auto solutionCons = makeConstraint<ClauseConstraint>(currentSolutionLits);
@@ -1105,19 +1228,20 @@ EConstraintSolverResult ConstraintSolver::step()
 			m_currentStatus = EConstraintSolverResult::Unsatisfiable;
 			return EConstraintSolverResult::Unsatisfiable;
 		}
-		else if (backtrackLevel == 0)
-		{
-			m_restartPolicy.onRestarted();
-			for (auto& heuristic : m_heuristicStack)
-			{
-				heuristic->onRestarted();
-			}
-			m_newDescentAfterRestart = true;
-		}
+
+		// Record target/best phases from the part of the trail that didn't lead to this conflict.
+		m_phaseManager.onConflict(getTimestampForDecisionLevel(getCurrentDecisionLevel()));
 
 		// Jump back to the relevant decision level.
 		backtrackUntilDecision(backtrackLevel);
 
+		// Going back to the first decision level counts as a restart. This must happen after backtracking, so that
+		// phase saving doesn't overwrite any rephasing.
+		if (backtrackLevel == 0)
+		{
+			onRestarted();
+		}
+
 		//VERTEXY_LOG("Learned constraint %d: %s", learnedConstraint->getID(), clauseConstraintToString(*learnedConstraint).c_str());
 		vxy_assert(learnedConstraint->getNumLiterals() > 0);
 		if (learnedConstraint->getNumLiterals() == 1)
@@ -1146,20 +1270,20 @@ EConstraintSolverResult ConstraintSolver::step()
 		// Check if we should restart now
 		if (getCurrentDecisionLevel() > 0 && shouldRestart())
 		{
-			backtrackUntilDecision(0, true);
-
-			m_restartPolicy.onRestarted();
-			for (auto& heuristic : m_heuristicStack)
+			const SolverDecisionLevel restartLevel = getRestartLevel();
+			if (restartLevel < getCurrentDecisionLevel())
 			{
-				heuristic->onRestarted();
+				backtrackUntilDecision(restartLevel, true);
 			}
-			m_newDescentAfterRestart = true;
+
+			onRestarted();
 			++m_stats.numRestarts;
+			m_stats.numReusedTrailLevels += restartLevel;
 		}
 		else
 		{
 			// Get rid of old learned constraints if database has grown too large
-			if (getCurrentDecisionLevel() > 0 && m_temporaryLearnedConstraints.size() >= size_t(float(m_numUserConstraints)*MAX_LEARNED_CONSTRAINTS_SCALAR))
+			if (getCurrentDecisionLevel() > 0 && m_temporaryLearnedConstraints.size() >= size_t(float(m_numUserConstraints)*m_config.maxLearnedConstraintsScalar))
 			{
 				purgeConstraints();
 				++m_stats.numConstraintPurges;
@@ -1218,22 +1342,51 @@ EConstraintSolverResult ConstraintSolver::step()
 
 bool ConstraintSolver::propagate()
 {
-	if (!propagateVariables())
-	{
-		return false;
-	}
+	bool success = propagateVariables();
 
 	// Check for unfounded sets in rules: heads that do not have any non-cyclical supports.
-	if (m_unfoundedSetAnalyzer != nullptr)
+	if (success && m_unfoundedSetAnalyzer != nullptr)
 	{
 		// Note that this will call propagateVariables (multiple times) if it finds any unfounded sets
-		if (!m_unfoundedSetAnalyzer->analyze())
-		{
-			return false;
-		}
+		success = m_unfoundedSetAnalyzer->analyze();
 	}
 
-	return true;
+	// Let batched heuristics know about everything that changed, before conflict analysis or the next decision.
+	flushHeuristicNotifications();
+	return success;
+}
+
+void ConstraintSolver::flushHeuristicNotifications()
+{
+	const SolverTimestamp latest = m_variableDB.getTimestamp();
+	if (!m_heuristicsInitialized || latest <= m_lastBatchedNotifyTime)
+	{
+		return;
+	}
+
+	for (auto heuristic : m_batchedNotifyHeuristics)
+	{
+		heuristic->onVariablesAssigned(m_variableDB, m_lastBatchedNotifyTime + 1, latest);
+	}
+	m_lastBatchedNotifyTime = latest;
+}
+
+void ConstraintSolver::notifyHeuristicsOfBacktrack(SolverTimestamp timestamp)
+{
+	m_phaseManager.onBacktrack(timestamp);
+
+	// Everything after the timestamp is un-done. Entries after the last flush were never reported, so don't need
+	// to be un-reported either.
+	if (!m_heuristicsInitialized || timestamp >= m_lastBatchedNotifyTime)
+	{
+		return;
+	}
+
+	for (auto heuristic : m_batchedNotifyHeuristics)
+	{
+		heuristic->onVariablesUnassigned(m_variableDB, timestamp + 1, m_lastBatchedNotifyTime);
+	}
+	m_lastBatchedNotifyTime = timestamp;
 }
 
 bool ConstraintSolver::propagateVariables()
@@ -1264,8 +1417,9 @@ bool ConstraintSolver::emptyVariableQueue()
 		QueuedVariablePropagation item = m_variablePropagationQueue.back();
 		m_variablePropagationQueue.pop_back();
 
-		vxy_assert(m_variableQueuedSet[item.variable.raw()]);
-		m_variableQueuedSet[item.variable.raw()] = false;
+		// The queued set is pushed/popped in lockstep with the queue, so the last element is always this item.
+		vxy_assert(m_variableQueuedSet.back() == item.variable.raw());
+		m_variableQueuedSet.pop();
 
 		vxy_assert(stack[item.timestamp].variable == item.variable);
 
@@ -1289,8 +1443,9 @@ bool ConstraintSolver::emptyConstraintQueue()
 		int constraintID = m_constraintPropagationQueue.front();
 		m_constraintPropagationQueue.pop_front();
 
-		vxy_assert(m_constraintQueuedSet[constraintID]);
-		m_constraintQueuedSet[constraintID] = false;
+		// Constraints are pushed/popped from the front of the queue, so the most recently added is always first.
+		vxy_assert(m_constraintQueuedSet.back() == constraintID);
+		m_constraintQueuedSet.pop();
 
 		IConstraint* constraint = m_constraints[constraintID].get();
 
@@ -1312,6 +1467,8 @@ void ConstraintSolver::startNextDecision()
 
 bool ConstraintSolver::getNextDecisionLiteral(VarID& variable, ValueSet& value)
 {
+	flushHeuristicNotifications();
+
 	// Check if any strategies want to make a decision
 	for (int i = m_heuristicStack.size() - 1; i >= 0; --i)
 	{
@@ -1325,14 +1482,44 @@ bool ConstraintSolver::getNextDecisionLiteral(VarID& variable, ValueSet& value)
 	return false;
 }
 
+bool ConstraintSolver::probeDecision(VarID varID, int value, int& outNumModifications)
+{
+	// Only valid after startNextDecision, before the decision is made.
+	const SolverDecisionLevel level = getCurrentDecisionLevel();
+	vxy_assert(level > 0);
+	vxy_assert(!m_decisionLevels.back().variable.isValid());
+	vxy_assert(m_decisionLevels.back().modificationIndex == m_variableDB.getTimestamp());
+	vxy_assert(m_variablePropagationQueue.empty() && m_constraintPropagationQueue.empty());
+
+	const SolverTimestamp startTime = m_variableDB.getTimestamp();
+	m_variableDB.makeDecision(varID, value);
+	const bool success = propagate();
+	outNumModifications = m_variableDB.getTimestamp() - startTime;
+
+	// Undo everything done on this level, then open it again. Backtracking grows the constraint activity increment,
+	// which shouldn't happen for a probe.
+	const float prevConflictIncr = m_constraintConflictIncr;
+	backtrackUntilDecision(level - 1, true);
+	m_constraintConflictIncr = prevConflictIncr;
+	startNextDecision();
+
+	return success;
+}
+
 bool ConstraintSolver::shouldRestart()
 {
-	if (m_restartPolicy.shouldRestart())
+	if (m_restartPolicy->shouldRestart())
+	{
+		return true;
+	}
+
+	if (m_pendingPromotedConstraints.size() >= size_t(m_config.numPendingPromotionsBeforeRestart))
 	{
 		return true;
 	}
 
-	if (m_pendingPromotedConstraints.size() >= NUM_PENDING_PROMOTIONS_BEFORE_RESTART)
+	// Mode switches happen on restart, so force one if we're due (the current mode may never restart otherwise).
+	if (isModeSwitchDue())
 	{
 		return true;
 	}
@@ -1340,6 +1527,114 @@ bool ConstraintSolver::shouldRestart()
 	return false;
 }
 
+SolverDecisionLevel ConstraintSolver::getRestartLevel()
+{
+	// Queued graph promotions are only registered at the root, and mode switches change the heuristic.
+	if (!m_config.enableTrailReuse ||
+		m_heuristicStack.size() != 1 ||
+		m_pendingPromotedConstraints.size() >= size_t(m_config.numPendingPromotionsBeforeRestart) ||
+		isModeSwitchDue())
+	{
+		return 0;
+	}
+
+	ISolverDecisionHeuristic* heuristic = m_heuristicStack[0].get();
+	double nextPriority;
+	if (!heuristic->getNextDecisionPriority(nextPriority))
+	{
+		return 0;
+	}
+
+	// Keep each decision that would be picked ahead of the best unassigned variable.
+	SolverDecisionLevel level = 0;
+	while (level < getCurrentDecisionLevel())
+	{
+		const VarID decisionVar = m_decisionLevels[level].variable;
+		if (!decisionVar.isValid())
+		{
+			break;
+		}
+
+		const int value = m_variableDB.getPotentialValues(decisionVar).indexOf(true);
+		if (heuristic->getPriority(decisionVar, value) <= nextPriority)
+		{
+			break;
+		}
+		++level;
+	}
+	return level;
+}
+
+void ConstraintSolver::onRestarted()
+{
+	if (isModeSwitchDue())
+	{
+		switchMode();
+	}
+
+	m_restartPolicy->onRestarted();
+	m_phaseManager.onRestarted();
+	for (auto& heuristic : m_heuristicStack)
+	{
+		heuristic->onRestarted();
+	}
+	m_newDescentAfterRestart = true;
+}
+
+bool ConstraintSolver::isModeSwitchDue() const
+{
+	return m_config.enableModeSwitching && float(m_conflictsInMode) >= m_modeLength;
+}
+
+void ConstraintSolver::switchMode()
+{
+	vxy_assert(m_config.enableModeSwitching);
+
+	m_stableMode = !m_stableMode;
+	swap(m_restartPolicy, m_inactiveRestartPolicy);
+	if (m_modeSwitchingHeuristic != nullptr)
+	{
+		m_modeSwitchingHeuristic->setStableMode(m_stableMode);
+	}
+
+	m_conflictsInMode = 0;
+	m_modeLength *= m_config.modeSwitchGrowth;
+}
+
+unique_ptr<IRestartPolicy> ConstraintSolver::createRestartPolicy(ERestartPolicy policy)
+{
+	switch (policy)
+	{
+	case ERestartPolicy::Luby:
+		return make_unique<LubyRestartPolicy>(*this);
+	case ERestartPolicy::LBD:
+		return make_unique<LBDRestartPolicy>(*this);
+	case ERestartPolicy::None:
+		return make_unique<NoRestartPolicy>(*this);
+	default:
+		vxy_fail();
+		return nullptr;
+	}
+}
+
+shared_ptr<ISolverDecisionHeuristic> ConstraintSolver::createHeuristic(EDecisionHeuristic heuristic)
+{
+	switch (heuristic)
+	{
+	case EDecisionHeuristic::CoarseLRB:
+		return make_shared<CoarseLRBHeuristic>(*this);
+	case EDecisionHeuristic::VSIDS:
+		return make_shared<VSIDSHeuristic>(*this);
+	case EDecisionHeuristic::LRB:
+		return make_shared<LRBHeuristic>(*this);
+	case EDecisionHeuristic::TopologyLocality:
+		return make_shared<TopologyLocalityHeuristic>(*this);
+	default:
+		vxy_fail();
+		return nullptr;
+	}
+}
+
 void ConstraintSolver::backtrackUntilDecision(SolverDecisionLevel decisionLevel, bool isRestart/*=false*/)
 {
 	vxy_assert(decisionLevel < getCurrentDecisionLevel());
@@ -1383,6 +1678,26 @@ void ConstraintSolver::backtrackUntilDecision(SolverDecisionLevel decisionLevel,
 		constraint->backtrack(&m_variableDB, decisionLevel);
 	}
 
+	// Notify any constraints that recorded state beyond the level we're backtracking to. A constraint may have
+	// multiple records, but only needs to be backtracked once.
+	m_constraintsToBacktrack.clear();
+	while (!m_backtrackRecordTrail.empty() && m_backtrackRecordTrail.back().level > decisionLevel)
+	{
+		const int constraintID = m_backtrackRecordTrail.back().constraintID;
+		m_constraintBacktrackRecordLevel[constraintID] = 0;
+		m_constraintsToBacktrack.add(constraintID);
+		m_backtrackRecordTrail.pop_back();
+	}
+
+	for (int constraintID : m_constraintsToBacktrack)
+	{
+		if (IConstraint* constraint = m_constraints[constraintID].get())
+		{
+			vxy_sanity(constraint->needsBacktracking());
+			static_cast<IBacktrackingSolverConstraint*>(constraint)->backtrack(&m_variableDB, decisionLevel);
+		}
+	}
+
 	if (m_unfoundedSetAnalyzer != nullptr)
 	{
 		m_unfoundedSetAnalyzer->onBacktrack();
@@ -1391,18 +1706,17 @@ void ConstraintSolver::backtrackUntilDecision(SolverDecisionLevel decisionLevel,
 	// Remove any propagations that were queued (since we just undid them)
 	m_variablePropagationQueue.clear();
 	m_constraintPropagationQueue.clear();
-	m_constraintQueuedSet.setZeroed();
-	m_variableQueuedSet.setZeroed();
+	m_constraintQueuedSet.clear();
+	m_variableQueuedSet.clear();
 	m_lastTriggeredSink = nullptr;
 	m_lastTriggeredTs = -1;
 }
 
 void ConstraintSolver::notifyVariableModification(VarID variable, IConstraint* constraint)
 {
-	if (variable.raw() >= m_variableQueuedSet.size() || !m_variableQueuedSet[variable.raw()])
+	if (!m_variableQueuedSet.contains(variable.raw()))
 	{
-		m_variableQueuedSet.pad(variable.raw()+1, false);
-		m_variableQueuedSet[variable.raw()] = true;
+		m_variableQueuedSet.add(variable.raw());
 		m_variablePropagationQueue.emplace_back(constraint, variable, m_variableDB.getLastModificationTimestamp(variable));
 	}
 
@@ -1415,43 +1729,55 @@ void ConstraintSolver::notifyVariableModification(VarID variable, IConstraint* c
 void ConstraintSolver::queueConstraintPropagation(const IConstraint* constraint)
 {
 	const int constraintID = constraint->getID();
-	if (constraintID >= m_constraintQueuedSet.size() || !m_constraintQueuedSet[constraintID])
+	if (!m_constraintQueuedSet.contains(constraintID))
 	{
-		m_constraintQueuedSet.pad(constraintID + 1, false);
-		m_constraintQueuedSet[constraintID] = true;
+		m_constraintQueuedSet.add(constraintID);
 		m_constraintPropagationQueue.push_front(constraint->getID());
 	}
 }
 
+void ConstraintSolver::markConstraintNeedsBacktrack(IConstraint* constraint)
+{
+	vxy_sanity(constraint->needsBacktracking());
+	vxy_sanity(!static_cast<IBacktrackingSolverConstraint*>(constraint)->wantsEveryBacktrack());
+
+	// We never backtrack beyond level 0, so no need to record anything.
+	const SolverDecisionLevel level = getCurrentDecisionLevel();
+	if (level == 0)
+	{
+		return;
+	}
+
+	const int constraintID = constraint->getID();
+	if (constraintID >= m_constraintBacktrackRecordLevel.size())
+	{
+		m_constraintBacktrackRecordLevel.resize(constraintID + 1, 0);
+	}
+
+	if (m_constraintBacktrackRecordLevel[constraintID] != level)
+	{
+		vxy_sanity(m_backtrackRecordTrail.empty() || m_backtrackRecordTrail.back().level <= level);
+		m_constraintBacktrackRecordLevel[constraintID] = level;
+		m_backtrackRecordTrail.push_back({level, constraintID});
+	}
+}
+
 SolverDecisionLevel ConstraintSolver::getDecisionLevelForTimestamp(SolverTimestamp time) const
 {
-	int found = 0;
+	if (time < 0)
+	{
+		return 0;
+	}
 
-	// Binary search to find quickly
-	int last = m_decisionLevels.size() - 1;
-	int left = 0;
-	int right = last;
-	while (right >= left)
+	// Each modification on the stack records the level it was made on.
+	const AssignmentStack& stack = m_variableDB.getAssignmentStack();
+	if (time <= stack.getMostRecentTimestamp())
 	{
-		int mid = left + ((right - left) >> 1);
-		bool under = m_decisionLevels[mid].modificationIndex < time;
-		bool over = (mid == last) || (m_decisionLevels[mid + 1].modificationIndex >= time);
-		if (!under)
-		{
-			right = mid - 1;
-		}
-		else if (!over)
-		{
-			left = mid + 1;
-		}
-		else
-		{
-			found = mid + 1;
-			break;
-		}
+		return stack.getDecisionLevelAtTime(time);
 	}
 
-	return found;
+	// Anything past the end of the stack will happen on the current level.
+	return getCurrentDecisionLevel();
 }
 
 void ConstraintSolver::getExplanationForModification(SolverTimestamp modificationTime, vector<Literal>& outExplanation) const
@@ -1553,7 +1879,7 @@ ClauseConstraint* ConstraintSolver::learn(const vector<Literal>& explanation, co
 		learnedCons->incrementActivity(m_constraintConflictIncr);
 
 		static ConstraintHashFuncs hasher;
-		const uint32_t hash = hasher(learnedCons);
+		const size_t hash = hasher(learnedCons);
 
 		auto foundExisting = m_learnedConstraintSet.find_by_hash(learnedCons, hash);
 		if (foundExisting != m_learnedConstraintSet.end())
@@ -1564,7 +1890,7 @@ ClauseConstraint* ConstraintSolver::learn(const vector<Literal>& explanation, co
 		m_learnedConstraintSet.insert(hash, nullptr, learnedCons);
 
 		bool canPromoteToGraph = (GRAPH_LEARNING_ENABLED && learnedCons->isPromotableToGraph());
-		if (learnedCons->getLBD() <= MAX_PERMANENT_CONSTRAINT_LBD || canPromoteToGraph)
+		if (learnedCons->getLBD() <= m_config.maxPermanentConstraintLBD || canPromoteToGraph)
 		{
 			learnedCons->setPermanent();
 			m_permanentLearnedConstraints.push_back(learnedCons);
@@ -1587,7 +1913,8 @@ ClauseConstraint* ConstraintSolver::learn(const vector<Literal>& explanation, co
 	// Let various heuristics know that we encountered a conflict/learned a new constraint.
 	//
 
-	m_restartPolicy.onClauseLearned(*learnedCons);
+	m_restartPolicy->onClauseLearned(*learnedCons);
+	++m_conflictsInMode;
 	for (auto& heuristic : m_heuristicStack)
 	{
 		heuristic->onClauseLearned();
@@ -1653,7 +1980,7 @@ void ConstraintSolver::markConstraintActivity(ClauseConstraint& constraint, bool
 	if (recomputeLBD && constraint.getLBD() > 2)
 	{
 		constraint.computeLbd(m_variableDB);
-		if (constraint.getLBD() <= MAX_PERMANENT_CONSTRAINT_LBD)
+		if (constraint.getLBD() <= m_config.maxPermanentConstraintLBD)
 		{
 			constraint.setPermanent();
 
@@ -1721,22 +2048,19 @@ void ConstraintSolver::promoteConstraintToGraph(ClauseConstraint& constraint)
 			continue;
 		}
 
-		ClauseConstraint* newCons = ClauseConstraint::Factory::construct(ConstraintFactoryParams(*this, newRelationInfo), nodeClauses, true);
+		// Check for an existing identical clause before paying for construction.
 		static ConstraintHashFuncs hasher;
-		const uint32_t hash = hasher(newCons);
+		m_candidateSignature.assign(nodeClauses);
 
-		auto existingIt = m_learnedConstraintSet.find_by_hash(newCons, hash);
+		auto existingIt = m_learnedConstraintSet.find_as(m_candidateSignature, hasher, hasher);
 		if (existingIt != m_learnedConstraintSet.end())
 		{
 			(*existingIt)->setPromotedToGraph();
-
-			delete newCons;
-			newCons = nullptr;
-
 			++numDuplicates;
 		}
 		else
 		{
+			ClauseConstraint* newCons = ClauseConstraint::Factory::construct(ConstraintFactoryParams(*this, newRelationInfo), nodeClauses, true);
 			++numCreated;
 			registerConstraint(newCons);
 			newCons->setStepLearned(m_stats.stepCount);
@@ -1882,7 +2206,7 @@ void ConstraintSolver::purgeConstraints()
 	});
 
 	const int prevTotal = m_temporaryLearnedConstraints.size();
-	const int numRemaining = int(float(prevTotal) * (1.0f - CONSTRAINT_PURGE_PERCENT));
+	const int numRemaining = int(float(prevTotal) * (1.0f - m_config.constraintPurgePercent));
 	const int numPurged = prevTotal - numRemaining;
 
 	int bestRemovedLBD = INT_MAX;
@@ -2030,12 +2354,7 @@ void ConstraintSolver::debugAttemptSolution(const wchar_t* filename)
 		backtrackUntilDecision(0, true);
 	}
 
-	m_restartPolicy.onRestarted();
-	for (auto& heuristic : m_heuristicStack)
-	{
-		heuristic->onRestarted();
-	}
-	m_newDescentAfterRestart = true;
+	onRestarted();
 	++m_stats.numRestarts;
 
 	for (auto& entry : solution)
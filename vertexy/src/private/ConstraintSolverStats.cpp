@@ -14,8 +14,11 @@ void ConstraintSolverStats::reset()
 	numBacktracks = 0;
 	maxBackjump = 0;
 	numRestarts = 0;
+	numReusedTrailLevels = 0;
 	numInitialConstraints = 0;
 	numConstraintsLearned = 0;
+	numMinimizedLiterals = 0;
+	numMinimizedGraphLiterals = 0;
 	numConstraintPromotions = 0;
 	numFailedConstraintPromotions = 0;
 	numGraphClonedConstraints = 0;
@@ -63,6 +66,7 @@ wstring ConstraintSolverStats::toString(bool verbose)
 		out.append_sprintf(TEXT("\n\tNumber of variables: %d"), m_solver.getVariableDB()->getNumVariables());
 		out.append_sprintf(TEXT("\n\tNumber of initial constraints: %d"), numInitialConstraints);
 		out.append_sprintf(TEXT("\n\tNumber of learned constraints: %d"), numConstraintsLearned);
+		out.append_sprintf(TEXT("\n\tLiterals removed by minimization: %d (graph: %d)"), numMinimizedLiterals, numMinimizedGraphLiterals);
 		out.append_sprintf(TEXT("\n\tLearned constraints purged: %d"), numPurgedConstraints);
 		out.append_sprintf(TEXT("\n\tNumber of purges: %d"), numConstraintPurges);
 		out.append_sprintf(TEXT("\n\tNumber of graph promotions: %d"), numConstraintPromotions);
@@ -70,6 +74,7 @@ wstring ConstraintSolverStats::toString(bool verbose)
 		out.append_sprintf(TEXT("\n\tNumber of constraints promoted from graphs: %d"), numGraphClonedConstraints);
 		out.append_sprintf(TEXT("\n\tNumber of duplicate learned constraints: %d"), numDuplicateLearnedConstraints);
 		out.append_sprintf(TEXT("\n\tLocked constraints during purge: %d"), numLockedConstraintsToPurge);
+		out.append_sprintf(TEXT("\n\tDecision levels reused on restart: %d"), numReusedTrailLevels);
 	}
 	return out;
 }
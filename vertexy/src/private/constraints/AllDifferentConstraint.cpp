@@ -8,14 +8,19 @@ using namespace Vertexy;
 
 AllDifferentConstraint* AllDifferentConstraint::AllDifferentFactory::construct(const ConstraintFactoryParams& params, const vector<VarID>& variables, bool useWeakPropagation)
 {
-	return new AllDifferentConstraint(params, params.unifyVariableDomains(variables), useWeakPropagation);
+	return construct(params, variables, useWeakPropagation ? EAllDifferentPropagation::Weak : EAllDifferentPropagation::Bounds);
 }
 
-AllDifferentConstraint::AllDifferentConstraint(const ConstraintFactoryParams& params, const vector<VarID>& inVariables, bool useWeakPropagation)
+AllDifferentConstraint* AllDifferentConstraint::AllDifferentFactory::construct(const ConstraintFactoryParams& params, const vector<VarID>& variables, EAllDifferentPropagation propagation)
+{
+	return new AllDifferentConstraint(params, params.unifyVariableDomains(variables), propagation);
+}
+
+AllDifferentConstraint::AllDifferentConstraint(const ConstraintFactoryParams& params, const vector<VarID>& inVariables, EAllDifferentPropagation propagation)
 	: IConstraint(params)
 	, m_variables(inVariables)
 	, m_maxDomainSize(0)
-	, m_useWeakPropagation(useWeakPropagation)
+	, m_propagation(propagation)
 {
 }
 
@@ -41,14 +46,18 @@ bool AllDifferentConstraint::initialize(IVariableDatabase* db)
 			unsolvedVariables.erase_first_unsorted(var);
 		}
 
-		if (m_useWeakPropagation)
+		switch (m_propagation)
 		{
+		case EAllDifferentPropagation::Weak:
 			m_watcherHandles.push_back(db->addVariableWatch(var, EVariableWatchType::WatchSolved, this));
-		}
-		else
-		{
+			break;
+		case EAllDifferentPropagation::Bounds:
 			m_watcherHandles.push_back(db->addVariableWatch(var, EVariableWatchType::WatchLowerBoundChange, this));
 			m_watcherHandles.push_back(db->addVariableWatch(var, EVariableWatchType::WatchUpperBoundChange, this));
+			break;
+		case EAllDifferentPropagation::Domain:
+			m_watcherHandles.push_back(db->addVariableWatch(var, EVariableWatchType::WatchModification, this));
+			break;
 		}
 	}
 
@@ -57,7 +66,7 @@ bool AllDifferentConstraint::initialize(IVariableDatabase* db)
 		excludeSolvedValue(db, solvedVar);
 	}
 
-	if (!m_useWeakPropagation)
+	if (m_propagation == EAllDifferentPropagation::Bounds)
 	{
 		m_hallIntervalPropagator = make_unique<HallIntervalPropagation>(m_maxDomainSize);
 		if (unsolvedVariables.size() > 0 && !checkBoundsConsistency(db, unsolvedVariables))
@@ -70,14 +79,26 @@ bool AllDifferentConstraint::initialize(IVariableDatabase* db)
 	maxs.reserve(m_maxDomainSize);
 	for (int i = 0; i < m_maxDomainSize; ++i)	{ maxs.push_back(1); }
 
-	m_explainer.initialize(*db, m_variables, 0, m_maxDomainSize-1, maxs, /*useBoundsConsistency=*/true);
+	const bool useBoundsExplanation = m_propagation != EAllDifferentPropagation::Domain;
+	m_explainer.initialize(*db, m_variables, 0, m_maxDomainSize-1, maxs, useBoundsExplanation);
+
+	if (m_propagation == EAllDifferentPropagation::Domain)
+	{
+		m_matchingGraph.initialize(m_variables.size(), m_maxDomainSize);
+		m_dirtyVariables.clear();
+		m_dirtyVariables.resize(m_variables.size(), true);
+		if (!checkDomainConsistency(db))
+		{
+			return false;
+		}
+	}
 
 	return true;
 }
 
 void AllDifferentConstraint::reset(IVariableDatabase* db)
 {
-	if (!m_useWeakPropagation)
+	if (m_propagation == EAllDifferentPropagation::Bounds)
 	{
 		// Two watchers per variable
 		for (int i = 0; i < m_watcherHandles.size(); ++i)
@@ -105,7 +126,14 @@ bool AllDifferentConstraint::onVariableNarrowed(IVariableDatabase* db, VarID nar
 		}
 	}
 
-	if (!m_useWeakPropagation)
+	if (m_propagation == EAllDifferentPropagation::Domain)
+	{
+		const int varIndex = indexOf(m_variables.begin(), m_variables.end(), narrowedVar);
+		vxy_assert(varIndex >= 0);
+		m_dirtyVariables[varIndex] = true;
+	}
+
+	if (m_propagation != EAllDifferentPropagation::Weak)
 	{
 		db->queueConstraintPropagation(this);
 	}
@@ -114,7 +142,12 @@ bool AllDifferentConstraint::onVariableNarrowed(IVariableDatabase* db, VarID nar
 
 bool AllDifferentConstraint::propagate(IVariableDatabase* db)
 {
-	vxy_assert(!m_useWeakPropagation);
+	if (m_propagation == EAllDifferentPropagation::Domain)
+	{
+		return checkDomainConsistency(db);
+	}
+
+	vxy_assert(m_propagation == EAllDifferentPropagation::Bounds);
 	static vector<VarID> unsolvedVariables;
 	unsolvedVariables.clear();
 	unsolvedVariables.reserve(m_variables.size());
@@ -140,7 +173,20 @@ bool AllDifferentConstraint::propagate(IVariableDatabase* db)
 
 bool AllDifferentConstraint::checkConflicting(IVariableDatabase* db) const
 {
-	if (!m_useWeakPropagation)
+	if (m_propagation == EAllDifferentPropagation::Domain)
+	{
+		BipartiteGraph graph(m_variables.size(), m_maxDomainSize);
+		for (int varIndex = 0; varIndex < m_variables.size(); ++varIndex)
+		{
+			const ValueSet& values = db->getPotentialValues(m_variables[varIndex]);
+			for (auto it = values.beginSetBits(), itEnd = values.endSetBits(); it != itEnd; ++it)
+			{
+				graph.addEdge(varIndex, *it);
+			}
+		}
+		return !graph.incrementalMaximalMatching();
+	}
+	else if (m_propagation == EAllDifferentPropagation::Bounds)
 	{
 		vector<Interval> tempBounds, tempInvBounds;
 		calculateBounds(db, m_variables, tempBounds, tempInvBounds);
@@ -257,6 +303,133 @@ bool AllDifferentConstraint::checkBoundsConsistency(IVariableDatabase* db, const
 	return true;
 }
 
+bool AllDifferentConstraint::updateMatching(IVariableDatabase* db)
+{
+	for (int varIndex = 0; varIndex < m_variables.size(); ++varIndex)
+	{
+		const ValueSet& values = db->getPotentialValues(m_variables[varIndex]);
+
+		// A variable that hasn't been narrowed since its edges were added can only have been widened by
+		// backtracking, so its edges are a subset of its domain and comparing the counts is enough.
+		if (!m_dirtyVariables[varIndex] && m_matchingGraph.getNumOutgoing(varIndex) == values.getNumSetBits())
+		{
+			continue;
+		}
+		m_dirtyVariables[varIndex] = false;
+
+		m_matchingGraph.removeEdges(varIndex);
+		for (auto it = values.beginSetBits(), itEnd = values.endSetBits(); it != itEnd; ++it)
+		{
+			m_matchingGraph.addEdge(varIndex, *it);
+		}
+	}
+
+	// Only the variables whose edges were replaced need to be rematched.
+	return m_matchingGraph.incrementalMaximalMatching();
+}
+
+//
+// Ensure domain consistency. Given a maximum matching between variables and values, a value can be removed from a
+// variable if the edge between them does not belong to any maximum matching. In the residual graph (matched edges
+// point Variable->Value, unmatched edges Value->Variable, with a sink connecting matched values to free values), those
+// are exactly the unmatched edges between nodes in different strongly-connected components.
+//
+// See "A filtering algorithm for constraints of difference in CSPs", Regin
+// https://www.aaai.org/Papers/AAAI/1994/AAAI94-055.pdf
+// and "Generalised Arc Consistency for the AllDifferent Constraint: An Empirical Study", Gent et. al.
+// https://www-users.cs.york.ac.uk/pwn503/gac-alldifferent.pdf
+//
+bool AllDifferentConstraint::checkDomainConsistency(IVariableDatabase* db)
+{
+	if (!updateMatching(db))
+	{
+		// Not every variable can take a distinct value.
+		return false;
+	}
+
+	const int numNodes = m_variables.size() + m_maxDomainSize + 1;
+	m_tarjan.findStronglyConnectedComponents(numNodes, [&](int node, auto visitor) { tarjanVisit(node, visitor); }, m_nodeToScc);
+
+	for (int varIndex = 0; varIndex < m_variables.size(); ++varIndex)
+	{
+		const VarID var = m_variables[varIndex];
+		if (db->isSolved(var))
+		{
+			continue;
+		}
+
+		const int matchedValue = m_matchingGraph.getMatchedRightSide(varIndex);
+		const int varScc = m_nodeToScc[varIndex];
+
+		const ValueSet& values = db->getPotentialValues(var);
+		m_removedValues.init(values.size(), false);
+
+		bool anyRemoved = false;
+		for (auto it = values.beginSetBits(), itEnd = values.endSetBits(); it != itEnd; ++it)
+		{
+			if (*it != matchedValue && m_nodeToScc[valueToNode(*it)] != varScc)
+			{
+				m_removedValues[*it] = true;
+				anyRemoved = true;
+			}
+		}
+
+		if (anyRemoved)
+		{
+			// The graph still has the removed edges, so make sure they're dropped next time.
+			m_dirtyVariables[varIndex] = true;
+			if (!db->excludeValues(var, m_removedValues, this))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Visit the residual graph implied by the matching.
+template <typename T>
+void AllDifferentConstraint::tarjanVisit(int node, T&& visitor)
+{
+	if (isSinkNode(node))
+	{
+		// Sink: edge to each value that isn't matched
+		for (int value = 0; value < m_maxDomainSize; ++value)
+		{
+			if (m_matchingGraph.getNumRightSideMatched(value) == 0)
+			{
+				visitor(valueToNode(value));
+			}
+		}
+	}
+	else if (isVariableNode(node))
+	{
+		// Variable: edge to its matched value
+		visitor(valueToNode(m_matchingGraph.getMatchedRightSide(node)));
+	}
+	else
+	{
+		// Value: edge to each variable that can take the value but isn't matched to it, and to the sink if matched.
+		// Value nodes share their indices with the right side of the bipartite graph.
+		const int value = nodeToValue(node);
+		for (int edgeIndex = 0; edgeIndex < m_matchingGraph.getNumIncoming(node); ++edgeIndex)
+		{
+			int varIndex;
+			m_matchingGraph.getIncomingSource(node, edgeIndex, varIndex);
+			if (m_matchingGraph.getMatchedRightSide(varIndex) != value)
+			{
+				visitor(varIndex);
+			}
+		}
+
+		if (m_matchingGraph.getNumRightSideMatched(value) > 0)
+		{
+			visitor(m_variables.size() + m_maxDomainSize);
+		}
+	}
+}
+
 void AllDifferentConstraint::calculateBounds(const IVariableDatabase* db, const vector<VarID>& unsolvedVariables, vector<Interval>& outBounds, vector<Interval>& outInvBounds) const
 {
 	// Grab the min/max value for each variable.
@@ -221,8 +221,7 @@ bool CardinalityConstraint::initialize(IVariableDatabase* db)
 
 	if (isUpperBoundFullySatisfied(db) && isLowerBoundFullySatisfied(db))
 	{
-		db->markConstraintFullySatisfied(this);
-		m_fullySatisfiedLevel = db->getDecisionLevel();
+		markFullySatisfied(db);
 	}
 
 	return propagate(db);
@@ -277,16 +276,25 @@ void CardinalityConstraint::backtrack(const IVariableDatabase* db, SolverDecisio
 	#endif
 }
 
-CardinalityConstraint::BacktrackInfo& CardinalityConstraint::backtrackRecord(SolverDecisionLevel level)
+CardinalityConstraint::BacktrackInfo& CardinalityConstraint::backtrackRecord(IVariableDatabase* db)
 {
+	const SolverDecisionLevel level = db->getDecisionLevel();
 	if (m_backtrackStack.back().level != level)
 	{
 		vxy_assert(m_backtrackStack.back().level < level);
 		m_backtrackStack.push_back({level, m_sccSplits.size(), m_upperBoundProcessList, m_numUpperBoundVarsOutsideUBC, m_numUnitSCCs});
+		db->markConstraintNeedsBacktrack(this);
 	}
 	return m_backtrackStack.back();
 }
 
+void CardinalityConstraint::markFullySatisfied(IVariableDatabase* db)
+{
+	db->markConstraintFullySatisfied(this);
+	m_fullySatisfiedLevel = db->getDecisionLevel();
+	db->markConstraintNeedsBacktrack(this);
+}
+
 bool CardinalityConstraint::onVariableNarrowed(IVariableDatabase* db, VarID variable, const ValueSet& prevValues, bool&)
 {
 	if (m_fullySatisfiedLevel >= 0)
@@ -296,8 +304,7 @@ bool CardinalityConstraint::onVariableNarrowed(IVariableDatabase* db, VarID vari
 	}
 	else if (isUpperBoundFullySatisfied(db) && isLowerBoundFullySatisfied(db))
 	{
-		db->markConstraintFullySatisfied(this);
-		m_fullySatisfiedLevel = db->getDecisionLevel();
+		markFullySatisfied(db);
 		return true;
 	}
 
@@ -313,7 +320,7 @@ bool CardinalityConstraint::onVariableNarrowed(IVariableDatabase* db, VarID vari
 		}
 		else if (prevValues.anyPossible(m_upperBoundConstrainedValues))
 		{
-			backtrackRecord(db->getDecisionLevel());
+			backtrackRecord(db);
 			vxy_sanity(contains(m_upperBoundVariables.begin(), m_upperBoundVariables.end(), variable));
 			m_numUpperBoundVarsOutsideUBC++;
 			vxy_assert(m_numUpperBoundVarsOutsideUBC <= m_upperBoundVariables.size());
@@ -461,7 +468,7 @@ bool CardinalityConstraint::processUpperboundConstraint(IVariableDatabase* db)
 
 	if (m_backtrackStack.back().level != db->getDecisionLevel())
 	{
-		backtrackRecord(db->getDecisionLevel());
+		backtrackRecord(db);
 	}
 	else
 	{
@@ -479,6 +486,7 @@ bool CardinalityConstraint::processUpperboundConstraint(IVariableDatabase* db)
 	{
 		// We could not match all variables with a value, so we can't satisfy.
 		m_failedUpperBoundMatching = true;
+		db->markConstraintNeedsBacktrack(this);
 		return false;
 	}
 
@@ -942,6 +950,7 @@ bool CardinalityConstraint::lbcLow(IVariableDatabase* db, vector<Interval>& inte
 	if (m_lbcFailures.contains(true))
 	{
 		m_failedLowerBoundMatching = true;
+		db->markConstraintNeedsBacktrack(this);
 		return false;
 	}
 
@@ -1063,6 +1072,7 @@ bool CardinalityConstraint::lbcHi(IVariableDatabase* db, vector<Interval>& inter
 	if (m_lbcFailures.contains(true))
 	{
 		m_failedLowerBoundMatching = true;
+		db->markConstraintNeedsBacktrack(this);
 		return false;
 	}
 
@@ -107,6 +107,7 @@ ClauseConstraint::ClauseConstraint(const ConstraintFactoryParams& params, const
 		m_extendedInfo->isPermanent = false;
 		m_extendedInfo->isPromoted = false;
 		m_extendedInfo->promotionSource = nullptr;
+		m_extendedInfo->literalHash = ClauseSignature::hashLiterals(m_literals, m_numLiterals);
 	}
 }
 
@@ -336,6 +337,11 @@ void ClauseConstraint::removeLiteralAt(IVariableDatabase* db, int litIndex)
 	}
 	--m_numLiterals;
 
+	if (m_extendedInfo != nullptr)
+	{
+		m_extendedInfo->literalHash = ClauseSignature::hashLiterals(m_literals, m_numLiterals);
+	}
+
 	if (litIndex < 2 && litIndex < m_numLiterals)
 	{
 		if (!db->anyPossible(m_literals[litIndex]))
@@ -0,0 +1,117 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#include "constraints/ClauseSignature.h"
+#include <EASTL/algorithm.h>
+#include <EASTL/fixed_vector.h>
+#include <EASTL/sort.h>
+
+using namespace Vertexy;
+
+void ClauseSignature::assign(const Literal* literals, int numLiterals)
+{
+	m_literals.clear();
+	m_literals.reserve(numLiterals);
+	for (int i = 0; i < numLiterals; ++i)
+	{
+		m_literals.push_back(literals[i]);
+	}
+
+	quick_sort(m_literals.begin(), m_literals.end(), [](const Literal& lhs, const Literal& rhs)
+	{
+		return lhs.variable.raw() < rhs.variable.raw();
+	});
+
+	// Merge any literals referring to the same variable, as ClauseConstraint construction does for graph clauses.
+	int numUnique = 0;
+	for (int i = 0; i < m_literals.size(); ++i)
+	{
+		if (numUnique > 0 && m_literals[numUnique-1].variable == m_literals[i].variable)
+		{
+			m_literals[numUnique-1].values.include(m_literals[i].values);
+		}
+		else
+		{
+			if (numUnique != i)
+			{
+				m_literals[numUnique] = move(m_literals[i]);
+			}
+			++numUnique;
+		}
+	}
+	m_literals.resize(numUnique);
+
+	m_hash = mix(uint64_t(numUnique));
+	for (const Literal& lit : m_literals)
+	{
+		m_hash = combineLiteral(m_hash, lit);
+	}
+}
+
+uint64_t ClauseSignature::hashLiterals(const Literal* literals, int numLiterals)
+{
+	fixed_vector<const Literal*, 16> sorted;
+	sorted.reserve(numLiterals);
+	for (int i = 0; i < numLiterals; ++i)
+	{
+		sorted.push_back(&literals[i]);
+	}
+
+	quick_sort(sorted.begin(), sorted.end(), [](const Literal* lhs, const Literal* rhs)
+	{
+		return lhs->variable.raw() < rhs->variable.raw();
+	});
+
+	uint64_t h = mix(uint64_t(numLiterals));
+	for (const Literal* lit : sorted)
+	{
+		h = combineLiteral(h, *lit);
+	}
+	return h;
+}
+
+bool ClauseSignature::matches(const Literal* literals, int numLiterals) const
+{
+	if (numLiterals != m_literals.size())
+	{
+		return false;
+	}
+
+	for (int i = 0; i < numLiterals; ++i)
+	{
+		auto found = lower_bound(m_literals.begin(), m_literals.end(), literals[i].variable, [](const Literal& lhs, VarID rhs)
+		{
+			return lhs.variable.raw() < rhs.raw();
+		});
+		if (found == m_literals.end() || *found != literals[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ClauseSignature::operator==(const ClauseSignature& rhs) const
+{
+	if (m_hash != rhs.m_hash || m_literals.size() != rhs.m_literals.size())
+	{
+		return false;
+	}
+
+	for (int i = 0; i < m_literals.size(); ++i)
+	{
+		if (m_literals[i] != rhs.m_literals[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+uint64_t ClauseSignature::combineLiteral(uint64_t h, const Literal& lit)
+{
+	h = mix(h ^ (uint64_t(lit.variable.raw()) + 0x9e3779b97f4a7c15ULL));
+	for (auto it = lit.values.getWordIterator(); it; ++it)
+	{
+		h = mix(h ^ uint64_t(it.getWord()));
+	}
+	return h;
+}
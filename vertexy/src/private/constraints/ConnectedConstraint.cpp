@@ -0,0 +1,545 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#include "constraints/ConnectedConstraint.h"
+#include "constraints/ConstraintFactoryParams.h"
+#include "variable/IVariableDatabase.h"
+
+#include <EASTL/algorithm.h>
+#include <EASTL/sort.h>
+
+using namespace Vertexy;
+
+ConnectedConstraint* ConnectedConstraint::ConnectedFactory::construct(const ConstraintFactoryParams& params, const shared_ptr<TTopologyVertexData<VarID>>& vertexData, const vector<int>& connectedValues)
+{
+	// Get an example graph variable
+	VarID graphVar;
+	for (int i = 0; i < vertexData->getSource()->getNumVertices(); ++i)
+	{
+		if (vertexData->get(i).isValid())
+		{
+			graphVar = vertexData->get(i);
+			break;
+		}
+	}
+	vxy_assert(graphVar.isValid());
+
+	return new ConnectedConstraint(params, vertexData, params.valuesToInternal(graphVar, connectedValues));
+}
+
+ConnectedConstraint::ConnectedConstraint(const ConstraintFactoryParams& params, const shared_ptr<TTopologyVertexData<VarID>>& vertexData, const ValueSet& connectedMask)
+	: IBacktrackingSolverConstraint(params)
+	, m_vertexData(vertexData)
+	, m_vertexVariables(vertexData->getData())
+	, m_connectedMask(connectedMask)
+{
+	m_notConnectedMask = connectedMask.inverted();
+
+	const shared_ptr<ITopology>& topology = vertexData->getSource();
+	const int numVertices = topology->getNumVertices();
+
+	for (int vertex = 0; vertex < numVertices; ++vertex)
+	{
+		const VarID var = m_vertexVariables[vertex];
+		if (var.isValid())
+		{
+			vxy_assert_msg(m_variableToVertex.find(var) == m_variableToVertex.end(), "Variable appears in multiple vertices");
+			vxy_assert(params.getDomain(var).getDomainSize() == m_connectedMask.size());
+			m_variableToVertex[var] = vertex;
+		}
+	}
+
+	// Connectivity is undirected, so treat each edge of the topology as going both ways.
+	vector<vector<int>> neighbors;
+	neighbors.resize(numVertices);
+	for (int vertex = 0; vertex < numVertices; ++vertex)
+	{
+		for (int edge = 0; edge < topology->getNumOutgoing(vertex); ++edge)
+		{
+			int dest;
+			if (topology->getOutgoingDestination(vertex, edge, dest) && dest != vertex)
+			{
+				neighbors[vertex].push_back(dest);
+				neighbors[dest].push_back(vertex);
+			}
+		}
+	}
+
+	m_adjacencyStart.reserve(numVertices + 1);
+	for (auto& vertexNeighbors : neighbors)
+	{
+		quick_sort(vertexNeighbors.begin(), vertexNeighbors.end());
+		m_adjacencyStart.push_back(m_adjacency.size());
+		m_adjacency.insert(m_adjacency.end(), vertexNeighbors.begin(), unique(vertexNeighbors.begin(), vertexNeighbors.end()));
+	}
+	m_adjacencyStart.push_back(m_adjacency.size());
+}
+
+vector<VarID> ConnectedConstraint::getConstrainingVariables() const
+{
+	vector<VarID> out;
+	out.reserve(m_variableToVertex.size());
+	for (VarID var : m_vertexVariables)
+	{
+		if (var.isValid())
+		{
+			out.push_back(var);
+		}
+	}
+	return out;
+}
+
+bool ConnectedConstraint::initialize(IVariableDatabase* db)
+{
+	for (VarID var : m_vertexVariables)
+	{
+		if (var.isValid())
+		{
+			m_watchers.push_back(db->addVariableWatch(var, EVariableWatchType::WatchModification, this));
+		}
+	}
+
+	m_changedLevels.clear();
+	m_needsRebuild = true;
+	m_conflictVertex = -1;
+	return propagate(db);
+}
+
+void ConnectedConstraint::reset(IVariableDatabase* db)
+{
+	int watchIndex = 0;
+	for (VarID var : m_vertexVariables)
+	{
+		if (var.isValid())
+		{
+			db->removeVariableWatch(var, m_watchers[watchIndex], this);
+			++watchIndex;
+		}
+	}
+	m_watchers.clear();
+}
+
+bool ConnectedConstraint::onVariableNarrowed(IVariableDatabase* db, VarID variable, const ValueSet&, bool&)
+{
+	auto found = m_variableToVertex.find(variable);
+	vxy_assert(found != m_variableToVertex.end());
+
+	// If we need a rebuild, the change will be picked up during propagation.
+	if (m_needsRebuild || updateVertex(db, found->second))
+	{
+		db->queueConstraintPropagation(this);
+	}
+	return true;
+}
+
+bool ConnectedConstraint::propagate(IVariableDatabase* db)
+{
+	if (m_needsRebuild)
+	{
+		rebuild(db);
+	}
+
+	if (m_numInVertices == 0)
+	{
+		return true;
+	}
+
+	// Vertices joining the region don't remove anything from the max graph, so the last search still holds. If the
+	// region is also connected, there are no cut vertices to look for.
+	if (!m_anyOutSinceSearch && m_numMinComponents == 1)
+	{
+		return true;
+	}
+
+	int root = -1;
+	for (int vertex = 0; vertex < m_vertexStates.size(); ++vertex)
+	{
+		if (m_vertexStates[vertex] == In)
+		{
+			root = vertex;
+			break;
+		}
+	}
+	vxy_sanity(root >= 0);
+
+	// If the min graph is already connected, there can't be any cut vertices between region vertices.
+	searchMaxGraph(root, m_numMinComponents > 1);
+
+	//
+	// Anything not reached from the root is either a region vertex that can't be connected (conflict), or can't be
+	// part of the region.
+	//
+
+	vector<int> unreachable;
+	for (int vertex = 0; vertex < m_vertexStates.size(); ++vertex)
+	{
+		if (m_discovery[vertex] >= 0 || m_vertexStates[vertex] == Out)
+		{
+			continue;
+		}
+
+		if (m_vertexStates[vertex] == In)
+		{
+			m_conflictVertex = root;
+			return false;
+		}
+		unreachable.push_back(vertex);
+	}
+
+	for (int vertex : unreachable)
+	{
+		if (!db->excludeValues(m_vertexVariables[vertex], m_connectedMask, this, makeExplainer(vertex, -1)))
+		{
+			return false;
+		}
+		updateVertex(db, vertex);
+	}
+
+	//
+	// Cut vertices separating region vertices must be part of the region.
+	//
+
+	for (auto& cut : m_cutVertices)
+	{
+		const int vertex = get<0>(cut);
+		if (m_vertexStates[vertex] != Undecided)
+		{
+			continue;
+		}
+
+		if (!db->constrainToValues(m_vertexVariables[vertex], m_connectedMask, this, makeExplainer(get<1>(cut), vertex)))
+		{
+			return false;
+		}
+		updateVertex(db, vertex);
+	}
+
+	// The vertices excluded above were unreachable, so removing them didn't change what the search found.
+	m_anyOutSinceSearch = false;
+	return true;
+}
+
+void ConnectedConstraint::searchMaxGraph(int root, bool findCutVertices)
+{
+	const int numVertices = m_vertexStates.size();
+	m_discovery.clear();
+	m_discovery.resize(numVertices, -1);
+	m_lowLink.resize(numVertices);
+	m_subtreeInCount.resize(numVertices);
+	m_subtreeInVertex.resize(numVertices);
+	m_cutVertices.clear();
+
+	int counter = 0;
+	auto visit = [&](int vertex)
+	{
+		m_discovery[vertex] = counter;
+		m_lowLink[vertex] = counter;
+		++counter;
+		const bool inRegion = m_vertexStates[vertex] == In;
+		m_subtreeInCount[vertex] = inRegion ? 1 : 0;
+		m_subtreeInVertex[vertex] = inRegion ? vertex : -1;
+		m_searchStack.push_back(make_tuple(vertex, m_adjacencyStart[vertex]));
+	};
+
+	m_searchStack.clear();
+	visit(root);
+	while (!m_searchStack.empty())
+	{
+		const int vertex = get<0>(m_searchStack.back());
+		const int nextEdge = get<1>(m_searchStack.back());
+		if (nextEdge < m_adjacencyStart[vertex + 1])
+		{
+			get<1>(m_searchStack.back()) = nextEdge + 1;
+
+			const int neighbor = m_adjacency[nextEdge];
+			if (m_vertexStates[neighbor] == Out)
+			{
+				continue;
+			}
+
+			if (m_discovery[neighbor] < 0)
+			{
+				visit(neighbor);
+			}
+			else
+			{
+				m_lowLink[vertex] = min(m_lowLink[vertex], m_discovery[neighbor]);
+			}
+			continue;
+		}
+
+		m_searchStack.pop_back();
+		if (m_searchStack.empty())
+		{
+			break;
+		}
+
+		const int parent = get<0>(m_searchStack.back());
+		m_lowLink[parent] = min(m_lowLink[parent], m_lowLink[vertex]);
+		m_subtreeInCount[parent] += m_subtreeInCount[vertex];
+		if (m_subtreeInVertex[parent] < 0)
+		{
+			m_subtreeInVertex[parent] = m_subtreeInVertex[vertex];
+		}
+
+		// If the subtree can't reach above the parent without going through it, the parent separates the subtree from
+		// the root. Since the root is in the region, it only matters if the subtree contains a region vertex.
+		if (findCutVertices && parent != root && m_vertexStates[parent] == Undecided &&
+			m_lowLink[vertex] >= m_discovery[parent] && m_subtreeInCount[vertex] > 0)
+		{
+			m_cutVertices.push_back(make_tuple(parent, m_subtreeInVertex[vertex]));
+		}
+	}
+}
+
+void ConnectedConstraint::backtrack(const IVariableDatabase* db, SolverDecisionLevel level)
+{
+	while (!m_changedLevels.empty() && m_changedLevels.back() > level)
+	{
+		m_changedLevels.pop_back();
+		m_needsRebuild = true;
+	}
+}
+
+bool ConnectedConstraint::checkConflicting(IVariableDatabase* db) const
+{
+	const int numVertices = m_vertexVariables.size();
+
+	int root = -1;
+	for (int vertex = 0; vertex < numVertices && root < 0; ++vertex)
+	{
+		if (getVertexState(db, vertex) == In)
+		{
+			root = vertex;
+		}
+	}
+	if (root < 0)
+	{
+		return false;
+	}
+
+	vector<bool> reached;
+	reached.resize(numVertices, false);
+	vector<int> stack;
+	stack.push_back(root);
+	reached[root] = true;
+	while (!stack.empty())
+	{
+		const int vertex = stack.back();
+		stack.pop_back();
+		for (int i = m_adjacencyStart[vertex]; i < m_adjacencyStart[vertex + 1]; ++i)
+		{
+			const int neighbor = m_adjacency[i];
+			if (!reached[neighbor] && getVertexState(db, neighbor) != Out)
+			{
+				reached[neighbor] = true;
+				stack.push_back(neighbor);
+			}
+		}
+	}
+
+	for (int vertex = 0; vertex < numVertices; ++vertex)
+	{
+		if (!reached[vertex] && getVertexState(db, vertex) == In)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+ConnectedConstraint::EVertexState ConnectedConstraint::getVertexState(const IVariableDatabase* db, int vertex) const
+{
+	const VarID var = m_vertexVariables[vertex];
+	if (!var.isValid())
+	{
+		return Out;
+	}
+
+	const ValueSet& values = db->getPotentialValues(var);
+	if (!values.anyPossible(m_connectedMask))
+	{
+		return Out;
+	}
+	return values.anyPossible(m_notConnectedMask) ? Undecided : In;
+}
+
+bool ConnectedConstraint::updateVertex(IVariableDatabase* db, int vertex)
+{
+	const EVertexState newState = getVertexState(db, vertex);
+	if (newState == m_vertexStates[vertex])
+	{
+		return false;
+	}
+
+	const SolverDecisionLevel level = db->getDecisionLevel();
+	if (level > 0 && (m_changedLevels.empty() || m_changedLevels.back() != level))
+	{
+		vxy_assert(m_changedLevels.empty() || m_changedLevels.back() < level);
+		m_changedLevels.push_back(level);
+		db->markConstraintNeedsBacktrack(this);
+	}
+
+	m_vertexStates[vertex] = newState;
+	if (newState == Out)
+	{
+		m_anyOutSinceSearch = true;
+	}
+	else if (newState == In)
+	{
+		++m_numInVertices;
+		++m_numMinComponents;
+		for (int i = m_adjacencyStart[vertex]; i < m_adjacencyStart[vertex + 1]; ++i)
+		{
+			const int neighbor = m_adjacency[i];
+			if (m_vertexStates[neighbor] == In && m_minGraphSets.find(neighbor) != m_minGraphSets.find(vertex))
+			{
+				m_minGraphSets.makeUnion(neighbor, vertex);
+				--m_numMinComponents;
+			}
+		}
+	}
+	return true;
+}
+
+void ConnectedConstraint::rebuild(IVariableDatabase* db)
+{
+	const int numVertices = m_vertexVariables.size();
+	m_vertexStates.resize(numVertices);
+	for (int vertex = 0; vertex < numVertices; ++vertex)
+	{
+		m_vertexStates[vertex] = getVertexState(db, vertex);
+	}
+
+	m_minGraphSets.reset(numVertices);
+	m_numInVertices = 0;
+	m_numMinComponents = 0;
+	for (int vertex = 0; vertex < numVertices; ++vertex)
+	{
+		if (m_vertexStates[vertex] != In)
+		{
+			continue;
+		}
+
+		++m_numInVertices;
+		++m_numMinComponents;
+		for (int i = m_adjacencyStart[vertex]; i < m_adjacencyStart[vertex + 1]; ++i)
+		{
+			const int neighbor = m_adjacency[i];
+			if (neighbor < vertex && m_vertexStates[neighbor] == In && m_minGraphSets.find(neighbor) != m_minGraphSets.find(vertex))
+			{
+				m_minGraphSets.makeUnion(neighbor, vertex);
+				--m_numMinComponents;
+			}
+		}
+	}
+	m_needsRebuild = false;
+	m_anyOutSinceSearch = true;
+
+	// The rebuilt state reflects changes made at this level, so we need to know if we backtrack past it.
+	const SolverDecisionLevel level = db->getDecisionLevel();
+	if (level > 0 && (m_changedLevels.empty() || m_changedLevels.back() != level))
+	{
+		m_changedLevels.push_back(level);
+		db->markConstraintNeedsBacktrack(this);
+	}
+}
+
+ExplainerFunction ConnectedConstraint::makeExplainer(int start, int blocked)
+{
+	return [this, start, blocked](const NarrowingExplanationParams& params, vector<Literal>& outExplanation)
+	{
+		// The database is as it was immediately before the narrowing being explained.
+		auto db = params.database;
+		const VarID propagatedVar = params.propagatedVariable;
+
+		// Values that were removed by the narrowing. If the variable became contradictory, that's all of them.
+		ValueSet removed = db->getPotentialValues(propagatedVar);
+		if (!params.propagatedValues.isZero())
+		{
+			removed.exclude(params.propagatedValues);
+		}
+
+		outExplanation.clear();
+		outExplanation.push_back(Literal(propagatedVar, removed.inverted()));
+		explainSeparation(db, start, blocked, outExplanation);
+	};
+}
+
+void ConnectedConstraint::explain(const NarrowingExplanationParams& params, vector<Literal>& outExplanation) const
+{
+	// Every narrowing has its own explainer, so this is only called when region vertices were found to be separated.
+	vxy_assert(!params.propagatedVariable.isValid());
+	vxy_assert(m_conflictVertex >= 0);
+
+	outExplanation.clear();
+	explainSeparation(params.database, m_conflictVertex, -1, outExplanation);
+}
+
+void ConnectedConstraint::explainSeparation(const IVariableDatabase* db, int start, int blocked, vector<Literal>& outExplanation) const
+{
+	const int numVertices = m_vertexVariables.size();
+
+	// Flood fill the max graph from Start. The vertices out of the region surrounding the fill are what separate it.
+	vector<bool> visited;
+	visited.resize(numVertices, false);
+	vector<int> boundary;
+	vector<int> stack;
+	stack.push_back(start);
+	visited[start] = true;
+	if (blocked >= 0)
+	{
+		visited[blocked] = true;
+	}
+
+	while (!stack.empty())
+	{
+		const int vertex = stack.back();
+		stack.pop_back();
+		for (int i = m_adjacencyStart[vertex]; i < m_adjacencyStart[vertex + 1]; ++i)
+		{
+			const int neighbor = m_adjacency[i];
+			if (visited[neighbor])
+			{
+				continue;
+			}
+
+			visited[neighbor] = true;
+			if (getVertexState(db, neighbor) == Out)
+			{
+				boundary.push_back(neighbor);
+			}
+			else
+			{
+				stack.push_back(neighbor);
+			}
+		}
+	}
+
+	// Find a region vertex on the other side.
+	int other = -1;
+	for (int vertex = 0; vertex < numVertices; ++vertex)
+	{
+		if (!visited[vertex] && getVertexState(db, vertex) == In)
+		{
+			other = vertex;
+			break;
+		}
+	}
+	vxy_sanity(other >= 0);
+
+	// Start not in the region OR Other not in the region OR some boundary vertex is in the region.
+	if (getVertexState(db, start) == In)
+	{
+		outExplanation.push_back(Literal(m_vertexVariables[start], m_notConnectedMask));
+	}
+	if (other >= 0)
+	{
+		outExplanation.push_back(Literal(m_vertexVariables[other], m_notConnectedMask));
+	}
+	for (int vertex : boundary)
+	{
+		if (m_vertexVariables[vertex].isValid())
+		{
+			outExplanation.push_back(Literal(m_vertexVariables[vertex], m_connectedMask));
+		}
+	}
+}
@@ -0,0 +1,427 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#include "constraints/DifferenceConstraint.h"
+#include "constraints/ConstraintFactoryParams.h"
+#include "variable/IVariableDatabase.h"
+
+#include <EASTL/heap.h>
+
+using namespace Vertexy;
+
+// Min-heap ordering for (key, node) pairs
+static inline bool heapCompare(const pair<int64_t, int>& lhs, const pair<int64_t, int>& rhs)
+{
+	return lhs.first > rhs.first;
+}
+
+void DifferenceEdge::fromInequality(VarID left, EConstraintOperator op, VarID right, int delta, vector<DifferenceEdge>& outEdges)
+{
+	switch (op)
+	{
+	case EConstraintOperator::LessThan:
+		outEdges.push_back({left, right, delta - 1});
+		break;
+	case EConstraintOperator::LessThanEq:
+		outEdges.push_back({left, right, delta});
+		break;
+	case EConstraintOperator::GreaterThan:
+		outEdges.push_back({right, left, -delta - 1});
+		break;
+	case EConstraintOperator::GreaterThanEq:
+		outEdges.push_back({right, left, -delta});
+		break;
+	case EConstraintOperator::Equal:
+		fromOffset(left, right, delta, outEdges);
+		break;
+	default:
+		vxy_fail_msg("Unsupported operator for difference constraint");
+		break;
+	}
+}
+
+void DifferenceEdge::fromOffset(VarID sum, VarID term, int delta, vector<DifferenceEdge>& outEdges)
+{
+	outEdges.push_back({sum, term, delta});
+	outEdges.push_back({term, sum, -delta});
+}
+
+DifferenceConstraint* DifferenceConstraint::DifferenceConstraintFactory::construct(const ConstraintFactoryParams& params, const vector<DifferenceEdge>& edges)
+{
+	return new DifferenceConstraint(params, edges);
+}
+
+DifferenceConstraint::DifferenceConstraint(const ConstraintFactoryParams& params, const vector<DifferenceEdge>& edges)
+	: IConstraint(params)
+{
+	for (auto& edge : edges)
+	{
+		// Left - Right <= Bound  =>  Left <= Right + Bound
+		const int from = getOrCreateNode(params, edge.right);
+		const int to = getOrCreateNode(params, edge.left);
+		addEdge(from, to, edge.bound);
+	}
+
+	const int numNodes = m_nodes.size();
+	for (int side = 0; side < 2; ++side)
+	{
+		m_isPending[side].resize(numNodes, false);
+	}
+	m_originBounds.resize(numNodes, 0);
+}
+
+int DifferenceConstraint::getOrCreateNode(const ConstraintFactoryParams& params, VarID variable)
+{
+	auto found = m_variableToNode.find(variable);
+	if (found != m_variableToNode.end())
+	{
+		return found->second;
+	}
+
+	const int node = m_nodes.size();
+	m_variableToNode[variable] = node;
+	m_nodes.push_back({variable, params.getDomain(variable).getMin(), INVALID_WATCHER_HANDLE, INVALID_WATCHER_HANDLE});
+	m_outEdges.emplace_back();
+	m_inEdges.emplace_back();
+	m_potentials.push_back(0);
+	m_distances.push_back(0);
+	m_origins.push_back(-1);
+	m_visitedStamps.push_back(0);
+	return node;
+}
+
+bool DifferenceConstraint::addEdge(int from, int to, int64_t weight)
+{
+	const int edgeIndex = m_edges.size();
+	m_edges.push_back({from, to, weight});
+	m_outEdges[from].push_back(edgeIndex);
+	m_inEdges[to].push_back(edgeIndex);
+
+	if (!m_negativeCycle.empty())
+	{
+		// Already infeasible; no point maintaining the potential any further.
+		return false;
+	}
+
+	// Repair the potential function so that it is feasible for the new edge. Nodes reachable from To are visited in
+	// order of how far their potential needs to drop (Distances[]), and Origins[] records the edge that lowered each.
+	// If From's potential needs to drop, the new edge closes a negative cycle.
+	int64_t delta = m_potentials[from] + weight - m_potentials[to];
+	if (delta >= 0)
+	{
+		return true;
+	}
+
+	++m_visitStamp;
+	m_visitedStamps[to] = m_visitStamp;
+	m_distances[to] = delta;
+	m_origins[to] = edgeIndex;
+
+	m_heap.clear();
+	m_heap.push_back({delta, to});
+	while (!m_heap.empty())
+	{
+		pop_heap(m_heap.begin(), m_heap.end(), heapCompare);
+		const int64_t key = m_heap.back().first;
+		const int node = m_heap.back().second;
+		m_heap.pop_back();
+
+		if (m_visitedStamps[node] != m_visitStamp || key != m_distances[node])
+		{
+			continue;
+		}
+
+		if (node == from)
+		{
+			// Walk back from From to the new edge to collect the cycle.
+			int cycleNode = from;
+			int cycleEdge;
+			do
+			{
+				cycleEdge = m_origins[cycleNode];
+				const Edge& edge = m_edges[cycleEdge];
+				m_negativeCycle.push_back({m_nodes[edge.to].variable, m_nodes[edge.from].variable, int(edge.weight)});
+				cycleNode = edge.from;
+			}
+			while (cycleEdge != edgeIndex);
+
+			m_heap.clear();
+			return false;
+		}
+
+		// Once a node is settled its potential is final, and no later relaxation can lower it further.
+		m_potentials[node] += key;
+		m_distances[node] = 0;
+
+		for (int outEdge : m_outEdges[node])
+		{
+			const Edge& edge = m_edges[outEdge];
+			const int64_t lowered = m_potentials[node] + edge.weight - m_potentials[edge.to];
+			const int64_t current = m_visitedStamps[edge.to] == m_visitStamp ? m_distances[edge.to] : 0;
+			if (lowered < current)
+			{
+				m_visitedStamps[edge.to] = m_visitStamp;
+				m_distances[edge.to] = lowered;
+				m_origins[edge.to] = outEdge;
+				m_heap.push_back({lowered, edge.to});
+				push_heap(m_heap.begin(), m_heap.end(), heapCompare);
+			}
+		}
+	}
+
+	return true;
+}
+
+vector<VarID> DifferenceConstraint::getConstrainingVariables() const
+{
+	vector<VarID> out;
+	out.reserve(m_nodes.size());
+	for (auto& node : m_nodes)
+	{
+		out.push_back(node.variable);
+	}
+	return out;
+}
+
+bool DifferenceConstraint::initialize(IVariableDatabase* db)
+{
+	if (!m_negativeCycle.empty())
+	{
+		return false;
+	}
+
+	for (int i = 0; i < m_nodes.size(); ++i)
+	{
+		Node& node = m_nodes[i];
+		// Upper bounds only matter for nodes with successors, and lower bounds only for nodes with predecessors.
+		if (!m_outEdges[i].empty())
+		{
+			node.upperBoundWatch = db->addVariableWatch(node.variable, EVariableWatchType::WatchUpperBoundChange, this);
+			if (!m_isPending[1][i])
+			{
+				m_isPending[1][i] = true;
+				m_pending[1].push_back(i);
+			}
+		}
+		if (!m_inEdges[i].empty())
+		{
+			node.lowerBoundWatch = db->addVariableWatch(node.variable, EVariableWatchType::WatchLowerBoundChange, this);
+			if (!m_isPending[0][i])
+			{
+				m_isPending[0][i] = true;
+				m_pending[0].push_back(i);
+			}
+		}
+	}
+
+	return propagate(db);
+}
+
+void DifferenceConstraint::reset(IVariableDatabase* db)
+{
+	for (auto& node : m_nodes)
+	{
+		if (node.lowerBoundWatch != INVALID_WATCHER_HANDLE)
+		{
+			db->removeVariableWatch(node.variable, node.lowerBoundWatch, this);
+			node.lowerBoundWatch = INVALID_WATCHER_HANDLE;
+		}
+		if (node.upperBoundWatch != INVALID_WATCHER_HANDLE)
+		{
+			db->removeVariableWatch(node.variable, node.upperBoundWatch, this);
+			node.upperBoundWatch = INVALID_WATCHER_HANDLE;
+		}
+	}
+}
+
+bool DifferenceConstraint::onVariableNarrowed(IVariableDatabase* db, VarID variable, const ValueSet& previousValue, bool&)
+{
+	auto found = m_variableToNode.find(variable);
+	vxy_assert(found != m_variableToNode.end());
+	const int node = found->second;
+
+	// Pending nodes are not cleared if we backtrack before propagating. That is harmless: propagating from a node
+	// whose bound didn't change just finds nothing to do.
+	const bool upperChanged = !m_outEdges[node].empty() && db->getMaximumPossibleValue(variable) != previousValue.lastIndexOf(true);
+	const bool lowerChanged = !m_inEdges[node].empty() && db->getMinimumPossibleValue(variable) != previousValue.indexOf(true);
+	for (int side = 0; side < 2; ++side)
+	{
+		if ((side == 1 ? upperChanged : lowerChanged) && !m_isPending[side][node])
+		{
+			m_isPending[side][node] = true;
+			m_pending[side].push_back(node);
+		}
+	}
+
+	if (upperChanged || lowerChanged)
+	{
+		db->queueConstraintPropagation(this);
+	}
+	return true;
+}
+
+bool DifferenceConstraint::propagate(IVariableDatabase* db)
+{
+	// Upper bounds only depend on other upper bounds, and lower bounds on other lower bounds, so each side reaches
+	// its fixpoint in a single pass.
+	return propagateBounds(db, true) && propagateBounds(db, false);
+}
+
+bool DifferenceConstraint::propagateBounds(IVariableDatabase* db, bool upper)
+{
+	const int side = upper ? 1 : 0;
+
+	// Distances are upper bounds when going forward, or negated lower bounds when going backward, so that in both
+	// cases a shorter distance is a tighter bound. Heap keys are the distances adjusted by the potential, which makes
+	// every edge weight non-negative.
+	auto getBound = [&](int node) -> int64_t
+	{
+		const Node& n = m_nodes[node];
+		return upper
+			? int64_t(n.offset) + db->getMaximumPossibleValue(n.variable)
+			: -(int64_t(n.offset) + db->getMinimumPossibleValue(n.variable));
+	};
+	auto getKey = [&](int node)
+	{
+		return m_distances[node] - (upper ? m_potentials[node] : -m_potentials[node]);
+	};
+	auto visit = [&](int node)
+	{
+		if (m_visitedStamps[node] != m_visitStamp)
+		{
+			m_visitedStamps[node] = m_visitStamp;
+			m_distances[node] = getBound(node);
+			m_origins[node] = node;
+			m_originBounds[node] = m_distances[node];
+		}
+	};
+
+	++m_visitStamp;
+	m_heap.clear();
+	for (int node : m_pending[side])
+	{
+		m_isPending[side][node] = false;
+		visit(node);
+		m_heap.push_back({getKey(node), node});
+	}
+	m_pending[side].clear();
+	make_heap(m_heap.begin(), m_heap.end(), heapCompare);
+
+	while (!m_heap.empty())
+	{
+		pop_heap(m_heap.begin(), m_heap.end(), heapCompare);
+		const int64_t key = m_heap.back().first;
+		const int node = m_heap.back().second;
+		m_heap.pop_back();
+
+		if (key != getKey(node))
+		{
+			continue;
+		}
+
+		if (m_origins[node] != node)
+		{
+			const Node& n = m_nodes[node];
+			const int origin = m_origins[node];
+			const int64_t originBound = upper ? m_originBounds[node] : -m_originBounds[node];
+			const int64_t propagatedBound = upper ? m_distances[node] : -m_distances[node];
+
+			// The narrowing is implied by the origin's bound and the (static) edges along the path.
+			auto explainer = [this, origin, originBound, node, propagatedBound, upper](const NarrowingExplanationParams& params, vector<Literal>& outExplanation)
+			{
+				outExplanation.clear();
+				if (upper)
+				{
+					outExplanation.push_back(getRangeLiteral(params.database, origin, originBound + 1, INT_MAX));
+					outExplanation.push_back(getRangeLiteral(params.database, node, INT_MIN, propagatedBound));
+				}
+				else
+				{
+					outExplanation.push_back(getRangeLiteral(params.database, origin, INT_MIN, originBound - 1));
+					outExplanation.push_back(getRangeLiteral(params.database, node, propagatedBound, INT_MAX));
+				}
+			};
+
+			if (upper)
+			{
+				const int64_t maxIndex = propagatedBound - n.offset;
+				if (!db->excludeValuesGreaterThan(n.variable, int(max(maxIndex, int64_t(-1))), this, explainer))
+				{
+					return false;
+				}
+			}
+			else
+			{
+				const int64_t minIndex = propagatedBound - n.offset;
+				const int domainSize = db->getDomainSize(n.variable);
+				if (!db->excludeValuesLessThan(n.variable, int(min(minIndex, int64_t(domainSize))), this, explainer))
+				{
+					return false;
+				}
+			}
+
+			// If the bound landed in a hole, the variable is now tighter than the path implies.
+			const int64_t newBound = getBound(node);
+			if (newBound < m_distances[node])
+			{
+				m_distances[node] = newBound;
+				m_origins[node] = node;
+				m_originBounds[node] = newBound;
+			}
+		}
+
+		const vector<int>& edges = upper ? m_outEdges[node] : m_inEdges[node];
+		for (int edgeIndex : edges)
+		{
+			const Edge& edge = m_edges[edgeIndex];
+			const int next = upper ? edge.to : edge.from;
+			visit(next);
+
+			const int64_t candidate = m_distances[node] + edge.weight;
+			if (candidate < m_distances[next])
+			{
+				m_distances[next] = candidate;
+				m_origins[next] = m_origins[node];
+				m_originBounds[next] = m_originBounds[node];
+				m_heap.push_back({getKey(next), next});
+				push_heap(m_heap.begin(), m_heap.end(), heapCompare);
+			}
+		}
+	}
+
+	return true;
+}
+
+Literal DifferenceConstraint::getRangeLiteral(const IVariableDatabase* db, int node, int64_t minValue, int64_t maxValue) const
+{
+	const Node& n = m_nodes[node];
+	const int domainSize = db->getDomainSize(n.variable);
+	const int64_t minIndex = max(minValue - n.offset, int64_t(0));
+	const int64_t maxIndex = min(maxValue - n.offset, int64_t(domainSize - 1));
+
+	ValueSet values(domainSize, false);
+	if (minIndex <= maxIndex)
+	{
+		values.setRange(int(minIndex), int(maxIndex) + 1, true);
+	}
+	return Literal(n.variable, move(values));
+}
+
+bool DifferenceConstraint::checkConflicting(IVariableDatabase* db) const
+{
+	if (!m_negativeCycle.empty())
+	{
+		return true;
+	}
+
+	for (auto& edge : m_edges)
+	{
+		const Node& from = m_nodes[edge.from];
+		const Node& to = m_nodes[edge.to];
+		const int64_t toMin = int64_t(to.offset) + db->getMinimumPossibleValue(to.variable);
+		const int64_t fromMax = int64_t(from.offset) + db->getMaximumPossibleValue(from.variable);
+		if (toMin > fromMax + edge.weight)
+		{
+			return true;
+		}
+	}
+	return false;
+}
@@ -1,5 +1,6 @@
 // Copyright Proletariat, Inc. All Rights Reserved.
 #include "constraints/DisjunctionConstraint.h"
+#include "ConstraintSolver.h"
 #include "constraints/ConstraintFactoryParams.h"
 #include "constraints/ClauseConstraint.h"
 #include "variable/CommittableVariableDatabase.h"
@@ -9,60 +10,74 @@ using namespace Vertexy;
 
 DisjunctionConstraint* DisjunctionConstraint::Factory::construct(const ConstraintFactoryParams& params, IConstraint* innerConsA, IConstraint* innerConsB)
 {
-	params.markChildConstraint(innerConsA);
-	params.markChildConstraint(innerConsB);
-	return new DisjunctionConstraint(params, innerConsA, innerConsB);
+	return construct(params, vector<IConstraint*>{innerConsA, innerConsB});
 }
 
-DisjunctionConstraint::DisjunctionConstraint(const ConstraintFactoryParams& params, IConstraint* innerConsA, IConstraint* innerConsB)
-	: IBacktrackingSolverConstraint(params)
-	, m_innerCons{innerConsA, innerConsB}
-	, m_fullySatLevel{-1,-1}
-	, m_constraintQueued{false,false}
-	, m_lastPropagation{-1,-1}
+DisjunctionConstraint* DisjunctionConstraint::Factory::construct(const ConstraintFactoryParams& params, const vector<IConstraint*>& innerCons)
 {
+	vxy_assert_msg(!innerCons.empty(), "Disjunction requires at least one constraint");
+	for (IConstraint* cons : innerCons)
+	{
+		params.markChildConstraint(cons);
+	}
+	return new DisjunctionConstraint(params, innerCons);
 }
 
-vector<VarID> DisjunctionConstraint::getConstrainingVariables() const
+DisjunctionConstraint::DisjunctionConstraint(const ConstraintFactoryParams& params, const vector<IConstraint*>& innerCons)
+	: IBacktrackingSolverConstraint(params)
+	, m_sentinels{-1, -1}
 {
-	auto vars = m_innerCons[0]->getConstrainingVariables();
-	auto otherVars = m_innerCons[1]->getConstrainingVariables();
-	for (VarID var : otherVars)
+	m_alternatives.resize(innerCons.size());
+	for (int i = 0; i < innerCons.size(); ++i)
 	{
-		if (!contains(vars.begin(), vars.end(), var))
-		{
-			vars.push_back(var);
-		}
+		m_alternatives[i].constraint = innerCons[i];
 	}
-	return vars;
 }
 
-bool DisjunctionConstraint::initialize(IVariableDatabase* db)
+vector<VarID> DisjunctionConstraint::getConstrainingVariables() const
 {
-	for (int i = 0; i < 2; ++i)
+	vector<VarID> vars;
+	for (const Alternative& alt : m_alternatives)
 	{
-		auto cdb = createCommittableDB(db, i);
-		if (!m_innerCons[i]->initialize(&cdb, this))
+		for (VarID var : alt.constraint->getConstrainingVariables())
 		{
-			if (!markUnsat(cdb, i))
+			if (!contains(vars.begin(), vars.end(), var))
 			{
-				return false;
+				vars.push_back(var);
 			}
 		}
 	}
-	return true;
+	return vars;
+}
+
+bool DisjunctionConstraint::initialize(IVariableDatabase* db)
+{
+	// Only the sentinels are initialized here. The rest are initialized when they are first needed.
+	return updateSentinels(db);
 }
 
 void DisjunctionConstraint::reset(IVariableDatabase* db)
 {
-	for (int i = 0; i < 2; ++i)
+	for (int i = 0; i < m_alternatives.size(); ++i)
 	{
-		m_sinkWrappers[i].clear();
-		m_unsatInfo[i].reset();
-		m_constraintQueued[i] = false;
-		m_lastPropagation[i] = -1;
-		m_fullySatLevel[i] = -1;
+		Alternative& alt = m_alternatives[i];
+		if (alt.initLevel >= 0)
+		{
+			auto cdb = createCommittableDB(db, i);
+			alt.constraint->reset(cdb.get());
+		}
+
+		alt.sinkWrappers.clear();
+		alt.unsatInfo.reset();
+		alt.fullySatLevel = -1;
+		alt.initLevel = -1;
+		alt.constraintQueued = false;
+		alt.lastPropagation = -1;
 	}
+
+	m_sentinels[0] = m_sentinels[1] = -1;
+	m_unitLevel = -1;
+	m_sentinelTrail.clear();
 }
 
 bool DisjunctionConstraint::onVariableNarrowed(IVariableDatabase* db, VarID variable, const ValueSet& previousValue, bool& removeWatch)
@@ -73,123 +88,256 @@ bool DisjunctionConstraint::onVariableNarrowed(IVariableDatabase* db, VarID vari
 
 bool DisjunctionConstraint::forwardVariableNarrowed(IVariableDatabase* db, IVariableWatchSink* innerSink, int innerConsIndex, VarID var, const ValueSet& previousValue, bool& removeHandle)
 {
-	vxy_sanity(innerConsIndex == 0 || innerConsIndex == 1);
-	int otherConsIndex = innerConsIndex == 0 ? 1 : 0;
-	if (!m_unsatInfo[innerConsIndex].isUnsat() && m_fullySatLevel[otherConsIndex] < 0)
+	Alternative& alt = m_alternatives[innerConsIndex];
+
+	if (isSatisfied())
 	{
-		m_lastPropagation[innerConsIndex] = db->getTimestamp();
+		return true;
+	}
 
-		auto cdb = createCommittableDB(db, innerConsIndex);
-		if (!innerSink->onVariableNarrowed(&cdb, var, previousValue, removeHandle))
-		{
-			return markUnsat(cdb, innerConsIndex);
-		}
+	// A sentinel slot may have been emptied by backtracking. Refill it on any notification, even one for a dormant
+	// alternative, so that we don't wait for a watch on the remaining sentinel to fire before propagating.
+	const bool wasSentinel = isSentinel(innerConsIndex);
+	const bool wasUnit = m_unitLevel >= 0;
+	if (!updateSentinels(db))
+	{
+		return false;
 	}
-	else
+	else if (!wasSentinel || (!wasUnit && m_unitLevel >= 0))
 	{
-		vxy_sanity(m_fullySatLevel[otherConsIndex] < 0 || !m_innerCons[otherConsIndex]->checkConflicting(db));
+		// Dormant alternatives are rebuilt from scratch when woken, so they can ignore narrowings until then.
+		// If we're now the only alternative left, we were just rebuilt against the current state.
+		return true;
 	}
+	vxy_assert(!alt.unsatInfo.isUnsat());
 
-	vxy_sanity(!m_unsatInfo[0].isUnsat() || !m_unsatInfo[1].isUnsat());
+	alt.lastPropagation = db->getTimestamp();
+
+	auto cdb = createCommittableDB(db, innerConsIndex);
+	if (!innerSink->onVariableNarrowed(cdb.get(), var, previousValue, removeHandle) || alt.unsatInfo.isUnsat())
+	{
+		markUnsat(*cdb, innerConsIndex);
+		return onSentinelUnsat(db, innerConsIndex);
+	}
 	return true;
 }
 
 bool DisjunctionConstraint::propagate(IVariableDatabase* db)
 {
-	for (int i = 0; i < 2; ++i)
+	if (!updateSentinels(db))
 	{
-		int oi = i == 0 ? 1 : 0;
-		if (m_constraintQueued[i] && !m_unsatInfo[i].isUnsat() && m_fullySatLevel[oi] < 0)
+		return false;
+	}
+
+	for (int slot = 0; slot < 2; ++slot)
+	{
+		const int innerConsIndex = m_sentinels[slot];
+		if (innerConsIndex < 0)
+		{
+			continue;
+		}
+
+		Alternative& alt = m_alternatives[innerConsIndex];
+		if (alt.constraintQueued && !isSatisfied())
 		{
-			auto cdb = createCommittableDB(db, 0);
-			if (!m_innerCons[i]->propagate(&cdb))
+			alt.constraintQueued = false;
+
+			auto cdb = createCommittableDB(db, innerConsIndex);
+			if (!alt.constraint->propagate(cdb.get()) || alt.unsatInfo.isUnsat())
 			{
-				if (!markUnsat(cdb, i))
+				markUnsat(*cdb, innerConsIndex);
+				if (!onSentinelUnsat(db, innerConsIndex))
 				{
 					return false;
 				}
 			}
 		}
-		else
+	}
+
+	for (Alternative& alt : m_alternatives)
+	{
+		alt.constraintQueued = false;
+	}
+	return true;
+}
+
+void DisjunctionConstraint::backtrack(const IVariableDatabase* db, SolverDecisionLevel level)
+{
+	for (Alternative& alt : m_alternatives)
+	{
+		alt.constraintQueued = false;
+		if (alt.unsatInfo.level > level)
+		{
+			alt.unsatInfo.reset();
+		}
+		if (alt.fullySatLevel > level)
+		{
+			alt.fullySatLevel = -1;
+		}
+	}
+
+	while (!m_sentinelTrail.empty() && m_sentinelTrail.back().level > level)
+	{
+		m_sentinels[0] = m_sentinelTrail.back().sentinels[0];
+		m_sentinels[1] = m_sentinelTrail.back().sentinels[1];
+		m_sentinelTrail.pop_back();
+	}
+
+	if (m_unitLevel > level)
+	{
+		m_unitLevel = -1;
+	}
+
+	// A sentinel that was re-initialized after this level is now out of date. Leave its slot empty: it will be
+	// filled again the next time we're notified.
+	for (int slot = 0; slot < 2; ++slot)
+	{
+		if (m_sentinels[slot] >= 0 && m_alternatives[m_sentinels[slot]].initLevel > level)
 		{
-			vxy_sanity(m_fullySatLevel[oi] < 0 || !m_innerCons[oi]->checkConflicting(db));
+			m_sentinels[slot] = -1;
 		}
-		m_constraintQueued[i] = false;
 	}
+}
+
+bool DisjunctionConstraint::wakeAlternative(IVariableDatabase* db, int innerConsIndex)
+{
+	Alternative& alt = m_alternatives[innerConsIndex];
+	vxy_assert(!alt.unsatInfo.isUnsat());
+
+	auto cdb = createCommittableDB(db, innerConsIndex);
+	if (alt.initLevel >= 0)
+	{
+		// The alternative has been ignoring narrowings, so rebuild it.
+		alt.constraint->reset(cdb.get());
+	}
+
+	alt.initLevel = db->getDecisionLevel();
+	alt.fullySatLevel = -1;
+	alt.constraintQueued = false;
+	alt.lastPropagation = db->getTimestamp();
 
+	if (!alt.constraint->initialize(cdb.get(), this) || alt.unsatInfo.isUnsat())
+	{
+		markUnsat(*cdb, innerConsIndex);
+		return false;
+	}
 	return true;
 }
 
-void DisjunctionConstraint::backtrack(const IVariableDatabase* db, SolverDecisionLevel level)
+bool DisjunctionConstraint::onSentinelUnsat(IVariableDatabase* db, int innerConsIndex)
 {
-	for (int i = 0; i < 2; ++i)
+	const int slot = m_sentinels[0] == innerConsIndex ? 0 : 1;
+	vxy_assert(m_sentinels[slot] == innerConsIndex);
+	setSentinel(db, slot, -1);
+
+	return updateSentinels(db);
+}
+
+bool DisjunctionConstraint::updateSentinels(IVariableDatabase* db)
+{
+	for (int slot = 0; slot < 2; ++slot)
 	{
-		m_constraintQueued[i] = false;
-		if (m_unsatInfo[i].level > level)
+		if (m_sentinels[slot] >= 0)
+		{
+			continue;
+		}
+
+		for (int i = 0; i < m_alternatives.size(); ++i)
 		{
-			m_unsatInfo[i].reset();
+			if (!isSentinel(i) && !m_alternatives[i].unsatInfo.isUnsat() && wakeAlternative(db, i))
+			{
+				setSentinel(db, slot, i);
+				break;
+			}
 		}
-		if (m_fullySatLevel[i] > level)
+	}
+
+	if (m_sentinels[0] < 0 && m_sentinels[1] < 0)
+	{
+		// Every alternative is unsatisfiable.
+		return false;
+	}
+
+	if ((m_sentinels[0] < 0 || m_sentinels[1] < 0) && m_unitLevel < 0)
+	{
+		// Every other alternative is unsatisfiable, so this one must hold. Rebuild it with changes committed, so that
+		// anything it previously inferred speculatively makes it into the database.
+		const int slot = m_sentinels[0] >= 0 ? 0 : 1;
+		m_unitLevel = db->getDecisionLevel();
+		if (!wakeAlternative(db, m_sentinels[slot]))
 		{
-			m_fullySatLevel[i] = -1;
+			setSentinel(db, slot, -1);
+			return false;
 		}
 	}
+
+	return true;
 }
 
-void DisjunctionConstraint::explain(const NarrowingExplanationParams& params, vector<Literal>& outExplanation) const
+void DisjunctionConstraint::setSentinel(IVariableDatabase* db, int slot, int innerConsIndex)
 {
-	vxy_assert(m_unsatInfo[0].isUnsat() && m_unsatInfo[1].isUnsat());
+	// Changes at level 0 are permanent.
+	const SolverDecisionLevel level = db->getDecisionLevel();
+	if (level > 0 && (m_sentinelTrail.empty() || m_sentinelTrail.back().level != level))
+	{
+		m_sentinelTrail.push_back({level, {m_sentinels[0], m_sentinels[1]}});
+	}
+	m_sentinels[slot] = innerConsIndex;
+}
 
+void DisjunctionConstraint::explain(const NarrowingExplanationParams& params, vector<Literal>& outExplanation) const
+{
 	outExplanation.clear();
-	outExplanation.reserve(m_unsatInfo[0].explanation.size() + m_unsatInfo[1].explanation.size());
-	outExplanation.insert(outExplanation.end(), m_unsatInfo[0].explanation.begin(), m_unsatInfo[0].explanation.end());
-	outExplanation.insert(outExplanation.end(), m_unsatInfo[1].explanation.begin(), m_unsatInfo[1].explanation.end());
+	for (const Alternative& alt : m_alternatives)
+	{
+		vxy_assert(alt.unsatInfo.isUnsat());
+		outExplanation.insert(outExplanation.end(), alt.unsatInfo.explanation.begin(), alt.unsatInfo.explanation.end());
+	}
 }
 
 bool DisjunctionConstraint::checkConflicting(IVariableDatabase* db) const
 {
-	if (m_innerCons[0]->checkConflicting(db) && m_innerCons[1]->checkConflicting(db))
+	for (const Alternative& alt : m_alternatives)
 	{
-		return true;
+		if (!alt.constraint->checkConflicting(db))
+		{
+			return false;
+		}
 	}
-	return false;
+	return true;
 }
 
-bool DisjunctionConstraint::markUnsat(const CommittableVariableDatabase& cdb, int innerConsIndex, VarID contradictingVar, const ExplainerFunction& explainer)
+void DisjunctionConstraint::markUnsat(const CommittableVariableDatabase& cdb, int innerConsIndex, VarID contradictingVar, const ExplainerFunction& explainer)
 {
-	vxy_sanity(innerConsIndex == 0 || innerConsIndex == 1);
-	vxy_assert(m_fullySatLevel[innerConsIndex] < 0);
-	if (!m_unsatInfo[innerConsIndex].isUnsat())
+	Alternative& alt = m_alternatives[innerConsIndex];
+	vxy_assert(alt.fullySatLevel < 0);
+	if (!alt.unsatInfo.isUnsat())
 	{
 		vector<Literal> literals;
-		HistoricalVariableDatabase hdb(&cdb, m_lastPropagation[innerConsIndex]);
+		HistoricalVariableDatabase hdb(&cdb, alt.lastPropagation);
 		vxy_assert(!contradictingVar.isValid() || cdb.getPotentialValues(contradictingVar).isZero());
 
-		vxy_assert(m_lastPropagation[innerConsIndex] >= 0);
-		NarrowingExplanationParams explParams(cdb.getSolver(), &hdb, m_innerCons[innerConsIndex], contradictingVar, cdb.getPotentialValues(contradictingVar).isZero(), m_lastPropagation[innerConsIndex]);
+		vxy_assert(alt.lastPropagation >= 0);
+		NarrowingExplanationParams explParams(cdb.getSolver(), &hdb, alt.constraint, contradictingVar, cdb.getPotentialValues(contradictingVar).isZero(), alt.lastPropagation);
 		if (explainer != nullptr)
 		{
 			explainer(explParams, literals);
 		}
 		else
 		{
-			m_innerCons[innerConsIndex]->explain(explParams, literals);
+			alt.constraint->explain(explParams, literals);
 		}
 
-		m_unsatInfo[innerConsIndex].markUnsat(cdb.getDecisionLevel(), literals);
+		alt.unsatInfo.markUnsat(cdb.getDecisionLevel(), literals);
 	}
-	bool result = !m_unsatInfo[0].isUnsat() || !m_unsatInfo[1].isUnsat();
-	return result;
 }
 
-CommittableVariableDatabase DisjunctionConstraint::createCommittableDB(IVariableDatabase* db, int innerConsIndex)
+CommittableVariableDatabaseArena::Scope DisjunctionConstraint::createCommittableDB(IVariableDatabase* db, int innerConsIndex)
 {
-	vxy_sanity(innerConsIndex == 0 || innerConsIndex == 1);
-	CommittableVariableDatabase cdb(db, this, this, innerConsIndex);
-	int otherConsIndex = (innerConsIndex == 0) ? 1 : 0;
-	if (m_unsatInfo[otherConsIndex].isUnsat())
+	auto cdb = db->getSolver()->getScratchDatabaseArena().acquire(db, this, this, innerConsIndex);
+	if (m_unitLevel >= 0 && isSentinel(innerConsIndex))
 	{
-		cdb.commitPastAndFutureChanges();
+		cdb->commitPastAndFutureChanges();
 	}
 	return cdb;
 }
@@ -197,20 +345,19 @@ CommittableVariableDatabase DisjunctionConstraint::createCommittableDB(IVariable
 void DisjunctionConstraint::committableDatabaseContradictionFound(const CommittableVariableDatabase& db, VarID varID, IConstraint* source, const ExplainerFunction& explainer)
 {
 	const int innerConsIndex = db.getOuterSinkID();
-	vxy_sanity(innerConsIndex == 0 || innerConsIndex == 1);
-	vxy_sanity(source == m_innerCons[innerConsIndex]);
+	vxy_sanity(source == m_alternatives[innerConsIndex].constraint);
 
 	markUnsat(db, innerConsIndex, varID, explainer);
 }
 
 WatcherHandle DisjunctionConstraint::committableDatabaseAddWatchRequest(const CommittableVariableDatabase& db, VarID varID, EVariableWatchType watchType, IVariableWatchSink* sink)
 {
-	int innerConsIdx = db.getOuterSinkID();
-	vxy_sanity(innerConsIdx == 0 || innerConsIdx == 1);
-	auto it = m_sinkWrappers[innerConsIdx].find(sink);
-	if (it == m_sinkWrappers[innerConsIdx].end())
+	const int innerConsIdx = db.getOuterSinkID();
+	auto& sinkWrappers = m_alternatives[innerConsIdx].sinkWrappers;
+	auto it = sinkWrappers.find(sink);
+	if (it == sinkWrappers.end())
 	{
-		it = m_sinkWrappers[innerConsIdx].insert(make_pair(sink, make_unique<SinkWrapper>(this, sink, innerConsIdx))).first;
+		it = sinkWrappers.insert(make_pair(sink, make_unique<SinkWrapper>(this, sink, innerConsIdx))).first;
 	}
 	WatcherHandle handle = db.getParent()->addVariableWatch(varID, watchType, it->second.get());
 	it->second->handles.push_back(make_tuple(handle, varID));
@@ -219,12 +366,12 @@ WatcherHandle DisjunctionConstraint::committableDatabaseAddWatchRequest(const Co
 
 WatcherHandle DisjunctionConstraint::committableDatabaseAddValueWatchRequest(const CommittableVariableDatabase& db, VarID varID, const ValueSet& values, IVariableWatchSink* sink)
 {
-	int innerConsIdx = db.getOuterSinkID();
-	vxy_sanity(innerConsIdx == 0 || innerConsIdx == 1);
-	auto it = m_sinkWrappers[innerConsIdx].find(sink);
-	if (it == m_sinkWrappers[innerConsIdx].end())
+	const int innerConsIdx = db.getOuterSinkID();
+	auto& sinkWrappers = m_alternatives[innerConsIdx].sinkWrappers;
+	auto it = sinkWrappers.find(sink);
+	if (it == sinkWrappers.end())
 	{
-		it = m_sinkWrappers[innerConsIdx].insert(make_pair(sink, make_unique<SinkWrapper>(this, sink, innerConsIdx))).first;
+		it = sinkWrappers.insert(make_pair(sink, make_unique<SinkWrapper>(this, sink, innerConsIdx))).first;
 	}
 	WatcherHandle handle = db.getParent()->addVariableValueWatch(varID, values, it->second.get());
 	it->second->handles.push_back(make_tuple(handle, varID));
@@ -233,10 +380,9 @@ WatcherHandle DisjunctionConstraint::committableDatabaseAddValueWatchRequest(con
 
 void DisjunctionConstraint::committableDatabaseDisableWatchRequest(const CommittableVariableDatabase& db, WatcherHandle handle, VarID variable, IVariableWatchSink* sink)
 {
-	int innerConsIdx = db.getOuterSinkID();
-	vxy_sanity(innerConsIdx == 0 || innerConsIdx == 1);
-	auto it = m_sinkWrappers[innerConsIdx].find(sink);
-	if (it != m_sinkWrappers[innerConsIdx].end())
+	auto& sinkWrappers = m_alternatives[db.getOuterSinkID()].sinkWrappers;
+	auto it = sinkWrappers.find(sink);
+	if (it != sinkWrappers.end())
 	{
 		return db.getParent()->disableWatcherUntilBacktrack(handle, variable, it->second.get());
 	}
@@ -244,10 +390,9 @@ void DisjunctionConstraint::committableDatabaseDisableWatchRequest(const Committ
 
 void DisjunctionConstraint::committableDatabaseRemoveWatchRequest(const CommittableVariableDatabase& db, VarID varID, WatcherHandle handle, IVariableWatchSink* sink)
 {
-	int innerConsIdx = db.getOuterSinkID();
-	vxy_sanity(innerConsIdx == 0 || innerConsIdx == 1);
-	auto it = m_sinkWrappers[innerConsIdx].find(sink);
-	if (it != m_sinkWrappers[innerConsIdx].end())
+	auto& sinkWrappers = m_alternatives[db.getOuterSinkID()].sinkWrappers;
+	auto it = sinkWrappers.find(sink);
+	if (it != sinkWrappers.end())
 	{
 		db.getParent()->removeVariableWatch(varID, handle, it->second.get());
 		it->second->handles.erase_first_unsorted(make_tuple(handle, varID));
@@ -265,39 +410,53 @@ ExplainerFunction DisjunctionConstraint::committableDatabaseWrapExplanation(cons
 
 void DisjunctionConstraint::committableDatabaseConstraintSatisfied(const CommittableVariableDatabase& db, IConstraint* constraint)
 {
-	vxy_sanity(constraint == m_innerCons[0] || constraint == m_innerCons[1]);
-	int innerConsIndex = constraint == m_innerCons[0] ? 0 : 1;
-	vxy_assert(!m_unsatInfo[innerConsIndex].isUnsat());
-	if (m_fullySatLevel[innerConsIndex] < 0)
+	Alternative& alt = m_alternatives[db.getOuterSinkID()];
+	vxy_sanity(constraint == alt.constraint);
+	vxy_assert(!alt.unsatInfo.isUnsat());
+	if (alt.fullySatLevel < 0)
 	{
-		m_fullySatLevel[innerConsIndex] = db.getDecisionLevel();
+		alt.fullySatLevel = db.getDecisionLevel();
 	}
 }
 
 void DisjunctionConstraint::committableDatabaseQueueRequest(const CommittableVariableDatabase& db, IConstraint* cons)
 {
-	vxy_sanity(cons == m_innerCons[0] || cons == m_innerCons[1]);
-	int innerConsIndex = cons == m_innerCons[0] ? 0 : 1;
-	m_constraintQueued[innerConsIndex] = true;
+	Alternative& alt = m_alternatives[db.getOuterSinkID()];
+	vxy_sanity(cons == alt.constraint);
+	alt.constraintQueued = true;
 	db.getParent()->queueConstraintPropagation(this);
 }
 
 void DisjunctionConstraint::explainInner(const NarrowingExplanationParams& params, int innerConsIndex, const ExplainerFunction& innerExpl, vector<Literal>& outExplanation) const
 {
-	vxy_sanity(innerConsIndex == 0 || innerConsIndex == 1);
-	int otherConsIndex = (innerConsIndex == 0) ? 1 : 0;
-	vxy_assert(m_unsatInfo[otherConsIndex].isUnsat());
+	const Alternative& alt = m_alternatives[innerConsIndex];
 
-	vector<Literal> expl;
-	if (auto clauseCons = m_innerCons[innerConsIndex]->asClauseConstraint())
+	outExplanation.clear();
+	if (auto clauseCons = alt.constraint->asClauseConstraint())
 	{
-		clauseCons->getLiteralsCopy(expl);
+		clauseCons->getLiteralsCopy(outExplanation);
 	}
 	else
 	{
-		NarrowingExplanationParams explParams(params.solver, params.database, m_innerCons[innerConsIndex], params.propagatedVariable, params.propagatedValues, params.timestamp);
-		innerExpl(explParams, expl);
+		NarrowingExplanationParams explParams(params.solver, params.database, alt.constraint, params.propagatedVariable, params.propagatedValues, params.timestamp);
+		if (innerExpl != nullptr)
+		{
+			innerExpl(explParams, outExplanation);
+		}
+		else
+		{
+			alt.constraint->explain(explParams, outExplanation);
+		}
+	}
+
+	// The narrowing only holds because every other alternative is unsatisfiable.
+	for (int i = 0; i < m_alternatives.size(); ++i)
+	{
+		if (i != innerConsIndex)
+		{
+			vxy_assert(m_alternatives[i].unsatInfo.isUnsat());
+			const vector<Literal>& otherExpl = m_alternatives[i].unsatInfo.explanation;
+			outExplanation.insert(outExplanation.end(), otherExpl.begin(), otherExpl.end());
+		}
 	}
-	expl.reserve(expl.size() + m_unsatInfo[otherConsIndex].explanation.size());
-	expl.insert(expl.end(), m_unsatInfo[otherConsIndex].explanation.begin(), m_unsatInfo[otherConsIndex].explanation.end());
 }
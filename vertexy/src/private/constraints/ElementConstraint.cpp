@@ -0,0 +1,389 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#include "constraints/ElementConstraint.h"
+#include "constraints/ConstraintFactoryParams.h"
+#include "variable/IVariableDatabase.h"
+
+using namespace Vertexy;
+
+// Add a literal to an explanation, merging it with any existing literal for the same variable.
+static void addExplanationLiteral(vector<Literal>& outExplanation, VarID var, const ValueSet& values)
+{
+	if (values.isZero())
+	{
+		return;
+	}
+
+	for (auto& lit : outExplanation)
+	{
+		if (lit.variable == var)
+		{
+			lit.values.include(values);
+			return;
+		}
+	}
+	outExplanation.push_back(Literal(var, values));
+}
+
+ElementConstraint* ElementConstraint::ElementConstraintFactory::construct(const ConstraintFactoryParams& params, VarID result, VarID index, const vector<VarID>& array)
+{
+	int minValue = params.getDomain(result).getMin();
+	int maxValue = params.getDomain(result).getMax();
+	for (VarID var : array)
+	{
+		if (var.isValid())
+		{
+			minValue = min(minValue, params.getDomain(var).getMin());
+			maxValue = max(maxValue, params.getDomain(var).getMax());
+		}
+	}
+
+	vector<Entry> entries;
+	entries.reserve(array.size());
+	for (VarID var : array)
+	{
+		entries.push_back({var, var.isValid() ? params.getDomain(var).getMin() - minValue : -1});
+	}
+
+	return new ElementConstraint(params, result, index, entries, minValue, maxValue - minValue + 1);
+}
+
+ElementConstraint* ElementConstraint::ElementConstraintFactory::construct(const ConstraintFactoryParams& params, VarID result, VarID index, const vector<int>& constants)
+{
+	// Constants outside of the result's domain can never be selected.
+	const SolverVariableDomain& resultDomain = params.getDomain(result);
+
+	vector<Entry> entries;
+	entries.reserve(constants.size());
+	for (int constant : constants)
+	{
+		int position;
+		if (!resultDomain.getIndexForValue(constant, position))
+		{
+			position = -1;
+		}
+		entries.push_back({VarID::INVALID, position});
+	}
+
+	return new ElementConstraint(params, result, index, entries, resultDomain.getMin(), resultDomain.getDomainSize());
+}
+
+ElementConstraint::ElementConstraint(const ConstraintFactoryParams& params, VarID result, VarID index, const vector<Entry>& entries, int minValue, int numValues)
+	: IConstraint(params)
+	, m_result(result)
+	, m_index(index)
+	, m_entries(entries)
+	, m_indexMin(params.getDomain(index).getMin())
+	, m_minValue(minValue)
+	, m_numValues(numValues)
+	, m_resultPosition(params.getDomain(result).getMin() - minValue)
+{
+	bool anyMissing = false;
+	for (int i = 0; i < m_entries.size(); ++i)
+	{
+		if (m_entries[i].variable.isValid())
+		{
+			m_variableEntries[m_entries[i].variable].push_back(i);
+		}
+		else if (m_entries[i].position < 0)
+		{
+			anyMissing = true;
+		}
+	}
+
+	// Missing entries are neighbors outside of the topology. Which neighbors exist depends on the vertex, so graph-based
+	// learning can't be applied. (Constants outside of the result's domain are the same for every vertex, so don't
+	// matter.)
+	if (anyMissing && m_graphRelationInfo != nullptr)
+	{
+		m_graphRelationInfo->invalidate();
+	}
+}
+
+vector<VarID> ElementConstraint::getConstrainingVariables() const
+{
+	vector<VarID> out = {m_result, m_index};
+	for (auto& entry : m_entries)
+	{
+		if (entry.variable.isValid() && !contains(out.begin(), out.end(), entry.variable))
+		{
+			out.push_back(entry.variable);
+		}
+	}
+	return out;
+}
+
+bool ElementConstraint::initialize(IVariableDatabase* db)
+{
+	for (VarID var : getConstrainingVariables())
+	{
+		m_watches.push_back(make_tuple(var, db->addVariableWatch(var, EVariableWatchType::WatchModification, this)));
+	}
+	return propagate(db);
+}
+
+void ElementConstraint::reset(IVariableDatabase* db)
+{
+	for (auto& watch : m_watches)
+	{
+		db->removeVariableWatch(get<0>(watch), get<1>(watch), this);
+	}
+	m_watches.clear();
+}
+
+bool ElementConstraint::onVariableNarrowed(IVariableDatabase* db, VarID variable, const ValueSet&, bool&)
+{
+	if (variable != m_result && variable != m_index)
+	{
+		// An array variable only matters if the index can still select it.
+		auto found = m_variableEntries.find(variable);
+		vxy_assert(found != m_variableEntries.end());
+
+		const ValueSet& indexValues = db->getPotentialValues(m_index);
+		bool selectable = false;
+		for (int entry : found->second)
+		{
+			const int indexValue = entry - m_indexMin;
+			if (indexValue >= 0 && indexValue < indexValues.size() && indexValues[indexValue])
+			{
+				selectable = true;
+				break;
+			}
+		}
+
+		if (!selectable)
+		{
+			return true;
+		}
+	}
+
+	db->queueConstraintPropagation(this);
+	return true;
+}
+
+bool ElementConstraint::propagate(IVariableDatabase* db)
+{
+	getAxisValues(db, m_result, m_resultPosition, m_resultValues);
+	m_supportedValues.init(m_numValues, false);
+
+	//
+	// Remove any index values that select an entry sharing no values with the result, and collect the values of the
+	// entries that remain.
+	//
+
+	const ValueSet& indexValues = db->getPotentialValues(m_index);
+	ValueSet removedIndices(indexValues.size(), false);
+	int selectedEntry = -1;
+	int numSelectable = 0;
+	for (auto it = indexValues.beginSetBits(), itEnd = indexValues.endSetBits(); it != itEnd; ++it)
+	{
+		const int entry = getEntryForIndex(*it);
+		if (entry < 0 || !getEntryValues(db, entry, m_entryValues) || !m_entryValues.anyPossible(m_resultValues))
+		{
+			removedIndices[*it] = true;
+			continue;
+		}
+
+		m_supportedValues.include(m_entryValues);
+		selectedEntry = entry;
+		++numSelectable;
+	}
+
+	if (!removedIndices.isZero())
+	{
+		if (!db->excludeValues(m_index, removedIndices, this, makeExplainer(ERule::Index)))
+		{
+			return false;
+		}
+	}
+
+	if (!db->constrainToValues(m_result, toVariableValues(db, m_result, m_resultPosition, m_supportedValues), this, makeExplainer(ERule::Result)))
+	{
+		return false;
+	}
+
+	//
+	// If only one entry can be selected, it must equal the result.
+	//
+
+	if (numSelectable == 1 && m_entries[selectedEntry].variable.isValid())
+	{
+		const Entry& selected = m_entries[selectedEntry];
+		getAxisValues(db, m_result, m_resultPosition, m_resultValues);
+		if (!db->constrainToValues(selected.variable, toVariableValues(db, selected.variable, selected.position, m_resultValues), this, makeExplainer(ERule::Entry, selectedEntry)))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool ElementConstraint::checkConflicting(IVariableDatabase* db) const
+{
+	ValueSet resultValues, entryValues;
+	getAxisValues(db, m_result, m_resultPosition, resultValues);
+
+	const ValueSet& indexValues = db->getPotentialValues(m_index);
+	for (auto it = indexValues.beginSetBits(), itEnd = indexValues.endSetBits(); it != itEnd; ++it)
+	{
+		const int entry = getEntryForIndex(*it);
+		if (entry >= 0 && getEntryValues(db, entry, entryValues) && entryValues.anyPossible(resultValues))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int ElementConstraint::getEntryForIndex(int indexValue) const
+{
+	const int entry = m_indexMin + indexValue;
+	return entry >= 0 && entry < m_entries.size() ? entry : -1;
+}
+
+void ElementConstraint::getAxisValues(const IVariableDatabase* db, VarID var, int position, ValueSet& outValues) const
+{
+	outValues.init(m_numValues, false);
+	const ValueSet& values = db->getPotentialValues(var);
+	for (auto it = values.beginSetBits(), itEnd = values.endSetBits(); it != itEnd; ++it)
+	{
+		outValues[position + *it] = true;
+	}
+}
+
+ValueSet ElementConstraint::toVariableValues(const IVariableDatabase* db, VarID var, int position, const ValueSet& axisValues) const
+{
+	ValueSet out(db->getDomainSize(var), false);
+	for (auto it = axisValues.beginSetBits(), itEnd = axisValues.endSetBits(); it != itEnd; ++it)
+	{
+		const int value = *it - position;
+		if (value >= 0 && value < out.size())
+		{
+			out[value] = true;
+		}
+	}
+	return out;
+}
+
+bool ElementConstraint::getEntryValues(const IVariableDatabase* db, int entry, ValueSet& outValues) const
+{
+	const Entry& e = m_entries[entry];
+	if (e.variable.isValid())
+	{
+		getAxisValues(db, e.variable, e.position, outValues);
+		return true;
+	}
+	else if (e.position >= 0)
+	{
+		outValues.init(m_numValues, false);
+		outValues[e.position] = true;
+		return true;
+	}
+	return false;
+}
+
+ExplainerFunction ElementConstraint::makeExplainer(ERule rule, int entry)
+{
+	return [this, rule, entry](const NarrowingExplanationParams& params, vector<Literal>& outExplanation)
+	{
+		explainRule(params, rule, entry, outExplanation);
+	};
+}
+
+void ElementConstraint::explainRule(const NarrowingExplanationParams& params, ERule rule, int entry, vector<Literal>& outExplanation) const
+{
+	// The database is as it was immediately before the narrowing being explained.
+	auto db = params.database;
+	const VarID propagatedVar = params.propagatedVariable;
+
+	// Values that were removed by the narrowing. If the variable became contradictory, that's all of them.
+	ValueSet removed = db->getPotentialValues(propagatedVar);
+	if (!params.propagatedValues.isZero())
+	{
+		removed.exclude(params.propagatedValues);
+	}
+
+	outExplanation.clear();
+	outExplanation.push_back(Literal(propagatedVar, removed.inverted()));
+
+	ValueSet axisValues;
+	switch (rule)
+	{
+	case ERule::Index:
+		{
+			// Index != K OR Result is one of Array[K]'s values OR Array[K] is not one of its (current) values.
+			ValueSet resultLiteral(m_numValues, false);
+			for (auto it = removed.beginSetBits(), itEnd = removed.endSetBits(); it != itEnd; ++it)
+			{
+				const int removedEntry = getEntryForIndex(*it);
+				if (removedEntry < 0 || !getEntryValues(db, removedEntry, axisValues))
+				{
+					continue;
+				}
+
+				resultLiteral.include(axisValues);
+				if (m_entries[removedEntry].variable.isValid())
+				{
+					addExplanationLiteral(outExplanation, m_entries[removedEntry].variable, db->getPotentialValues(m_entries[removedEntry].variable).inverted());
+				}
+			}
+			addExplanationLiteral(outExplanation, m_result, toVariableValues(db, m_result, m_resultPosition, resultLiteral));
+		}
+		break;
+	case ERule::Result:
+		{
+			// Result is not one of the removed values OR Index selects something else OR one of the selectable
+			// entries is one of the removed values.
+			addExplanationLiteral(outExplanation, m_index, db->getPotentialValues(m_index).inverted());
+
+			getAxisValues(db, m_result, m_resultPosition, axisValues);
+			ValueSet removedAxis(m_numValues, false);
+			for (auto it = removed.beginSetBits(), itEnd = removed.endSetBits(); it != itEnd; ++it)
+			{
+				removedAxis[m_resultPosition + *it] = true;
+			}
+
+			const ValueSet& indexValues = db->getPotentialValues(m_index);
+			for (auto it = indexValues.beginSetBits(), itEnd = indexValues.endSetBits(); it != itEnd; ++it)
+			{
+				const int selectable = getEntryForIndex(*it);
+				if (selectable >= 0 && m_entries[selectable].variable.isValid())
+				{
+					const Entry& e = m_entries[selectable];
+					addExplanationLiteral(outExplanation, e.variable, toVariableValues(db, e.variable, e.position, removedAxis));
+				}
+			}
+		}
+		break;
+	case ERule::Entry:
+		{
+			// Array[K] is not one of the removed values OR Index != K OR Result is one of the removed values.
+			const Entry& e = m_entries[entry];
+			vxy_sanity(e.variable == propagatedVar);
+
+			ValueSet indexLiteral(db->getDomainSize(m_index), true);
+			indexLiteral[entry - m_indexMin] = false;
+			addExplanationLiteral(outExplanation, m_index, indexLiteral);
+
+			ValueSet removedAxis(m_numValues, false);
+			for (auto it = removed.beginSetBits(), itEnd = removed.endSetBits(); it != itEnd; ++it)
+			{
+				removedAxis[e.position + *it] = true;
+			}
+			addExplanationLiteral(outExplanation, m_result, toVariableValues(db, m_result, m_resultPosition, removedAxis));
+		}
+		break;
+	}
+}
+
+vector<IGraphRelationPtr<VarID>> ElementConstraint::makeNeighborRelations(const ITopologyPtr& topo, const shared_ptr<TTopologyVertexData<VarID>>& data, const vector<TopologyLink>& links)
+{
+	vector<IGraphRelationPtr<VarID>> out;
+	out.reserve(links.size());
+	for (auto& link : links)
+	{
+		auto linkRelation = make_shared<TTopologyLinkGraphRelation<VarID>>(topo, data, link);
+		out.push_back(make_shared<TFallbackGraphRelation<VarID>>(linkRelation, VarID::INVALID));
+	}
+	return out;
+}
@@ -40,6 +40,10 @@ bool InequalityConstraint::initialize(IVariableDatabase* db)
 		m_handleA = db->addVariableWatch(m_a, EVariableWatchType::WatchSolved, this);
 		m_handleB = db->addVariableWatch(m_b, EVariableWatchType::WatchSolved, this);
 		break;
+	case EConstraintOperator::Equal:
+		m_handleA = db->addVariableWatch(m_a, EVariableWatchType::WatchModification, this);
+		m_handleB = db->addVariableWatch(m_b, EVariableWatchType::WatchModification, this);
+		break;
 	default:
 		vxy_fail();
 		break;
@@ -160,6 +164,18 @@ bool InequalityConstraint::applyOperator(IVariableDatabase* db, EConstraintOpera
 				return false;
 			}
 		}
+		break;
+	case EConstraintOperator::Equal:
+		{
+			const int minPossible = db->getMinimumPossibleValue(lhs);
+			const int maxPossible = db->getMaximumPossibleValue(lhs);
+			if (!db->excludeValuesLessThan(rhs, minPossible, this) ||
+				!db->excludeValuesGreaterThan(rhs, maxPossible, this))
+			{
+				return false;
+			}
+		}
+		break;
 	}
 	return true;
 }
@@ -218,6 +234,17 @@ void InequalityConstraint::explain(const NarrowingExplanationParams& params, vec
 	case EConstraintOperator::NotEqual:
 		vxy_fail(); // handled by default explainer
 		break;
+	case EConstraintOperator::Equal:
+		{
+			const int minValue = db->getMinimumPossibleValue(lhs);
+			const int maxValue = db->getMaximumPossibleValue(lhs);
+
+			// M <= Lhs <= N implies M <= Rhs <= N
+			lhsVals.setRange(0, minValue, true);
+			lhsVals.setRange(maxValue+1, lhsVals.size(), true);
+			rhsVals.setRange(minValue, maxValue+1, true);
+		}
+		break;
 	}
 
 	outExplanation.clear();
@@ -240,6 +267,9 @@ bool InequalityConstraint::checkConflicting(IVariableDatabase* db) const
 	case EConstraintOperator::NotEqual:
 		return (db->isSolved(m_a) && db->isPossible(m_b, db->getSolvedValue(m_a))) ||
 			(db->isSolved(m_b) && db->isPossible(m_a, db->getSolvedValue(m_b)));
+	case EConstraintOperator::Equal:
+		return db->getMaximumPossibleValue(m_a) < db->getMinimumPossibleValue(m_b) ||
+			db->getMinimumPossibleValue(m_a) > db->getMaximumPossibleValue(m_b);
 	}
 
 	vxy_fail();
@@ -256,6 +286,7 @@ EConstraintOperator InequalityConstraint::getMirrorOperator(EConstraintOperator
 	case EConstraintOperator::LessThanEq: return EConstraintOperator::GreaterThanEq;
 	case EConstraintOperator::GreaterThanEq: return EConstraintOperator::LessThanEq;
 	case EConstraintOperator::NotEqual: return EConstraintOperator::NotEqual;
+	case EConstraintOperator::Equal: return EConstraintOperator::Equal;
 	}
 	vxy_fail();
 	return EConstraintOperator::NotEqual;
@@ -0,0 +1,485 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#include "constraints/LinearConstraint.h"
+#include "constraints/ConstraintFactoryParams.h"
+#include "variable/IVariableDatabase.h"
+
+using namespace Vertexy;
+
+static inline int64_t floorDiv(int64_t num, int64_t denom)
+{
+	const int64_t quotient = num / denom;
+	return (num % denom != 0 && (num < 0) != (denom < 0)) ? quotient - 1 : quotient;
+}
+
+static inline int64_t ceilDiv(int64_t num, int64_t denom)
+{
+	const int64_t quotient = num / denom;
+	return (num % denom != 0 && (num < 0) == (denom < 0)) ? quotient + 1 : quotient;
+}
+
+LinearConstraint* LinearConstraint::LinearConstraintFactory::construct(const ConstraintFactoryParams& params, const vector<VarID>& variables, const vector<int>& coefficients, EConstraintOperator op, int rhs)
+{
+	switch (op)
+	{
+	case EConstraintOperator::LessThan:
+		return new LinearConstraint(params, variables, coefficients, false, 0, true, rhs - 1);
+	case EConstraintOperator::LessThanEq:
+		return new LinearConstraint(params, variables, coefficients, false, 0, true, rhs);
+	case EConstraintOperator::GreaterThan:
+		return new LinearConstraint(params, variables, coefficients, true, rhs + 1, false, 0);
+	case EConstraintOperator::GreaterThanEq:
+		return new LinearConstraint(params, variables, coefficients, true, rhs, false, 0);
+	case EConstraintOperator::Equal:
+		return new LinearConstraint(params, variables, coefficients, true, rhs, true, rhs);
+	default:
+		vxy_fail_msg("Unsupported operator for linear constraint");
+		return nullptr;
+	}
+}
+
+LinearConstraint* LinearConstraint::LinearConstraintFactory::construct(const ConstraintFactoryParams& params, const vector<VarID>& variables, EConstraintOperator op, int rhs)
+{
+	vector<int> coefficients;
+	coefficients.resize(variables.size(), 1);
+	return construct(params, variables, coefficients, op, rhs);
+}
+
+LinearConstraint* LinearConstraint::LinearConstraintFactory::construct(const ConstraintFactoryParams& params, const vector<VarID>& variables, const vector<int>& coefficients, int lowerBound, int upperBound)
+{
+	vxy_assert(lowerBound <= upperBound);
+	return new LinearConstraint(params, variables, coefficients, true, lowerBound, true, upperBound);
+}
+
+LinearConstraint::LinearConstraint(const ConstraintFactoryParams& params, const vector<VarID>& variables, const vector<int>& coefficients, bool hasLower, int lower, bool hasUpper, int upper)
+	: IBacktrackingSolverConstraint(params)
+	, m_hasLower(hasLower)
+	, m_lower(lower)
+	, m_hasUpper(hasUpper)
+	, m_upper(upper)
+{
+	vxy_assert(variables.size() == coefficients.size());
+	vxy_assert(hasLower || hasUpper);
+
+	// Merge duplicate variables, and drop any that end up not contributing.
+	for (int i = 0; i < variables.size(); ++i)
+	{
+		auto found = m_variableToTerm.find(variables[i]);
+		if (found != m_variableToTerm.end())
+		{
+			m_terms[found->second].coefficient += coefficients[i];
+		}
+		else
+		{
+			m_variableToTerm[variables[i]] = m_terms.size();
+			m_terms.push_back({variables[i], coefficients[i], params.getDomain(variables[i]).getMin(), 0, 0, INVALID_WATCHER_HANDLE, INVALID_WATCHER_HANDLE});
+		}
+	}
+
+	for (int i = m_terms.size() - 1; i >= 0; --i)
+	{
+		if (m_terms[i].coefficient == 0)
+		{
+			m_terms.erase(m_terms.begin() + i);
+		}
+	}
+
+	m_variableToTerm.clear();
+	for (int i = 0; i < m_terms.size(); ++i)
+	{
+		m_variableToTerm[m_terms[i].variable] = i;
+	}
+}
+
+vector<VarID> LinearConstraint::getConstrainingVariables() const
+{
+	vector<VarID> out;
+	out.reserve(m_terms.size());
+	for (auto& term : m_terms)
+	{
+		out.push_back(term.variable);
+	}
+	return out;
+}
+
+bool LinearConstraint::initialize(IVariableDatabase* db)
+{
+	m_minSum = 0;
+	m_maxSum = 0;
+	m_maxTermSpan = 0;
+	m_trail.clear();
+	m_backtrackStack.clear();
+	m_backtrackStack.push_back({0, 0, 0, 0});
+
+	for (auto& term : m_terms)
+	{
+		// The upper bound of the sum is limited by each term's minimum contribution, and the lower bound by each
+		// term's maximum contribution. Only watch for the variable bounds that determine those.
+		const bool watchLowerBound = term.coefficient > 0 ? m_hasUpper : m_hasLower;
+		const bool watchUpperBound = term.coefficient > 0 ? m_hasLower : m_hasUpper;
+		if (watchLowerBound)
+		{
+			term.lowerBoundWatch = db->addVariableWatch(term.variable, EVariableWatchType::WatchLowerBoundChange, this);
+		}
+		if (watchUpperBound)
+		{
+			term.upperBoundWatch = db->addVariableWatch(term.variable, EVariableWatchType::WatchUpperBoundChange, this);
+		}
+
+		term.minIndex = db->getMinimumPossibleValue(term.variable);
+		term.maxIndex = db->getMaximumPossibleValue(term.variable);
+		if (term.minIndex < 0)
+		{
+			return false;
+		}
+
+		m_minSum += getTermMin(term, term.minIndex, term.maxIndex);
+		m_maxSum += getTermMax(term, term.minIndex, term.maxIndex);
+
+		const int64_t span = abs(term.coefficient) * (db->getDomainSize(term.variable) - 1);
+		m_maxTermSpan = max(m_maxTermSpan, span);
+	}
+
+	return propagate(db);
+}
+
+void LinearConstraint::reset(IVariableDatabase* db)
+{
+	for (auto& term : m_terms)
+	{
+		if (term.lowerBoundWatch != INVALID_WATCHER_HANDLE)
+		{
+			db->removeVariableWatch(term.variable, term.lowerBoundWatch, this);
+			term.lowerBoundWatch = INVALID_WATCHER_HANDLE;
+		}
+		if (term.upperBoundWatch != INVALID_WATCHER_HANDLE)
+		{
+			db->removeVariableWatch(term.variable, term.upperBoundWatch, this);
+			term.upperBoundWatch = INVALID_WATCHER_HANDLE;
+		}
+	}
+}
+
+bool LinearConstraint::onVariableNarrowed(IVariableDatabase* db, VarID variable, const ValueSet&, bool&)
+{
+	auto found = m_variableToTerm.find(variable);
+	vxy_assert(found != m_variableToTerm.end());
+
+	if (updateTerm(db, found->second))
+	{
+		if (isViolated())
+		{
+			return false;
+		}
+
+		if (needsPropagation())
+		{
+			db->queueConstraintPropagation(this);
+		}
+	}
+	return true;
+}
+
+bool LinearConstraint::propagate(IVariableDatabase* db)
+{
+	if (isViolated())
+	{
+		return false;
+	}
+
+	// Narrowing a term against one bound can reduce the slack of the other, so repeat until nothing changes.
+	bool changed = true;
+	while (changed && needsPropagation())
+	{
+		changed = false;
+		for (int i = 0; i < m_terms.size(); ++i)
+		{
+			if (!tightenTerm(db, i))
+			{
+				return false;
+			}
+
+			if (updateTerm(db, i))
+			{
+				changed = true;
+				if (isViolated())
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	if ((!m_hasUpper || m_maxSum <= m_upper) && (!m_hasLower || m_minSum >= m_lower))
+	{
+		db->markConstraintFullySatisfied(this);
+	}
+	return true;
+}
+
+bool LinearConstraint::tightenTerm(IVariableDatabase* db, int termIndex)
+{
+	const Term& term = m_terms[termIndex];
+	const int64_t termMin = getTermMin(term, term.minIndex, term.maxIndex);
+	const int64_t termMax = getTermMax(term, term.minIndex, term.maxIndex);
+	const int64_t span = termMax - termMin;
+
+	// Largest value index to keep, and smallest value index to keep.
+	int64_t maxKeep = term.maxIndex;
+	int64_t minKeep = term.minIndex;
+
+	if (m_hasUpper && span > m_upper - m_minSum)
+	{
+		// Coefficient * Value <= Upper - (minimum contribution of all other terms)
+		const int64_t limit = m_upper - (m_minSum - termMin);
+		if (term.coefficient > 0)
+		{
+			maxKeep = min(maxKeep, floorDiv(limit, term.coefficient) - term.offset);
+		}
+		else
+		{
+			minKeep = max(minKeep, ceilDiv(limit, term.coefficient) - term.offset);
+		}
+	}
+
+	if (m_hasLower && span > m_maxSum - m_lower)
+	{
+		// Coefficient * Value >= Lower - (maximum contribution of all other terms)
+		const int64_t limit = m_lower - (m_maxSum - termMax);
+		if (term.coefficient > 0)
+		{
+			minKeep = max(minKeep, ceilDiv(limit, term.coefficient) - term.offset);
+		}
+		else
+		{
+			maxKeep = min(maxKeep, floorDiv(limit, term.coefficient) - term.offset);
+		}
+	}
+
+	if (maxKeep < term.maxIndex)
+	{
+		if (!db->excludeValuesGreaterThan(term.variable, int(max(maxKeep, int64_t(-1))), this))
+		{
+			return false;
+		}
+	}
+
+	if (minKeep > term.minIndex)
+	{
+		const int domainSize = db->getDomainSize(term.variable);
+		if (!db->excludeValuesLessThan(term.variable, int(min(minKeep, int64_t(domainSize))), this))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool LinearConstraint::updateTerm(IVariableDatabase* db, int termIndex)
+{
+	Term& term = m_terms[termIndex];
+	const int newMin = db->getMinimumPossibleValue(term.variable);
+	const int newMax = db->getMaximumPossibleValue(term.variable);
+	if (newMin < 0 || (newMin == term.minIndex && newMax == term.maxIndex))
+	{
+		return false;
+	}
+
+	const SolverDecisionLevel level = db->getDecisionLevel();
+	if (level > 0)
+	{
+		if (m_backtrackStack.back().level != level)
+		{
+			vxy_assert(m_backtrackStack.back().level < level);
+			m_backtrackStack.push_back({level, int(m_trail.size()), m_minSum, m_maxSum});
+			db->markConstraintNeedsBacktrack(this);
+		}
+		m_trail.push_back({termIndex, term.minIndex, term.maxIndex});
+	}
+
+	m_minSum += getTermMin(term, newMin, newMax) - getTermMin(term, term.minIndex, term.maxIndex);
+	m_maxSum += getTermMax(term, newMin, newMax) - getTermMax(term, term.minIndex, term.maxIndex);
+	term.minIndex = newMin;
+	term.maxIndex = newMax;
+	return true;
+}
+
+void LinearConstraint::backtrack(const IVariableDatabase* db, SolverDecisionLevel level)
+{
+	while (m_backtrackStack.back().level > level)
+	{
+		const BacktrackInfo& info = m_backtrackStack.back();
+		for (int i = m_trail.size() - 1; i >= info.trailSize; --i)
+		{
+			Term& term = m_terms[m_trail[i].term];
+			term.minIndex = m_trail[i].minIndex;
+			term.maxIndex = m_trail[i].maxIndex;
+		}
+		m_trail.resize(info.trailSize);
+		m_minSum = info.minSum;
+		m_maxSum = info.maxSum;
+		m_backtrackStack.pop_back();
+	}
+}
+
+bool LinearConstraint::isViolated() const
+{
+	return (m_hasUpper && m_minSum > m_upper) || (m_hasLower && m_maxSum < m_lower);
+}
+
+bool LinearConstraint::needsPropagation() const
+{
+	return (m_hasUpper && m_upper - m_minSum < m_maxTermSpan) || (m_hasLower && m_maxSum - m_lower < m_maxTermSpan);
+}
+
+bool LinearConstraint::checkConflicting(IVariableDatabase* db) const
+{
+	int64_t minSum, maxSum;
+	getSumBounds(db, minSum, maxSum);
+	return (m_hasUpper && minSum > m_upper) || (m_hasLower && maxSum < m_lower);
+}
+
+void LinearConstraint::getSumBounds(const IVariableDatabase* db, int64_t& outMinSum, int64_t& outMaxSum) const
+{
+	outMinSum = 0;
+	outMaxSum = 0;
+	for (auto& term : m_terms)
+	{
+		const int minIndex = db->getMinimumPossibleValue(term.variable);
+		const int maxIndex = db->getMaximumPossibleValue(term.variable);
+		outMinSum += getTermMin(term, minIndex, maxIndex);
+		outMaxSum += getTermMax(term, minIndex, maxIndex);
+	}
+}
+
+void LinearConstraint::explain(const NarrowingExplanationParams& params, vector<Literal>& outExplanation) const
+{
+	// The database is as it was immediately before the propagation (or conflict) being explained.
+	auto db = params.database;
+
+	int64_t minSum, maxSum;
+	getSumBounds(db, minSum, maxSum);
+
+	outExplanation.clear();
+	if (!params.propagatedVariable.isValid())
+	{
+		// The minimum (or maximum) contribution of every term together already exceeds the bound.
+		const bool upperSide = m_hasUpper && minSum > m_upper;
+		const bool lowerSide = !upperSide;
+		vxy_assert(upperSide || (m_hasLower && maxSum < m_lower));
+		for (auto& term : m_terms)
+		{
+			addTermReason(db, term, upperSide, lowerSide, outExplanation);
+		}
+		return;
+	}
+
+	auto found = m_variableToTerm.find(params.propagatedVariable);
+	vxy_assert(found != m_variableToTerm.end());
+	const Term& propagated = m_terms[found->second];
+
+	const ValueSet& priorValues = db->getPotentialValues(propagated.variable);
+	const int priorMin = priorValues.indexOf(true);
+	const int priorMax = priorValues.lastIndexOf(true);
+	const int64_t termMin = getTermMin(propagated, priorMin, priorMax);
+	const int64_t termMax = getTermMax(propagated, priorMin, priorMax);
+
+	// Values that were removed by this propagation. If the variable became contradictory, that's all of them.
+	ValueSet removed = priorValues;
+	if (!params.propagatedValues.isZero())
+	{
+		removed.exclude(params.propagatedValues);
+	}
+	vxy_sanity(!removed.isZero());
+
+	// Recompute the range allowed by each bound, and determine which one(s) removed the values.
+	const int domainSize = db->getDomainSize(propagated.variable);
+	int64_t minKeep = 0;
+	int64_t maxKeep = domainSize - 1;
+	bool upperSide = false, lowerSide = false;
+	if (m_hasUpper)
+	{
+		const int64_t limit = m_upper - (minSum - termMin);
+		const int64_t keepMin = propagated.coefficient > 0 ? 0 : ceilDiv(limit, propagated.coefficient) - propagated.offset;
+		const int64_t keepMax = propagated.coefficient > 0 ? floorDiv(limit, propagated.coefficient) - propagated.offset : domainSize - 1;
+		if (removed.indexOf(true) < keepMin || removed.lastIndexOf(true) > keepMax)
+		{
+			upperSide = true;
+			minKeep = max(minKeep, keepMin);
+			maxKeep = min(maxKeep, keepMax);
+		}
+	}
+	if (m_hasLower)
+	{
+		const int64_t limit = m_lower - (maxSum - termMax);
+		const int64_t keepMin = propagated.coefficient > 0 ? ceilDiv(limit, propagated.coefficient) - propagated.offset : 0;
+		const int64_t keepMax = propagated.coefficient > 0 ? domainSize - 1 : floorDiv(limit, propagated.coefficient) - propagated.offset;
+		if (removed.indexOf(true) < keepMin || removed.lastIndexOf(true) > keepMax)
+		{
+			lowerSide = true;
+			minKeep = max(minKeep, keepMin);
+			maxKeep = min(maxKeep, keepMax);
+		}
+	}
+
+	if (!upperSide && !lowerSide)
+	{
+		vxy_fail();
+		return;
+	}
+
+	for (auto& term : m_terms)
+	{
+		if (term.variable != propagated.variable)
+		{
+			addTermReason(db, term, upperSide, lowerSide, outExplanation);
+		}
+	}
+
+	ValueSet propagatedLiteral(domainSize, false);
+	if (minKeep <= maxKeep)
+	{
+		propagatedLiteral.setRange(int(minKeep), int(maxKeep) + 1, true);
+	}
+	outExplanation.push_back(Literal(propagated.variable, propagatedLiteral));
+}
+
+void LinearConstraint::addTermReason(const IVariableDatabase* db, const Term& term, bool upperSide, bool lowerSide, vector<Literal>& outExplanation) const
+{
+	const int domainSize = db->getDomainSize(term.variable);
+	const int minIndex = db->getMinimumPossibleValue(term.variable);
+	const int maxIndex = db->getMaximumPossibleValue(term.variable);
+
+	// The upper side relies on the term's minimum contribution, the lower side on its maximum.
+	const bool usesMinIndex = (upperSide && term.coefficient > 0) || (lowerSide && term.coefficient < 0);
+	const bool usesMaxIndex = (upperSide && term.coefficient < 0) || (lowerSide && term.coefficient > 0);
+
+	ValueSet values(domainSize, false);
+	if (usesMinIndex && minIndex > 0)
+	{
+		values.setRange(0, minIndex, true);
+	}
+	if (usesMaxIndex && maxIndex < domainSize - 1)
+	{
+		values.setRange(maxIndex + 1, domainSize, true);
+	}
+
+	if (!values.isZero())
+	{
+		outExplanation.push_back(Literal(term.variable, values));
+	}
+}
+
+int64_t LinearConstraint::getTermMin(const Term& term, int minIndex, int maxIndex)
+{
+	return term.coefficient > 0
+		? term.coefficient * (term.offset + minIndex)
+		: term.coefficient * (term.offset + maxIndex);
+}
+
+int64_t LinearConstraint::getTermMax(const Term& term, int minIndex, int maxIndex)
+{
+	return term.coefficient > 0
+		? term.coefficient * (term.offset + maxIndex)
+		: term.coefficient * (term.offset + minIndex);
+}
@@ -0,0 +1,631 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#include "constraints/MDDConstraint.h"
+#include "constraints/ConstraintFactoryParams.h"
+#include "constraints/TableConstraint.h"
+#include "variable/IVariableDatabase.h"
+
+#include <EASTL/hash_map.h>
+#include <EASTL/map.h>
+#include <EASTL/sort.h>
+
+using namespace Vertexy;
+
+MDDConstraintDataPtr MDDConstraintData::fromTuples(const vector<vector<int>>& tupleRows)
+{
+	vxy_assert(!tupleRows.empty());
+	const int numLayers = tupleRows[0].size();
+	vxy_assert(numLayers > 0);
+
+	// Build a trie of the tuples: reduction will merge the shared suffixes.
+	vector<NodeList> layers;
+	layers.resize(numLayers);
+	layers[0].resize(1);
+
+	vector<hash_map<tuple<int, int>, int>> children;
+	children.resize(numLayers);
+
+	for (const vector<int>& row : tupleRows)
+	{
+		vxy_assert(row.size() == numLayers);
+		int node = 0;
+		for (int layer = 0; layer < numLayers - 1; ++layer)
+		{
+			const tuple<int, int> key(node, row[layer]);
+			auto found = children[layer].find(key);
+			if (found != children[layer].end())
+			{
+				node = found->second;
+			}
+			else
+			{
+				const int child = layers[layer + 1].size();
+				layers[layer + 1].emplace_back();
+				layers[layer][node].push_back(make_pair(row[layer], child));
+				children[layer][key] = child;
+				node = child;
+			}
+		}
+		layers[numLayers - 1][node].push_back(make_pair(row[numLayers - 1], 0));
+	}
+
+	return reduce(layers);
+}
+
+MDDConstraintDataPtr MDDConstraintData::fromTable(const TableConstraintData& table)
+{
+	return fromTuples(table.tupleRows);
+}
+
+MDDConstraintDataPtr MDDConstraintData::fromTransitions(const vector<SolverVariableDomain>& domains, int initialState, const TransitionFunction& transition, const AcceptFunction& isAccepting)
+{
+	const int numLayers = domains.size();
+	vxy_assert(numLayers > 0);
+
+	vector<NodeList> layers;
+	layers.resize(numLayers);
+	layers[0].resize(1);
+
+	// The state of each node in the current layer
+	vector<int> states = {initialState};
+	vector<int> nextStates;
+	hash_map<int, int> stateToNode;
+
+	for (int layer = 0; layer < numLayers; ++layer)
+	{
+		const bool lastLayer = layer == numLayers - 1;
+		nextStates.clear();
+		stateToNode.clear();
+
+		for (int node = 0; node < states.size(); ++node)
+		{
+			for (int value = domains[layer].getMin(); value <= domains[layer].getMax(); ++value)
+			{
+				int nextState;
+				if (!transition(layer, states[node], value, nextState))
+				{
+					continue;
+				}
+
+				if (lastLayer)
+				{
+					if (isAccepting(nextState))
+					{
+						layers[layer][node].push_back(make_pair(value, 0));
+					}
+					continue;
+				}
+
+				vxy_assert(nextState >= 0);
+				auto found = stateToNode.find(nextState);
+				int head;
+				if (found != stateToNode.end())
+				{
+					head = found->second;
+				}
+				else
+				{
+					head = nextStates.size();
+					nextStates.push_back(nextState);
+					layers[layer + 1].emplace_back();
+					stateToNode[nextState] = head;
+				}
+				layers[layer][node].push_back(make_pair(value, head));
+			}
+		}
+
+		states.swap(nextStates);
+	}
+
+	return reduce(layers);
+}
+
+MDDConstraintDataPtr MDDConstraintData::reduce(const vector<NodeList>& layers)
+{
+	const int numLayers = layers.size();
+	vxy_assert(layers[0].size() == 1);
+
+	//
+	// Bottom-up: remove nodes that can't reach the terminal, and merge nodes with identical outgoing edges.
+	//
+
+	vector<NodeList> reduced;
+	reduced.resize(numLayers);
+
+	// For the layer below the current one, maps unreduced node index to reduced node index, or -1 if removed.
+	vector<int> belowMapping = {0};
+	vector<int> mapping;
+	map<vector<pair<int, int>>, int> signatures;
+	vector<pair<int, int>> signature;
+
+	for (int layer = numLayers - 1; layer >= 0; --layer)
+	{
+		mapping.clear();
+		signatures.clear();
+		for (const vector<pair<int, int>>& node : layers[layer])
+		{
+			signature.clear();
+			for (auto& edge : node)
+			{
+				const int head = belowMapping[edge.second];
+				if (head >= 0)
+				{
+					signature.push_back(make_pair(edge.first, head));
+				}
+			}
+
+			if (signature.empty())
+			{
+				mapping.push_back(-1);
+				continue;
+			}
+
+			quick_sort(signature.begin(), signature.end());
+			signature.erase(unique(signature.begin(), signature.end()), signature.end());
+
+			auto found = signatures.find(signature);
+			if (found != signatures.end())
+			{
+				mapping.push_back(found->second);
+			}
+			else
+			{
+				const int newIndex = reduced[layer].size();
+				signatures[signature] = newIndex;
+				reduced[layer].push_back(signature);
+				mapping.push_back(newIndex);
+			}
+		}
+		belowMapping.swap(mapping);
+	}
+
+	//
+	// Top-down: remove any nodes that are no longer reachable from the root, and flatten.
+	//
+
+	auto out = make_shared<MDDConstraintData>();
+	out->layerNodeStart.reserve(numLayers + 1);
+
+	vector<int> reachable;
+	if (!reduced[0].empty())
+	{
+		reachable.push_back(0);
+	}
+
+	// Global index for each reachable node of the current layer
+	vector<int> nodeIndices;
+	vector<int> nextNodeIndices;
+	nodeIndices.resize(reduced[0].size(), -1);
+	if (!reachable.empty())
+	{
+		nodeIndices[0] = 0;
+	}
+
+	int numNodes = reachable.size();
+	for (int layer = 0; layer < numLayers; ++layer)
+	{
+		out->layerNodeStart.push_back(numNodes - int(reachable.size()));
+		out->layerEdgeStart.push_back(out->edges.size());
+
+		const bool lastLayer = layer == numLayers - 1;
+		vector<int> nextReachable;
+		nextNodeIndices.clear();
+		nextNodeIndices.resize(lastLayer ? 1 : reduced[layer + 1].size(), -1);
+
+		int minValue = INT_MAX, maxValue = INT_MIN;
+		for (int node : reachable)
+		{
+			for (auto& edge : reduced[layer][node])
+			{
+				if (nextNodeIndices[edge.second] < 0)
+				{
+					nextNodeIndices[edge.second] = numNodes++;
+					nextReachable.push_back(edge.second);
+				}
+				out->edges.push_back({nodeIndices[node], nextNodeIndices[edge.second], edge.first});
+				minValue = min(minValue, edge.first);
+				maxValue = max(maxValue, edge.first);
+			}
+		}
+
+		out->layerMinValue.push_back(minValue <= maxValue ? minValue : 0);
+		out->layerMaxValue.push_back(minValue <= maxValue ? maxValue + 1 : 0);
+
+		reachable.swap(nextReachable);
+		nodeIndices.swap(nextNodeIndices);
+	}
+
+	// Terminal layer
+	out->layerNodeStart.push_back(out->edges.empty() ? numNodes : numNodes - 1);
+	out->layerEdgeStart.push_back(out->edges.size());
+	if (out->edges.empty())
+	{
+		// No tuples: just a root and a terminal.
+		out->layerNodeStart.clear();
+		out->layerNodeStart.resize(numLayers + 1, 1);
+		out->layerNodeStart[0] = 0;
+		numNodes = 2;
+	}
+	vxy_assert(out->getNumNodes() == numNodes);
+
+	//
+	// Build the adjacency lists.
+	//
+
+	const int numEdges = out->edges.size();
+
+	out->layerValueSetStart.reserve(numLayers + 1);
+	int numValueSets = 0;
+	for (int layer = 0; layer < numLayers; ++layer)
+	{
+		out->layerValueSetStart.push_back(numValueSets);
+		numValueSets += out->layerMaxValue[layer] - out->layerMinValue[layer];
+	}
+	out->layerValueSetStart.push_back(numValueSets);
+
+	out->edgeValueSets.resize(numEdges);
+	for (int layer = 0; layer < numLayers; ++layer)
+	{
+		for (int edge = out->layerEdgeStart[layer]; edge < out->layerEdgeStart[layer + 1]; ++edge)
+		{
+			out->edgeValueSets[edge] = out->getValueSetIndex(layer, out->edges[edge].value);
+		}
+	}
+
+	auto buildCSR = [&](int numSets, auto&& getSet, vector<int>& outStarts, vector<int>& outMembers)
+	{
+		outStarts.clear();
+		outStarts.resize(numSets + 1, 0);
+		for (int edge = 0; edge < numEdges; ++edge)
+		{
+			++outStarts[getSet(edge) + 1];
+		}
+		for (int i = 0; i < numSets; ++i)
+		{
+			outStarts[i + 1] += outStarts[i];
+		}
+
+		vector<int> cursors(outStarts.begin(), outStarts.end() - 1);
+		outMembers.resize(numEdges);
+		for (int edge = 0; edge < numEdges; ++edge)
+		{
+			outMembers[cursors[getSet(edge)]++] = edge;
+		}
+	};
+
+	buildCSR(numNodes, [&](int edge) { return out->edges[edge].tail; }, out->outEdgeStart, out->outEdges);
+	buildCSR(numNodes, [&](int edge) { return out->edges[edge].head; }, out->inEdgeStart, out->inEdges);
+	buildCSR(numValueSets, [&](int edge) { return out->edgeValueSets[edge]; }, out->valueEdgeStart, out->valueEdges);
+
+	return out;
+}
+
+MDDConstraint* MDDConstraint::MDDConstraintFactory::construct(const ConstraintFactoryParams& params, const MDDConstraintDataPtr& data, const vector<VarID>& variables)
+{
+	vxy_assert(data->getNumLayers() == variables.size());
+	return new MDDConstraint(params, data, variables);
+}
+
+MDDConstraint::MDDConstraint(const ConstraintFactoryParams& params, const MDDConstraintDataPtr& inData, const vector<VarID>& inVariables)
+	: IBacktrackingSolverConstraint(params)
+	, m_data(inData)
+	, m_variables(inVariables)
+{
+	m_domainMins.reserve(m_variables.size());
+	for (VarID var : m_variables)
+	{
+		m_domainMins.push_back(params.getDomain(var).getMin());
+	}
+}
+
+bool MDDConstraint::initialize(IVariableDatabase* db)
+{
+	const int numEdges = m_data->edges.size();
+	const int numNodes = m_data->getNumNodes();
+	const int numValueSets = m_data->valueEdgeStart.size() - 1;
+
+	//
+	// Set up the sparse sets, with every edge alive.
+	//
+
+	m_kindSetOffsets[ValueSetKind] = 0;
+	m_kindSetOffsets[OutSetKind] = numValueSets;
+	m_kindSetOffsets[InSetKind] = numValueSets + numNodes;
+
+	m_members.clear();
+	m_members.reserve(numEdges * NumSetKinds);
+	m_setStarts.clear();
+	m_setStarts.reserve(numValueSets + 2 * numNodes);
+	m_sizes.clear();
+	m_sizes.reserve(numValueSets + 2 * numNodes);
+
+	auto addSets = [&](ESetKind kind, const vector<int>& starts, const vector<int>& members)
+	{
+		const int memberOffset = m_members.size();
+		for (int i = 0; i < starts.size() - 1; ++i)
+		{
+			m_setStarts.push_back(memberOffset + starts[i]);
+			m_sizes.push_back(starts[i + 1] - starts[i]);
+		}
+
+		m_positions[kind].resize(numEdges);
+		for (int i = 0; i < members.size(); ++i)
+		{
+			m_positions[kind][members[i]] = m_members.size();
+			m_members.push_back(members[i]);
+		}
+	};
+
+	addSets(ValueSetKind, m_data->valueEdgeStart, m_data->valueEdges);
+	addSets(OutSetKind, m_data->outEdgeStart, m_data->outEdges);
+	addSets(InSetKind, m_data->inEdgeStart, m_data->inEdges);
+
+	m_trail.clear();
+	m_backtrackStack.clear();
+	m_edgesToDelete.clear();
+	m_unsupportedValueSets.clear();
+
+	for (VarID var : m_variables)
+	{
+		m_watchers.push_back(db->addVariableWatch(var, EVariableWatchType::WatchModification, this));
+	}
+
+	if (!isRootAlive())
+	{
+		return false;
+	}
+
+	//
+	// Remove the edges for any values the variables can't have, then constrain each variable to the values that
+	// still have edges.
+	//
+
+	for (int layer = 0; layer < m_variables.size(); ++layer)
+	{
+		const VarID var = m_variables[layer];
+		for (int value = m_data->layerMinValue[layer]; value < m_data->layerMaxValue[layer]; ++value)
+		{
+			const int index = value - m_domainMins[layer];
+			if (index < 0 || index >= db->getDomainSize(var) || !db->isPossible(var, index))
+			{
+				removeValue(db, layer, value);
+			}
+		}
+	}
+	m_unsupportedValueSets.clear();
+
+	if (!isRootAlive())
+	{
+		return false;
+	}
+
+	for (int layer = 0; layer < m_variables.size(); ++layer)
+	{
+		const VarID var = m_variables[layer];
+		ValueSet supported(db->getDomainSize(var), false);
+		for (int value = m_data->layerMinValue[layer]; value < m_data->layerMaxValue[layer]; ++value)
+		{
+			const int set = m_data->getValueSetIndex(layer, value);
+			const int index = value - m_domainMins[layer];
+			if (m_sizes[m_kindSetOffsets[ValueSetKind] + set] > 0)
+			{
+				vxy_sanity(index >= 0 && index < supported.size());
+				supported[index] = true;
+			}
+		}
+
+		if (!db->constrainToValues(var, supported, this))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void MDDConstraint::reset(IVariableDatabase* db)
+{
+	for (int i = 0; i < m_watchers.size(); ++i)
+	{
+		db->removeVariableWatch(m_variables[i], m_watchers[i], this);
+	}
+	m_watchers.clear();
+
+	m_members.clear();
+	m_setStarts.clear();
+	m_sizes.clear();
+	for (auto& positions : m_positions)
+	{
+		positions.clear();
+	}
+	m_trail.clear();
+	m_backtrackStack.clear();
+}
+
+bool MDDConstraint::onVariableNarrowed(IVariableDatabase* db, VarID variable, const ValueSet& prevValues, bool&)
+{
+	const int layer = indexOf(m_variables.begin(), m_variables.end(), variable);
+	vxy_assert(layer >= 0);
+
+	m_removedValues = prevValues;
+	m_removedValues.exclude(db->getPotentialValues(variable));
+	for (auto it = m_removedValues.beginSetBits(), itEnd = m_removedValues.endSetBits(); it != itEnd; ++it)
+	{
+		removeValue(db, layer, *it + m_domainMins[layer]);
+	}
+
+	if (!isRootAlive())
+	{
+		m_unsupportedValueSets.clear();
+		return false;
+	}
+
+	return removeUnsupportedValues(db);
+}
+
+void MDDConstraint::removeValue(IVariableDatabase* db, int layer, int value)
+{
+	const int valueSet = m_data->getValueSetIndex(layer, value);
+	if (valueSet < 0)
+	{
+		return;
+	}
+
+	const int set = m_kindSetOffsets[ValueSetKind] + valueSet;
+	while (m_sizes[set] > 0)
+	{
+		deleteEdge(db, m_members[m_setStarts[set] + m_sizes[set] - 1]);
+	}
+}
+
+void MDDConstraint::deleteEdge(IVariableDatabase* db, int edge)
+{
+	const int root = 0;
+	const int terminal = m_data->getTerminal();
+
+	m_edgesToDelete.push_back(edge);
+	while (!m_edgesToDelete.empty())
+	{
+		const int toDelete = m_edgesToDelete.back();
+		m_edgesToDelete.pop_back();
+		if (!isAlive(toDelete))
+		{
+			continue;
+		}
+
+		const MDDConstraintData::Edge& edgeData = m_data->edges[toDelete];
+		if (removeFromSet(db, ValueSetKind, toDelete) == 0)
+		{
+			m_unsupportedValueSets.push_back(m_data->edgeValueSets[toDelete]);
+		}
+
+		// If the tail has no more outgoing edges, nothing can reach the terminal through it.
+		if (removeFromSet(db, OutSetKind, toDelete) == 0 && edgeData.tail != root)
+		{
+			const int set = m_kindSetOffsets[InSetKind] + edgeData.tail;
+			for (int i = 0; i < m_sizes[set]; ++i)
+			{
+				m_edgesToDelete.push_back(m_members[m_setStarts[set] + i]);
+			}
+		}
+
+		// If the head has no more incoming edges, it can't be reached from the root.
+		if (removeFromSet(db, InSetKind, toDelete) == 0 && edgeData.head != terminal)
+		{
+			const int set = m_kindSetOffsets[OutSetKind] + edgeData.head;
+			for (int i = 0; i < m_sizes[set]; ++i)
+			{
+				m_edgesToDelete.push_back(m_members[m_setStarts[set] + i]);
+			}
+		}
+	}
+}
+
+int MDDConstraint::removeFromSet(IVariableDatabase* db, ESetKind kind, int edge)
+{
+	const int set = getSetForEdge(kind, edge);
+	vector<int>& positions = m_positions[kind];
+
+	// Changes at level 0 are permanent.
+	const SolverDecisionLevel level = db->getDecisionLevel();
+	if (level > 0)
+	{
+		if (m_backtrackStack.empty() || m_backtrackStack.back().level != level)
+		{
+			vxy_assert(m_backtrackStack.empty() || m_backtrackStack.back().level < level);
+			m_backtrackStack.push_back({level, int(m_trail.size())});
+			db->markConstraintNeedsBacktrack(this);
+		}
+		m_trail.push_back({set, m_sizes[set]});
+	}
+
+	// Swap with the last alive member of the set
+	const int pos = positions[edge];
+	const int lastPos = m_setStarts[set] + m_sizes[set] - 1;
+	vxy_sanity(pos <= lastPos);
+
+	const int lastEdge = m_members[lastPos];
+	m_members[pos] = lastEdge;
+	positions[lastEdge] = pos;
+	m_members[lastPos] = edge;
+	positions[edge] = lastPos;
+
+	return --m_sizes[set];
+}
+
+bool MDDConstraint::removeUnsupportedValues(IVariableDatabase* db)
+{
+	if (m_unsupportedValueSets.empty())
+	{
+		return true;
+	}
+
+	// Value sets are ordered by layer, so this groups the removals for each variable together.
+	quick_sort(m_unsupportedValueSets.begin(), m_unsupportedValueSets.end());
+
+	bool success = true;
+	int layer = 0;
+	for (int i = 0; i < m_unsupportedValueSets.size() && success;)
+	{
+		const int valueSet = m_unsupportedValueSets[i];
+		while (m_data->layerValueSetStart[layer + 1] <= valueSet)
+		{
+			++layer;
+		}
+
+		const VarID var = m_variables[layer];
+		m_removedValues.init(db->getDomainSize(var), false);
+		for (; i < m_unsupportedValueSets.size() && m_unsupportedValueSets[i] < m_data->layerValueSetStart[layer + 1]; ++i)
+		{
+			const int value = m_data->layerMinValue[layer] + m_unsupportedValueSets[i] - m_data->layerValueSetStart[layer];
+			const int index = value - m_domainMins[layer];
+			if (index >= 0 && index < m_removedValues.size())
+			{
+				m_removedValues[index] = true;
+			}
+		}
+
+		success = db->excludeValues(var, m_removedValues, this);
+	}
+
+	m_unsupportedValueSets.clear();
+	return success;
+}
+
+void MDDConstraint::backtrack(const IVariableDatabase*, SolverDecisionLevel level)
+{
+	while (!m_backtrackStack.empty() && m_backtrackStack.back().level > level)
+	{
+		const int trailSize = m_backtrackStack.back().trailSize;
+		for (int i = m_trail.size() - 1; i >= trailSize; --i)
+		{
+			m_sizes[m_trail[i].set] = m_trail[i].size;
+		}
+		m_trail.resize(trailSize);
+		m_backtrackStack.pop_back();
+	}
+}
+
+bool MDDConstraint::checkConflicting(IVariableDatabase* db) const
+{
+	// Conflicting if there is no path from the root to the terminal using only possible values.
+	vector<bool> reached;
+	reached.resize(m_data->getNumNodes(), false);
+	reached[0] = true;
+
+	for (int layer = 0; layer < m_variables.size(); ++layer)
+	{
+		const VarID var = m_variables[layer];
+		for (int edge = m_data->layerEdgeStart[layer]; edge < m_data->layerEdgeStart[layer + 1]; ++edge)
+		{
+			const MDDConstraintData::Edge& edgeData = m_data->edges[edge];
+			const int index = edgeData.value - m_domainMins[layer];
+			if (reached[edgeData.tail] && index >= 0 && index < db->getDomainSize(var) && db->isPossible(var, index))
+			{
+				reached[edgeData.head] = true;
+			}
+		}
+	}
+
+	return !reached[m_data->getTerminal()];
+}
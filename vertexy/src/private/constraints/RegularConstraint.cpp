@@ -0,0 +1,121 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#include "constraints/RegularConstraint.h"
+#include "constraints/ConstraintFactoryParams.h"
+
+#include <EASTL/algorithm.h>
+
+using namespace Vertexy;
+
+RegularConstraintData::RegularConstraintData(int numStates, int initialState)
+	: initialState(initialState)
+{
+	vxy_assert(numStates > 0);
+	vxy_assert(initialState >= 0 && initialState < numStates);
+	transitions.resize(numStates);
+	accepting.resize(numStates, false);
+}
+
+shared_ptr<RegularConstraintData> RegularConstraintData::maxRunLength(const SolverVariableDomain& domain, const vector<int>& runValues, int maxLength)
+{
+	vxy_assert(maxLength >= 0);
+
+	// State N = the last N values were all in RunValues.
+	auto out = make_shared<RegularConstraintData>(maxLength + 1, 0);
+	for (int state = 0; state <= maxLength; ++state)
+	{
+		out->setAccepting(state);
+		for (int value = domain.getMin(); value <= domain.getMax(); ++value)
+		{
+			if (find(runValues.begin(), runValues.end(), value) == runValues.end())
+			{
+				out->addTransition(state, value, 0);
+			}
+			else if (state < maxLength)
+			{
+				out->addTransition(state, value, state + 1);
+			}
+		}
+	}
+	return out;
+}
+
+void RegularConstraintData::addTransition(int fromState, int value, int toState)
+{
+	vxy_assert(fromState >= 0 && fromState < getNumStates());
+	vxy_assert(toState >= 0 && toState < getNumStates());
+	vxy_assert_msg(m_unrolled.empty(), "Automaton modified after it was used in a constraint");
+	transitions[fromState][value] = toState;
+}
+
+void RegularConstraintData::setAccepting(int state, bool acceptState)
+{
+	vxy_assert(state >= 0 && state < getNumStates());
+	vxy_assert_msg(m_unrolled.empty(), "Automaton modified after it was used in a constraint");
+	accepting[state] = acceptState;
+}
+
+bool RegularConstraintData::getTransition(int state, int value, int& outNextState) const
+{
+	auto found = transitions[state].find(value);
+	if (found == transitions[state].end())
+	{
+		return false;
+	}
+	outNextState = found->second;
+	return true;
+}
+
+MDDConstraintDataPtr RegularConstraintData::unroll(const vector<SolverVariableDomain>& domains) const
+{
+	for (auto& entry : m_unrolled)
+	{
+		if (entry.first == domains)
+		{
+			return entry.second;
+		}
+	}
+
+	MDDConstraintDataPtr unrolled = MDDConstraintData::fromTransitions(domains, initialState,
+		[&](int, int state, int value, int& outNextState) { return getTransition(state, value, outNextState); },
+		[&](int state) { return isAccepting(state); }
+	);
+	m_unrolled.push_back({domains, unrolled});
+	return unrolled;
+}
+
+RegularConstraint* RegularConstraint::RegularConstraintFactory::construct(const ConstraintFactoryParams& params, const RegularConstraintDataPtr& automaton, const vector<VarID>& variables)
+{
+	vxy_assert(!variables.empty());
+
+	vector<SolverVariableDomain> domains;
+	domains.reserve(variables.size());
+	for (VarID var : variables)
+	{
+		domains.push_back(params.getDomain(var));
+	}
+
+	return new RegularConstraint(params, automaton, automaton->unroll(domains), variables);
+}
+
+RegularConstraint::RegularConstraint(const ConstraintFactoryParams& params, const RegularConstraintDataPtr& inAutomaton, const MDDConstraintDataPtr& inUnrolled, const vector<VarID>& inVariables)
+	: MDDConstraint(params, inUnrolled, inVariables)
+	, m_automaton(inAutomaton)
+{
+}
+
+vector<IGraphRelationPtr<VarID>> RegularConstraint::makeWalkRelations(const ITopologyPtr& topo, const shared_ptr<TTopologyVertexData<VarID>>& data, const TopologyLink& step, int length)
+{
+	vxy_assert(length > 0);
+
+	vector<IGraphRelationPtr<VarID>> out;
+	out.reserve(length);
+	out.push_back(make_shared<TVertexToDataGraphRelation<VarID>>(topo, data));
+
+	TopologyLink link = step;
+	for (int i = 1; i < length; ++i)
+	{
+		out.push_back(make_shared<TTopologyLinkGraphRelation<VarID>>(topo, data, link));
+		link = link.combine(step);
+	}
+	return out;
+}
@@ -3,43 +3,59 @@
 #include "constraints/TableConstraint.h"
 #include "constraints/ConstraintFactoryParams.h"
 #include "variable/IVariableDatabase.h"
-#include <EASTL/hash_map.h>
-#include <EASTL/tuple.h>
-#include <EASTL/fixed_vector.h>
 
 using namespace Vertexy;
 
-void TableConstraintIntermediateData::buildSupportsIfNeeded(const IVariableDatabase* db, const vector<VarID>& exampleVariables)
+void TableConstraintIntermediateData::buildSupportsIfNeeded()
 {
-	if (!supports.empty())
+	if (!maskOffsets.empty())
 	{
 		return;
 	}
 
+	vxy_assert(!tupleRows.empty());
 	const int numVariables = tupleRows[0].size();
+	const int numRows = tupleRows.size();
+	numWords = (numRows + ReversibleSparseBitset::NUM_BITS_PER_WORD - 1) / ReversibleSparseBitset::NUM_BITS_PER_WORD;
 
 	//
-	// Create the supports map: For each variable, for each potential value, the rows that contain that value for that variable.
+	// Create the support masks: For each variable, for each value, the set of rows that contain that value for that variable.
 	//
 
-	supports.clear();
-	supports.resize(numVariables);
-
-	for (int rowIndex = 0; rowIndex < tupleRows.size(); ++rowIndex)
+	numValues.clear();
+	numValues.resize(numVariables, 0);
+	for (const vector<int>& row : tupleRows)
 	{
-		const vector<int>& row = tupleRows[rowIndex];
 		vxy_assert(row.size() == numVariables);
-
-		for (int variableIndex = 0; variableIndex < row.size(); ++variableIndex)
+		for (int variableIndex = 0; variableIndex < numVariables; ++variableIndex)
 		{
-			vector<vector<int>>& variableSupports = supports[variableIndex];
+			numValues[variableIndex] = max(numValues[variableIndex], row[variableIndex] + 1);
+		}
+	}
 
-			const int variableValue = row[variableIndex];
+	maskOffsets.clear();
+	maskOffsets.reserve(numVariables);
+	int numMasks = 0;
+	for (int variableIndex = 0; variableIndex < numVariables; ++variableIndex)
+	{
+		maskOffsets.push_back(numMasks);
+		numMasks += numValues[variableIndex];
+	}
 
-			variableSupports.resize(db->getDomainSize(exampleVariables[variableIndex]));
-			if (variableValue >= 0 && variableValue < variableSupports.size())
+	supportMasks.clear();
+	supportMasks.resize(numMasks * numWords, 0);
+	for (int rowIndex = 0; rowIndex < numRows; ++rowIndex)
+	{
+		const vector<int>& row = tupleRows[rowIndex];
+		const int word = rowIndex / ReversibleSparseBitset::NUM_BITS_PER_WORD;
+		const WordType bit = WordType(1) << (rowIndex % ReversibleSparseBitset::NUM_BITS_PER_WORD);
+		for (int variableIndex = 0; variableIndex < numVariables; ++variableIndex)
+		{
+			// Values outside of the domain (from convertFromDomains) can never be supported.
+			const int variableValue = row[variableIndex];
+			if (variableValue >= 0)
 			{
-				variableSupports[variableValue].push_back(rowIndex);
+				supportMasks[(maskOffsets[variableIndex] + variableValue) * numWords + word] |= bit;
 			}
 		}
 	}
@@ -49,16 +65,26 @@ void TableConstraintData::clear()
 {
 	tupleRows.clear();
 	m_intermediateData.reset();
+	m_convertedData.clear();
 }
 
 void TableConstraintData::setData(const vector<vector<int>>& inRows)
 {
 	tupleRows = inRows;
 	m_intermediateData.reset();
+	m_convertedData.clear();
 }
 
 TableConstraintDataPtr TableConstraintData::convertFromDomains(const vector<SolverVariableDomain>& domains) const
 {
+	for (auto& converted : m_convertedData)
+	{
+		if (get<0>(converted) == domains)
+		{
+			return get<1>(converted);
+		}
+	}
+
 	vector<vector<int>> convertedRows;
 	convertedRows.reserve(tupleRows.size());
 	for (const vector<int>& row : tupleRows)
@@ -71,7 +97,10 @@ TableConstraintDataPtr TableConstraintData::convertFromDomains(const vector<Solv
 		}
 		convertedRows.push_back(move(newRow));
 	}
-	return make_shared<TableConstraintData>(convertedRows);
+
+	auto convertedData = make_shared<TableConstraintData>(convertedRows);
+	m_convertedData.push_back(make_tuple(domains, convertedData));
+	return convertedData;
 }
 
 const shared_ptr<TableConstraintIntermediateData>& TableConstraintData::getIntermediateData() const
@@ -115,47 +144,49 @@ TableConstraint::TableConstraint(const ConstraintFactoryParams& params, const Ta
 
 bool TableConstraint::initialize(IVariableDatabase* db)
 {
-	//
-	// For each variable, find the total set of allowable values
-	//
+	m_intermediateData = m_constraintData->getIntermediateData();
+	m_intermediateData->buildSupportsIfNeeded();
+	vxy_assert(m_intermediateData->numValues.size() == m_variables.size());
 
-	vector<ValueSet> allowableValues;
-	allowableValues.resize(m_variables.size());
+	m_validRows.init(m_intermediateData->tupleRows.size());
+	m_backtrackLevels.clear();
 
-	for (int tupleIndex = 0; tupleIndex < m_constraintData->tupleRows.size(); ++tupleIndex)
+	m_residueOffsets.clear();
+	m_residueOffsets.reserve(m_variables.size());
+	int numResidues = 0;
+	for (VarID variable : m_variables)
 	{
-		for (int variableIndex = 0; variableIndex < m_variables.size(); ++variableIndex)
-		{
-			const int variableValue = m_constraintData->tupleRows[tupleIndex][variableIndex];
-
-			allowableValues[variableIndex].pad(db->getDomainSize(m_variables[variableIndex]), false);
-			allowableValues[variableIndex][variableValue] = true;
-		}
+		m_residueOffsets.push_back(numResidues);
+		numResidues += db->getDomainSize(variable);
 	}
+	m_residues.clear();
+	m_residues.resize(numResidues, 0);
 
 	//
-	// Constrain each variable to exclude values that aren't allowed
+	// Remove any rows that contain values the variables can't have, then constrain each variable to the values
+	// that remain.
 	//
 
 	for (int i = 0; i < m_variables.size(); ++i)
 	{
 		m_watchers.push_back(db->addVariableWatch(m_variables[i], EVariableWatchType::WatchModification, this));
-		if (!db->constrainToValues(m_variables[i], allowableValues[i], this))
+
+		bool changed;
+		if (!resetTable(db, i, changed))
 		{
 			return false;
 		}
 	}
 
-	return true;
+	return filterDomains(db);
 }
 
 void TableConstraint::reset(IVariableDatabase* db)
 {
 	m_intermediateData.reset();
-	m_rowCursors.clear();
-	m_invalidatedRows.clear();
-	m_dependencies.clear();
-	m_backtrackStack.clear();
+	m_backtrackLevels.clear();
+	m_residueOffsets.clear();
+	m_residues.clear();
 
 	for (int i = 0; i < m_watchers.size(); ++i)
 	{
@@ -169,274 +200,149 @@ bool TableConstraint::onVariableNarrowed(IVariableDatabase* db, VarID variable,
 	int variableIndex = indexOf(m_variables.begin(), m_variables.end(), variable);
 	vxy_assert(variableIndex >= 0);
 
-	if (!db->hasFinishedInitialArcConsistency())
+	bool changed = false;
+	if (!updateTable(db, variableIndex, prevValues, changed))
 	{
-		// We haven't yet finished the initial application of constraints, so we can't use Str3 for support resolution.
-		// For now, we just do a naive implementation. Constrain the other variables based on what values the narrowed variable can be.
-		vector<ValueSet> allowableValuesPerVariable;
-		allowableValuesPerVariable.resize(m_variables.size());
-
-		for (const vector<int>& rowTuple : m_constraintData->tupleRows)
-		{
-			if (db->isPossible(variable, rowTuple[variableIndex]))
-			{
-				for (int depVarIndex = 0; depVarIndex != rowTuple.size(); ++depVarIndex)
-				{
-					if (depVarIndex == variableIndex)
-					{
-						continue;
-					}
-					const VarID depVariable = m_variables[depVarIndex];
-					const int depVarValue = rowTuple[depVarIndex];
-
-					allowableValuesPerVariable[depVarIndex].pad(db->getDomainSize(depVariable), false);
-					allowableValuesPerVariable[depVarIndex][depVarValue] = true;
-				}
-			}
-		}
-
-		// Constrain all other dependent variables (excluding the narrowed variable)
-		for (int i = 0; i < m_variables.size(); ++i)
-		{
-			if (i == variableIndex)
-			{
-				continue;
-			}
-
-			if (!db->constrainToValues(m_variables[i], allowableValuesPerVariable[i], this))
-			{
-				return false;
-			}
-		}
+		return false;
 	}
-	else
-	{
-		const ValueSet& curValues = db->getPotentialValues(variable);
 
-		const int prevMembers = m_invalidatedRows.size();
-		for (auto it = prevValues.beginSetBits(), itEnd = prevValues.endSetBits(); it != itEnd; ++it)
-		{
-			const int removedValue = *it;
-			if (curValues[removedValue])
-			{
-				continue;
-			}
+	// Defer filtering until all narrowed variables have been applied to the table.
+	if (changed)
+	{
+		db->queueConstraintPropagation(this);
+	}
+	return true;
+}
 
-			vxy_assert(!m_rowCursors.empty());
-			vxy_assert(removedValue >= 0 && removedValue < m_rowCursors[variableIndex].size());
+bool TableConstraint::propagate(IVariableDatabase* db)
+{
+	return filterDomains(db);
+}
 
-			int cursor = m_rowCursors[variableIndex][removedValue];
+bool TableConstraint::updateTable(IVariableDatabase* db, int variableIndex, const ValueSet& prevValues, bool& outChanged)
+{
+	const ValueSet& curValues = db->getPotentialValues(m_variables[variableIndex]);
 
-			// Add all tuple rows that contain the removed value to the invalidated constraint list.
-			const vector<int>& valueSupportRows = m_intermediateData->supports[variableIndex][removedValue];
-			for (int k = 0; k <= cursor; ++k)
-			{
-				m_invalidatedRows.add(valueSupportRows[k]);
-			}
-		}
+	m_removedValues = prevValues;
+	m_removedValues.exclude(curValues);
 
-		if (m_invalidatedRows.size() == prevMembers)
-		{
-			// Nothing changed
-			return true;
-		}
+	const int numRemoved = m_removedValues.getNumSetBits();
+	if (numRemoved == 0)
+	{
+		return true;
+	}
 
-		BacktrackData& backtrackData = getOrCreateBacktrackData(db->getDecisionLevel(), prevMembers);
+	const int numRemaining = curValues.getNumSetBits();
+	if (numRemaining <= numRemoved)
+	{
+		return resetTable(db, variableIndex, outChanged);
+	}
 
-		// go through any newly invalidated rows, and find new supports for each value of every other variable.
-		for (int i = prevMembers; i < m_invalidatedRows.size(); ++i)
+	// Fewer values were removed than remain: remove the rows that support any of the removed values.
+	recordBacktrackPoint(db);
+	m_validRows.clearMask();
+	for (auto it = m_removedValues.beginSetBits(), itEnd = m_removedValues.endSetBits(); it != itEnd; ++it)
+	{
+		if (auto mask = m_intermediateData->getSupportMask(variableIndex, *it))
 		{
-			const int invalidatedRowIndex = m_invalidatedRows[i];
-
-			// TODO: Find good inline size
-			fixed_vector<tuple<int, int>, 16> dependenciesToRemove;
-
-			// Go through each variable+value tuple that currently depends on this row for support
-			for (auto& depVariableAndValue : m_dependencies[invalidatedRowIndex])
-			{
-				const int depVariableIndex = get<0>(depVariableAndValue);
-				const int depVariableValue = get<1>(depVariableAndValue);
-				VarID depVariable = m_variables[depVariableIndex];
-				if (db->isPossible(depVariable, depVariableValue))
-				{
-					vxy_assert(variable != depVariable);
-
-					//
-					// Look (backwards) through the list of other rows that can support this variable/value. Find the
-					// first row that is still supported.
-					//
-
-					const vector<int>& depSupports = m_intermediateData->supports[depVariableIndex][depVariableValue];
-
-					// Go backwards until we find a row that hasn't already been invalidated.
-					int depCursor = m_rowCursors[depVariableIndex][depVariableValue];
-					while (depCursor >= 0 && m_invalidatedRows.contains(depSupports[depCursor]))
-					{
-						--depCursor;
-					}
-
-					// Has the dependent variable's value run out of supports (i.e. tuples that can still potentially exist)?
-					if (depCursor < 0)
-					{
-						// Remove the value from the variable's potential set, and add any dependent constraints to the propagation queue.
-						if (!db->excludeValue(depVariable, depVariableValue, this))
-						{
-							return false;
-						}
-					}
-					else
-					{
-						// The dependent variable is still supported by some row other than the invalidated one.
-						// Update the cursor, pointing it to the last-most row in the support list that is still supported.
-						if (depCursor != m_rowCursors[depVariableIndex][depVariableValue])
-						{
-							tuple<int, int> indices(depVariableIndex, depVariableValue);
-							if (backtrackData.cursors.find(indices) == backtrackData.cursors.end())
-							{
-								backtrackData.cursors[indices] = m_rowCursors[depVariableIndex][depVariableValue];
-							}
-							m_rowCursors[depVariableIndex][depVariableValue] = depCursor;
-						}
-
-						// The variable+value can no longer depend on this for a support, so we need to point it to
-						// a new support. We've already calculated this (DepCursor). We don't need to store this
-						// modification in backtrack data, because the support will remain valid if/when we backtrack.
-						// See STR3 paper for more detailed explanation.
-
-						dependenciesToRemove.push_back(depVariableAndValue);
-						m_dependencies[depSupports[depCursor]].insert(depVariableAndValue);
-					}
-				}
-			}
-
-			for (auto& depToRemove : dependenciesToRemove)
-			{
-				m_dependencies[invalidatedRowIndex].erase(depToRemove);
-			}
+			m_validRows.addToMask(mask);
 		}
 	}
+	m_validRows.reverseMask();
 
-	return true;
+	outChanged = m_validRows.intersectWithMask();
+	return !m_validRows.isEmpty();
 }
 
-void TableConstraint::backtrack(const IVariableDatabase*, SolverDecisionLevel level)
+bool TableConstraint::resetTable(IVariableDatabase* db, int variableIndex, bool& outChanged)
 {
-	while (m_backtrackStack.back().level > level)
+	const ValueSet& curValues = db->getPotentialValues(m_variables[variableIndex]);
+
+	// Only keep rows that support one of the remaining values.
+	recordBacktrackPoint(db);
+	m_validRows.clearMask();
+	for (auto it = curValues.beginSetBits(), itEnd = curValues.endSetBits(); it != itEnd; ++it)
 	{
-		// Restore data to what it was before this step.
-		BacktrackData& restoreState = m_backtrackStack.back();
-		m_invalidatedRows.backtrack(restoreState.numInvalidatedRows);
-		for (auto it = restoreState.cursors.begin(), itEnd = restoreState.cursors.end(); it != itEnd; ++it)
+		if (auto mask = m_intermediateData->getSupportMask(variableIndex, *it))
 		{
-			const tuple<int, int>& variableAndValueIndices = it->first;
-			m_rowCursors[get<0>(variableAndValueIndices)][get<1>(variableAndValueIndices)] = it->second;
+			m_validRows.addToMask(mask);
 		}
-		m_backtrackStack.pop_back();
 	}
+
+	outChanged = m_validRows.intersectWithMask();
+	return !m_validRows.isEmpty();
 }
 
-void TableConstraint::onInitialArcConsistency(IVariableDatabase* db)
+bool TableConstraint::filterDomains(IVariableDatabase* db)
 {
-	//
-	// Create the final set of tuples: those that are valid after initial arc consistency has been established.
-	// (STR3 only works when the set of tuples is initially arc-consistent)
-	//
-
-	const int numVariables = m_variables.size();
-
-	// First pass: check if any of the original tuples have been invalidated.
-	// If so, we need to use our own tuple set and support table. Otherwise,
-	// we can use a shared one (saving memory and avoiding support table recalculation).
-
-	vxy_assert(m_intermediateData.get() == nullptr);
-
-	bool tuplesChanged = false;
-	for (const vector<int>& row : m_constraintData->tupleRows)
+	for (int variableIndex = 0; variableIndex < m_variables.size(); ++variableIndex)
 	{
-		vxy_assert(row.size() == numVariables);
-		int i = 0;
-		auto found = find_if(m_variables.begin(), m_variables.end(), [&](VarID varID)
-		{
-			return !db->isPossible(varID, row[i++]);
-		});
+		const VarID variable = m_variables[variableIndex];
 
-		if (found != m_variables.end())
+		// Every valid row only contains values that are still possible, so a solved variable is always supported.
+		if (db->isSolved(variable))
 		{
-			tuplesChanged = true;
-			break;
+			continue;
 		}
-	}
 
-	if (!tuplesChanged)
-	{
-		m_intermediateData = m_constraintData->getIntermediateData();
-	}
-	else
-	{
-		// Some tuples are no longer valid, so we need to cull and build our own support table.
-		m_instancedTupleRows.clear();
-		for (const vector<int>& row : m_constraintData->tupleRows)
+		const ValueSet& curValues = db->getPotentialValues(variable);
+		m_removedValues.init(curValues.size(), false);
+
+		bool anyRemoved = false;
+		for (auto it = curValues.beginSetBits(), itEnd = curValues.endSetBits(); it != itEnd; ++it)
 		{
-			vxy_assert(row.size() == numVariables);
-			int i = 0;
-			auto found = find_if(m_variables.begin(), m_variables.end(), [&](VarID v)
-			{
-				return !db->isPossible(v, row[i++]);
-			});
-			if (found != m_variables.end())
+			const int value = *it;
+			auto mask = m_intermediateData->getSupportMask(variableIndex, value);
+			if (mask != nullptr)
 			{
-				m_instancedTupleRows.push_back(row);
+				// Check the last word we found a support in, before searching all of them.
+				int& residue = m_residues[m_residueOffsets[variableIndex] + value];
+				if (m_validRows.intersectsAt(mask, residue))
+				{
+					continue;
+				}
+
+				const int supportIndex = m_validRows.intersectIndex(mask);
+				if (supportIndex >= 0)
+				{
+					residue = supportIndex;
+					continue;
+				}
 			}
+
+			m_removedValues[value] = true;
+			anyRemoved = true;
 		}
 
-		// All potential combinations have already been ruled out.
-		// This should've been caught during Initialize()
-		vxy_assert(m_instancedTupleRows.size() > 0);
-		m_intermediateData = make_shared<TableConstraintIntermediateData>(m_instancedTupleRows);
+		if (anyRemoved && !db->excludeValues(variable, m_removedValues, this))
+		{
+			return false;
+		}
 	}
 
-	m_intermediateData->buildSupportsIfNeeded(db, m_variables);
-	m_invalidatedRows.reserve(m_intermediateData->tupleRows.size());
-
-	//
-	// Set up the cursors for each row. For each variable, for each value, the cursor is set to the last support row that is valid.
-	//
-	// Also create the initial dependency map: for each row, the list of (variable, value) pairs that currently
-	// depend on that row for support.
-	//
-	// Also create the initial backtrack state - needed if we backtrack all the way to the beginning.
-	//
-
-	m_rowCursors.resize(numVariables);
-	m_dependencies.clear();
-	m_dependencies.resize(m_intermediateData->tupleRows.size());
-	auto& backtrackData = getOrCreateBacktrackData(0, 0);
+	return true;
+}
 
-	for (int varIndex = 0; varIndex < numVariables; ++varIndex)
+void TableConstraint::recordBacktrackPoint(IVariableDatabase* db)
+{
+	// Changes at level 0 are permanent.
+	const SolverDecisionLevel level = db->getDecisionLevel();
+	if (level > 0 && (m_backtrackLevels.empty() || m_backtrackLevels.back() != level))
 	{
-		vector<int>& cursorsForRow = m_rowCursors[varIndex];
-		VarID variable = m_variables[varIndex];
-		const vector<vector<int>>& supportsForRow = m_intermediateData->supports[varIndex];
-		vxy_assert(supportsForRow.size() == db->getDomainSize(variable));
-
-		cursorsForRow.resize(supportsForRow.size());
-		for (int value = 0; value < supportsForRow.size(); ++value)
-		{
-			m_dependencies[supportsForRow[value][0]].insert(make_tuple(varIndex, value));
-			cursorsForRow[value] = supportsForRow[value].size() - 1;
-			backtrackData.cursors[make_tuple(varIndex, value)] = cursorsForRow[value];
-		}
+		vxy_assert(m_backtrackLevels.empty() || m_backtrackLevels.back() < level);
+		m_backtrackLevels.push_back(level);
+		m_validRows.pushFrame();
+		db->markConstraintNeedsBacktrack(this);
 	}
 }
 
-TableConstraint::BacktrackData& TableConstraint::getOrCreateBacktrackData(SolverDecisionLevel level, int prevNumInvalidatedRows)
+void TableConstraint::backtrack(const IVariableDatabase*, SolverDecisionLevel level)
 {
-	if (m_backtrackStack.size() == 0 || m_backtrackStack.back().level != level)
+	while (!m_backtrackLevels.empty() && m_backtrackLevels.back() > level)
 	{
-		vxy_assert(m_backtrackStack.empty() || m_backtrackStack.back().level < level);
-		m_backtrackStack.push_back(BacktrackData(level, prevNumInvalidatedRows));
+		m_validRows.popFrame();
+		m_backtrackLevels.pop_back();
 	}
-	return m_backtrackStack.back();
 }
 
 bool TableConstraint::checkConflicting(IVariableDatabase* db) const
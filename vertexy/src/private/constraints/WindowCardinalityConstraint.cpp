@@ -0,0 +1,467 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#include "constraints/WindowCardinalityConstraint.h"
+#include "constraints/ConstraintFactoryParams.h"
+#include "variable/IVariableDatabase.h"
+
+#include <EASTL/algorithm.h>
+
+using namespace Vertexy;
+
+WindowCardinalityConstraint* WindowCardinalityConstraint::WindowCardinalityConstraintFactory::construct(const ConstraintFactoryParams& params, const shared_ptr<PlanarGridTopology>& grid, const shared_ptr<TTopologyVertexData<VarID>>& cellVariables, const vector<int>& countedValues, EWindowShape shape, int size, int minCount, int maxCount)
+{
+	vxy_assert_msg(cellVariables->getData().size() == grid->getNumVertices(), "Cell variables must be defined over the grid");
+	return new WindowCardinalityConstraint(params, grid, cellVariables->getData(), countedValues, shape, size, minCount, maxCount);
+}
+
+WindowCardinalityConstraint::WindowCardinalityConstraint(const ConstraintFactoryParams& params, const shared_ptr<PlanarGridTopology>& grid, const vector<VarID>& cellVariables, const vector<int>& countedValues, EWindowShape shape, int size, int minCount, int maxCount)
+	: IBacktrackingSolverConstraint(params)
+	, m_grid(grid)
+	, m_width(grid->getWidth())
+	, m_height(grid->getHeight())
+	, m_shape(shape)
+	, m_size(size)
+	, m_minCount(minCount)
+	, m_maxCount(maxCount)
+	, m_cellVariables(cellVariables)
+{
+	vxy_assert(m_minCount <= m_maxCount);
+	if (m_shape == EWindowShape::Square)
+	{
+		vxy_assert_msg(m_size > 0 && m_size <= m_width && m_size <= m_height, "Window must fit within the grid");
+		m_numAnchorsX = m_width - m_size + 1;
+		m_numAnchorsY = m_height - m_size + 1;
+	}
+	else
+	{
+		vxy_assert(m_size >= 0);
+		m_numAnchorsX = m_width;
+		m_numAnchorsY = m_height;
+	}
+
+	// Cells with the same domain share a mask of the counted values.
+	vector<SolverVariableDomain> maskDomains;
+	m_cellMasks.resize(m_cellVariables.size(), -1);
+	for (int cell = 0; cell < m_cellVariables.size(); ++cell)
+	{
+		const VarID var = m_cellVariables[cell];
+		if (!var.isValid())
+		{
+			continue;
+		}
+
+		vxy_assert_msg(m_variableToCell.find(var) == m_variableToCell.end(), "Variable appears in multiple cells");
+		m_variableToCell[var] = cell;
+
+		const SolverVariableDomain& domain = params.getDomain(var);
+		auto found = find(maskDomains.begin(), maskDomains.end(), domain);
+		if (found != maskDomains.end())
+		{
+			m_cellMasks[cell] = found - maskDomains.begin();
+			continue;
+		}
+
+		ValueSet mask(domain.getDomainSize(), false);
+		for (int value : countedValues)
+		{
+			int index;
+			if (domain.getIndexForValue(value, index))
+			{
+				mask[index] = true;
+			}
+		}
+
+		m_cellMasks[cell] = m_countedMasks.size();
+		maskDomains.push_back(domain);
+		m_countedMasks.push_back(mask);
+	}
+
+	const int numWindows = m_numAnchorsX * m_numAnchorsY;
+	m_windowPending.resize(numWindows, false);
+}
+
+vector<VarID> WindowCardinalityConstraint::getConstrainingVariables() const
+{
+	vector<VarID> out;
+	out.reserve(m_variableToCell.size());
+	for (VarID var : m_cellVariables)
+	{
+		if (var.isValid())
+		{
+			out.push_back(var);
+		}
+	}
+	return out;
+}
+
+bool WindowCardinalityConstraint::initialize(IVariableDatabase* db)
+{
+	m_trail.clear();
+	m_backtrackStack.clear();
+	m_backtrackStack.push_back({0, 0});
+	m_conflictWindow = -1;
+
+	m_cellStates.resize(m_cellVariables.size());
+	for (int cell = 0; cell < m_cellVariables.size(); ++cell)
+	{
+		if (m_cellVariables[cell].isValid())
+		{
+			m_watchers.push_back(db->addVariableWatch(m_cellVariables[cell], EVariableWatchType::WatchModification, this));
+		}
+		m_cellStates[cell] = getCellState(db, cell);
+	}
+
+	computeWindowCounts(db, m_countedCells, m_possibleCells);
+
+	clearPendingWindows();
+	for (int window = 0; window < m_countedCells.size(); ++window)
+	{
+		if (isViolated(window) || isTight(window))
+		{
+			m_pendingWindows.push_back(window);
+			m_windowPending[window] = true;
+		}
+	}
+
+	return propagate(db);
+}
+
+void WindowCardinalityConstraint::reset(IVariableDatabase* db)
+{
+	int watchIndex = 0;
+	for (VarID var : m_cellVariables)
+	{
+		if (var.isValid())
+		{
+			db->removeVariableWatch(var, m_watchers[watchIndex], this);
+			++watchIndex;
+		}
+	}
+	m_watchers.clear();
+}
+
+bool WindowCardinalityConstraint::onVariableNarrowed(IVariableDatabase* db, VarID variable, const ValueSet&, bool&)
+{
+	auto found = m_variableToCell.find(variable);
+	vxy_assert(found != m_variableToCell.end());
+
+	updateCell(db, found->second);
+	if (!m_pendingWindows.empty())
+	{
+		db->queueConstraintPropagation(this);
+	}
+	return true;
+}
+
+bool WindowCardinalityConstraint::propagate(IVariableDatabase* db)
+{
+	while (!m_pendingWindows.empty())
+	{
+		const int window = m_pendingWindows.back();
+		m_pendingWindows.pop_back();
+		m_windowPending[window] = false;
+
+		if (isViolated(window))
+		{
+			m_conflictWindow = window;
+			clearPendingWindows();
+			return false;
+		}
+		else if (!isTight(window))
+		{
+			continue;
+		}
+
+		// Either every remaining cell must be uncounted (maximum reached), or every remaining cell must be counted
+		// (minimum reached). Both can't happen at once, since the window still has undecided cells.
+		const bool upper = m_countedCells[window] == m_maxCount;
+
+		int minX, minY, maxX, maxY;
+		getWindowRect(window, minX, minY, maxX, maxY);
+		for (int y = minY; y <= maxY; ++y)
+		{
+			for (int x = minX; x <= maxX; ++x)
+			{
+				const int cell = m_grid->coordinateToIndex(x, y);
+				if (m_cellStates[cell] != Undecided)
+				{
+					continue;
+				}
+
+				const VarID var = m_cellVariables[cell];
+				const ValueSet& mask = m_countedMasks[m_cellMasks[cell]];
+				if (upper)
+				{
+					if (!db->excludeValues(var, mask, this, makeExplainer(window, true)))
+					{
+						clearPendingWindows();
+						return false;
+					}
+				}
+				else if (!db->constrainToValues(var, mask, this, makeExplainer(window, false)))
+				{
+					clearPendingWindows();
+					return false;
+				}
+
+				updateCell(db, cell);
+			}
+		}
+	}
+
+	return true;
+}
+
+void WindowCardinalityConstraint::backtrack(const IVariableDatabase* db, SolverDecisionLevel level)
+{
+	clearPendingWindows();
+	while (m_backtrackStack.back().level > level)
+	{
+		const BacktrackInfo& info = m_backtrackStack.back();
+		for (int i = m_trail.size() - 1; i >= info.trailSize; --i)
+		{
+			setCellState(m_trail[i].cell, m_trail[i].state, false);
+		}
+		m_trail.resize(info.trailSize);
+		m_backtrackStack.pop_back();
+	}
+}
+
+bool WindowCardinalityConstraint::checkConflicting(IVariableDatabase* db) const
+{
+	vector<int> counted, possible;
+	computeWindowCounts(db, counted, possible);
+	for (int window = 0; window < counted.size(); ++window)
+	{
+		if (counted[window] > m_maxCount || possible[window] < m_minCount)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+WindowCardinalityConstraint::ECellState WindowCardinalityConstraint::getCellState(const IVariableDatabase* db, int cell) const
+{
+	const VarID var = m_cellVariables[cell];
+	if (!var.isValid())
+	{
+		return NotCounted;
+	}
+
+	const ValueSet& values = db->getPotentialValues(var);
+	const ValueSet& mask = m_countedMasks[m_cellMasks[cell]];
+	if (!values.anyPossible(mask))
+	{
+		return NotCounted;
+	}
+	return values.isSubsetOf(mask) ? Counted : Undecided;
+}
+
+void WindowCardinalityConstraint::updateCell(IVariableDatabase* db, int cell)
+{
+	const ECellState newState = getCellState(db, cell);
+	if (newState == m_cellStates[cell])
+	{
+		return;
+	}
+
+	const SolverDecisionLevel level = db->getDecisionLevel();
+	if (level > 0)
+	{
+		if (m_backtrackStack.back().level != level)
+		{
+			vxy_assert(m_backtrackStack.back().level < level);
+			m_backtrackStack.push_back({level, int(m_trail.size())});
+			db->markConstraintNeedsBacktrack(this);
+		}
+		m_trail.push_back({cell, m_cellStates[cell]});
+	}
+
+	setCellState(cell, newState, true);
+}
+
+void WindowCardinalityConstraint::setCellState(int cell, ECellState state, bool queueWindows)
+{
+	const ECellState oldState = m_cellStates[cell];
+	const int countedDelta = int(state == Counted) - int(oldState == Counted);
+	const int possibleDelta = int(state != NotCounted) - int(oldState != NotCounted);
+	m_cellStates[cell] = state;
+
+	int minX, minY, maxX, maxY;
+	if (!getWindowsForCell(cell, minX, minY, maxX, maxY))
+	{
+		return;
+	}
+
+	for (int ay = minY; ay <= maxY; ++ay)
+	{
+		for (int ax = minX; ax <= maxX; ++ax)
+		{
+			const int window = ay * m_numAnchorsX + ax;
+			m_countedCells[window] += countedDelta;
+			m_possibleCells[window] += possibleDelta;
+
+			if (queueWindows && !m_windowPending[window] && (isViolated(window) || isTight(window)))
+			{
+				m_pendingWindows.push_back(window);
+				m_windowPending[window] = true;
+			}
+		}
+	}
+}
+
+void WindowCardinalityConstraint::computeWindowCounts(const IVariableDatabase* db, vector<int>& outCounted, vector<int>& outPossible) const
+{
+	// Prefix[(y+1)*(Width+1) + (x+1)] = number of cells in the rectangle [0,x]x[0,y].
+	const int stride = m_width + 1;
+	vector<int> countedPrefix((m_height + 1) * stride, 0);
+	vector<int> possiblePrefix((m_height + 1) * stride, 0);
+	for (int y = 0; y < m_height; ++y)
+	{
+		for (int x = 0; x < m_width; ++x)
+		{
+			const ECellState state = getCellState(db, m_grid->coordinateToIndex(x, y));
+			const int idx = (y + 1) * stride + (x + 1);
+			countedPrefix[idx] = countedPrefix[idx - 1] + countedPrefix[idx - stride] - countedPrefix[idx - stride - 1] + (state == Counted ? 1 : 0);
+			possiblePrefix[idx] = possiblePrefix[idx - 1] + possiblePrefix[idx - stride] - possiblePrefix[idx - stride - 1] + (state != NotCounted ? 1 : 0);
+		}
+	}
+
+	auto sumRect = [&](const vector<int>& prefix, int minX, int minY, int maxX, int maxY)
+	{
+		return prefix[(maxY + 1) * stride + (maxX + 1)] - prefix[minY * stride + (maxX + 1)] - prefix[(maxY + 1) * stride + minX] + prefix[minY * stride + minX];
+	};
+
+	const int numWindows = m_numAnchorsX * m_numAnchorsY;
+	outCounted.resize(numWindows);
+	outPossible.resize(numWindows);
+	for (int window = 0; window < numWindows; ++window)
+	{
+		int minX, minY, maxX, maxY;
+		getWindowRect(window, minX, minY, maxX, maxY);
+		outCounted[window] = sumRect(countedPrefix, minX, minY, maxX, maxY);
+		outPossible[window] = sumRect(possiblePrefix, minX, minY, maxX, maxY);
+	}
+}
+
+void WindowCardinalityConstraint::clearPendingWindows()
+{
+	for (int window : m_pendingWindows)
+	{
+		m_windowPending[window] = false;
+	}
+	m_pendingWindows.clear();
+}
+
+void WindowCardinalityConstraint::getWindowRect(int window, int& outMinX, int& outMinY, int& outMaxX, int& outMaxY) const
+{
+	const int ax = window % m_numAnchorsX;
+	const int ay = window / m_numAnchorsX;
+	if (m_shape == EWindowShape::Square)
+	{
+		outMinX = ax;
+		outMinY = ay;
+		outMaxX = ax + m_size - 1;
+		outMaxY = ay + m_size - 1;
+	}
+	else
+	{
+		outMinX = max(0, ax - m_size);
+		outMinY = max(0, ay - m_size);
+		outMaxX = min(m_width - 1, ax + m_size);
+		outMaxY = min(m_height - 1, ay + m_size);
+	}
+}
+
+bool WindowCardinalityConstraint::getWindowsForCell(int cell, int& outMinX, int& outMinY, int& outMaxX, int& outMaxY) const
+{
+	int x, y;
+	m_grid->indexToCoordinate(cell, x, y);
+	if (m_shape == EWindowShape::Square)
+	{
+		outMinX = max(0, x - m_size + 1);
+		outMinY = max(0, y - m_size + 1);
+		outMaxX = min(x, m_numAnchorsX - 1);
+		outMaxY = min(y, m_numAnchorsY - 1);
+	}
+	else
+	{
+		outMinX = max(0, x - m_size);
+		outMinY = max(0, y - m_size);
+		outMaxX = min(m_width - 1, x + m_size);
+		outMaxY = min(m_height - 1, y + m_size);
+	}
+	return outMinX <= outMaxX && outMinY <= outMaxY;
+}
+
+ExplainerFunction WindowCardinalityConstraint::makeExplainer(int window, bool upper)
+{
+	return [this, window, upper](const NarrowingExplanationParams& params, vector<Literal>& outExplanation)
+	{
+		// The database is as it was immediately before the narrowing being explained.
+		auto db = params.database;
+		const VarID propagatedVar = params.propagatedVariable;
+
+		// Values that were removed by the narrowing. If the variable became contradictory, that's all of them.
+		ValueSet removed = db->getPotentialValues(propagatedVar);
+		if (!params.propagatedValues.isZero())
+		{
+			removed.exclude(params.propagatedValues);
+		}
+
+		outExplanation.clear();
+		outExplanation.push_back(Literal(propagatedVar, removed.inverted()));
+		explainWindow(db, window, upper, propagatedVar, outExplanation);
+	};
+}
+
+void WindowCardinalityConstraint::explain(const NarrowingExplanationParams& params, vector<Literal>& outExplanation) const
+{
+	// Every narrowing has its own explainer, so this is only called for a window found to be violated.
+	vxy_assert(!params.propagatedVariable.isValid());
+	vxy_assert(m_conflictWindow >= 0);
+
+	auto db = params.database;
+
+	int minX, minY, maxX, maxY;
+	getWindowRect(m_conflictWindow, minX, minY, maxX, maxY);
+	int numCounted = 0;
+	for (int y = minY; y <= maxY; ++y)
+	{
+		for (int x = minX; x <= maxX; ++x)
+		{
+			if (getCellState(db, m_grid->coordinateToIndex(x, y)) == Counted)
+			{
+				++numCounted;
+			}
+		}
+	}
+
+	outExplanation.clear();
+	explainWindow(db, m_conflictWindow, numCounted > m_maxCount, VarID::INVALID, outExplanation);
+}
+
+void WindowCardinalityConstraint::explainWindow(const IVariableDatabase* db, int window, bool upper, VarID skipVar, vector<Literal>& outExplanation) const
+{
+	// For the maximum, each counted cell could have been uncounted. For the minimum, each uncounted cell could have
+	// been counted.
+	const ECellState reasonState = upper ? Counted : NotCounted;
+
+	int minX, minY, maxX, maxY;
+	getWindowRect(window, minX, minY, maxX, maxY);
+	for (int y = minY; y <= maxY; ++y)
+	{
+		for (int x = minX; x <= maxX; ++x)
+		{
+			const int cell = m_grid->coordinateToIndex(x, y);
+			const VarID var = m_cellVariables[cell];
+			if (!var.isValid() || var == skipVar || getCellState(db, cell) != reasonState)
+			{
+				continue;
+			}
+
+			const ValueSet& mask = m_countedMasks[m_cellMasks[cell]];
+			outExplanation.push_back(Literal(var, upper ? mask.inverted() : mask));
+		}
+	}
+}
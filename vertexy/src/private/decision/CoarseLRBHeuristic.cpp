@@ -54,44 +54,20 @@ bool CoarseLRBHeuristic::getNextDecision(SolverDecisionLevel level, VarID& var,
 		return false;
 	}
 
-	uint32_t heapValue = m_heap.peek();
-	vxy_assert(heapValue > 0);
-
-	uint32_t age = m_learntCounter - m_unassigned[heapValue];
-	while (age > 0)
-	{
-		float decay = powf(RECENCY_DECAY, age);
-		m_priorities[heapValue] *= decay;
-		m_heap.update(heapValue);
-		m_unassigned[heapValue] = m_learntCounter;
-
-		heapValue = m_heap.peek();
-		age = m_learntCounter - m_unassigned[heapValue];
-	}
-
-	var = VarID(heapValue);
+	var = VarID(peekDecayed());
 	vxy_assert(var.isValid());
 
 	const ValueSet& potentials = db->getPotentialValues(var);
 
 	int value;
-	if (m_solver.getVariableDB()->getLastSolvedValue(var, value) && potentials[value])
+	if (m_solver.getPhaseManager().getPreferredValue(var, potentials, value))
 	{
 		//VERTEXY_LOG("Picking prev value %d = %d", Var, Value);
 	}
 	else
 	{
-		// pick a random bit to set
-		const int numVals = potentials.getNumSetBits();
-		const int randomIndex = m_solver.randomRange(0, numVals - 1);
-
-		auto it = potentials.beginSetBits();
-		for (int i = 0; i < randomIndex; ++i)
-		{
-			++it;
-			++i;
-		}
-		value = *it;
+		// pick a random (possibly weighted) bit to set
+		value = m_solver.sampleValue(var, potentials);
 	}
 
 	chosenValues.pad(db->getDomainSize(var), false);
@@ -100,14 +76,53 @@ bool CoarseLRBHeuristic::getNextDecision(SolverDecisionLevel level, VarID& var,
 	return true;
 }
 
+bool CoarseLRBHeuristic::getNextDecisionPriority(double& outPriority)
+{
+	if (m_heap.empty())
+	{
+		return false;
+	}
+	outPriority = m_priorities[peekDecayed()];
+	return true;
+}
+
+bool CoarseLRBHeuristic::getDecisionCandidates(int maxCandidates, vector<VarID>& outCandidates)
+{
+	outCandidates.clear();
+	while (outCandidates.size() < maxCandidates && !m_heap.empty())
+	{
+		peekDecayed();
+		outCandidates.push_back(VarID(m_heap.removeMin()));
+	}
+	for (VarID candidate : outCandidates)
+	{
+		m_heap.insert(candidate.raw());
+	}
+	return true;
+}
+
+uint32_t CoarseLRBHeuristic::peekDecayed()
+{
+	uint32_t heapValue = m_heap.peek();
+	uint32_t age = m_learntCounter - m_unassigned[heapValue];
+	while (age > 0)
+	{
+		float decay = powf(RECENCY_DECAY, age);
+		m_priorities[heapValue] *= decay;
+		m_heap.update(heapValue);
+		m_unassigned[heapValue] = m_learntCounter;
+
+		heapValue = m_heap.peek();
+		age = m_learntCounter - m_unassigned[heapValue];
+	}
+	return heapValue;
+}
+
 void CoarseLRBHeuristic::onVariableAssignment(VarID var, const ValueSet& prevValues, const ValueSet& newValues)
 {
 	if (newValues.isSingleton())
 	{
-		m_assigned[var.raw()] = m_learntCounter;
-		m_participated[var.raw()] = 0;
-		m_reasoned[var.raw()] = 0;
-		m_heap.remove(var.raw());
+		onSolved(var);
 	}
 }
 
@@ -115,22 +130,62 @@ void CoarseLRBHeuristic::onVariableUnassignment(VarID var, const ValueSet& befor
 {
 	if (beforeBacktrack.isSingleton())
 	{
-		if (!m_heap.inHeap(var.raw()))
+		onUnsolved(var);
+	}
+}
+
+void CoarseLRBHeuristic::onVariablesAssigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last)
+{
+	auto& stack = db.getAssignmentStack().getStack();
+	for (SolverTimestamp t = first; t <= last; ++t)
+	{
+		const VarID var = stack[t].variable;
+		if (m_heap.inHeap(var.raw()) && db.getPotentialValues(var).isSingleton())
 		{
-			const float interval = float(m_learntCounter - m_assigned[var.raw()]);
-			if (interval > 0)
-			{
-				const float r = m_participated[var.raw()] / interval; // Learning rate
-				const float rsr = m_reasoned[var.raw()] / interval; // Reason side rate
-				m_priorities[var.raw()] = (1.0f - m_stepSize) * m_priorities[var.raw()] + m_stepSize * (r + rsr);
-			}
-
-			m_heap.insert(var.raw());
+			onSolved(var);
 		}
-		m_unassigned[var.raw()] = m_learntCounter;
 	}
 }
 
+void CoarseLRBHeuristic::onVariablesUnassigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last)
+{
+	auto& stack = db.getAssignmentStack().getStack();
+	for (SolverTimestamp t = first; t <= last; ++t)
+	{
+		// The earliest modification in the range holds the value the variable will have after backtracking.
+		auto& mod = stack[t];
+		if (mod.previousVariableAssignment < first && !mod.previousValue.isSingleton() && !m_heap.inHeap(mod.variable.raw()))
+		{
+			onUnsolved(mod.variable);
+		}
+	}
+}
+
+void CoarseLRBHeuristic::onSolved(VarID var)
+{
+	m_assigned[var.raw()] = m_learntCounter;
+	m_participated[var.raw()] = 0;
+	m_reasoned[var.raw()] = 0;
+	m_heap.remove(var.raw());
+}
+
+void CoarseLRBHeuristic::onUnsolved(VarID var)
+{
+	if (!m_heap.inHeap(var.raw()))
+	{
+		const float interval = float(m_learntCounter - m_assigned[var.raw()]);
+		if (interval > 0)
+		{
+			const float r = m_participated[var.raw()] / interval; // Learning rate
+			const float rsr = m_reasoned[var.raw()] / interval; // Reason side rate
+			m_priorities[var.raw()] = (1.0f - m_stepSize) * m_priorities[var.raw()] + m_stepSize * (r + rsr);
+		}
+
+		m_heap.insert(var.raw());
+	}
+	m_unassigned[var.raw()] = m_learntCounter;
+}
+
 void CoarseLRBHeuristic::onVariableConflictActivity(VarID var, const ValueSet& values, const ValueSet& prevValues)
 {
 	m_participated[var.raw()]++;
@@ -0,0 +1,182 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#include "decision/EntropyHeuristic.h"
+
+#include "ConstraintSolver.h"
+
+using namespace Vertexy;
+
+// Maximum magnitude of the random noise added to each variable's entropy, to break ties
+static constexpr double ENTROPY_NOISE = 1e-6;
+
+EntropyHeuristic::EntropyHeuristic(ConstraintSolver& solver)
+	: m_solver(solver)
+	, m_heap(Comparator(m_entropies))
+{
+}
+
+void EntropyHeuristic::setVariableWeights(VarID varID, const shared_ptr<const vector<float>>& weights)
+{
+	vxy_assert(varID.isValid());
+	vxy_assert(weights != nullptr);
+	vxy_assert(!m_solver.hasFinishedInitialArcConsistency());
+
+	if (varID.raw() >= m_weights.size())
+	{
+		m_weights.resize(varID.raw() + 1, nullptr);
+	}
+	m_weights[varID.raw()] = weights;
+	m_sampler.setWeights(varID, weights);
+}
+
+void EntropyHeuristic::initialize()
+{
+	auto db = m_solver.getVariableDB();
+	const int numVars = db->getNumVariables();
+
+	m_weights.resize(numVars + 1, nullptr);
+	m_weightSums.resize(numVars + 1, 0.0);
+	m_weightLogWeightSums.resize(numVars + 1, 0.0);
+	m_noise.resize(numVars + 1, 0.0);
+	m_entropies.resize(numVars + 1, 0.0);
+	m_heap.reserve(numVars + 1);
+
+	for (int i = 1; i < numVars + 1; ++i)
+	{
+		const VarID varID(i);
+		if (!isManaged(varID))
+		{
+			continue;
+		}
+		vxy_assert_msg(m_weights[i]->size() >= db->getDomainSize(varID), "Not enough weights for variable %s", db->getVariableName(varID).c_str());
+
+		const ValueSet& potentials = db->getPotentialValues(varID);
+		for (auto it = potentials.beginSetBits(), itEnd = potentials.endSetBits(); it != itEnd; ++it)
+		{
+			addValue(varID, *it, 1.0);
+		}
+
+		m_noise[i] = m_solver.randomRangeFloat(0.0, ENTROPY_NOISE);
+		updateEntropy(varID);
+
+		if (!potentials.isSingleton())
+		{
+			m_heap.insert(i);
+		}
+	}
+}
+
+void EntropyHeuristic::addValue(VarID varID, int value, double sign)
+{
+	const double weight = (*m_weights[varID.raw()])[value];
+	if (weight > 0.0)
+	{
+		m_weightSums[varID.raw()] += sign * weight;
+		m_weightLogWeightSums[varID.raw()] += sign * weight * log(weight);
+	}
+}
+
+void EntropyHeuristic::updateEntropy(VarID varID)
+{
+	// H = -sum(p*log(p)), where p = w/W. This simplifies to log(W) - sum(w*log(w))/W.
+	const double sum = m_weightSums[varID.raw()];
+	const double entropy = sum > 0.0 ? (log(sum) - m_weightLogWeightSums[varID.raw()] / sum) : 0.0;
+	m_entropies[varID.raw()] = entropy + m_noise[varID.raw()];
+}
+
+bool EntropyHeuristic::getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues)
+{
+	if (m_heap.empty())
+	{
+		return false;
+	}
+
+	auto db = m_solver.getVariableDB();
+
+	var = VarID(m_heap.peek());
+	vxy_sanity(!db->isSolved(var));
+
+	const int value = m_sampler.sample(var, db->getPotentialValues(var), m_solver.randomFloat<float>());
+
+	chosenValues.pad(db->getDomainSize(var), false);
+	chosenValues[value] = true;
+	return true;
+}
+
+void EntropyHeuristic::onVariableAssignment(VarID var, const ValueSet& prevValues, const ValueSet& newValues)
+{
+	if (!isManaged(var))
+	{
+		return;
+	}
+
+	for (auto it = prevValues.beginSetBits(), itEnd = prevValues.endSetBits(); it != itEnd; ++it)
+	{
+		if (!newValues[*it])
+		{
+			addValue(var, *it, -1.0);
+		}
+	}
+	updateEntropy(var);
+
+	if (newValues.isSingleton() || newValues.isZero())
+	{
+		if (m_heap.inHeap(var.raw()))
+		{
+			m_heap.remove(var.raw());
+		}
+	}
+	else if (m_heap.inHeap(var.raw()))
+	{
+		m_heap.update(var.raw());
+	}
+}
+
+void EntropyHeuristic::onVariableUnassignment(VarID var, const ValueSet& beforeBacktrack, const ValueSet& afterBacktrack)
+{
+	if (!isManaged(var))
+	{
+		return;
+	}
+
+	for (auto it = afterBacktrack.beginSetBits(), itEnd = afterBacktrack.endSetBits(); it != itEnd; ++it)
+	{
+		if (!beforeBacktrack[*it])
+		{
+			addValue(var, *it, 1.0);
+		}
+	}
+	updateEntropy(var);
+
+	if (!afterBacktrack.isSingleton())
+	{
+		m_heap.update(var.raw());
+	}
+}
+
+void EntropyHeuristic::onVariablesAssigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last)
+{
+	auto& stack = db.getAssignmentStack().getStack();
+	for (SolverTimestamp t = first; t <= last; ++t)
+	{
+		// The earliest modification in the range holds the value the variable had before the range.
+		auto& mod = stack[t];
+		if (mod.previousVariableAssignment < first)
+		{
+			onVariableAssignment(mod.variable, mod.previousValue, db.getPotentialValues(mod.variable));
+		}
+	}
+}
+
+void EntropyHeuristic::onVariablesUnassigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last)
+{
+	auto& stack = db.getAssignmentStack().getStack();
+	for (SolverTimestamp t = first; t <= last; ++t)
+	{
+		// The earliest modification in the range holds the value the variable will have after backtracking.
+		auto& mod = stack[t];
+		if (mod.previousVariableAssignment < first)
+		{
+			onVariableUnassignment(mod.variable, db.getPotentialValues(mod.variable), mod.previousValue);
+		}
+	}
+}
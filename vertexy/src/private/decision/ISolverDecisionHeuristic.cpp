@@ -0,0 +1,26 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#include "decision/ISolverDecisionHeuristic.h"
+
+#include "variable/SolverVariableDatabase.h"
+
+using namespace Vertexy;
+
+void ISolverDecisionHeuristic::onVariablesAssigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last)
+{
+	auto& stack = db.getAssignmentStack().getStack();
+	for (SolverTimestamp t = first; t <= last; ++t)
+	{
+		auto& mod = stack[t];
+		onVariableAssignment(mod.variable, mod.previousValue, db.getValueAfter(mod.variable, t));
+	}
+}
+
+void ISolverDecisionHeuristic::onVariablesUnassigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last)
+{
+	auto& stack = db.getAssignmentStack().getStack();
+	for (SolverTimestamp t = last; t >= first; --t)
+	{
+		auto& mod = stack[t];
+		onVariableUnassignment(mod.variable, db.getValueAfter(mod.variable, t), mod.previousValue);
+	}
+}
@@ -0,0 +1,249 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#include "decision/LRBHeuristic.h"
+
+#include "ConstraintSolver.h"
+#include "variable/IVariableDatabase.h"
+
+using namespace Vertexy;
+
+static constexpr float MIN_STEP_SIZE = 0.06f;
+static constexpr float STEP_DECAY_SIZE = 10e-6f;
+static constexpr float RECENCY_DECAY = 0.99f;
+static constexpr float EMA_SEED_RANGE = 0.75f;
+static constexpr bool USE_REASON_ACTIVITY = false;
+
+LRBHeuristic::LRBHeuristic(ConstraintSolver& solver)
+	: m_solver(solver)
+	, m_heap(Comparator(m_priorities))
+	, m_wantReasonActivity(USE_REASON_ACTIVITY)
+	, m_stepSize(0.4)
+	, m_learntCounter(0)
+{
+}
+
+void LRBHeuristic::initialize()
+{
+	auto db = m_solver.getVariableDB();
+	int numVars = db->getNumVariables();
+
+	m_keyOffsets.resize(numVars + 1, 0);
+	m_keyToVar.clear();
+	m_keyToVar.push_back(VarID::INVALID); // dummy for invalid var
+	for (int i = 1; i < numVars + 1; ++i)
+	{
+		m_keyOffsets[i] = m_keyToVar.size();
+		m_keyToVar.insert(m_keyToVar.end(), db->getDomainSize(VarID(i)), VarID(i));
+	}
+
+	const int numKeys = m_keyToVar.size();
+	m_heap.reserve(numKeys);
+	m_priorities.resize(numKeys, 0);
+
+	m_assigned.resize(numKeys, 0);
+	m_unassigned.resize(numKeys, 0);
+	m_participated.resize(numKeys, 0);
+	m_reasoned.resize(numKeys, 0);
+
+	for (int i = 1; i < numVars + 1; ++i)
+	{
+		const VarID varID(i);
+		if (db->isSolved(varID))
+		{
+			continue;
+		}
+
+		const ValueSet& potentials = db->getPotentialValues(varID);
+		for (auto it = potentials.beginSetBits(), itEnd = potentials.endSetBits(); it != itEnd; ++it)
+		{
+			// Initialize with random values so seed actually matters
+			const uint32_t key = getKey(varID, *it);
+			m_priorities[key] = m_solver.randomRangeFloat(0.f, EMA_SEED_RANGE);
+			m_heap.insert(key);
+		}
+	}
+}
+
+bool LRBHeuristic::getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues)
+{
+	auto db = m_solver.getVariableDB();
+	if (m_heap.empty())
+	{
+		return false;
+	}
+
+	const uint32_t key = peekDecayed();
+	var = m_keyToVar[key];
+	vxy_assert(var.isValid());
+
+	const int value = key - m_keyOffsets[var.raw()];
+	vxy_sanity(db->getPotentialValues(var)[value]);
+
+	chosenValues.pad(db->getDomainSize(var), false);
+	chosenValues[value] = true;
+
+	return true;
+}
+
+bool LRBHeuristic::getNextDecisionPriority(double& outPriority)
+{
+	if (m_heap.empty())
+	{
+		return false;
+	}
+	outPriority = m_priorities[peekDecayed()];
+	return true;
+}
+
+bool LRBHeuristic::getDecisionCandidates(int maxCandidates, vector<VarID>& outCandidates)
+{
+	// Pop keys until we've seen enough distinct variables, then put them all back.
+	outCandidates.clear();
+	m_poppedKeys.clear();
+	while (outCandidates.size() < maxCandidates && !m_heap.empty())
+	{
+		peekDecayed();
+		const uint32_t key = m_heap.removeMin();
+		m_poppedKeys.push_back(key);
+
+		const VarID var = m_keyToVar[key];
+		if (!contains(outCandidates.begin(), outCandidates.end(), var))
+		{
+			outCandidates.push_back(var);
+		}
+	}
+	for (uint32_t key : m_poppedKeys)
+	{
+		m_heap.insert(key);
+	}
+	return true;
+}
+
+uint32_t LRBHeuristic::peekDecayed()
+{
+	uint32_t key = m_heap.peek();
+	uint32_t age = m_learntCounter - m_unassigned[key];
+	while (age > 0)
+	{
+		float decay = powf(RECENCY_DECAY, age);
+		m_priorities[key] *= decay;
+		m_heap.update(key);
+		m_unassigned[key] = m_learntCounter;
+
+		key = m_heap.peek();
+		age = m_learntCounter - m_unassigned[key];
+	}
+	return key;
+}
+
+void LRBHeuristic::removeKey(uint32_t key)
+{
+	if (m_heap.inHeap(key))
+	{
+		m_assigned[key] = m_learntCounter;
+		m_participated[key] = 0;
+		m_reasoned[key] = 0;
+		m_heap.remove(key);
+	}
+}
+
+void LRBHeuristic::restoreKey(uint32_t key)
+{
+	if (!m_heap.inHeap(key))
+	{
+		const float interval = float(m_learntCounter - m_assigned[key]);
+		if (interval > 0)
+		{
+			const float r = m_participated[key] / interval; // Learning rate
+			const float rsr = m_reasoned[key] / interval; // Reason side rate
+			m_priorities[key] = (1.0f - m_stepSize) * m_priorities[key] + m_stepSize * (r + rsr);
+		}
+
+		m_heap.insert(key);
+		m_unassigned[key] = m_learntCounter;
+	}
+}
+
+void LRBHeuristic::onVariableAssignment(VarID var, const ValueSet& prevValues, const ValueSet& newValues)
+{
+	// Once solved, none of the variable's values are candidates. Otherwise, only the values that were just removed.
+	const bool solved = newValues.isSingleton();
+	for (auto it = prevValues.beginSetBits(), itEnd = prevValues.endSetBits(); it != itEnd; ++it)
+	{
+		if (solved || !newValues[*it])
+		{
+			removeKey(getKey(var, *it));
+		}
+	}
+}
+
+void LRBHeuristic::onVariableUnassignment(VarID var, const ValueSet& beforeBacktrack, const ValueSet& afterBacktrack)
+{
+	if (afterBacktrack.isSingleton())
+	{
+		return;
+	}
+
+	for (auto it = afterBacktrack.beginSetBits(), itEnd = afterBacktrack.endSetBits(); it != itEnd; ++it)
+	{
+		restoreKey(getKey(var, *it));
+	}
+}
+
+void LRBHeuristic::onVariablesAssigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last)
+{
+	auto& stack = db.getAssignmentStack().getStack();
+	for (SolverTimestamp t = first; t <= last; ++t)
+	{
+		// The earliest modification in the range holds the value the variable had before the range.
+		auto& mod = stack[t];
+		if (mod.previousVariableAssignment < first)
+		{
+			onVariableAssignment(mod.variable, mod.previousValue, db.getPotentialValues(mod.variable));
+		}
+	}
+}
+
+void LRBHeuristic::onVariablesUnassigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last)
+{
+	auto& stack = db.getAssignmentStack().getStack();
+	for (SolverTimestamp t = first; t <= last; ++t)
+	{
+		// The earliest modification in the range holds the value the variable will have after backtracking.
+		auto& mod = stack[t];
+		if (mod.previousVariableAssignment < first)
+		{
+			onVariableUnassignment(mod.variable, db.getPotentialValues(mod.variable), mod.previousValue);
+		}
+	}
+}
+
+void LRBHeuristic::onVariableConflictActivity(VarID var, const ValueSet& values, const ValueSet& prevValues)
+{
+	// The learned clause requires the variable to take one of these values. Those values are currently ruled out, so
+	// credit each one that is out of the heap: they are what the clause is learning about.
+	for (auto it = values.beginSetBits(), itEnd = values.endSetBits(); it != itEnd; ++it)
+	{
+		const uint32_t key = getKey(var, *it);
+		if (!m_heap.inHeap(key))
+		{
+			m_participated[key]++;
+		}
+	}
+}
+
+void LRBHeuristic::onVariableReasonActivity(VarID var, const ValueSet& values, const ValueSet& prevValues)
+{
+	for (auto it = values.beginSetBits(), itEnd = values.endSetBits(); it != itEnd; ++it)
+	{
+		if (prevValues[*it])
+		{
+			m_reasoned[getKey(var, *it)]++;
+		}
+	}
+}
+
+void LRBHeuristic::onClauseLearned()
+{
+	++m_learntCounter;
+	m_stepSize = max(MIN_STEP_SIZE, m_stepSize - STEP_DECAY_SIZE);
+}
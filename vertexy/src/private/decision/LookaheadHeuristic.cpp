@@ -0,0 +1,74 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#include "decision/LookaheadHeuristic.h"
+
+#include "ConstraintSolver.h"
+
+using namespace Vertexy;
+
+LookaheadHeuristic::LookaheadHeuristic(ConstraintSolver& solver, int numCandidates)
+	: m_solver(solver)
+	, m_numCandidates(numCandidates)
+{
+	vxy_assert(numCandidates > 0);
+}
+
+bool LookaheadHeuristic::getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues)
+{
+	// Candidates come from the base heuristic. If it can't provide them, defer to it entirely.
+	auto& heuristics = m_solver.getDecisionHeuristics();
+	if (!heuristics[0]->getDecisionCandidates(m_numCandidates, m_candidates) || m_candidates.empty())
+	{
+		return false;
+	}
+
+	auto db = m_solver.getVariableDB();
+
+	VarID bestVar;
+	int bestValue = -1;
+	double bestScore = -1.0;
+	for (VarID candidate : m_candidates)
+	{
+		vxy_sanity(!db->isSolved(candidate));
+
+		// Copy, since the potential values are modified while probing
+		m_values = db->getPotentialValues(candidate);
+
+		// Score is the product of the propagation caused by each value, so that variables where every value
+		// propagates a lot are preferred over those where only one does.
+		double score = 1.0;
+		int leastValue = -1;
+		int leastModifications = INT_MAX;
+		for (auto it = m_values.beginSetBits(), itEnd = m_values.endSetBits(); it != itEnd; ++it)
+		{
+			int numModifications;
+			if (!m_solver.probeDecision(candidate, *it, numModifications))
+			{
+				// Failed literal: decide on it so that conflict analysis learns to exclude it.
+				var = candidate;
+				chosenValues.pad(db->getDomainSize(var), false);
+				chosenValues[*it] = true;
+				return true;
+			}
+
+			score *= double(numModifications);
+			if (numModifications < leastModifications)
+			{
+				leastModifications = numModifications;
+				leastValue = *it;
+			}
+		}
+
+		if (score > bestScore)
+		{
+			bestScore = score;
+			bestVar = candidate;
+			bestValue = leastValue;
+		}
+	}
+
+	vxy_assert(bestVar.isValid());
+	var = bestVar;
+	chosenValues.pad(db->getDomainSize(var), false);
+	chosenValues[bestValue] = true;
+	return true;
+}
@@ -0,0 +1,112 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#include "decision/ModeSwitchingHeuristic.h"
+
+using namespace Vertexy;
+
+ModeSwitchingHeuristic::ModeSwitchingHeuristic(const shared_ptr<ISolverDecisionHeuristic>& focused, const shared_ptr<ISolverDecisionHeuristic>& stable)
+	: m_focused(focused)
+	, m_stable(stable)
+	, m_active(focused.get())
+{
+	vxy_assert(m_focused != nullptr && m_stable != nullptr);
+}
+
+void ModeSwitchingHeuristic::initialize()
+{
+	m_focused->initialize();
+	m_stable->initialize();
+}
+
+bool ModeSwitchingHeuristic::getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues)
+{
+	return m_active->getNextDecision(level, var, chosenValues);
+}
+
+void ModeSwitchingHeuristic::onVariableAssignment(VarID var, const ValueSet& prevValues, const ValueSet& newValues)
+{
+	m_focused->onVariableAssignment(var, prevValues, newValues);
+	m_stable->onVariableAssignment(var, prevValues, newValues);
+}
+
+void ModeSwitchingHeuristic::onVariableUnassignment(VarID var, const ValueSet& beforeBacktrack, const ValueSet& afterBacktrack)
+{
+	m_focused->onVariableUnassignment(var, beforeBacktrack, afterBacktrack);
+	m_stable->onVariableUnassignment(var, beforeBacktrack, afterBacktrack);
+}
+
+bool ModeSwitchingHeuristic::wantsVariableNotifications() const
+{
+	return m_focused->wantsVariableNotifications() || m_stable->wantsVariableNotifications();
+}
+
+void ModeSwitchingHeuristic::onVariablesAssigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last)
+{
+	// If a child doesn't want batched notifications, the default implementation splits them up for it.
+	if (m_focused->wantsVariableNotifications())
+	{
+		m_focused->onVariablesAssigned(db, first, last);
+	}
+	if (m_stable->wantsVariableNotifications())
+	{
+		m_stable->onVariablesAssigned(db, first, last);
+	}
+}
+
+void ModeSwitchingHeuristic::onVariablesUnassigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last)
+{
+	if (m_focused->wantsVariableNotifications())
+	{
+		m_focused->onVariablesUnassigned(db, first, last);
+	}
+	if (m_stable->wantsVariableNotifications())
+	{
+		m_stable->onVariablesUnassigned(db, first, last);
+	}
+}
+
+bool ModeSwitchingHeuristic::wantsConflictActivity() const
+{
+	return m_focused->wantsConflictActivity() || m_stable->wantsConflictActivity();
+}
+
+void ModeSwitchingHeuristic::onVariableConflictActivity(VarID var, const ValueSet& values, const ValueSet& prevValues)
+{
+	if (m_focused->wantsConflictActivity())
+	{
+		m_focused->onVariableConflictActivity(var, values, prevValues);
+	}
+	if (m_stable->wantsConflictActivity())
+	{
+		m_stable->onVariableConflictActivity(var, values, prevValues);
+	}
+}
+
+void ModeSwitchingHeuristic::onVariableReasonActivity(VarID var, const ValueSet& values, const ValueSet& prevValues)
+{
+	// Only called if wantsReasonActivity() returned true, so check each heuristic individually.
+	if (m_focused->wantsReasonActivity())
+	{
+		m_focused->onVariableReasonActivity(var, values, prevValues);
+	}
+	if (m_stable->wantsReasonActivity())
+	{
+		m_stable->onVariableReasonActivity(var, values, prevValues);
+	}
+}
+
+bool ModeSwitchingHeuristic::wantsReasonActivity() const
+{
+	return m_focused->wantsReasonActivity() || m_stable->wantsReasonActivity();
+}
+
+void ModeSwitchingHeuristic::onClauseLearned()
+{
+	m_focused->onClauseLearned();
+	m_stable->onClauseLearned();
+}
+
+void ModeSwitchingHeuristic::onRestarted()
+{
+	m_focused->onRestarted();
+	m_stable->onRestarted();
+}
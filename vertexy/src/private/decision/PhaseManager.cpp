@@ -0,0 +1,191 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#include "decision/PhaseManager.h"
+
+#include "ConstraintSolver.h"
+
+using namespace Vertexy;
+
+// The order in which rephasing cycles through the different types
+static constexpr PhaseManager::ERephase REPHASE_SCHEDULE[] = {
+	PhaseManager::ERephase::Best,
+	PhaseManager::ERephase::Original,
+	PhaseManager::ERephase::Best,
+	PhaseManager::ERephase::Flipped,
+	PhaseManager::ERephase::Best,
+	PhaseManager::ERephase::Random,
+};
+static constexpr int REPHASE_SCHEDULE_LENGTH = sizeof(REPHASE_SCHEDULE) / sizeof(REPHASE_SCHEDULE[0]);
+
+PhaseManager::PhaseManager(ConstraintSolver& solver)
+	: m_solver(solver)
+{
+}
+
+void PhaseManager::initialize()
+{
+	const int numVars = m_solver.getVariableDB()->getNumVariables();
+	m_targetPhases.resize(numVars + 1, 0);
+	m_bestPhases.resize(numVars + 1, 0);
+}
+
+void PhaseManager::reset()
+{
+	for (int i = 0; i < m_targetPhases.size(); ++i)
+	{
+		m_targetPhases[i] = 0;
+		m_bestPhases[i] = 0;
+	}
+	m_targetTrailSize = 0;
+	m_bestTrailSize = 0;
+	m_targetValidTimestamp = -1;
+	m_bestValidTimestamp = -1;
+	m_conflictsSinceRephase = 0;
+}
+
+void PhaseManager::onConflict(SolverTimestamp conflictFreeTimestamp)
+{
+	++m_conflictsSinceRephase;
+
+	// Target phases are only read if enabled, and best phases are only read when rephasing.
+	const SolverConfig& config = m_solver.getConfig();
+	const SolverTimestamp trailSize = conflictFreeTimestamp + 1;
+	if (config.targetPhases != ETargetPhases::None && trailSize > m_targetTrailSize)
+	{
+		updatePhases(m_targetPhases, m_targetValidTimestamp, conflictFreeTimestamp);
+		m_targetTrailSize = trailSize;
+		m_targetValidTimestamp = conflictFreeTimestamp;
+	}
+	if (config.enableRephasing && trailSize > m_bestTrailSize)
+	{
+		updatePhases(m_bestPhases, m_bestValidTimestamp, conflictFreeTimestamp);
+		m_bestTrailSize = trailSize;
+		m_bestValidTimestamp = conflictFreeTimestamp;
+	}
+}
+
+void PhaseManager::onBacktrack(SolverTimestamp timestamp)
+{
+	m_targetValidTimestamp = min(m_targetValidTimestamp, timestamp);
+	m_bestValidTimestamp = min(m_bestValidTimestamp, timestamp);
+}
+
+void PhaseManager::updatePhases(vector<int>& phases, SolverTimestamp validTimestamp, SolverTimestamp conflictFreeTimestamp)
+{
+	// Only variables modified during search need a phase: variables solved before search are never decided on.
+	auto db = m_solver.getVariableDB();
+	auto& stack = db->getAssignmentStack().getStack();
+
+	// A variable solved within the unchanged part of the trail had the same value when phases were last updated,
+	// and can't have been modified since without a conflict. So only the rest of the trail needs to be walked.
+	const SolverTimestamp start = min(validTimestamp, conflictFreeTimestamp) + 1;
+
+	// Variables not modified after the conflict-free part of the trail still hold their value from that point.
+	for (SolverTimestamp t = start; t <= conflictFreeTimestamp; ++t)
+	{
+		const VarID varID = stack[t].variable;
+
+		int value;
+		if (db->getLastModificationTimestamp(varID) <= conflictFreeTimestamp && db->getPotentialValues(varID).isSingleton(value))
+		{
+			phases[varID.raw()] = value + 1;
+		}
+	}
+
+	// For the remainder, the first modification after the conflict-free point records the value at that point.
+	for (SolverTimestamp t = conflictFreeTimestamp + 1; t < stack.size(); ++t)
+	{
+		int value;
+		if (stack[t].previousVariableAssignment >= start && stack[t].previousVariableAssignment <= conflictFreeTimestamp &&
+			stack[t].previousValue.isSingleton(value))
+		{
+			phases[stack[t].variable.raw()] = value + 1;
+		}
+	}
+}
+
+void PhaseManager::onRestarted()
+{
+	const SolverConfig& config = m_solver.getConfig();
+	if (!config.enableRephasing)
+	{
+		return;
+	}
+
+	// Rephase intervals grow arithmetically
+	if (m_conflictsSinceRephase >= config.rephaseInitialConflicts * (m_numRephases + 1))
+	{
+		rephase(REPHASE_SCHEDULE[m_numRephases % REPHASE_SCHEDULE_LENGTH]);
+		++m_numRephases;
+		m_conflictsSinceRephase = 0;
+	}
+}
+
+void PhaseManager::rephase(ERephase type)
+{
+	auto db = m_solver.getVariableDB();
+	for (int i = 1; i < m_targetPhases.size(); ++i)
+	{
+		const VarID varID(i);
+		switch (type)
+		{
+		case ERephase::Original:
+			db->setLastSolvedValue(varID, -1);
+			break;
+		case ERephase::Flipped:
+			if (int value; db->getLastSolvedValue(varID, value))
+			{
+				db->setLastSolvedValue(varID, db->getDomainSize(varID) - 1 - value);
+			}
+			break;
+		case ERephase::Best:
+			db->setLastSolvedValue(varID, m_bestPhases[i] - 1);
+			break;
+		case ERephase::Random:
+			db->setLastSolvedValue(varID, m_solver.randomRange(0, db->getDomainSize(varID) - 1));
+			break;
+		}
+	}
+
+	if (type == ERephase::Best)
+	{
+		m_bestTrailSize = 0;
+	}
+	m_targetTrailSize = 0;
+}
+
+bool PhaseManager::useTargetPhases() const
+{
+	const SolverConfig& config = m_solver.getConfig();
+	switch (config.targetPhases)
+	{
+	case ETargetPhases::Always:
+		return true;
+	case ETargetPhases::StableOnly:
+		// Without mode switching, we're always effectively in stable mode.
+		return !config.enableModeSwitching || m_solver.isInStableMode();
+	default:
+		return false;
+	}
+}
+
+bool PhaseManager::getPreferredValue(VarID varID, const ValueSet& potentialValues, int& outValue) const
+{
+	if (useTargetPhases())
+	{
+		const int target = m_targetPhases[varID.raw()] - 1;
+		if (target >= 0 && potentialValues[target])
+		{
+			outValue = target;
+			return true;
+		}
+	}
+
+	int saved;
+	if (m_solver.getVariableDB()->getLastSolvedValue(varID, saved) && potentialValues[saved])
+	{
+		outValue = saved;
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,208 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#include "decision/TopologyLocalityHeuristic.h"
+
+#include "ConstraintSolver.h"
+#include "decision/CoarseLRBHeuristic.h"
+#include "topology/ITopology.h"
+#include "topology/TopologyVertexData.h"
+
+using namespace Vertexy;
+
+TopologyLocalityHeuristic::TopologyLocalityHeuristic(ConstraintSolver& solver)
+	: m_solver(solver)
+	, m_activity(make_shared<CoarseLRBHeuristic>(solver))
+	, m_heap(Comparator(m_recency))
+{
+}
+
+void TopologyLocalityHeuristic::initialize()
+{
+	m_activity->initialize();
+
+	auto db = m_solver.getVariableDB();
+	const int numVars = db->getNumVariables();
+
+	m_recency.resize(numVars + 1, 0);
+	m_heap.reserve(numVars + 1);
+
+	for (int i = 1; i < numVars + 1; ++i)
+	{
+		const VarID varID(i);
+		if (m_solver.getVertexForVariable(varID) >= 0 && !db->isSolved(varID))
+		{
+			m_heap.insert(i);
+		}
+	}
+}
+
+bool TopologyLocalityHeuristic::getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues)
+{
+	// With no frontier, every graph variable is equally local, so just go by activity.
+	if (m_heap.empty() || m_recency[m_heap.peek()] == 0)
+	{
+		return m_activity->getNextDecision(level, var, chosenValues);
+	}
+
+	// Pull out every variable touched by the most recent stamp, and pick the most active one.
+	const uint64_t stamp = m_recency[m_heap.peek()];
+	m_ties.clear();
+	while (!m_heap.empty() && m_recency[m_heap.peek()] == stamp)
+	{
+		m_ties.push_back(m_heap.removeMin());
+	}
+
+	uint32_t best = m_ties[0];
+	double bestPriority = m_activity->getPriority(VarID(best), 0);
+	for (int i = 1; i < m_ties.size(); ++i)
+	{
+		const double priority = m_activity->getPriority(VarID(m_ties[i]), 0);
+		if (priority > bestPriority)
+		{
+			best = m_ties[i];
+			bestPriority = priority;
+		}
+	}
+
+	for (uint32_t tied : m_ties)
+	{
+		m_heap.insert(tied);
+	}
+
+	var = VarID(best);
+
+	auto db = m_solver.getVariableDB();
+	vxy_sanity(!db->isSolved(var));
+
+	const ValueSet& potentials = db->getPotentialValues(var);
+	int value;
+	if (!m_solver.getPhaseManager().getPreferredValue(var, potentials, value))
+	{
+		value = m_solver.sampleValue(var, potentials);
+	}
+
+	chosenValues.pad(db->getDomainSize(var), false);
+	chosenValues[value] = true;
+	return true;
+}
+
+void TopologyLocalityHeuristic::touchNeighbors(VarID var)
+{
+	const int vertex = m_solver.getVertexForVariable(var);
+	if (vertex < 0)
+	{
+		return;
+	}
+
+	++m_stamp;
+	for (uint32_t graphID : m_solver.getGraphsForVariable(var))
+	{
+		// Variables in other layers of the same vertex are always considered adjacent.
+		touchVertex(graphID, vertex);
+
+		auto& topology = m_solver.getGraphs()[graphID];
+		for (int edge = 0; edge < topology->getNumOutgoing(vertex); ++edge)
+		{
+			int neighbor;
+			if (topology->getOutgoingDestination(vertex, edge, neighbor))
+			{
+				touchVertex(graphID, neighbor);
+			}
+		}
+	}
+}
+
+void TopologyLocalityHeuristic::touchVertex(uint32_t graphID, int vertex)
+{
+	for (auto& variableGraph : m_solver.getVariableGraphs(graphID))
+	{
+		const VarID neighborVar = variableGraph->get(vertex);
+		if (neighborVar.isValid() && m_heap.inHeap(neighborVar.raw()))
+		{
+			m_recency[neighborVar.raw()] = m_stamp;
+			m_heap.update(neighborVar.raw());
+		}
+	}
+}
+
+void TopologyLocalityHeuristic::onVariableAssignment(VarID var, const ValueSet& prevValues, const ValueSet& newValues)
+{
+	m_activity->onVariableAssignment(var, prevValues, newValues);
+	if (newValues.isSingleton() && m_heap.inHeap(var.raw()))
+	{
+		m_heap.remove(var.raw());
+	}
+	touchNeighbors(var);
+}
+
+void TopologyLocalityHeuristic::onVariableUnassignment(VarID var, const ValueSet& beforeBacktrack, const ValueSet& afterBacktrack)
+{
+	m_activity->onVariableUnassignment(var, beforeBacktrack, afterBacktrack);
+	if (beforeBacktrack.isSingleton() && m_solver.getVertexForVariable(var) >= 0 && !m_heap.inHeap(var.raw()))
+	{
+		m_heap.insert(var.raw());
+	}
+}
+
+void TopologyLocalityHeuristic::onVariablesAssigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last)
+{
+	m_activity->onVariablesAssigned(db, first, last);
+
+	auto& stack = db.getAssignmentStack().getStack();
+	for (SolverTimestamp t = first; t <= last; ++t)
+	{
+		const VarID var = stack[t].variable;
+		if (m_heap.inHeap(var.raw()) && db.getPotentialValues(var).isSingleton())
+		{
+			m_heap.remove(var.raw());
+		}
+		touchNeighbors(var);
+	}
+}
+
+void TopologyLocalityHeuristic::onVariablesUnassigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last)
+{
+	m_activity->onVariablesUnassigned(db, first, last);
+
+	auto& stack = db.getAssignmentStack().getStack();
+	for (SolverTimestamp t = first; t <= last; ++t)
+	{
+		// The earliest modification in the range holds the value the variable will have after backtracking.
+		auto& mod = stack[t];
+		if (mod.previousVariableAssignment < first && !mod.previousValue.isSingleton() &&
+			m_solver.getVertexForVariable(mod.variable) >= 0 && !m_heap.inHeap(mod.variable.raw()))
+		{
+			m_heap.insert(mod.variable.raw());
+		}
+	}
+}
+
+void TopologyLocalityHeuristic::onVariableConflictActivity(VarID var, const ValueSet& values, const ValueSet& prevValues)
+{
+	m_activity->onVariableConflictActivity(var, values, prevValues);
+}
+
+void TopologyLocalityHeuristic::onVariableReasonActivity(VarID var, const ValueSet& values, const ValueSet& prevValues)
+{
+	m_activity->onVariableReasonActivity(var, values, prevValues);
+}
+
+bool TopologyLocalityHeuristic::wantsReasonActivity() const
+{
+	return m_activity->wantsReasonActivity();
+}
+
+void TopologyLocalityHeuristic::onClauseLearned()
+{
+	m_activity->onClauseLearned();
+}
+
+void TopologyLocalityHeuristic::onRestarted()
+{
+	// Recency is kept across restarts, so the next descent resumes from the last frontier.
+	m_activity->onRestarted();
+}
+
+double TopologyLocalityHeuristic::getPriority(VarID varID, int value) const
+{
+	return m_activity->getPriority(varID, value);
+}
@@ -60,25 +60,13 @@ bool VSIDSHeuristic::getNextDecision(SolverDecisionLevel level, VarID& varID, Va
 	const ValueSet& potentials = db->getPotentialValues(varID);
 
 	int value;
-	if (m_solver.getVariableDB()->getLastSolvedValue(varID, value) && potentials[value])
+	if (m_solver.getPhaseManager().getPreferredValue(varID, potentials, value))
 	{
 		//VERTEXY_LOG("Picking prev value %d = %d", Var, Value);
 	}
 	else
 	{
-		//Value = Potentials.Find(true);
-
-		const int numVals = potentials.getNumSetBits();
-		const int randomIndex = m_solver.randomRange(0, numVals - 1);
-
-		auto it = potentials.beginSetBits();
-		for (int i = 0; i < randomIndex; ++i)
-		{
-			++it;
-			++i;
-		}
-
-		value = *it;
+		value = m_solver.sampleValue(varID, potentials);
 	}
 
 	chosenValues.pad(db->getDomainSize(varID), false);
@@ -87,6 +75,30 @@ bool VSIDSHeuristic::getNextDecision(SolverDecisionLevel level, VarID& varID, Va
 	return true;
 }
 
+bool VSIDSHeuristic::getNextDecisionPriority(double& outPriority)
+{
+	if (m_heap.empty())
+	{
+		return false;
+	}
+	outPriority = m_priorities[m_heap.peek()];
+	return true;
+}
+
+bool VSIDSHeuristic::getDecisionCandidates(int maxCandidates, vector<VarID>& outCandidates)
+{
+	outCandidates.clear();
+	while (outCandidates.size() < maxCandidates && !m_heap.empty())
+	{
+		outCandidates.push_back(VarID(m_heap.removeMin()));
+	}
+	for (VarID candidate : outCandidates)
+	{
+		m_heap.insert(candidate.raw());
+	}
+	return true;
+}
+
 void VSIDSHeuristic::onVariableAssignment(VarID varID, const ValueSet& prevValues, const ValueSet& newValues)
 {
 	if (newValues.isSingleton())
@@ -103,6 +115,33 @@ void VSIDSHeuristic::onVariableUnassignment(VarID varID, const ValueSet& beforeB
 	}
 }
 
+void VSIDSHeuristic::onVariablesAssigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last)
+{
+	auto& stack = db.getAssignmentStack().getStack();
+	for (SolverTimestamp t = first; t <= last; ++t)
+	{
+		const VarID varID = stack[t].variable;
+		if (m_heap.inHeap(varID.raw()) && db.getPotentialValues(varID).isSingleton())
+		{
+			m_heap.remove(varID.raw());
+		}
+	}
+}
+
+void VSIDSHeuristic::onVariablesUnassigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last)
+{
+	auto& stack = db.getAssignmentStack().getStack();
+	for (SolverTimestamp t = first; t <= last; ++t)
+	{
+		// The earliest modification in the range holds the value the variable will have after backtracking.
+		auto& mod = stack[t];
+		if (mod.previousVariableAssignment < first && !mod.previousValue.isSingleton() && !m_heap.inHeap(mod.variable.raw()))
+		{
+			m_heap.insert(mod.variable.raw());
+		}
+	}
+}
+
 void VSIDSHeuristic::onVariableConflictActivity(VarID varID, const ValueSet& values, const ValueSet& prevValues)
 {
 	increasePriority(varID, m_increment);
@@ -19,11 +19,21 @@ void DisjointSet::reset(int numItems)
 
 int DisjointSet::find(int val) const
 {
-	if (m_parents[val] != val)
+	// Iterative, so that long chains (e.g. over the vertices of a large graph) can't overflow the stack.
+	int root = val;
+	while (m_parents[root] != root)
 	{
-		m_parents[val] = find(m_parents[val]);
+		root = m_parents[root];
 	}
-	return m_parents[val];
+
+	// Path compression
+	while (m_parents[val] != root)
+	{
+		const int next = m_parents[val];
+		m_parents[val] = root;
+		val = next;
+	}
+	return root;
 }
 
 bool DisjointSet::check(int value, int set) const
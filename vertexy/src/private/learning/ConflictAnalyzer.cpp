@@ -6,8 +6,9 @@
 
 using namespace Vertexy;
 
-constexpr int REDUNDANCY_CHECKING_LEVEL = 0;
 constexpr bool LOG_CONFLICTS = false;
+// Upper bound on the total number of interned graph relations before the intern tables are flushed.
+constexpr int MAX_INTERNED_RELATIONS = 1 << 16;
 
 ConflictAnalyzer::ConflictAnalyzer(ConstraintSolver& inSolver)
 	: m_solver(inSolver)
@@ -29,13 +30,22 @@ SolverDecisionLevel ConflictAnalyzer::analyzeConflict(SolverTimestamp conflictTs
 		return -1;
 	}
 
+	// Flushing only drops our references: any relations still used by learned constraints stay alive.
+	if (m_internedLiteralRelations.size() + m_internedVariableRelations.size() + m_internedFilterRelations.size() > MAX_INTERNED_RELATIONS)
+	{
+		m_internedLiteralRelations.clear();
+		m_internedVariableRelations.clear();
+		m_internedFilterRelations.clear();
+	}
+
 	//
 	// Ask the constraint that failed for an explanation. If there was a variable that was contradicting
 	// (i.e. no potential values remaining), then ask for an explanation for that. Otherwise, ask the
 	// constraint for a general explanation for its failure.
 	//
 
-	static vector<Literal> explanation;
+	ScopedExplanationBuffer explanationBuffer(*this);
+	vector<Literal>& explanation = explanationBuffer.get();
 	if (!contradictingVariable.isValid())
 	{
 		HistoricalVariableDatabase hdb(&m_solver.m_variableDB, conflictTs);
@@ -88,7 +98,7 @@ SolverDecisionLevel ConflictAnalyzer::analyzeConflict(SolverTimestamp conflictTs
 	// Record the new constraint
 	//
 
-	outLearned = m_solver.learn(explanation, m_resolvedRelationInfo.get());
+	outLearned = m_solver.learn(explanation, m_hasResolvedRelationInfo ? &m_resolvedRelationInfo : nullptr);
 
 	return backtrackLevel;
 }
@@ -110,10 +120,10 @@ SolverDecisionLevel ConflictAnalyzer::searchImplicationGraph(vector<Literal>& in
 	m_graphFilter = initialConflict->getGraphRelationInfo() != nullptr ? initialConflict->getGraphRelationInfo()->getFilter() : nullptr;
 	m_anchorGraphVertex = initialConflict->getGraphRelationInfo() != nullptr ? initialConflict->getGraphRelationInfo()->getSourceGraphVertex() : -1;
 
-	ConstraintGraphRelationInfo initialConflictRelationInfo;
-	if (!initialConflict->getGraphRelations(inOutExplanation, initialConflictRelationInfo))
+	if (!initialConflict->getGraphRelations(inOutExplanation, m_conflictRelationInfo))
 	{
-		initialConflictRelationInfo.invalidate();
+		m_conflictRelationInfo.reset(nullptr, -1);
+		m_conflictRelationInfo.invalidate();
 		m_graph = nullptr;
 	}
 
@@ -123,9 +133,10 @@ SolverDecisionLevel ConflictAnalyzer::searchImplicationGraph(vector<Literal>& in
 		m_variableClauseIndices[lit.variable.raw()] = m_nodes.size();
 
 		SolverTimestamp time = m_solver.m_variableDB.getLastModificationTimestamp(lit.variable);
+		SolverDecisionLevel level = m_solver.m_variableDB.getLastModificationLevel(lit.variable);
 
-		m_nodes.push_back({lit.variable, time, m_solver.getDecisionLevelForTimestamp(time)});
-		applyGraphRelation(m_nodes.back(), initialConflictRelationInfo, lit.values, EGraphRelationType::Initialize);
+		m_nodes.push_back({lit.variable, time, level});
+		applyGraphRelation(m_nodes.back(), m_conflictRelationInfo, lit.values, EGraphRelationType::Initialize);
 
 		m_topLevel = max(m_nodes.back().level, m_topLevel);
 	}
@@ -159,9 +170,9 @@ SolverDecisionLevel ConflictAnalyzer::searchImplicationGraph(vector<Literal>& in
 	//
 
 	int mostRecentNodeIndex = findMostRecentNodeIndex();
-	static ConstraintGraphRelationInfo relationInfo;
 
-	static vector<Literal> explToResolve;
+	ScopedExplanationBuffer explToResolveBuffer(*this);
+	vector<Literal>& explToResolve = explToResolveBuffer.get();
 	while (!m_nodes.empty() && (m_numTopLevelNodes > 1 || m_nodes[mostRecentNodeIndex].time > mostRecentDecisionAssignment))
 	{
 		const VarID pivotVar = m_nodes[mostRecentNodeIndex].var;
@@ -207,12 +218,12 @@ SolverDecisionLevel ConflictAnalyzer::searchImplicationGraph(vector<Literal>& in
 		// to add/remove terms.
 		//
 
-		if (!antecedent->getGraphRelations(explToResolve, relationInfo))
+		if (!antecedent->getGraphRelations(explToResolve, m_antecedentRelationInfo))
 		{
-			relationInfo.invalidate();
+			m_antecedentRelationInfo.invalidate();
 		}
 
-		resolve(explToResolve, relationInfo, inOutExplanation, pivotVar, lastModificationTime);
+		resolve(explToResolve, m_antecedentRelationInfo, inOutExplanation, pivotVar, lastModificationTime);
 		//VERTEXY_LOG("Resolved to %s", *Solver.LiteralArrayToString(InOutExplanation));
 
 		// Find the new most-recent node
@@ -250,12 +261,20 @@ SolverDecisionLevel ConflictAnalyzer::searchImplicationGraph(vector<Literal>& in
 		}
 
 
+		//
+		// Remove any redundant literals
+		//
+		if (m_solver.getConfig().minimizeLearnedClauses)
+		{
+			minimizeExplanation(inOutExplanation);
+		}
+
 		//
 		// Find the graph, if any, this learned constraint can be part of. Each variable needs to be in the
 		// same graph, or has a relation to the graph.
 		//
 
-		m_resolvedRelationInfo.reset();
+		m_hasResolvedRelationInfo = false;
 		if (m_graph != nullptr)
 		{
 			vxy_sanity(initialConflict->getGraphRelationInfo() && initialConflict->getGraphRelationInfo()->getGraph() == m_graph);
@@ -265,19 +284,21 @@ SolverDecisionLevel ConflictAnalyzer::searchImplicationGraph(vector<Literal>& in
 			});
 			if (isPromotable)
 			{
-				m_resolvedRelationInfo = move(make_unique<ConstraintGraphRelationInfo>(m_graph, m_anchorGraphVertex, m_graphFilter));
+				m_hasResolvedRelationInfo = true;
+				m_resolvedRelationInfo.reset(m_graph, m_anchorGraphVertex);
+				m_resolvedRelationInfo.setFilter(m_graphFilter);
 				for (int i = 0; i < m_nodes.size(); ++i)
 				{
 					const ImplicationNode& node = m_nodes[i];
 
 					if (auto varRel = get_if<GraphVariableRelationPtr>(&node.relation))
 					{
-						m_resolvedRelationInfo->addVariableRelation(node.var, *varRel);						
+						m_resolvedRelationInfo.addVariableRelation(node.var, *varRel);						
 					}
 					else
 					{
 						vxy_assert(node.var == inOutExplanation[i].variable);
-						m_resolvedRelationInfo->addLiteralRelation(inOutExplanation[i], get<GraphLiteralRelationPtr>(node.relation));
+						m_resolvedRelationInfo.addLiteralRelation(inOutExplanation[i], get<GraphLiteralRelationPtr>(node.relation));
 					}
 
 					#if VERTEXY_SANITY_CHECKS
@@ -300,40 +321,6 @@ SolverDecisionLevel ConflictAnalyzer::searchImplicationGraph(vector<Literal>& in
 			}
 		}
 
-		//
-		// Remove any redundant variables
-		//
-		if constexpr (REDUNDANCY_CHECKING_LEVEL > 0)
-		{
-			uint32_t levelMask = 0;
-			for (int i = 1; i < m_nodes.size(); ++i)
-			{
-				levelMask |= getLevelBit(m_nodes[i].level);
-			}
-
-			int newSize = 1;
-			for (int i = 1; i < m_nodes.size(); ++i)
-			{
-				if (m_nodes[i].time < 0 || assignmentStack[m_nodes[i].time].constraint == nullptr || !checkRedundant(inOutExplanation, i, levelMask))
-				{
-					inOutExplanation[newSize] = inOutExplanation[i];
-
-					m_nodes[newSize] = m_nodes[i];
-					++newSize;
-				}
-			}
-			if (newSize < inOutExplanation.size())
-			{
-				// VERTEXY_LOG("Reduced clause size from %d to %d", InOutExplanation.Num(), NewSize);
-				// VERTEXY_LOG("Old: %s", *Solver.LiteralArrayToString(InOutExplanation));
-
-				inOutExplanation.resize(newSize);
-				m_nodes.resize(newSize);
-
-				// VERTEXY_LOG("New: %s", *Solver.LiteralArrayToString(InOutExplanation));
-			}
-		}
-
 		// Take note of constraint/variable activity for heuristics
 		markActivity(inOutExplanation, uipTime);
 
@@ -428,7 +415,10 @@ void ConflictAnalyzer::resolve(const vector<Literal>& newClauses, const Constrai
 		}
 		else
 		{
-			m_graphFilter = TManyToOneGraphRelation<bool>::combine(m_graphFilter, relationInfo.getFilter());
+			m_graphFilter = internRelation<bool>(EInternedRelationOp::ManyToOne, m_graphFilter, relationInfo.getFilter(), TopologyLink::SELF, [&]()
+			{
+				return TManyToOneGraphRelation<bool>::combine(m_graphFilter, relationInfo.getFilter());
+			});
 		}
 	}
 	
@@ -579,31 +569,34 @@ shared_ptr<const IGraphRelation<T>> ConflictAnalyzer::createOffsetGraphRelation(
 			return nullptr;
 		}
 
-		if (auto existingLinkRel = dynamic_cast<const TTopologyLinkGraphRelation<T>*>(inRel.get()))
+		return internRelation<T>(EInternedRelationOp::Offset, inRel, m_graph, link, [&]() -> IGraphRelationPtr<T>
 		{
-			TopologyLink combinedLink = link.combine(existingLinkRel->getLink());
-			if (combinedLink.isEquivalent(TopologyLink::SELF, *m_graph))
+			if (auto existingLinkRel = dynamic_cast<const TTopologyLinkGraphRelation<T>*>(inRel.get()))
 			{
-				return make_shared<TVertexToDataGraphRelation<T>>(existingLinkRel->getTopo(), existingLinkRel->getData());
+				TopologyLink combinedLink = link.combine(existingLinkRel->getLink());
+				if (combinedLink.isEquivalent(TopologyLink::SELF, *m_graph))
+				{
+					return make_shared<TVertexToDataGraphRelation<T>>(existingLinkRel->getTopo(), existingLinkRel->getData());
+				}
+				return make_shared<TTopologyLinkGraphRelation<T>>(existingLinkRel->getTopo(), existingLinkRel->getData(), combinedLink);
 			}
-			return make_shared<TTopologyLinkGraphRelation<T>>(existingLinkRel->getTopo(), existingLinkRel->getData(), combinedLink);
-		}
-		else if (auto existingMapping = dynamic_cast<const TMappingGraphRelation<T>*>(inRel.get()))
-		{
-			if (auto mapperLinkRel = dynamic_cast<const TopologyLinkIndexGraphRelation*>(existingMapping->getFirstRelation().get()))
+			else if (auto existingMapping = dynamic_cast<const TMappingGraphRelation<T>*>(inRel.get()))
 			{
-				TopologyLink combinedLink = link.combine(mapperLinkRel->getLink());
-				if (combinedLink.isEquivalent(TopologyLink::SELF, *m_graph))
+				if (auto mapperLinkRel = dynamic_cast<const TopologyLinkIndexGraphRelation*>(existingMapping->getFirstRelation().get()))
 				{
-					return existingMapping->getSecondRelation();
+					TopologyLink combinedLink = link.combine(mapperLinkRel->getLink());
+					if (combinedLink.isEquivalent(TopologyLink::SELF, *m_graph))
+					{
+						return existingMapping->getSecondRelation();
+					}
+					auto newLinkRel = make_shared<TopologyLinkIndexGraphRelation>(m_graph, combinedLink);
+					return newLinkRel->map(existingMapping->getSecondRelation());
 				}
-				auto newLinkRel = make_shared<TopologyLinkIndexGraphRelation>(m_graph, combinedLink);
-				return newLinkRel->map(existingMapping->getSecondRelation());
 			}
-		}
 
-		auto linkRel = make_shared<TopologyLinkIndexGraphRelation>(m_graph, link);
-		return linkRel->map(inRel);
+			auto linkRel = make_shared<TopologyLinkIndexGraphRelation>(m_graph, link);
+			return linkRel->map(inRel);
+		});
 	}
 	else
 	{
@@ -611,6 +604,41 @@ shared_ptr<const IGraphRelation<T>> ConflictAnalyzer::createOffsetGraphRelation(
 	}
 }
 
+template <typename T, typename Builder>
+IGraphRelationPtr<T> ConflictAnalyzer::internRelation(EInternedRelationOp op, const shared_ptr<const void>& first, const shared_ptr<const void>& second, const TopologyLink& link, Builder&& builder)
+{
+	auto& table = getInternTable<T>();
+
+	InternedRelationKey key{op, first.get(), second.get(), link};
+	auto found = table.find(key);
+	if (found != table.end())
+	{
+		return found->second.result;
+	}
+
+	IGraphRelationPtr<T> result = builder();
+	table.insert(make_pair(move(key), TInternedRelation<T>{first, second, result}));
+	return result;
+}
+
+template <typename T>
+ConflictAnalyzer::TRelationInternTable<T>& ConflictAnalyzer::getInternTable()
+{
+	if constexpr (is_same_v<T, Literal>)
+	{
+		return m_internedLiteralRelations;
+	}
+	else if constexpr (is_same_v<T, VarID>)
+	{
+		return m_internedVariableRelations;
+	}
+	else
+	{
+		static_assert(is_same_v<T, bool>, "No intern table for this relation type");
+		return m_internedFilterRelations;
+	}
+}
+
 void ConflictAnalyzer::applyGraphRelation(ImplicationNode& node, const ConstraintGraphRelationInfo& originGraphInfo, const ValueSet& values, EGraphRelationType applicationType)
 {
 	if (m_anchorGraphVertex < 0)
@@ -670,7 +698,10 @@ void ConflictAnalyzer::applyGraphRelation(ImplicationNode& node, const Constrain
 		if (applicationType == EGraphRelationType::Intersection)
 		{
 			relationVals.values.invert();
-			offsetRel = make_shared<InvertLiteralGraphRelation>(offsetRel);
+			offsetRel = internRelation<Literal>(EInternedRelationOp::Invert, offsetRel, nullptr, TopologyLink::SELF, [&]() -> GraphLiteralRelationPtr
+			{
+				return make_shared<InvertLiteralGraphRelation>(offsetRel);
+			});
 		}
 
 		if (relationVals.values != values)
@@ -682,19 +713,26 @@ void ConflictAnalyzer::applyGraphRelation(ImplicationNode& node, const Constrain
 		{
 			if (hasExistingRelation)
 			{
+				GraphLiteralRelationPtr existingRel = get<GraphLiteralRelationPtr>(node.relation);
 				if (applicationType == EGraphRelationType::Intersection)
 				{
-					auto intersectRel = make_shared<LiteralIntersectionGraphRelation>();
-					intersectRel->add(get<GraphLiteralRelationPtr>(node.relation));
-					intersectRel->add(offsetRel);
-					node.relation = intersectRel;
+					node.relation = internRelation<Literal>(EInternedRelationOp::Intersection, existingRel, offsetRel, TopologyLink::SELF, [&]() -> GraphLiteralRelationPtr
+					{
+						auto intersectRel = make_shared<LiteralIntersectionGraphRelation>();
+						intersectRel->add(existingRel);
+						intersectRel->add(offsetRel);
+						return intersectRel;
+					});
 				}
 				else
 				{
-					auto unionRel = make_shared<LiteralUnionGraphRelation>();
-					unionRel->add(get<GraphLiteralRelationPtr>(node.relation));
-					unionRel->add(offsetRel);
-					node.relation = unionRel;
+					node.relation = internRelation<Literal>(EInternedRelationOp::Union, existingRel, offsetRel, TopologyLink::SELF, [&]() -> GraphLiteralRelationPtr
+					{
+						auto unionRel = make_shared<LiteralUnionGraphRelation>();
+						unionRel->add(existingRel);
+						unionRel->add(offsetRel);
+						return unionRel;
+					});
 				}
 			}
 			else
@@ -714,33 +752,35 @@ void ConflictAnalyzer::applyGraphRelation(ImplicationNode& node, const Constrain
 		{
 			if (hasExistingRelation)
 			{
-				auto existingRel = get<GraphVariableRelationPtr>(node.relation);
-				if (node.multiRelation == nullptr)
-				{
-					auto newMultiRel = make_shared<TManyToOneGraphRelation<VarID>>();
-					// Compact chained ManyToOneGraphRelations:
-					if (auto existingMultiRel = dynamic_cast<const TManyToOneGraphRelation<VarID>*>(existingRel.get()))
-					{
-						for (auto& inner : existingMultiRel->getRelations())
-						{
-							newMultiRel->add(inner);
-						}
-					}
-					else
-					{
-						newMultiRel->add(existingRel);
-					}
-					node.relation = newMultiRel;
-					node.multiRelation = newMultiRel;
-				}
+				GraphVariableRelationPtr existingRel = get<GraphVariableRelationPtr>(node.relation);
+				auto existingMultiRel = dynamic_cast<const TManyToOneGraphRelation<VarID>*>(existingRel.get());
 
-				bool isAlreadyContained = containsPredicate(node.multiRelation->getRelations().begin(), node.multiRelation->getRelations().end(), [&](auto&& inner)
+				bool isAlreadyContained = existingMultiRel != nullptr && containsPredicate(existingMultiRel->getRelations().begin(), existingMultiRel->getRelations().end(), [&](auto&& inner)
 				{
 					return inner->equals(*offsetRel);
 				});
 				if (!isAlreadyContained)
 				{
-					node.multiRelation->add(offsetRel);
+					// Relations are shared through the intern table, so never modify an existing one: build a new
+					// relation containing both.
+					node.relation = internRelation<VarID>(EInternedRelationOp::ManyToOne, existingRel, offsetRel, TopologyLink::SELF, [&]() -> GraphVariableRelationPtr
+					{
+						auto newMultiRel = make_shared<TManyToOneGraphRelation<VarID>>();
+						// Compact chained ManyToOneGraphRelations:
+						if (existingMultiRel != nullptr)
+						{
+							for (auto& inner : existingMultiRel->getRelations())
+							{
+								newMultiRel->add(inner);
+							}
+						}
+						else
+						{
+							newMultiRel->add(existingRel);
+						}
+						newMultiRel->add(offsetRel);
+						return newMultiRel;
+					});
 				}
 			}
 			else
@@ -778,113 +818,410 @@ bool ConflictAnalyzer::compatibleRelations(const ARelation& existingRelation, co
 }
 
 // Conflict clause minimization: see http://minisat.se/downloads/MiniSat_v1.13_short.pdf
-bool ConflictAnalyzer::checkRedundant(const vector<Literal>& explanation, int litIndex, uint32_t levelMask) const
+// and "Minimizing Learned Clauses" (Sorensson, Biere 2009).
+//
+// A literal can be removed if the modification that made it false is implied by the other literals in the clause.
+// Facts used in the proof must always be established strictly earlier than the fact they prove, so literals can
+// be removed independently of each other, and results are memoized per-timestamp across all literals.
+void ConflictAnalyzer::minimizeExplanation(vector<Literal>& explanation)
 {
-	auto& db = m_solver.m_variableDB;
-	auto& stack = db.getAssignmentStack().getStack();
+	auto& stack = m_solver.m_variableDB.getAssignmentStack().getStack();
+
+	if (m_minimizationStamp == UINT_MAX)
+	{
+		m_minimizationStamp = 0;
+		m_clauseLevelStamps.clear();
+		m_redundancyMemoStamps.clear();
+	}
+	++m_minimizationStamp;
+	m_numRedundancyMemo = 0;
+
+	m_clauseLevelStamps.resize(m_solver.getCurrentDecisionLevel() + 1, 0);
+	m_redundancyMemoStamps.resize(stack.size(), 0);
+	m_redundancyMemoIndices.resize(stack.size(), -1);
+
+	// Literals that are removed must keep the learned clause valid for every vertex it may be promoted to.
+	m_minimizeForGraph = m_graph != nullptr;
+
+	for (int i = 0; i < explanation.size(); ++i)
+	{
+		vxy_assert(m_nodes[i].var == explanation[i].variable);
+		m_variableClauseIndices[explanation[i].variable.raw()] = i;
+		if (i > 0 && m_nodes[i].level >= 0)
+		{
+			m_clauseLevelStamps[m_nodes[i].level] = m_minimizationStamp;
+		}
+	}
+
+	m_literalIsRedundant.clear();
+	m_literalIsRedundant.resize(explanation.size(), false);
 
-	static vector<Literal> reason;
-	if constexpr (REDUNDANCY_CHECKING_LEVEL == 1)
+	for (int i = 1; i < explanation.size(); ++i)
 	{
-		// !!FIXME!! I don't think this is quite right... It's checking for variables but not values.
-		// The full version (after this block) correctly looks at values.
-		vxy_fail();
+		if (m_nodes[i].time >= 0 && stack[m_nodes[i].time].constraint != nullptr && isRedundantLiteral(explanation, i))
+		{
+			m_literalIsRedundant[i] = true;
+		}
+	}
 
-		// Simple/cheaper version of redundancy check that just sees if the reason for this literal's propagation
-		// is a subset of the constraint we're learning. If so, it's redundant.
-		m_solver.getExplanationForModification(m_nodes[litIndex].time, reason);
-		for (auto& reasonLit : reason)
+	if (m_solver.getConfig().minimizeWithBinaryClauses)
+	{
+		// Binary clauses are not checked against graph relations.
+		if (!m_minimizeForGraph)
 		{
-			if (db.getModificationTimePriorTo(reasonLit.variable, m_nodes[litIndex].time) >= 0)
+			binaryMinimize(explanation);
+		}
+	}
+
+	int newSize = 1;
+	for (int i = 1; i < explanation.size(); ++i)
+	{
+		if (!m_literalIsRedundant[i])
+		{
+			if (newSize != i)
 			{
-				bool wasFound = contains(explanation.begin(), explanation.end(), [&](auto& literal)
-				{
-					return literal.variable == reasonLit.variable;
-				});
-				if (!wasFound)
-				{
-					return false;
-				}
+				explanation[newSize] = move(explanation[i]);
+				m_nodes[newSize] = move(m_nodes[i]);
 			}
+			++newSize;
 		}
+	}
 
-		return true;
+	for (auto& literal : explanation)
+	{
+		m_variableClauseIndices[literal.variable.raw()] = -1;
 	}
 
-	m_redundancySeen.clear();
-	m_redundancySeen.pad(m_solver.m_variableDB.getNumVariables() + 1, false);
-	m_redundancyValues.resize(m_solver.m_variableDB.getNumVariables() + 1);
+	if (newSize < explanation.size())
+	{
+		// VERTEXY_LOG("Reduced clause size from %d to %d", explanation.size(), newSize);
+		auto& stats = m_solver.m_stats;
+		stats.numMinimizedLiterals += explanation.size() - newSize;
+		if (m_minimizeForGraph)
+		{
+			stats.numMinimizedGraphLiterals += explanation.size() - newSize;
+		}
+		explanation.resize(newSize);
+		m_nodes.resize(newSize);
+	}
+}
 
-	for (int i = 1; i < explanation.size(); ++i)
+bool ConflictAnalyzer::isRedundantLiteral(const vector<Literal>& explanation, int litIndex)
+{
+	auto& db = m_solver.m_variableDB;
+
+	const ImplicationNode& node = m_nodes[litIndex];
+	GraphVariableRelationPtr nodeRelation;
+	if (m_minimizeForGraph)
 	{
-		m_redundancySeen[explanation[i].variable.raw()] = true;
-		m_redundancyValues[explanation[i].variable.raw()] = explanation[i].values;
+		// Literal relations can't describe the partial values we track, so only variable relations are supported.
+		auto varRel = get_if<GraphVariableRelationPtr>(&node.relation);
+		if (varRel == nullptr || *varRel == nullptr)
+		{
+			return false;
+		}
+		nodeRelation = *varRel;
 	}
 
-	// Start by checking if this variable is subsumed by a prior constraint in the implication graph.
-	// I.e. if the explanation for this literal propagating is a subset of the constraint we're learning, then
-	// it is redundant.
-	// Otherwise, recurse: if there is some literal in the reason for this literal that doesn't appear in
-	// the learned constraint, see if the reason for THAT literal is a subset of the learned constraint. If so,
-	// that literal can be ignored.
-	m_redundancyStack.clear();
-	vxy_assert(m_nodes[litIndex].var == explanation[litIndex].variable);
-	m_redundancyStack.push_back(ImplicationNode{explanation[litIndex].variable, m_nodes[litIndex].time, -1});
+	m_numMinimizationFrames = 0;
+	m_minimizationReasons.clear();
+	m_minimizationReasonRelations.clear();
 
-	static vector<Literal> reasons;
-	while (!m_redundancyStack.empty())
+	m_minimizationRootValues = explanation[litIndex].values;
+	SolverTimestamp rootTime = node.time;
+	EFactRedundancy state = classifyFact(explanation, node.var, m_minimizationRootValues, rootTime, node.time, nodeRelation);
+
+	while (true)
 	{
-		ImplicationNode curNode = m_redundancyStack.back();
-		m_redundancyStack.pop_back();
+		if (state == EFactRedundancy::Required)
+		{
+			// Everything on the stack depended on this fact.
+			for (int i = 0; i < m_numMinimizationFrames; ++i)
+			{
+				addRedundancyMemo(m_minimizationFrames[i].time).redundant = false;
+			}
+			m_numMinimizationFrames = 0;
+			return false;
+		}
+		else if (state == EFactRedundancy::Expand)
+		{
+			const bool isRoot = m_numMinimizationFrames == 0;
+			const SolverTimestamp expandTime = isRoot ? rootTime : m_minimizationFrames[m_numMinimizationFrames-1].pendingTime;
+			const GraphVariableRelationPtr expectedRelation = isRoot ? nodeRelation : m_minimizationReasonRelations[m_minimizationFrames[m_numMinimizationFrames-1].cursor];
+			if (!pushMinimizationFrame(expandTime, expectedRelation))
+			{
+				state = EFactRedundancy::Required;
+				continue;
+			}
+		}
+		else if (m_numMinimizationFrames == 0)
+		{
+			// All values of the literal were proven
+			return true;
+		}
+		else
+		{
+			++m_minimizationFrames[m_numMinimizationFrames-1].cursor;
+		}
 
-		if (curNode.time >= 0)
+		MinimizationFrame& frame = m_minimizationFrames[m_numMinimizationFrames-1];
+		if (frame.cursor == frame.reasonsEnd)
 		{
-			vxy_assert(stack[curNode.time].variable == curNode.var);
-			vxy_assert(stack[curNode.time].constraint != nullptr);
+			// Every reason for this modification is implied.
+			RedundancyMemoEntry& memo = addRedundancyMemo(frame.time);
+			memo.redundant = true;
+			memo.pivotValues = frame.pivotValues;
+			memo.pivotRelation = frame.pivotRelation;
+
+			m_minimizationReasons.resize(frame.reasonsBegin);
+			m_minimizationReasonRelations.resize(frame.reasonsBegin);
+			--m_numMinimizationFrames;
+
+			// Continue with the fact that was waiting on this modification.
+			if (m_numMinimizationFrames == 0)
+			{
+				state = classifyFact(explanation, node.var, m_minimizationRootValues, rootTime, node.time, nodeRelation);
+			}
+			else
+			{
+				MinimizationFrame& parent = m_minimizationFrames[m_numMinimizationFrames-1];
+				state = classifyFact(explanation, m_minimizationReasons[parent.cursor].variable, parent.pendingValues, parent.pendingTime, parent.time, m_minimizationReasonRelations[parent.cursor]);
+			}
+		}
+		else
+		{
+			const Literal& reason = m_minimizationReasons[frame.cursor];
+			frame.pendingValues = reason.values;
+			frame.pendingTime = findLatestFalseTime(reason.variable, reason.values, db.getModificationTimePriorTo(reason.variable, frame.time));
+			state = classifyFact(explanation, reason.variable, frame.pendingValues, frame.pendingTime, frame.time, m_minimizationReasonRelations[frame.cursor]);
+		}
+	}
+}
 
-			m_solver.getExplanationForModification(curNode.time, reasons);
-			for (auto& reason : reasons)
+// Determine whether the fact that Var has none of Values (which became true at Time) is implied by the clause,
+// using only clause literals that became false before UsedBefore. Values/Time are advanced as parts of the fact are
+// proven through memoized modifications.
+ConflictAnalyzer::EFactRedundancy ConflictAnalyzer::classifyFact(const vector<Literal>& explanation, VarID var, ValueSet& values, SolverTimestamp& time, SolverTimestamp usedBefore, const GraphVariableRelationPtr& relation)
+{
+	auto& stack = m_solver.m_variableDB.getAssignmentStack().getStack();
+	while (true)
+	{
+		if (values.isZero())
+		{
+			return EFactRedundancy::Redundant;
+		}
+
+		// Covered by a literal in the clause?
+		const int clauseIndex = m_variableClauseIndices[var.raw()];
+		if (clauseIndex >= 0 && m_nodes[clauseIndex].time < usedBefore && values.isSubsetOf(explanation[clauseIndex].values))
+		{
+			if (!m_minimizeForGraph)
 			{
-				// Check if we've seen this variable and all its values
-				bool alreadySeen = m_redundancySeen[reason.variable.raw()];
-				ValueSet& seenValues = m_redundancyValues[reason.variable.raw()];
-				if (!alreadySeen || !reason.values.isSubsetOf(seenValues))
-				{
-					SolverTimestamp reasonTimestamp = db.getModificationTimePriorTo(reason.variable, curNode.time);
-					reasonTimestamp = findLatestFalseTime(reason.variable, reason.values, reasonTimestamp);
+				return EFactRedundancy::Redundant;
+			}
 
-					if (reasonTimestamp >= 0)
-					{
-						vxy_assert(stack[reasonTimestamp].variable == reason.variable);
+			auto clauseRel = get_if<GraphVariableRelationPtr>(&m_nodes[clauseIndex].relation);
+			if (clauseRel != nullptr && *clauseRel != nullptr && (*clauseRel)->equals(*relation))
+			{
+				return EFactRedundancy::Redundant;
+			}
+		}
 
-						SolverDecisionLevel reasonLevel = m_solver.getDecisionLevelForTimestamp(reasonTimestamp);
-						if (stack[reasonTimestamp].constraint && (getLevelBit(reasonLevel) & levelMask) != 0)
-						{
-							// Mark the variable and values in this reason as seen
-							if (!alreadySeen)
-							{
-								m_redundancySeen[reason.variable.raw()] = true;
-								seenValues = reason.values;
-							}
-							else
-							{
-								seenValues.include(reason.values);
-							}
-							m_redundancyStack.push_back(ImplicationNode{reason.variable, reasonTimestamp, -1});
-						}
-						else
-						{
-							return false;
-						}
-					}
-				}
+		if (time < 0)
+		{
+			// Never possible. The initial domain isn't necessarily the same for other vertices in the graph, though.
+			return m_minimizeForGraph ? EFactRedundancy::Required : EFactRedundancy::Redundant;
+		}
+
+		const AssignmentStack::Modification& mod = stack[time];
+		vxy_assert(mod.variable == var);
+		if (mod.constraint == nullptr)
+		{
+			return EFactRedundancy::Required;
+		}
+
+		const SolverDecisionLevel level = m_solver.getDecisionLevelForTimestamp(time);
+		if (level == 0 && !m_minimizeForGraph)
+		{
+			return EFactRedundancy::Redundant;
+		}
+		else if (m_clauseLevelStamps[level] != m_minimizationStamp)
+		{
+			// This modification must depend on a decision at a level that isn't in the clause.
+			return EFactRedundancy::Required;
+		}
+
+		const RedundancyMemoEntry* memo = findRedundancyMemo(time);
+		if (memo == nullptr)
+		{
+			return EFactRedundancy::Expand;
+		}
+		else if (!memo->redundant || (m_minimizeForGraph && !memo->pivotRelation->equals(*relation)))
+		{
+			return EFactRedundancy::Required;
+		}
+
+		// The modification is implied. Any values it didn't remove must have been removed earlier.
+		values.intersect(memo->pivotValues);
+		time = findLatestFalseTime(var, values, mod.previousVariableAssignment);
+	}
+}
+
+bool ConflictAnalyzer::pushMinimizationFrame(SolverTimestamp time, const GraphVariableRelationPtr& expectedRelation)
+{
+	const AssignmentStack::Modification& mod = m_solver.m_variableDB.getAssignmentStack().getStack()[time];
+
+	ScopedExplanationBuffer reasonsBuffer(*this);
+	vector<Literal>& reasons = reasonsBuffer.get();
+	m_solver.getExplanationForModification(time, reasons);
+
+	if (m_minimizeForGraph)
+	{
+		if (!mod.constraint->getGraphRelations(reasons, m_antecedentRelationInfo) || m_antecedentRelationInfo.getGraph() != m_graph)
+		{
+			return false;
+		}
+
+		auto& filter = m_antecedentRelationInfo.getFilter();
+		if (filter != nullptr && (m_graphFilter == nullptr || !filter->equals(*m_graphFilter)))
+		{
+			return false;
+		}
+	}
+
+	if (m_numMinimizationFrames == m_minimizationFrames.size())
+	{
+		m_minimizationFrames.emplace_back();
+	}
+	MinimizationFrame& frame = m_minimizationFrames[m_numMinimizationFrames];
+	frame.time = time;
+	frame.reasonsBegin = m_minimizationReasons.size();
+	frame.cursor = frame.reasonsBegin;
+	frame.pivotRelation = nullptr;
+
+	bool foundPivot = false;
+	bool isValid = true;
+	for (auto& reason : reasons)
+	{
+		GraphVariableRelationPtr reasonRelation;
+		if (m_minimizeForGraph)
+		{
+			GraphVariableRelationPtr sourceRelation;
+			if (!m_antecedentRelationInfo.getVariableRelation(reason.variable, sourceRelation))
+			{
+				isValid = false;
+				break;
 			}
+
+			reasonRelation = createOffsetGraphRelation(m_antecedentRelationInfo.getSourceGraphVertex(), sourceRelation);
+			if (reasonRelation == nullptr)
+			{
+				isValid = false;
+				break;
+			}
+		}
+
+		if (reason.variable == mod.variable)
+		{
+			vxy_assert(!foundPivot);
+			foundPivot = true;
+			frame.pivotValues = reason.values;
+			frame.pivotRelation = reasonRelation;
 		}
+		else if (!reason.values.isZero())
+		{
+			m_minimizationReasons.push_back(reason);
+			m_minimizationReasonRelations.push_back(reasonRelation);
+		}
+	}
+	vxy_assert(!isValid || foundPivot);
+
+	if (isValid && m_minimizeForGraph && !frame.pivotRelation->equals(*expectedRelation))
+	{
+		isValid = false;
+	}
+
+	if (!isValid)
+	{
+		m_minimizationReasons.resize(frame.reasonsBegin);
+		m_minimizationReasonRelations.resize(frame.reasonsBegin);
+		return false;
 	}
 
+	frame.reasonsEnd = m_minimizationReasons.size();
+	++m_numMinimizationFrames;
 	return true;
 }
 
+ConflictAnalyzer::RedundancyMemoEntry* ConflictAnalyzer::findRedundancyMemo(SolverTimestamp time)
+{
+	if (m_redundancyMemoStamps[time] != m_minimizationStamp)
+	{
+		return nullptr;
+	}
+	return &m_redundancyMemo[m_redundancyMemoIndices[time]];
+}
+
+ConflictAnalyzer::RedundancyMemoEntry& ConflictAnalyzer::addRedundancyMemo(SolverTimestamp time)
+{
+	if (RedundancyMemoEntry* existing = findRedundancyMemo(time))
+	{
+		return *existing;
+	}
+
+	if (m_numRedundancyMemo == m_redundancyMemo.size())
+	{
+		m_redundancyMemo.emplace_back();
+	}
+
+	m_redundancyMemoStamps[time] = m_minimizationStamp;
+	m_redundancyMemoIndices[time] = m_numRedundancyMemo;
+	return m_redundancyMemo[m_numRedundancyMemo++];
+}
+
+// Given the asserting literal U, for any binary clause (U' or Y) where U' is a subset of U, and where the Y is
+// disjoint from the clause's literal on the same variable, that literal can be removed: the clause's remaining
+// literals being false implies U' is false, so Y must be true, so the literal must be false.
+void ConflictAnalyzer::binaryMinimize(vector<Literal>& explanation)
+{
+	updateBinaryClauseIndex();
+
+	const Literal& asserting = explanation[0];
+	for (ClauseConstraint* binary : m_binaryClauses[asserting.variable.raw()])
+	{
+		vxy_sanity(binary->getNumLiterals() == 2);
+
+		const int assertingSide = binary->getLiteral(0).variable == asserting.variable ? 0 : 1;
+		const Literal& assertingLit = binary->getLiteral(assertingSide);
+		const Literal& otherLit = binary->getLiteral(1 - assertingSide);
+
+		const int clauseIndex = m_variableClauseIndices[otherLit.variable.raw()];
+		if (clauseIndex > 0 && !m_literalIsRedundant[clauseIndex] &&
+			assertingLit.values.isSubsetOf(asserting.values) &&
+			!otherLit.values.anyPossible(explanation[clauseIndex].values))
+		{
+			m_literalIsRedundant[clauseIndex] = true;
+		}
+	}
+}
+
+void ConflictAnalyzer::updateBinaryClauseIndex()
+{
+	m_binaryClauses.resize(m_solver.m_variableDB.getNumVariables() + 1);
+
+	// Permanent learned constraints are never removed, so we only need to look at ones added since last time.
+	auto& permanentClauses = m_solver.m_permanentLearnedConstraints;
+	for (; m_numIndexedPermanentClauses < permanentClauses.size(); ++m_numIndexedPermanentClauses)
+	{
+		ClauseConstraint* clause = permanentClauses[m_numIndexedPermanentClauses];
+		if (clause->getNumLiterals() == 2 && clause->getLiteral(0).variable != clause->getLiteral(1).variable)
+		{
+			m_binaryClauses[clause->getLiteral(0).variable.raw()].push_back(clause);
+			m_binaryClauses[clause->getLiteral(1).variable.raw()].push_back(clause);
+		}
+	}
+}
+
 bool ConflictAnalyzer::relax(ImplicationNode& node, const ValueSet& assertingValue)
 {
 	int origTime = node.time;
@@ -981,20 +1318,20 @@ void ConflictAnalyzer::markActivity(const vector<Literal>& resolvedExplanation,
 		return heuristic->wantsReasonActivity();
 	});
 
-	static hash_set<VarID> seenSet;
-	seenSet.clear();
+	m_activitySeen.clear();
 
 	for (int i = 0; i < resolvedExplanation.size(); ++i)
 	{
 		auto& literal = resolvedExplanation[i];
-		if (m_nodes[i].time >= 0 && m_nodes[i].level > 0)
+		if (m_nodes[i].time >= 0 && m_nodes[i].level > 0 && !m_solver.m_conflictActivityHeuristics.empty())
 		{
-			for (auto& heuristic : m_solver.getDecisionHeuristics())
+			const ValueSet& prevValues = db.getValueBefore(literal.variable, uipTime);
+			for (auto heuristic : m_solver.m_conflictActivityHeuristics)
 			{
-				heuristic->onVariableConflictActivity(literal.variable, literal.values, db.getValueBefore(literal.variable, uipTime));
+				heuristic->onVariableConflictActivity(literal.variable, literal.values, prevValues);
 			}
 		}
-		if (wantsReasonActivity) { seenSet.insert(literal.variable); }
+		if (wantsReasonActivity) { m_activitySeen.add(literal.variable.raw()); }
 	}
 
 	//
@@ -1004,7 +1341,8 @@ void ConflictAnalyzer::markActivity(const vector<Literal>& resolvedExplanation,
 
 	if (wantsReasonActivity)
 	{
-		static vector<Literal> reasons;
+		ScopedExplanationBuffer reasonsBuffer(*this);
+		vector<Literal>& reasons = reasonsBuffer.get();
 		for (auto& node : m_nodes)
 		{
 			SolverTimestamp explanationTime = node.time;
@@ -1021,7 +1359,7 @@ void ConflictAnalyzer::markActivity(const vector<Literal>& resolvedExplanation,
 			m_solver.getExplanationForModification(explanationTime, reasons);
 			for (auto& lit : reasons)
 			{
-				if (seenSet.find(lit.variable) != seenSet.end())
+				if (m_activitySeen.contains(lit.variable.raw()))
 				{
 					SolverTimestamp valuePreviousTime;
 					const ValueSet& reasonValue = db.getValueBefore(lit.variable, explanationTime, &valuePreviousTime);
@@ -1033,9 +1371,40 @@ void ConflictAnalyzer::markActivity(const vector<Literal>& resolvedExplanation,
 							heuristic->onVariableReasonActivity(lit.variable, reasonValue, prevReasonValue);
 						}
 					}
-					seenSet.insert(lit.variable);
+					m_activitySeen.add(lit.variable.raw());
 				}
 			}
 		}
 	}
 }
+
+vector<Literal>& ConflictAnalyzer::acquireExplanationBuffer() const
+{
+	if (m_explanationPoolUsed == m_explanationPool.size())
+	{
+		m_explanationPool.push_back(make_unique<vector<Literal>>());
+	}
+
+	vector<Literal>& buffer = *m_explanationPool[m_explanationPoolUsed];
+	++m_explanationPoolUsed;
+
+	buffer.clear();
+	return buffer;
+}
+
+void ConflictAnalyzer::releaseExplanationBuffer() const
+{
+	vxy_assert(m_explanationPoolUsed > 0);
+	--m_explanationPoolUsed;
+}
+
+ConflictAnalyzer::ScopedExplanationBuffer::ScopedExplanationBuffer(const ConflictAnalyzer& analyzer)
+	: m_analyzer(analyzer)
+	, m_buffer(analyzer.acquireExplanationBuffer())
+{
+}
+
+ConflictAnalyzer::ScopedExplanationBuffer::~ScopedExplanationBuffer()
+{
+	m_analyzer.releaseExplanationBuffer();
+}
@@ -1,6 +1,7 @@
 // Copyright Proletariat, Inc. All Rights Reserved.
 #include "prefab/TileSolver.h"
 #include "ConstraintSolver.h"
+#include "decision/EntropyHeuristic.h"
 #include <EASTL/vector.h>
 #include <EASTL/set.h>
 #include <EASTL/tuple.h>
@@ -208,6 +209,25 @@ void TileSolver::addUnique(const shared_ptr<Prefab>& p)
 	}
 }
 
+shared_ptr<EntropyHeuristic> TileSolver::createEntropyHeuristic() const
+{
+	vxy_assert_msg(m_tileData != nullptr, "Input must be parsed before creating the heuristic");
+
+	// Domain values are prefab IDs, starting at 1
+	auto weights = make_shared<vector<float>>(m_prefabs.size(), 0.f);
+	for (const auto& [id, freq] : m_prefabFreq)
+	{
+		(*weights)[id - 1] = float(freq);
+	}
+
+	auto heuristic = make_shared<EntropyHeuristic>(*m_solver);
+	for (int node = 0; node < m_grid->getNumVertices(); ++node)
+	{
+		heuristic->setVariableWeights(m_tileData->get(node), weights);
+	}
+	return heuristic;
+}
+
 void TileSolver::exportJson(string path)
 {
 	json j;
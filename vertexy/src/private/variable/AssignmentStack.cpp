@@ -13,10 +13,10 @@ void AssignmentStack::reset()
 	m_stack.clear();
 }
 
-SolverTimestamp AssignmentStack::recordChange(VarID variable, const ValueSet& prevValues, SolverTimestamp previousModificationTS, IConstraint* constraint, ExplainerFunction explanation)
+SolverTimestamp AssignmentStack::recordChange(VarID variable, const ValueSet& prevValues, SolverTimestamp previousModificationTS, SolverDecisionLevel level, IConstraint* constraint, ExplainerFunction explanation)
 {
 	SolverTimestamp time = m_stack.size();
-	m_stack.push_back({variable, prevValues, previousModificationTS, constraint, move(explanation)});
+	m_stack.push_back({variable, prevValues, previousModificationTS, level, constraint, move(explanation)});
 	return time;
 }
 
@@ -23,6 +23,24 @@ const ValueSet& CommittableVariableDatabase::getInitialValues(VarID variable) co
 	return m_parent->getInitialValues(variable);
 }
 
+void CommittableVariableDatabase::rebind(IVariableDatabase* inParent, IConstraint* outerCons, ICommittableVariableDatabaseOwner* outerSink, int outerSinkID)
+{
+	vxy_assert(!m_lockedVar.isValid());
+	m_parent = inParent;
+	m_outerCons = outerCons;
+	m_outerSink = outerSink;
+	m_outerSinkID = outerSinkID;
+	m_modifications.clear();
+	m_hasContradiction = false;
+	m_committed = false;
+
+	m_numVariables = m_parent->getNumVariables();
+	#if CONSTRAINT_USE_CACHED_STATES
+	m_states.clear();
+	m_states.resize(m_parent->getNumVariables() + 1, EVariableState::Unknown);
+	#endif
+}
+
 bool CommittableVariableDatabase::commitPastAndFutureChanges()
 {
 	if (!m_committed)
@@ -172,4 +190,24 @@ void CommittableVariableDatabase::disableWatcherUntilBacktrack(WatcherHandle han
 void CommittableVariableDatabase::removeVariableWatch(VarID varID, WatcherHandle handle, IVariableWatchSink* sink)
 {
 	return m_outerSink->committableDatabaseRemoveWatchRequest(*this, varID, handle, sink);
-}
\ No newline at end of file
+}
+
+CommittableVariableDatabaseArena::Scope CommittableVariableDatabaseArena::acquire(IVariableDatabase* parent, IConstraint* outerCons, ICommittableVariableDatabaseOwner* outerSink, int outerSinkID)
+{
+	if (m_numInUse == m_databases.size())
+	{
+		m_databases.push_back(make_unique<CommittableVariableDatabase>(parent, outerCons, outerSink, outerSinkID));
+	}
+	else
+	{
+		m_databases[m_numInUse]->rebind(parent, outerCons, outerSink, outerSinkID);
+	}
+	return Scope(*this, m_databases[m_numInUse++].get());
+}
+
+void CommittableVariableDatabaseArena::release(CommittableVariableDatabase* db)
+{
+	vxy_assert(m_numInUse > 0);
+	vxy_assert(m_databases[m_numInUse-1].get() == db);
+	--m_numInUse;
+}
@@ -14,7 +14,7 @@ SolverVariableDatabase::SolverVariableDatabase(ConstraintSolver* inSolver)
 	, m_solver(inSolver)
 {
 	// Dummy for invalid (0 index) var
-	m_variableInfo.push_back({ValueSet(), -1});
+	m_variableInfo.push_back({ValueSet(), -1, 0});
 	m_lastSolvedValues.push_back(0);
 	m_initialValues.push_back({});
 	m_variableNames.push_back({});
@@ -29,6 +29,7 @@ void SolverVariableDatabase::onInitialArcConsistency()
 	{
 		m_initialValues.push_back(m_variableInfo[i].potentialValues);
 		m_variableInfo[i].latestModification = -1;
+		m_variableInfo[i].latestModificationLevel = 0;
 	}
 	m_assignmentStack.reset();
 	m_isSolving = true;
@@ -73,7 +74,7 @@ VarID SolverVariableDatabase::addVariableImpl(const wstring& name, int domainSiz
 	}
 
 	VarID varID(m_variableInfo.size());
-	m_variableInfo.push_back({values, AssignmentStack::TIMESTAMP_INITIAL});
+	m_variableInfo.push_back({values, AssignmentStack::TIMESTAMP_INITIAL, 0});
 	m_lastSolvedValues.push_back(0);
 	m_initialValues.push_back(values);
 	m_variableNames.push_back(name);
@@ -121,7 +122,8 @@ void SolverVariableDatabase::unlockVariableImpl(VarID varID, bool wasChanged, IC
 
 		auto& info = m_variableInfo[varID.raw()];
 		ValueSet prev = info.potentialValues;
-		SolverTimestamp timestamp = m_assignmentStack.recordChange(varID, prev, info.latestModification, constraint, move(explainer));
+		const SolverDecisionLevel level = m_solver->getCurrentDecisionLevel();
+		SolverTimestamp timestamp = m_assignmentStack.recordChange(varID, prev, info.latestModification, level, constraint, move(explainer));
 		vxy_assert(prev.size() == m_lockedValues.size());
 
 		if (auto learned = constraint ? constraint->asClauseConstraint() : nullptr; learned && learned->isLearned())
@@ -132,7 +134,7 @@ void SolverVariableDatabase::unlockVariableImpl(VarID varID, bool wasChanged, IC
 
 		if (m_solver->m_heuristicsInitialized)
 		{
-			for (auto& heuristic : m_solver->getDecisionHeuristics())
+			for (auto heuristic : m_solver->m_immediateNotifyHeuristics)
 			{
 				heuristic->onVariableAssignment(varID, info.potentialValues, m_lockedValues);
 			}
@@ -144,6 +146,7 @@ void SolverVariableDatabase::unlockVariableImpl(VarID varID, bool wasChanged, IC
 		}
 
 		info.latestModification = timestamp;
+		info.latestModificationLevel = level;
 		info.potentialValues = move(m_lockedValues);
 
 		m_solver->notifyVariableModification(varID, constraint);
@@ -155,6 +158,11 @@ void SolverVariableDatabase::queueConstraintPropagation(IConstraint* constraint)
 	m_solver->queueConstraintPropagation(constraint);
 }
 
+void SolverVariableDatabase::markConstraintNeedsBacktrack(IConstraint* constraint)
+{
+	m_solver->markConstraintNeedsBacktrack(constraint);
+}
+
 bool SolverVariableDatabase::getLastSolvedValue(VarID varID, int& outValue) const
 {
 	if (m_lastSolvedValues[varID.raw()] != 0)
@@ -244,6 +252,7 @@ SolverTimestamp SolverVariableDatabase::getModificationTimePriorTo(VarID variabl
 void SolverVariableDatabase::backtrack(SolverTimestamp timestamp, SolverTimestamp latestDecisionLevelTimestamp)
 {
 	vxy_assert(m_isSolving);
+	m_solver->notifyHeuristicsOfBacktrack(timestamp);
 	m_assignmentStack.backtrackToTime(timestamp, [&](const AssignmentStack::Modification& mod)
 	{
 		VariableInfo& varInfo = m_variableInfo[mod.variable.raw()];
@@ -259,11 +268,12 @@ void SolverVariableDatabase::backtrack(SolverTimestamp timestamp, SolverTimestam
 			m_lastSolvedValues[mod.variable.raw()] = solvedValue + 1;
 		}
 
-		for (auto& heuristic : m_solver->getDecisionHeuristics())
+		for (auto heuristic : m_solver->m_immediateNotifyHeuristics)
 		{
 			heuristic->onVariableUnassignment(mod.variable, varInfo.potentialValues, mod.previousValue);
 		}
 		varInfo.latestModification = mod.previousVariableAssignment;
+		varInfo.latestModificationLevel = mod.previousVariableAssignment >= 0 ? m_assignmentStack.getDecisionLevelAtTime(mod.previousVariableAssignment) : 0;
 		varInfo.potentialValues = mod.previousValue;
 
 		// Unlock the learned clause that was locked when this entry was put on the stack
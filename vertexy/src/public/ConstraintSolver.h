@@ -9,14 +9,20 @@
 
 #include "ConstraintSolverStats.h"
 #include "ConstraintSolverResult.h"
+#include "SolverConfig.h"
 
 #include "ConstraintTypes.h"
 #include "SignedClause.h"
 #include "constraints/ConstraintFactoryParams.h"
+#include "variable/CommittableVariableDatabase.h"
 #include "variable/SolverVariableDatabase.h"
 #include "variable/SolverVariableDomain.h"
 #include "decision/CoarseLRBHeuristic.h"
 #include "decision/VSIDSHeuristic.h"
+#include "decision/LRBHeuristic.h"
+#include "decision/TopologyLocalityHeuristic.h"
+#include "decision/ModeSwitchingHeuristic.h"
+#include "decision/PhaseManager.h"
 #include "restart/LubyRestartPolicy.h"
 #include "restart/NoRestartPolicy.h"
 #include "restart/LBDRestartPolicy.h"
@@ -24,6 +30,8 @@
 #include "constraints/IBacktrackingSolverConstraint.h"
 #include "constraints/IConstraint.h"
 #include "learning/ConflictAnalyzer.h"
+#include "ds/FastLookupSet.h"
+#include "ds/WeightedValueSampler.h"
 #include "topology/GraphArgumentTransformer.h"
 #include "topology/TopologyVertexData.h"
 #include "variable/IVariablePropagator.h"
@@ -39,6 +47,10 @@ class IRestartPolicy;
 
 class ProgramInstance;
 class RuleDatabase;
+enum class EAllDifferentPropagation : uint8_t;
+struct DifferenceEdge;
+enum class EWindowShape : uint8_t;
+class PlanarGridTopology;
 
 template<typename T> class TTopologyVertexData;
 
@@ -48,7 +60,10 @@ struct SolvedVariableRecord
 	int value {};
 };
 
-/** For hashing learned constraints */
+/** For hashing learned constraints. Also allows lookup by ClauseSignature, to check for duplicates without constructing the clause.
+ *  Clauses reorder their literals as they watch different ones, so they can't be kept in a canonical order. Instead,
+ *  two clauses are compared in linear time by indexing one clause's literals by variable.
+ */
 struct ConstraintHashFuncs
 {
 	/**
@@ -56,47 +71,62 @@ struct ConstraintHashFuncs
 	 */
 	bool operator()(const ClauseConstraint* consA, const ClauseConstraint* consB) const
 	{
-		if (consA->getNumLiterals() != consB->getNumLiterals())
+		if (consA->getNumLiterals() != consB->getNumLiterals() || consA->getLiteralHash() != consB->getLiteralHash())
 		{
 			return false;
 		}
 
-		for (int i = 0; i < consA->getNumLiterals(); ++i)
+		const int numLiterals = consA->getNumLiterals();
+		for (int i = 0; i < numLiterals; ++i)
 		{
-			auto& lit = consA->getLiteral(i);
-
-			bool bFound = false;
-			for (int j = 0; j < consB->getNumLiterals(); ++j)
+			const int var = consA->getLiteral(i).variable.raw();
+			if (var >= m_literalIndices.size())
 			{
-				if (consB->getLiteral(j) == lit)
-				{
-					bFound = true;
-					break;
-				}
-			}
-			if (!bFound)
-			{
-				return false;
+				m_literalIndices.resize(var + 1, -1);
 			}
+			m_literalIndices[var] = i;
+		}
+
+		// Each variable appears at most once in a clause, so every literal of B must match A's literal on its variable.
+		bool matches = true;
+		for (int i = 0; i < numLiterals && matches; ++i)
+		{
+			auto& lit = consB->getLiteral(i);
+			const int var = lit.variable.raw();
+			matches = var < m_literalIndices.size() && m_literalIndices[var] >= 0 && consA->getLiteral(m_literalIndices[var]) == lit;
 		}
 
-		return true;
+		for (int i = 0; i < numLiterals; ++i)
+		{
+			m_literalIndices[consA->getLiteral(i).variable.raw()] = -1;
+		}
+		return matches;
+	}
+
+	bool operator()(const ClauseConstraint* cons, const ClauseSignature& signature) const
+	{
+		return cons->getLiteralHash() == signature.getHash() && signature.matches(cons->beginLiterals(), cons->getNumLiterals());
+	}
+
+	bool operator()(const ClauseSignature& signature, const ClauseConstraint* cons) const
+	{
+		return operator()(cons, signature);
 	}
 
 	/** Calculates a hash index for a key. */
-	uint32_t operator()(const ClauseConstraint* cons) const
+	size_t operator()(const ClauseConstraint* cons) const
 	{
-		eastl::hash<VarID> varHasher;
-		eastl::hash<ValueSet> valHasher;
+		return size_t(cons->getLiteralHash());
+	}
 
-		uint32_t hash = 0;
-		for (int i = 0; i < cons->getNumLiterals(); ++i)
-		{
-			hash += varHasher(cons->getLiteral(i).variable);
-			hash += valHasher(cons->getLiteral(i).values);
-		}
-		return hash;
+	size_t operator()(const ClauseSignature& signature) const
+	{
+		return size_t(signature.getHash());
 	}
+
+protected:
+	// For each variable, the index of its literal in the clause being compared, or -1
+	mutable vector<int> m_literalIndices;
 };
 
 /** Constraint solver implementation */
@@ -108,16 +138,14 @@ class ConstraintSolver : public IVariableDomainProvider
 	friend class UnfoundedSetAnalyzer;
 	friend class SolverDecisionLog;
 
-	using BaseHeuristicType = CoarseLRBHeuristic;
-	using RestartPolicyType = LubyRestartPolicy;
-
 	static ConstraintSolver* s_currentSolver; // for debugging
 
 	public:
 	using RandomStreamType = std::mt19937;
 
 	// Constructor: if RandomSeed is 0, a random value will be chosen as the seed.
-	explicit ConstraintSolver(const wstring& name = TEXT("[unnamed]"), int randomSeed = 0, const shared_ptr<ISolverDecisionHeuristic>& baseHeuristic = nullptr);
+	// If baseHeuristic is provided, it is used in place of the heuristic(s) selected by the config.
+	explicit ConstraintSolver(const wstring& name = TEXT("[unnamed]"), int randomSeed = 0, const shared_ptr<ISolverDecisionHeuristic>& baseHeuristic = nullptr, const SolverConfig& config = SolverConfig());
 	virtual ~ConstraintSolver() override;
 
 	//
@@ -137,6 +165,11 @@ class ConstraintSolver : public IVariableDomainProvider
 	}
 
 	const ConstraintSolverStats& getStats() const { return m_stats; }
+	const SolverConfig& getConfig() const { return m_config; }
+	// Whether we're currently in stable mode (as opposed to focused mode). Only relevant if mode switching is enabled.
+	bool isInStableMode() const { return m_stableMode; }
+	// The decision level to backtrack to when restarting. Zero unless trail reuse is possible.
+	SolverDecisionLevel getRestartLevel();
 	void dumpStats(bool verbose = false);
 
 	// Adds a strategy to the top of the solver's strategy stack. Must be done before solving starts.
@@ -221,6 +254,17 @@ class ConstraintSolver : public IVariableDomainProvider
 		return int(randomFloat<float>() * outRange + minVal);
 	}
 
+	// Preferred values for decision heuristics
+	PhaseManager& getPhaseManager() { return m_phaseManager; }
+	const PhaseManager& getPhaseManager() const { return m_phaseManager; }
+
+	// Choose a value for a decision from the variable's potential values. If weights have been set for the variable
+	// through setValueWeights, the value is sampled in proportion to the weights; otherwise it is chosen uniformly.
+	int sampleValue(VarID varID, const ValueSet& potentials)
+	{
+		return m_valueSampler.sample(varID, potentials, randomFloat<float>());
+	}
+
 	// Get the decision making heuristic
 	const vector<shared_ptr<ISolverDecisionHeuristic>>& getDecisionHeuristics() { return m_heuristicStack; }
 
@@ -237,6 +281,11 @@ class ConstraintSolver : public IVariableDomainProvider
 	// Gets the decision level where this timestamp occured.
 	SolverDecisionLevel getDecisionLevelForTimestamp(SolverTimestamp time) const;
 
+	// For lookahead heuristics, while choosing a decision: tentatively assign the variable to the value, propagate,
+	// then undo everything. Returns false if propagation failed. OutNumModifications receives the number of
+	// variable modifications that were made (including the assignment itself).
+	bool probeDecision(VarID varID, int value, int& outNumModifications);
+
 	// Whether we're in a new descent. This is true after we've restarted, until we hit a conflict.
 	bool isInNewDescent() const { return m_newDescentAfterRestart; }
 
@@ -270,13 +319,46 @@ class ConstraintSolver : public IVariableDomainProvider
 	// Fill in an already-instantiated graph with variables
 	void fillVariableGraph(const shared_ptr<TTopologyVertexData<VarID>>& data, const SolverVariableDomain& variableDomain, const wstring& namePrefix);
 
+	// Graphs (topologies) that have been registered with the solver through variable graphs
+	const vector<shared_ptr<ITopology>>& getGraphs() const { return m_graphs; }
+
+	// Indices (into getGraphs()) of the graphs that the variable is associated with
+	const vector<uint32_t>& getGraphsForVariable(VarID varID) const
+	{
+		vxy_assert(varID.isValid());
+		return m_variableToGraphs[varID.raw()];
+	}
+
+	// The vertex of the variable within its graph, or -1 if the variable was not created as part of a variable graph.
+	int getVertexForVariable(VarID varID) const
+	{
+		vxy_assert(varID.isValid());
+		return m_variableToVertex[varID.raw()];
+	}
+
+	// All variable graphs that have been created over the given graph (index into getGraphs()).
+	const vector<shared_ptr<TTopologyVertexData<VarID>>>& getVariableGraphs(uint32_t graphID) const
+	{
+		vxy_assert(graphID < m_variableGraphs.size());
+		return m_variableGraphs[graphID];
+	}
+
 	// Initialize a variable's potential values. Can only be called before solving.
 	void setInitialValues(VarID varID, const vector<int>& potentialValues);
 
+	// Bias random value choices made by the decision heuristics for this variable. Weights are indexed by internal
+	// value index (i.e. value - domain minimum), and may be shared between variables. Can only be called before solving.
+	void setValueWeights(VarID varID, const shared_ptr<const vector<float>>& weights);
+	// Set the same value weights for every variable in the graph.
+	void setValueWeights(const shared_ptr<TTopologyVertexData<VarID>>& graphData, const shared_ptr<const vector<float>>& weights);
+
 	// Get the database used to store current variable state and the assignment trail
 	SolverVariableDatabase* getVariableDB() { return &m_variableDB; }
 	const SolverVariableDatabase* getVariableDB() const { return &m_variableDB; }
 
+	// Get the scratch databases used by constraints for speculative propagation, e.g. by DisjunctionConstraint.
+	CommittableVariableDatabaseArena& getScratchDatabaseArena() const { return m_scratchDatabaseArena; }
+
 	// Get the TRANSLATED (not internal) potential values of a given variable.
 	vector<int> getPotentialValues(VarID varID) const;
 
@@ -311,12 +393,23 @@ class ConstraintSolver : public IVariableDomainProvider
 	class ClauseConstraint* nogood(const vector<SignedClause>& clauses);
 	class IffConstraint* iff(const SignedClause& head, const vector<SignedClause>& body);
 	class AllDifferentConstraint* allDifferent(const vector<VarID>& variables, bool useWeakPropagation = false);
+	class AllDifferentConstraint* allDifferent(const vector<VarID>& variables, EAllDifferentPropagation propagation);
 	class TableConstraint* table(const shared_ptr<struct TableConstraintData>& data, const vector<VarID>& variables);
+	class MDDConstraint* mdd(const shared_ptr<struct MDDConstraintData>& data, const vector<VarID>& variables);
+	class RegularConstraint* regular(const shared_ptr<struct RegularConstraintData>& automaton, const vector<VarID>& variables);
 	class OffsetConstraint* offset(VarID sum, VarID term, int delta);
 	class InequalityConstraint* inequality(VarID leftHandSide, EConstraintOperator op, VarID rightHandSide);
+	class ElementConstraint* element(VarID result, VarID index, const vector<VarID>& array);
+	class ElementConstraint* element(VarID result, VarID index, const vector<int>& constants);
+	class DifferenceConstraint* difference(const vector<DifferenceEdge>& edges);
+	class ConnectedConstraint* connected(const shared_ptr<TTopologyVertexData<VarID>>& vertexData, const vector<int>& connectedValues);
 	class CardinalityConstraint* cardinality(const vector<VarID>& variables, const hash_map<int, tuple<int, int>>& cardinalitiesForValues);
+	class WindowCardinalityConstraint* windowCardinality(const shared_ptr<PlanarGridTopology>& grid, const shared_ptr<TTopologyVertexData<VarID>>& cellVariables, const vector<int>& countedValues, EWindowShape shape, int size, int minCount, int maxCount);
 	class SumConstraint* sum(const VarID sum, const vector<VarID>& vars);
+	class LinearConstraint* linear(const vector<VarID>& vars, const vector<int>& coefficients, EConstraintOperator op, int rhs);
+	class LinearConstraint* linear(const vector<VarID>& vars, const vector<int>& coefficients, int lowerBound, int upperBound);
 	class DisjunctionConstraint* disjunction(IConstraint* consA, IConstraint* consB);
+	class DisjunctionConstraint* disjunction(const vector<IConstraint*>& constraints);
 
 	//
 	// Create a constraint across an entire graph. All vertices in the graph will share the same constraints.
@@ -339,6 +432,13 @@ class ConstraintSolver : public IVariableDomainProvider
 	//			OtherVar
 	//		);
 	//
+	// Example 3: Making a linear constraint where the sum of each vertex and its right and down neighbors is at most 4:
+	//		Solver.MakeGraphConstraint<FLinearConstraint>(MyGraph,
+	//			vector{FTopologyLink::Self, FTopologyLink(FGridTopology::Directions::Right, 1), FTopologyLink(FGridTopology::Directions::Down, 1)},
+	//			EConstraintOperator::LessThanEq,
+	//			4
+	//		);
+	//
 	template <typename ConstraintType, typename... ArgsType>
 	GraphConstraintID makeGraphConstraint(const shared_ptr<ITopology>& graph, ArgsType&&... args)
 	{
@@ -397,6 +497,10 @@ class ConstraintSolver : public IVariableDomainProvider
 	// Access the database for creating ASP-style rules
 	RuleDatabase& getRuleDB();
 
+	// Learned constraints that may be purged, and those that will be kept forever
+	const vector<ClauseConstraint*>& getTemporaryLearnedConstraints() const { return m_temporaryLearnedConstraints; }
+	const vector<ClauseConstraint*>& getPermanentLearnedConstraints() const { return m_permanentLearnedConstraints; }
+
 	// Return all the variables that a given constraint refers to
 	const vector<VarID>& getVariablesForConstraint(const IConstraint* constraint) const
 	{
@@ -408,6 +512,10 @@ class ConstraintSolver : public IVariableDomainProvider
 	// which can be more efficient if the constraint involves a large number of variables.
 	void queueConstraintPropagation(const IConstraint* constraint);
 
+	// Called by backtracking constraints that do not want every backtrack notification, when they record state at the
+	// current decision level. The constraint will be backtracked once we backtrack beyond the current level.
+	void markConstraintNeedsBacktrack(IConstraint* constraint);
+
 	// Used by constraint factories
 	inline int getNextConstraintID() const { return m_constraints.size(); }
 
@@ -451,6 +559,17 @@ protected:
 	void backtrackUntilDecision(SolverDecisionLevel decisionLevel, bool isRestart = false);
 	bool shouldRestart();
 
+	// Notify batched heuristics of any assignments made since the last flush
+	void flushHeuristicNotifications();
+	// Notify batched heuristics that every assignment after the given timestamp is about to be un-done
+	void notifyHeuristicsOfBacktrack(SolverTimestamp timestamp);
+	void onRestarted();
+
+	unique_ptr<IRestartPolicy> createRestartPolicy(ERestartPolicy policy);
+	shared_ptr<ISolverDecisionHeuristic> createHeuristic(EDecisionHeuristic heuristic);
+	bool isModeSwitchDue() const;
+	void switchMode();
+
 	ClauseConstraint* learn(const vector<Literal>& learnedClause, const ConstraintGraphRelationInfo* relationInfo);
 	void promoteConstraintToGraph(ClauseConstraint& constraint);
 	bool registerQueuedGraphPromotions();
@@ -503,6 +622,8 @@ protected:
 	EConstraintSolverResult m_currentStatus = EConstraintSolverResult::Uninitialized;
 	// storage for all variables and backtracking data
 	SolverVariableDatabase m_variableDB;
+	// Reusable databases for speculative propagation, shared between all constraints (including nested ones)
+	mutable CommittableVariableDatabaseArena m_scratchDatabaseArena;
 
 	// All constraints that have been learned through conflict analysis that may be purged
 	vector<ClauseConstraint*> m_temporaryLearnedConstraints;
@@ -510,6 +631,8 @@ protected:
 	vector<ClauseConstraint*> m_permanentLearnedConstraints;
 	// Hashset of constraints - used to prevent duplicates during graph promotion
 	hash_set<ClauseConstraint*, ConstraintHashFuncs, ConstraintHashFuncs> m_learnedConstraintSet;
+	// Scratch signature for looking up graph promotion candidates in m_learnedConstraintSet
+	ClauseSignature m_candidateSignature;
 	// Queue of constraints that were created from graph promotions but have not been registered yet.
 	vector<ClauseConstraint*> m_pendingPromotedConstraints;
 
@@ -536,8 +659,9 @@ protected:
 
 	vector<DisabledWatchMarker> m_disabledWatchMarkers;
 
-	// bit for whether a given variable is currently in propagation queue
-	ValueSet m_variableQueuedSet;
+	// Set of variables currently in the propagation queue, by raw VarID. Mirrors m_variablePropagationQueue,
+	// so that it can be cleared in O(1) on backtrack rather than zeroing a bit per variable.
+	TFastLookupSet<uint32_t> m_variableQueuedSet;
 
 	// For a given variable + domain, the created offset variable representing Var in that domain
 	hash_map<tuple<VarID, int, int>, VarID> m_offsetVariableMap;
@@ -549,9 +673,23 @@ protected:
 	// Whether the constraint at given index is a child constraint (i.e. wrapped by an outer constraint)
 	// Child constraints rely on their parents to initialize.
 	vector<bool> m_constraintIsChild;
-	// Constraints that need to be notified when we backtrack
+	// Constraints that need to be notified every time we backtrack
 	vector<IBacktrackingSolverConstraint*> m_backtrackingConstraints;
 
+	// Records that a constraint stored backtracking state at the given level
+	struct BacktrackRecordMarker
+	{
+		SolverDecisionLevel level;
+		int constraintID;
+	};
+
+	// Trail of constraints that need to be notified when we backtrack beyond a given level, ordered by level.
+	vector<BacktrackRecordMarker> m_backtrackRecordTrail;
+	// For each constraint ID, the most recent level it was put on m_backtrackRecordTrail (or 0).
+	vector<SolverDecisionLevel> m_constraintBacktrackRecordLevel;
+	// Working data: set of constraint IDs that need notification during backtracking.
+	TFastLookupSet<int> m_constraintsToBacktrack;
+
 	// For each constraint (indexed by Constraint->ID), the list of variables involved in the constraint.
 	vector<vector<VarID>> m_constraintArcs;
 	// domains for variables, for translation
@@ -564,6 +702,10 @@ protected:
 	vector<shared_ptr<TTopologyVertexData<IConstraint*>>> m_graphConstraints;
 	// For each variable, indices of graphs that the variable is associated with
 	vector<vector<uint32_t>> m_variableToGraphs;
+	// For each variable, the vertex within its graph, or -1 if not part of a variable graph
+	vector<int32_t> m_variableToVertex;
+	// For each graph, the variable graphs that were created over it
+	vector<vector<shared_ptr<TTopologyVertexData<VarID>>>> m_variableGraphs;
 
 	// The watcher for each variable
 	vector<unique_ptr<IVariablePropagator>> m_variablePropagators;
@@ -571,9 +713,33 @@ protected:
 	// Decision heuristic stack
 	vector<shared_ptr<ISolverDecisionHeuristic>> m_heuristicStack;
 	bool m_heuristicsInitialized = false;
+	// Subsets of the heuristic stack that want immediate variable notifications, batched variable notifications,
+	// or conflict activity. Built when heuristics are initialized.
+	vector<ISolverDecisionHeuristic*> m_immediateNotifyHeuristics;
+	vector<ISolverDecisionHeuristic*> m_batchedNotifyHeuristics;
+	vector<ISolverDecisionHeuristic*> m_conflictActivityHeuristics;
+	// Latest assignment stack entry that batched heuristics have been notified of
+	SolverTimestamp m_lastBatchedNotifyTime = -1;
+	// Saved/target/best phase tracking for heuristics
+	PhaseManager m_phaseManager;
+	// Designer-specified weights for random value choices
+	WeightedValueSampler m_valueSampler;
+
+	// Runtime settings
+	SolverConfig m_config;
 
 	// Policy for determining when we restart
-	RestartPolicyType m_restartPolicy;
+	unique_ptr<IRestartPolicy> m_restartPolicy;
+	// If mode switching, the restart policy for the mode we're not currently in
+	unique_ptr<IRestartPolicy> m_inactiveRestartPolicy;
+	// If mode switching (and no base heuristic was supplied), the heuristic holding the focused/stable heuristics
+	shared_ptr<ModeSwitchingHeuristic> m_modeSwitchingHeuristic;
+	// Whether we're in stable mode (false = focused mode)
+	bool m_stableMode = false;
+	// Number of conflicts since the last mode switch
+	uint32_t m_conflictsInMode = 0;
+	// Number of conflicts before we switch modes next
+	float m_modeLength = 0;
 	// Whether we are in a new descent after restarting. Cleared as soon as we hit a conflict.
 	bool m_newDescentAfterRestart = false;
 
@@ -589,8 +755,8 @@ protected:
 	vector<QueuedVariablePropagation> m_variablePropagationQueue;
 	// Prioritized constraint propagation queue. Maps to constraint ID.
 	deque<int> m_constraintPropagationQueue;
-	// Tracks whether a constraint is currently queued, by constraint ID
-	ValueSet m_constraintQueuedSet;
+	// Tracks whether a constraint is currently queued, by constraint ID. Mirrors m_constraintPropagationQueue.
+	TFastLookupSet<int> m_constraintQueuedSet;
 
 	// Most recent watch sink that was triggered.
 	// Reset to null on backtrack.
@@ -759,4 +925,4 @@ protected:
 	}
 };
 
-} // namespace Vertexy
\ No newline at end of file
+} // namespace Vertexy
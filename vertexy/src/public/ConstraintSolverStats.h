@@ -29,10 +29,16 @@ public:
 	uint32_t maxBackjump = 0;
 	// Number of times we've restarted
 	uint32_t numRestarts = 0;
+	// Total number of decision levels kept on restart through trail reuse
+	uint64_t numReusedTrailLevels = 0;
 	// How many initial constraints existed
 	uint32_t numInitialConstraints = 0;
 	// How many constraints were learned (including those that were purged)
 	uint32_t numConstraintsLearned = 0;
+	// Number of literals removed from learned constraints by minimization
+	uint64_t numMinimizedLiterals = 0;
+	// Number of literals removed by minimization from constraints learned within a graph
+	uint64_t numMinimizedGraphLiterals = 0;
 	// How many learned constraints have been promoted to graph constraints
 	uint32_t numConstraintPromotions = 0;
 	// How many promotions failed to generate any constraints;
@@ -32,7 +32,14 @@ enum class EConstraintType : uint8_t
 	Offset,
 	Table,
 	Reachability,
-	Sum
+	Sum,
+	Linear,
+	MDD,
+	Difference,
+	Regular,
+	Element,
+	WindowCardinality,
+	Connected
 };
 
 
@@ -0,0 +1,97 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ConstraintTypes.h"
+
+namespace Vertexy
+{
+
+// Selects the policy that decides when the solver restarts
+enum class ERestartPolicy : uint8_t
+{
+	// Restart on a Luby sequence of conflict counts. See LubyRestartPolicy.
+	Luby,
+	// Glucose-style restarts based on the quality (LBD) of recently learned clauses. See LBDRestartPolicy.
+	LBD,
+	// Never restart. See NoRestartPolicy.
+	None
+};
+
+// Selects the base heuristic used for choosing which variable/value to decide on next
+enum class EDecisionHeuristic : uint8_t
+{
+	// See CoarseLRBHeuristic
+	CoarseLRB,
+	// See VSIDSHeuristic
+	VSIDS,
+	// See LRBHeuristic. Scores each variable+value individually.
+	LRB,
+	// See TopologyLocalityHeuristic. Prefers variables adjacent to recent decisions/propagations in their graph.
+	TopologyLocality
+};
+
+// Selects when decision heuristics prefer target phases over saved phases. See PhaseManager.
+enum class ETargetPhases : uint8_t
+{
+	None,
+	// Only in stable mode (or always, if mode switching is disabled)
+	StableOnly,
+	Always
+};
+
+/**
+ * Runtime settings for a ConstraintSolver. Passed to the solver on construction.
+ *
+ * If mode switching is enabled, the solver alternates between a "focused" mode (aggressive restarts, fast-moving
+ * heuristic) and a "stable" mode (few restarts, slow-moving heuristic), as done by modern SAT solvers. The first
+ * mode lasts modeSwitchInitialConflicts conflicts, and each later mode lasts modeSwitchGrowth times longer than
+ * the one before it. Switches always happen on a restart.
+ */
+struct SolverConfig
+{
+	// Restart policy used when mode switching is disabled
+	ERestartPolicy restartPolicy = ERestartPolicy::Luby;
+	// Base heuristic used when mode switching is disabled. Ignored if a base heuristic is passed to the solver.
+	EDecisionHeuristic heuristic = EDecisionHeuristic::CoarseLRB;
+
+	// Whether to alternate between focused and stable modes
+	bool enableModeSwitching = false;
+	ERestartPolicy focusedRestartPolicy = ERestartPolicy::LBD;
+	EDecisionHeuristic focusedHeuristic = EDecisionHeuristic::VSIDS;
+	ERestartPolicy stableRestartPolicy = ERestartPolicy::Luby;
+	EDecisionHeuristic stableHeuristic = EDecisionHeuristic::CoarseLRB;
+	// Number of conflicts before the first mode switch
+	int modeSwitchInitialConflicts = 1000;
+	// Each mode lasts this many times longer than the previous one
+	float modeSwitchGrowth = 2.f;
+
+	// Whether saved phases are periodically reset to original/flipped/best/random values. See PhaseManager.
+	bool enableRephasing = false;
+	// Conflicts before the first rephase. The Nth rephase happens after N times this many conflicts.
+	int rephaseInitialConflicts = 1000;
+	// When to prefer target phases
+	ETargetPhases targetPhases = ETargetPhases::None;
+
+	// Whether restarts keep the decisions at the bottom of the trail that the heuristic would immediately make again.
+	// Only possible when the base heuristic is the only one on the solver's stack and supports it.
+	bool enableTrailReuse = false;
+
+	// Whether to remove literals from learned clauses that are implied by the rest of the clause.
+	bool minimizeLearnedClauses = true;
+	// Whether minimization also uses permanent learned binary clauses to remove literals implied by the asserting
+	// literal. Only used if minimizeLearnedClauses is set.
+	bool minimizeWithBinaryClauses = true;
+
+	// The literal block distance (LBD) for learned constraints where we put them in the permanent constraint pool.
+	// Permanent constraints will remain forever.
+	int maxPermanentConstraintLBD = 5;
+	// The size of the temporary constraint pool, as a function of the number of initial constraints.
+	float maxLearnedConstraintsScalar = 2.f;
+	// The percent (0.0-1.0) of temporary learned constraints we should purge whenever the pool becomes too large.
+	float constraintPurgePercent = 0.5f;
+	// How many constraints promoted from a graph constraint should be queued before we restart solving and initialize them.
+	int numPendingPromotionsBeforeRestart = 500;
+};
+
+} // namespace Vertexy
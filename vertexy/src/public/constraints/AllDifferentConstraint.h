@@ -11,14 +11,26 @@
 namespace Vertexy
 {
 
+// How much pruning an AllDifferentConstraint performs.
+enum class EAllDifferentPropagation : uint8_t
+{
+	// Only exclude the value of a solved variable from all other variables.
+	Weak,
+	// Also ensure bounds consistency using Hall intervals.
+	Bounds,
+	// Ensure domain consistency (every remaining value is part of some solution) using maximum matching.
+	Domain
+};
+
 class AllDifferentConstraint : public IConstraint
 {
 public:
-	AllDifferentConstraint(const ConstraintFactoryParams& params, const vector<VarID>& variables, bool bWeakPropagation = false);
+	AllDifferentConstraint(const ConstraintFactoryParams& params, const vector<VarID>& variables, EAllDifferentPropagation propagation = EAllDifferentPropagation::Bounds);
 
 	struct AllDifferentFactory
 	{
 		static AllDifferentConstraint* construct(const ConstraintFactoryParams& params, const vector<VarID>& variables, bool useWeakPropagation = false);
+		static AllDifferentConstraint* construct(const ConstraintFactoryParams& params, const vector<VarID>& variables, EAllDifferentPropagation propagation);
 	};
 
 	using Factory = AllDifferentFactory;
@@ -41,6 +53,14 @@ protected:
 	void calculateBounds(const IVariableDatabase* db, const vector<VarID>& unsolvedVariables, vector<Interval>& outBounds, vector<Interval>& outInvBounds) const;
 	bool checkBoundsConsistency(IVariableDatabase* db, const vector<VarID>& unsolvedVariables);
 
+	// Bring the matching graph's edges up to date with the variables' domains, and repair the matching.
+	// Returns false if no variable->value matching covers every variable.
+	bool updateMatching(IVariableDatabase* db);
+	// Remove any value that does not appear in any maximum matching.
+	bool checkDomainConsistency(IVariableDatabase* db);
+	template <typename T>
+	void tarjanVisit(int node, T&& visitor);
+
 	vector<VarID> m_variables;
 	vector<WatcherHandle> m_watcherHandles;
 
@@ -55,9 +75,27 @@ protected:
 
 	// Maximum domain size of all variables in the constraint
 	int m_maxDomainSize;
-	// If true, we will only propagate when a variable is solved, excluding its value from all other variables.
-	// Otherwise we will also perform bounds propagation using hall intervals.
-	bool m_useWeakPropagation;
+	EAllDifferentPropagation m_propagation;
+
+	//
+	// Domain consistency
+	//
+
+	// The variable->value graph. Persists between propagations (and across backtracking), so that only the
+	// variables whose domains changed need to be rematched.
+	BipartiteGraph m_matchingGraph;
+	// Variables that were narrowed since the graph was last updated.
+	vector<bool> m_dirtyVariables;
+	// The tarjan algorithm and the SCC for each node in the residual graph.
+	TarjanAlgorithm m_tarjan;
+	vector<int> m_nodeToScc;
+	// Scratch space
+	ValueSet m_removedValues;
+
+	inline bool isVariableNode(int node) const { return node < m_variables.size(); }
+	inline bool isSinkNode(int node) const { return node == m_variables.size() + m_maxDomainSize; }
+	inline int valueToNode(int value) const { return m_variables.size() + value; }
+	inline int nodeToValue(int node) const { return node - m_variables.size(); }
 
 	mutable MaxOccurrenceExplainer m_explainer;
 };
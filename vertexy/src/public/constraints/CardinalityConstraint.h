@@ -38,6 +38,7 @@ public:
 	virtual bool initialize(IVariableDatabase* db) override;
 	virtual void reset(IVariableDatabase* db) override;
 	virtual bool onVariableNarrowed(IVariableDatabase* db, VarID variable, const ValueSet& previousValue, bool& removeWatch) override;
+	virtual bool wantsEveryBacktrack() const override { return false; }
 	virtual void backtrack(const IVariableDatabase* db, SolverDecisionLevel level) override;
 	virtual bool propagate(IVariableDatabase* db) override;
 	virtual bool checkConflicting(IVariableDatabase* db) const override;
@@ -207,7 +208,8 @@ protected:
 		int numUnitSCCs;
 	};
 
-	BacktrackInfo& backtrackRecord(SolverDecisionLevel level);
+	BacktrackInfo& backtrackRecord(IVariableDatabase* db);
+	void markFullySatisfied(IVariableDatabase* db);
 
 	// The level at which we became fully satisfied
 	int m_fullySatisfiedLevel = -1;
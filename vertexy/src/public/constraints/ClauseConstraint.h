@@ -4,6 +4,7 @@
 #include "ConstraintTypes.h"
 #include "IConstraint.h"
 #include "SignedClause.h"
+#include "constraints/ClauseSignature.h"
 #include "variable/IVariableDatabase.h"
 
 namespace Vertexy
@@ -191,6 +192,13 @@ public:
 		m_extendedInfo->promotionSource = inSource;
 	}
 
+	// Hash of this clause's literals, independent of their order. Only available for learned clauses.
+	inline uint64_t getLiteralHash() const
+	{
+		vxy_assert(isLearned());
+		return m_extendedInfo->literalHash;
+	}
+
 	inline void setStepLearned(int step)
 	{
 		#if CLAUSE_DEBUG_INFO
@@ -233,6 +241,8 @@ protected:
 		unsigned isPromoted : 1;
 		// If we were created via a graph promotion, the constraint that we were promoted from.
 		ClauseConstraint* promotionSource = nullptr;
+		// Hash of the literals (see ClauseSignature::hashLiterals), used for detecting duplicate learned clauses.
+		uint64_t literalHash = 0;
 
 		#if CLAUSE_DEBUG_INFO
 		int stepLearned_ForDebugging = -1;
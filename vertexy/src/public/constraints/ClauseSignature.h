@@ -0,0 +1,54 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#pragma once
+
+#include "ConstraintTypes.h"
+
+namespace Vertexy
+{
+
+/** Canonical representation of a set of literals, used to look up duplicate clauses without constructing them.
+ *  Literals are sorted by variable (with any literals on the same variable merged), and summarized by a 64-bit
+ *  hash over the sorted literals. Learned clauses only store the hash (see hashLiterals), not a signature.
+ */
+class ClauseSignature
+{
+public:
+	ClauseSignature() {}
+	ClauseSignature(const Literal* literals, int numLiterals) { assign(literals, numLiterals); }
+	explicit ClauseSignature(const vector<Literal>& literals) { assign(literals); }
+
+	void assign(const Literal* literals, int numLiterals);
+	void assign(const vector<Literal>& literals) { assign(literals.data(), literals.size()); }
+
+	inline uint64_t getHash() const { return m_hash; }
+	inline int size() const { return m_literals.size(); }
+	inline const vector<Literal>& getLiterals() const { return m_literals; }
+
+	bool operator==(const ClauseSignature& rhs) const;
+	inline bool operator!=(const ClauseSignature& rhs) const { return !operator==(rhs); }
+
+	// Whether the given literals (in any order, each variable at most once) are the same as this signature's.
+	bool matches(const Literal* literals, int numLiterals) const;
+
+	// Hash of a set of literals with unique variables, in any order. Equal to the hash of a signature built from them.
+	static uint64_t hashLiterals(const Literal* literals, int numLiterals);
+
+protected:
+	// Combine a literal into the hash of the literals before it. Literals must be combined in variable order.
+	static uint64_t combineLiteral(uint64_t h, const Literal& lit);
+
+	static inline uint64_t mix(uint64_t h)
+	{
+		h ^= h >> 30;
+		h *= 0xbf58476d1ce4e5b9ULL;
+		h ^= h >> 27;
+		h *= 0x94d049bb133111ebULL;
+		h ^= h >> 31;
+		return h;
+	}
+
+	vector<Literal> m_literals;
+	uint64_t m_hash = 0;
+};
+
+} // namespace Vertexy
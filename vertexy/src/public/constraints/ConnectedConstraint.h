@@ -0,0 +1,115 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#pragma once
+
+#include <EASTL/hash_map.h>
+
+#include "ConstraintTypes.h"
+#include "IBacktrackingSolverConstraint.h"
+#include "ds/DisjointSet.h"
+#include "topology/TopologyVertexData.h"
+
+namespace Vertexy
+{
+
+/** Constraint to ensure that every vertex in a topology whose variable is one of ConnectedValues belongs to a single
+ *  connected region, e.g. "all floor tiles are connected". Unlike ReachabilityConstraint, no source needs to be chosen.
+ *
+ *  Each vertex is definitely in the region, definitely out of it, or undecided. The min graph holds only the vertices
+ *  that are definitely in, and is tracked with a union-find as vertices join it. The max graph holds every vertex that
+ *  isn't definitely out. Propagation:
+ *    - Fails if vertices in the region are in different components of the max graph.
+ *    - Removes undecided vertices that are in a different component of the max graph than the region.
+ *    - Adds undecided vertices that are articulation points of the max graph, separating two vertices in the region.
+ *  Cut vertices are only searched for while the min graph has more than one component. If it has one, and no vertex has
+ *  left the max graph since the last search, the search is skipped: joining the region can't disconnect anything.
+ *
+ *  Edges are taken from the topology in both directions. Vertices without a variable are never part of the region.
+ */
+class ConnectedConstraint : public IBacktrackingSolverConstraint
+{
+public:
+	ConnectedConstraint(const ConstraintFactoryParams& params, const shared_ptr<TTopologyVertexData<VarID>>& vertexData, const ValueSet& connectedMask);
+
+	struct ConnectedFactory
+	{
+		static ConnectedConstraint* construct(const ConstraintFactoryParams& params, const shared_ptr<TTopologyVertexData<VarID>>& vertexData, const vector<int>& connectedValues);
+	};
+
+	using Factory = ConnectedFactory;
+
+	virtual EConstraintType getConstraintType() const override { return EConstraintType::Connected; }
+	virtual vector<VarID> getConstrainingVariables() const override;
+	virtual bool initialize(IVariableDatabase* db) override;
+	virtual void reset(IVariableDatabase* db) override;
+	virtual bool onVariableNarrowed(IVariableDatabase* db, VarID variable, const ValueSet& previousValue, bool& removeWatch) override;
+	virtual bool propagate(IVariableDatabase* db) override;
+	virtual bool wantsEveryBacktrack() const override { return false; }
+	virtual void backtrack(const IVariableDatabase* db, SolverDecisionLevel level) override;
+	virtual bool checkConflicting(IVariableDatabase* db) const override;
+	virtual void explain(const NarrowingExplanationParams& params, vector<Literal>& outExplanation) const override;
+
+protected:
+	enum EVertexState : uint8_t
+	{
+		Out = 0,
+		Undecided,
+		In
+	};
+
+	EVertexState getVertexState(const IVariableDatabase* db, int vertex) const;
+	// Bring the vertex's state up to date with the database. Returns true if it changed.
+	bool updateVertex(IVariableDatabase* db, int vertex);
+	// Recompute all vertex states and the min graph components from the database.
+	void rebuild(const IVariableDatabase* db);
+
+	// Depth-first search of the max graph from Root, recording discovery order, low links, and the number of
+	// vertices in the region within each subtree. Cut vertices are only recorded if FindCutVertices is set.
+	void searchMaxGraph(int root, bool findCutVertices);
+
+	// Explain why the region vertex Start is separated from some other region vertex, by listing the vertices that are
+	// out of the region around Start's component of the max graph (not passing through Blocked).
+	void explainSeparation(const IVariableDatabase* db, int start, int blocked, vector<Literal>& outExplanation) const;
+	ExplainerFunction makeExplainer(int start, int blocked);
+
+	shared_ptr<TTopologyVertexData<VarID>> m_vertexData;
+	// The variable for each vertex. Vertices without a variable are never in the region.
+	vector<VarID> m_vertexVariables;
+	hash_map<VarID, int> m_variableToVertex;
+	vector<WatcherHandle> m_watchers;
+
+	ValueSet m_connectedMask;
+	ValueSet m_notConnectedMask;
+
+	// Undirected adjacency of the topology: the neighbors of vertex V are
+	// m_adjacency[m_adjacencyStart[V]...m_adjacencyStart[V+1]-1]
+	vector<int> m_adjacencyStart;
+	vector<int> m_adjacency;
+
+	vector<EVertexState> m_vertexStates;
+	// Components of the min graph
+	DisjointSet m_minGraphSets;
+	int m_numInVertices = 0;
+	int m_numMinComponents = 0;
+	// Set when backtracking, since the union-find can't be unwound. Rebuilt the next time it is needed.
+	bool m_needsRebuild = true;
+	// Whether any vertex became definitely out (or we rebuilt) since the max graph was last searched.
+	bool m_anyOutSinceSearch = true;
+	// Decision levels where vertex states changed, to be notified when backtracking past them
+	vector<SolverDecisionLevel> m_changedLevels;
+
+	// The region vertex that was found to be separated from another, for explanation
+	int m_conflictVertex = -1;
+
+	// Working data for searchMaxGraph
+	vector<int> m_discovery;
+	vector<int> m_lowLink;
+	vector<int> m_subtreeInCount;
+	// For each vertex, some region vertex in its subtree, or -1.
+	vector<int> m_subtreeInVertex;
+	vector<tuple<int, int>> m_searchStack;
+	// Undecided cut vertices found, along with a region vertex they separate from the root.
+	vector<tuple<int, int>> m_cutVertices;
+};
+
+} // namespace Vertexy
@@ -60,6 +60,7 @@ public:
 	const vector<LiteralRelation>& getLiteralRelations() const { return m_literalRelations; }
 
 	const IGraphRelationPtr<bool>& getFilter() const { return m_filter; }
+	void setFilter(const IGraphRelationPtr<bool>& filter) { m_filter = filter; }
 	
 protected:
 	// The filter for this relation: which vertices it can apply to.
@@ -10,6 +10,7 @@ namespace Vertexy
 		LessThanEq,
 		GreaterThan,
 		GreaterThanEq,
-		NotEqual
+		NotEqual,
+		Equal
 	};
 }
\ No newline at end of file
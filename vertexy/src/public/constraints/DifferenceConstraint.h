@@ -0,0 +1,118 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#pragma once
+
+#include <EASTL/hash_map.h>
+
+#include "ConstraintTypes.h"
+#include "ConstraintOperator.h"
+#include "IConstraint.h"
+
+namespace Vertexy
+{
+
+// A single difference constraint: Left - Right <= Bound, over the variables' actual domain values.
+struct DifferenceEdge
+{
+	VarID left;
+	VarID right;
+	int bound;
+
+	// Left <op> Right + Delta. Equal adds an edge in each direction. NotEqual is not a difference constraint and is
+	// not supported.
+	static void fromInequality(VarID left, EConstraintOperator op, VarID right, int delta, vector<DifferenceEdge>& outEdges);
+	// Sum = Term + Delta, as with OffsetConstraint.
+	static void fromOffset(VarID sum, VarID term, int delta, vector<DifferenceEdge>& outEdges);
+};
+
+/**
+ * Enforces a set of difference constraints (X - Y <= C) together, as a single precedence graph.
+ *
+ * Each difference is an edge Y -> X with weight C, meaning X <= Y + C. Upper bounds flow forward along edges and
+ * lower bounds flow backward, so the bounds of every variable are the shortest paths from the bounds of the others.
+ * When a bound changes, only the affected part of the graph is visited, in order of distance (Dijkstra, with the
+ * weights made non-negative by a feasible potential function). This reaches the same fixpoint as propagating each
+ * InequalityConstraint/OffsetConstraint independently, but in one pass.
+ *
+ * Negative cycles are detected incrementally as edges are added, by repairing the potential function one edge at a
+ * time. Each narrowing is explained by the bound at the start of the path that caused it, rather than by a chain of
+ * single-edge explanations, so a conflict along a cycle resolves to the literals at the ends of the cycle.
+ *
+ * See "Fast and Flexible Difference Constraint Propagation for DPLL(T)", Cotton and Maler.
+ */
+class DifferenceConstraint : public IConstraint
+{
+public:
+	DifferenceConstraint(const ConstraintFactoryParams& params, const vector<DifferenceEdge>& edges);
+
+	struct DifferenceConstraintFactory
+	{
+		static DifferenceConstraint* construct(const ConstraintFactoryParams& params, const vector<DifferenceEdge>& edges);
+	};
+
+	using Factory = DifferenceConstraintFactory;
+
+	virtual EConstraintType getConstraintType() const override { return EConstraintType::Difference; }
+	virtual vector<VarID> getConstrainingVariables() const override;
+	virtual bool initialize(IVariableDatabase* db) override;
+	virtual void reset(IVariableDatabase* db) override;
+	virtual bool onVariableNarrowed(IVariableDatabase* db, VarID variable, const ValueSet& previousValue, bool& removeWatch) override;
+	virtual bool propagate(IVariableDatabase* db) override;
+	virtual bool checkConflicting(IVariableDatabase* db) const override;
+
+	// If the edges contain a negative cycle, the edges that form it. Empty otherwise.
+	const vector<DifferenceEdge>& getNegativeCycle() const { return m_negativeCycle; }
+
+protected:
+	struct Node
+	{
+		VarID variable;
+		// The domain value of internal value index 0
+		int offset;
+		WatcherHandle lowerBoundWatch;
+		WatcherHandle upperBoundWatch;
+	};
+
+	struct Edge
+	{
+		// To <= From + Weight
+		int from;
+		int to;
+		int64_t weight;
+	};
+
+	// Add an edge, repairing the potential function. Returns false if the edge closes a negative cycle.
+	bool addEdge(int from, int to, int64_t weight);
+	int getOrCreateNode(const ConstraintFactoryParams& params, VarID variable);
+
+	// Push the upper bounds of the pending nodes forward along edges (Upper=true), or the lower bounds backward.
+	bool propagateBounds(IVariableDatabase* db, bool upper);
+
+	// Literal for the values of the node's variable that lie within [MinValue, MaxValue].
+	Literal getRangeLiteral(const IVariableDatabase* db, int node, int64_t minValue, int64_t maxValue) const;
+
+	vector<Node> m_nodes;
+	hash_map<VarID, int> m_variableToNode;
+
+	vector<Edge> m_edges;
+	// Edges leaving/entering each node
+	vector<vector<int>> m_outEdges;
+	vector<vector<int>> m_inEdges;
+	// Feasible potential: for every edge, Potential[To] <= Potential[From] + Weight.
+	vector<int64_t> m_potentials;
+	vector<DifferenceEdge> m_negativeCycle;
+
+	// Nodes whose upper/lower bound changed since the last propagation
+	vector<int> m_pending[2];
+	vector<bool> m_isPending[2];
+
+	// Working data for propagateBounds
+	vector<int64_t> m_distances;
+	vector<int> m_origins;
+	vector<int64_t> m_originBounds;
+	vector<int> m_visitedStamps;
+	int m_visitStamp = 0;
+	vector<pair<int64_t, int>> m_heap;
+};
+
+} // namespace Vertexy
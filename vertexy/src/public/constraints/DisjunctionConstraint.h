@@ -10,15 +10,26 @@
 namespace Vertexy
 {
 
-/** enforce that Head is one of HeadValues if and only if InnerCons is satisfied. */
+/**
+ * Enforce that at least one of the inner constraints is satisfied.
+ *
+ * Each inner constraint (alternative) propagates against a speculative database, so its narrowings only reach the
+ * real database once every other alternative is known to be unsatisfiable.
+ *
+ * Similar to two watched literals, only two alternatives (the sentinels) are propagated at any time. The others are
+ * dormant: they ignore narrowings until a sentinel becomes unsatisfiable, at which point a dormant alternative is
+ * re-initialized against the current state and takes its place. This keeps the cost of propagation independent of the
+ * number of alternatives, so a k-way choice doesn't need to be built as a tree of nested binary disjunctions.
+ */
 class DisjunctionConstraint : public IBacktrackingSolverConstraint, public ICommittableVariableDatabaseOwner
 {
 public:
-	DisjunctionConstraint(const ConstraintFactoryParams& params, IConstraint* innerConsA, IConstraint* innerConsB);
+	DisjunctionConstraint(const ConstraintFactoryParams& params, const vector<IConstraint*>& innerCons);
 
 	struct DisjunctionFactory
 	{
 		static DisjunctionConstraint* construct(const ConstraintFactoryParams& params, IConstraint* innerConsA, IConstraint* innerConsB);
+		static DisjunctionConstraint* construct(const ConstraintFactoryParams& params, const vector<IConstraint*>& innerCons);
 	};
 	using Factory = DisjunctionFactory;
 
@@ -44,12 +55,32 @@ public:
 	virtual void committableDatabaseConstraintSatisfied(const CommittableVariableDatabase& db, IConstraint* constraint) override;
 
 protected:
-	inline CommittableVariableDatabase createCommittableDB(IVariableDatabase* db, int innerConsIndex);
+	// Get a speculative database for the given alternative. Changes are committed immediately if it is the only
+	// alternative left.
+	CommittableVariableDatabaseArena::Scope createCommittableDB(IVariableDatabase* db, int innerConsIndex);
 	bool forwardVariableNarrowed(IVariableDatabase* db, IVariableWatchSink* innerSink, int innerConsIndex, VarID var, const ValueSet& previousValue, bool& removeHandle);
 	void explainInner(const NarrowingExplanationParams& params, int innerConsIndex, const ExplainerFunction& innerExpl, vector<Literal>& outExplanation) const;
-	bool markUnsat(const CommittableVariableDatabase& cdb, int innerConsIndex, VarID contradictingVar=VarID::INVALID, const ExplainerFunction& innerExpl = nullptr);
+	void markUnsat(const CommittableVariableDatabase& cdb, int innerConsIndex, VarID contradictingVar=VarID::INVALID, const ExplainerFunction& innerExpl = nullptr);
+
+	// (Re-)initialize a dormant alternative against the current state. Returns false if it is unsatisfiable.
+	bool wakeAlternative(IVariableDatabase* db, int innerConsIndex);
+	// Called when a sentinel alternative was found to be unsatisfiable.
+	bool onSentinelUnsat(IVariableDatabase* db, int innerConsIndex);
+	// Fill any empty sentinel slots with dormant alternatives. If only one alternative is left, its narrowings are
+	// committed from then on. Returns false if every alternative is unsatisfiable.
+	bool updateSentinels(IVariableDatabase* db);
+	void setSentinel(IVariableDatabase* db, int slot, int innerConsIndex);
+
+	inline bool isSentinel(int innerConsIndex) const
+	{
+		return m_sentinels[0] == innerConsIndex || m_sentinels[1] == innerConsIndex;
+	}
 
-	IConstraint* m_innerCons[2];
+	inline bool isSatisfied() const
+	{
+		return (m_sentinels[0] >= 0 && m_alternatives[m_sentinels[0]].fullySatLevel >= 0) ||
+			(m_sentinels[1] >= 0 && m_alternatives[m_sentinels[1]].fullySatLevel >= 0);
+	}
 
 	class SinkWrapper : public IVariableWatchSink
 	{
@@ -75,8 +106,6 @@ protected:
 		int innerConsIndex;
 	};
 
-	hash_map<IVariableWatchSink*, unique_ptr<SinkWrapper>> m_sinkWrappers[2];
-
 	struct UnsatInfo
 	{
 		UnsatInfo() { reset(); }
@@ -99,10 +128,32 @@ protected:
 		SolverDecisionLevel level;
 		vector<Literal> explanation;
 	};
-	UnsatInfo m_unsatInfo[2];
-	SolverDecisionLevel m_fullySatLevel[2];
-	bool m_constraintQueued[2];
-	SolverTimestamp m_lastPropagation[2];
+
+	struct Alternative
+	{
+		IConstraint* constraint = nullptr;
+		hash_map<IVariableWatchSink*, unique_ptr<SinkWrapper>> sinkWrappers;
+		UnsatInfo unsatInfo;
+		SolverDecisionLevel fullySatLevel = -1;
+		// The level the alternative was last initialized at, or -1 if it never was.
+		SolverDecisionLevel initLevel = -1;
+		bool constraintQueued = false;
+		SolverTimestamp lastPropagation = -1;
+	};
+	vector<Alternative> m_alternatives;
+
+	// The alternatives currently being propagated, or -1 if there is no alternative in the slot.
+	int m_sentinels[2];
+	// The level at which all but one alternative was found to be unsatisfiable.
+	SolverDecisionLevel m_unitLevel = -1;
+
+	struct SentinelRecord
+	{
+		SolverDecisionLevel level;
+		int sentinels[2];
+	};
+	// Sentinels before the first change at each level, restored on backtrack.
+	vector<SentinelRecord> m_sentinelTrail;
 };
 
-} // namespace Vertexy
\ No newline at end of file
+} // namespace Vertexy
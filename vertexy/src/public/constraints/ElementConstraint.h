@@ -0,0 +1,114 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#pragma once
+
+#include <EASTL/hash_map.h>
+
+#include "ConstraintTypes.h"
+#include "IConstraint.h"
+#include "topology/GraphRelations.h"
+
+namespace Vertexy
+{
+
+/**
+ * Constraint that Result = Array[Index], where each entry of the array is either a variable or a constant.
+ *
+ * The index variable's actual domain values are positions in the array, so Index = K selects Array[K]. Maintains
+ * domain consistency:
+ *   - Index can't select an entry that shares no values with Result.
+ *   - Result is restricted to the values of the entries that Index can still select.
+ *   - Once Index is fixed, the selected entry is restricted to the values of Result.
+ * Explanations only refer to the entries involved in each narrowing, rather than every variable in the constraint.
+ *
+ * Variable entries may be VarID::INVALID, meaning Index can't select that position. When used as a graph constraint,
+ * makeNeighborRelations() produces an array of neighbor vertices where neighbors outside the topology are INVALID, so
+ * Index can select among the neighbors that exist.
+ */
+class ElementConstraint : public IConstraint
+{
+public:
+	struct Entry
+	{
+		// The variable for this entry, or INVALID for a constant (or missing) entry.
+		VarID variable;
+		// For a variable, the position on the value axis of its internal value index 0.
+		// For a constant, the position on the value axis of the constant, or -1 if it is missing/unreachable.
+		int position;
+	};
+
+	ElementConstraint(const ConstraintFactoryParams& params, VarID result, VarID index, const vector<Entry>& entries, int minValue, int numValues);
+
+	struct ElementConstraintFactory
+	{
+		// Result = Array[Index]
+		static ElementConstraint* construct(const ConstraintFactoryParams& params, VarID result, VarID index, const vector<VarID>& array);
+		// Result = Constants[Index]
+		static ElementConstraint* construct(const ConstraintFactoryParams& params, VarID result, VarID index, const vector<int>& constants);
+	};
+
+	using Factory = ElementConstraintFactory;
+
+	virtual EConstraintType getConstraintType() const override { return EConstraintType::Element; }
+	virtual vector<VarID> getConstrainingVariables() const override;
+	virtual bool initialize(IVariableDatabase* db) override;
+	virtual void reset(IVariableDatabase* db) override;
+	virtual bool onVariableNarrowed(IVariableDatabase* db, VarID variable, const ValueSet& previousValue, bool& removeWatch) override;
+	virtual bool propagate(IVariableDatabase* db) override;
+	virtual bool checkConflicting(IVariableDatabase* db) const override;
+
+	// Relations for the variables at each of the given links from a vertex. Links that leave the topology resolve to
+	// VarID::INVALID rather than failing, so that the array has the same layout for every vertex.
+	static vector<IGraphRelationPtr<VarID>> makeNeighborRelations(const ITopologyPtr& topo, const shared_ptr<TTopologyVertexData<VarID>>& data, const vector<TopologyLink>& links);
+
+	template <typename Topo>
+	static vector<IGraphRelationPtr<VarID>> makeNeighborRelations(const shared_ptr<Topo>& topo, const shared_ptr<TTopologyVertexData<VarID>>& data, const vector<TopologyLink>& links)
+	{
+		return makeNeighborRelations(ITopology::adapt(topo), data, links);
+	}
+
+protected:
+	// Which of the rules narrowed a variable
+	enum class ERule : uint8_t
+	{
+		Index,
+		Result,
+		Entry
+	};
+
+	// The values of a variable, on the shared value axis.
+	void getAxisValues(const IVariableDatabase* db, VarID var, int position, ValueSet& outValues) const;
+	// The values of the variable that correspond to the values set on the value axis.
+	ValueSet toVariableValues(const IVariableDatabase* db, VarID var, int position, const ValueSet& axisValues) const;
+	// The values an entry can take, on the value axis. Returns false if the entry is missing.
+	bool getEntryValues(const IVariableDatabase* db, int entry, ValueSet& outValues) const;
+	// Returns the entry selected by the given index variable value index, or -1 if it doesn't select anything.
+	int getEntryForIndex(int indexValue) const;
+
+	ExplainerFunction makeExplainer(ERule rule, int entry = -1);
+	void explainRule(const NarrowingExplanationParams& params, ERule rule, int entry, vector<Literal>& outExplanation) const;
+
+	VarID m_result;
+	VarID m_index;
+	vector<Entry> m_entries;
+	// For each variable in the array, the entries it appears in.
+	hash_map<VarID, vector<int>> m_variableEntries;
+
+	// The actual value of the index variable's internal value index 0
+	int m_indexMin;
+	// The value axis covers the actual values [MinValue, MinValue + NumValues), and is used to compare values of
+	// variables with different domains.
+	int m_minValue;
+	int m_numValues;
+	// Position on the value axis of the result variable's internal value index 0
+	int m_resultPosition;
+
+	vector<tuple<VarID, WatcherHandle>> m_watches;
+
+	// Working data
+	ValueSet m_resultValues;
+	ValueSet m_supportedValues;
+	ValueSet m_entryValues;
+};
+
+} // namespace Vertexy
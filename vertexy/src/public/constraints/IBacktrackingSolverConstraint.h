@@ -24,6 +24,11 @@ public:
 
 	virtual bool needsBacktracking() const override { return true; }
 
+	// Whether backtrack() should be called every time the solver backtracks. If false, the constraint must call
+	// IVariableDatabase::markConstraintNeedsBacktrack() whenever it records state that needs to be restored, and
+	// backtrack() will only be called when the solver backtracks past a level where that happened.
+	virtual bool wantsEveryBacktrack() const { return true; }
+
 	// Called by the constraint solver if a contradiction has been reached and we need to backtrack.
 	virtual void backtrack(const IVariableDatabase* db, SolverDecisionLevel level) = 0;
 };
@@ -9,7 +9,7 @@
 namespace Vertexy
 {
 
-/** Represents an inequality between two variables e.g. "X <= Y" */
+/** Represents an inequality between two variables e.g. "X <= Y". Equal only propagates bounds. */
 class InequalityConstraint : public IConstraint
 {
 public:
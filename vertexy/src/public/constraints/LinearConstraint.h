@@ -0,0 +1,118 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#pragma once
+
+#include <EASTL/hash_map.h>
+
+#include "ConstraintTypes.h"
+#include "ConstraintOperator.h"
+#include "IBacktrackingSolverConstraint.h"
+
+namespace Vertexy
+{
+
+/**
+ * Constrains a weighted sum of variables to lie within a range: Lower <= Sum(Coefficient[i] * Variable[i]) <= Upper.
+ * Either bound may be omitted, e.g. "Sum <= N" when constructed from an EConstraintOperator. Equal sets both bounds.
+ * NotEqual is not a range, so isn't supported.
+ *
+ * Maintains bounds consistency: the sum of each term's minimum and maximum contribution is kept incrementally as
+ * variables are narrowed, and each term is then restricted to what the remaining slack allows. Unlike a chain of
+ * SumConstraints, no intermediate variables are created.
+ *
+ * Coefficients are applied to the variables' actual domain values (not their internal value indices).
+ */
+class LinearConstraint : public IBacktrackingSolverConstraint
+{
+public:
+	LinearConstraint(const ConstraintFactoryParams& params, const vector<VarID>& variables, const vector<int>& coefficients, bool hasLower, int lower, bool hasUpper, int upper);
+
+	struct LinearConstraintFactory
+	{
+		// Sum(Coefficients[i] * Variables[i]) <op> Rhs
+		static LinearConstraint* construct(const ConstraintFactoryParams& params, const vector<VarID>& variables, const vector<int>& coefficients, EConstraintOperator op, int rhs);
+		// Sum(Variables[i]) <op> Rhs
+		static LinearConstraint* construct(const ConstraintFactoryParams& params, const vector<VarID>& variables, EConstraintOperator op, int rhs);
+		// LowerBound <= Sum(Coefficients[i] * Variables[i]) <= UpperBound
+		static LinearConstraint* construct(const ConstraintFactoryParams& params, const vector<VarID>& variables, const vector<int>& coefficients, int lowerBound, int upperBound);
+	};
+
+	using Factory = LinearConstraintFactory;
+
+	virtual EConstraintType getConstraintType() const override { return EConstraintType::Linear; }
+	virtual vector<VarID> getConstrainingVariables() const override;
+	virtual bool initialize(IVariableDatabase* db) override;
+	virtual void reset(IVariableDatabase* db) override;
+	virtual bool onVariableNarrowed(IVariableDatabase* db, VarID variable, const ValueSet& prevValue, bool& removeWatch) override;
+	virtual bool propagate(IVariableDatabase* db) override;
+	virtual bool wantsEveryBacktrack() const override { return false; }
+	virtual void backtrack(const IVariableDatabase* db, SolverDecisionLevel level) override;
+	virtual bool checkConflicting(IVariableDatabase* db) const override;
+	virtual void explain(const NarrowingExplanationParams& params, vector<Literal>& outExplanation) const override;
+
+protected:
+	struct Term
+	{
+		VarID variable;
+		int64_t coefficient;
+		// The domain value of internal value index 0
+		int64_t offset;
+		// The potential value index bounds last seen for this variable
+		int minIndex;
+		int maxIndex;
+		WatcherHandle lowerBoundWatch;
+		WatcherHandle upperBoundWatch;
+	};
+
+	struct TrailEntry
+	{
+		int term;
+		int minIndex;
+		int maxIndex;
+	};
+
+	struct BacktrackInfo
+	{
+		SolverDecisionLevel level;
+		int trailSize;
+		int64_t minSum;
+		int64_t maxSum;
+	};
+
+	// Smallest/largest contribution of a term to the sum, given the index bounds of its variable
+	static int64_t getTermMin(const Term& term, int minIndex, int maxIndex);
+	static int64_t getTermMax(const Term& term, int minIndex, int maxIndex);
+
+	// Bring a term's cached bounds up to date with the database. Returns true if they changed.
+	bool updateTerm(IVariableDatabase* db, int termIndex);
+	// Restrict a term so that it fits within the slack of each bound.
+	bool tightenTerm(IVariableDatabase* db, int termIndex);
+	bool isViolated() const;
+	bool needsPropagation() const;
+
+	// Compute the sum bounds from a database, rather than from the cached term bounds.
+	void getSumBounds(const IVariableDatabase* db, int64_t& outMinSum, int64_t& outMaxSum) const;
+	// Add the literals for a term that negate the bounds it contributed to the upper and/or lower side of the sum.
+	void addTermReason(const IVariableDatabase* db, const Term& term, bool upperSide, bool lowerSide, vector<Literal>& outExplanation) const;
+
+	vector<Term> m_terms;
+	hash_map<VarID, int> m_variableToTerm;
+
+	bool m_hasLower;
+	int64_t m_lower;
+	bool m_hasUpper;
+	int64_t m_upper;
+
+	// The largest range of contribution any term can have. If the slack of both bounds is at least this large,
+	// no term can be narrowed.
+	int64_t m_maxTermSpan = 0;
+
+	// Sum of each term's minimum/maximum contribution
+	int64_t m_minSum = 0;
+	int64_t m_maxSum = 0;
+
+	// Previous term bounds, restored on backtrack
+	vector<TrailEntry> m_trail;
+	vector<BacktrackInfo> m_backtrackStack;
+};
+
+} // namespace Vertexy
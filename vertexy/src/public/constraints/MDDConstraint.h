@@ -0,0 +1,207 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ConstraintTypes.h"
+#include "IBacktrackingSolverConstraint.h"
+#include "variable/SolverVariableDomain.h"
+
+namespace Vertexy
+{
+
+struct TableConstraintData;
+
+// Static/immutable data for an MDD (multi-valued decision diagram) constraint.
+//
+// The diagram has one layer of nodes per variable, plus a final layer containing only the terminal node. Each edge
+// goes from a node in layer i to a node in layer i+1, and is labelled with a value for variable i. Every path from the
+// root to the terminal is an allowed tuple. The diagram is reduced on construction, so relations with a lot of shared
+// structure take far less space than the equivalent table.
+struct MDDConstraintData
+{
+	// Return true and set OutNextState if Value is allowed for the variable at Layer, when in State.
+	using TransitionFunction = function<bool(int layer, int state, int value, int& outNextState)>;
+	// Return true if the state reached after the last variable is an accepting state.
+	using AcceptFunction = function<bool(int state)>;
+
+	struct Edge
+	{
+		int tail;
+		int head;
+		int value;
+	};
+
+	// Build from a list of tuples. Each entry is a list of values, one per variable.
+	static shared_ptr<MDDConstraintData> fromTuples(const vector<vector<int>>& tupleRows);
+	// Build from the tuples of a table constraint.
+	static shared_ptr<MDDConstraintData> fromTable(const TableConstraintData& table);
+	// Build from a state machine, without ever enumerating the tuples. Starting from InitialState, each layer's
+	// states are expanded by calling Transition for each value in that layer's domain. States must be
+	// non-negative. States that are equal within the same layer share a node.
+	static shared_ptr<MDDConstraintData> fromTransitions(const vector<SolverVariableDomain>& domains, int initialState, const TransitionFunction& transition, const AcceptFunction& isAccepting);
+
+	inline int getNumLayers() const { return layerNodeStart.size() - 1; }
+	inline int getNumNodes() const { return layerNodeStart.back() + 1; }
+	inline int getTerminal() const { return layerNodeStart.back(); }
+	inline bool isEmpty() const { return edges.empty(); }
+
+	// Index of the first node in each layer. The root is node 0, and the terminal is the last node.
+	vector<int> layerNodeStart;
+	// All edges, ordered by layer. Edge values are actual domain values.
+	vector<Edge> edges;
+	// Index of the first edge in each layer, plus one past the end.
+	vector<int> layerEdgeStart;
+
+	// For each layer, the lowest value on any of its edges, and one past the highest.
+	vector<int> layerMinValue;
+	vector<int> layerMaxValue;
+
+	// CSR adjacency: OutEdges[OutEdgeStart[node]...OutEdgeStart[node+1]) are the edges leaving the node.
+	vector<int> outEdgeStart;
+	vector<int> outEdges;
+	// CSR adjacency for edges entering each node.
+	vector<int> inEdgeStart;
+	vector<int> inEdges;
+	// CSR list of edges for each (layer, value), indexed by getValueSetIndex().
+	vector<int> valueEdgeStart;
+	vector<int> valueEdges;
+	// Index of the first value set for each layer, plus one past the end.
+	vector<int> layerValueSetStart;
+	// For each edge, the index of its value set.
+	vector<int> edgeValueSets;
+
+	// Returns the index of the value set for the given layer and value, or -1 if no edges have that value.
+	inline int getValueSetIndex(int layer, int value) const
+	{
+		if (value < layerMinValue[layer] || value >= layerMaxValue[layer])
+		{
+			return -1;
+		}
+		return layerValueSetStart[layer] + value - layerMinValue[layer];
+	}
+
+protected:
+	// Unreduced diagram: for each layer, for each node, the (value, head node) of each outgoing edge.
+	using NodeList = vector<vector<pair<int, int>>>;
+	static shared_ptr<MDDConstraintData> reduce(const vector<NodeList>& layers);
+};
+
+using MDDConstraintDataPtr = shared_ptr<MDDConstraintData>;
+
+// Constraint that, given a list of variables and an MDD, ensures that the variables' values form a path through the
+// MDD from the root to the terminal.
+//
+// Maintains generalized arc consistency incrementally, in the style of MDD4R: the alive edges of each node and of each
+// (variable, value) are kept in sparse sets. Removing a value deletes its edges, which cascades to nodes that lose
+// all of their incoming or outgoing edges. A value is removed once it has no alive edges left. Backtracking restores
+// the sizes of the sparse sets from a trail.
+// See "Efficient Operations On MDDs for Building Constraint Programming Models" Perez and Regin.
+//
+class MDDConstraint : public IBacktrackingSolverConstraint
+{
+public:
+	MDDConstraint(const ConstraintFactoryParams& params, const MDDConstraintDataPtr& inData, const vector<VarID>& inVariables);
+
+	struct MDDConstraintFactory
+	{
+		static MDDConstraint* construct(const ConstraintFactoryParams& params, const MDDConstraintDataPtr& data, const vector<VarID>& variables);
+	};
+
+	using Factory = MDDConstraintFactory;
+
+	virtual EConstraintType getConstraintType() const override { return EConstraintType::MDD; }
+	virtual vector<VarID> getConstrainingVariables() const override { return m_variables; }
+	virtual bool initialize(IVariableDatabase* db) override;
+	virtual void reset(IVariableDatabase* db) override;
+	virtual bool onVariableNarrowed(IVariableDatabase* db, VarID variable, const ValueSet& previousValue, bool& removeWatch) override;
+	virtual bool checkConflicting(IVariableDatabase* db) const override;
+	virtual bool wantsEveryBacktrack() const override { return false; }
+	virtual void backtrack(const IVariableDatabase* db, SolverDecisionLevel level) override;
+
+protected:
+	// Each edge is a member of three sparse sets: its (layer, value), its tail's outgoing edges, and its head's
+	// incoming edges.
+	enum ESetKind
+	{
+		ValueSetKind = 0,
+		OutSetKind,
+		InSetKind,
+		NumSetKinds
+	};
+
+	struct TrailEntry
+	{
+		int set;
+		int size;
+	};
+
+	struct BacktrackData
+	{
+		SolverDecisionLevel level;
+		int trailSize;
+	};
+
+	// Delete all alive edges for the value of the variable at Layer.
+	void removeValue(IVariableDatabase* db, int layer, int value);
+	// Delete the edge, and any edges that become unreachable as a result.
+	void deleteEdge(IVariableDatabase* db, int edge);
+	// Remove any values that lost their last edge. Returns false on contradiction.
+	bool removeUnsupportedValues(IVariableDatabase* db);
+
+	inline int getSetForEdge(ESetKind kind, int edge) const
+	{
+		switch (kind)
+		{
+		case ValueSetKind: return m_kindSetOffsets[kind] + m_data->edgeValueSets[edge];
+		case OutSetKind: return m_kindSetOffsets[kind] + m_data->edges[edge].tail;
+		default: return m_kindSetOffsets[kind] + m_data->edges[edge].head;
+		}
+	}
+
+	inline bool isAlive(int edge) const
+	{
+		const int set = getSetForEdge(ValueSetKind, edge);
+		return m_positions[ValueSetKind][edge] < m_setStarts[set] + m_sizes[set];
+	}
+
+	inline bool isRootAlive() const
+	{
+		return m_sizes[m_kindSetOffsets[OutSetKind]] > 0;
+	}
+
+	// Swap the edge out of the set, returning the new size of the set.
+	int removeFromSet(IVariableDatabase* db, ESetKind kind, int edge);
+
+	// Reference to diagram data.
+	MDDConstraintDataPtr m_data;
+
+	// The variables for this instance of the constraint, one per layer.
+	vector<VarID> m_variables;
+	// Watch for each variable
+	vector<WatcherHandle> m_watchers;
+	// For each variable, the domain value of internal value index 0
+	vector<int> m_domainMins;
+
+	// Flattened sparse sets: all value sets, then all out sets, then all in sets. Members of each set are stored in
+	// Members[SetStarts[set]...SetStarts[set]+Sizes[set]) (alive), followed by the removed members.
+	vector<int> m_members;
+	vector<int> m_setStarts;
+	vector<int> m_sizes;
+	// Offset of the first set of each kind
+	int m_kindSetOffsets[NumSetKinds];
+	// For each kind, for each edge, its index in Members.
+	vector<int> m_positions[NumSetKinds];
+
+	// Previous set sizes, restored on backtrack
+	vector<TrailEntry> m_trail;
+	vector<BacktrackData> m_backtrackStack;
+
+	// Working data: edges pending deletion
+	vector<int> m_edgesToDelete;
+	// Working data: value sets that became empty
+	vector<int> m_unsupportedValueSets;
+	// Scratch space
+	ValueSet m_removedValues;
+};
+
+} // namespace Vertexy
@@ -0,0 +1,85 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#pragma once
+
+#include <EASTL/hash_map.h>
+
+#include "ConstraintTypes.h"
+#include "MDDConstraint.h"
+#include "topology/GraphRelations.h"
+
+namespace Vertexy
+{
+
+// Static/immutable data for a regular constraint: a deterministic finite automaton over variable values.
+// States are numbered 0...NumStates-1. Any (state, value) pair without a transition rejects the sequence.
+struct RegularConstraintData
+{
+	RegularConstraintData(int numStates, int initialState);
+
+	// Build an automaton that accepts any sequence where values in RunValues never appear more than MaxLength
+	// times in a row, e.g. "no more than 3 walls in a row". Values outside of RunValues may appear freely.
+	static shared_ptr<RegularConstraintData> maxRunLength(const SolverVariableDomain& domain, const vector<int>& runValues, int maxLength);
+
+	// Add a transition from FromState to ToState when the next variable has the (actual domain) value Value.
+	void addTransition(int fromState, int value, int toState);
+	void setAccepting(int state, bool acceptState = true);
+
+	bool getTransition(int state, int value, int& outNextState) const;
+	inline bool isAccepting(int state) const { return accepting[state]; }
+	inline int getNumStates() const { return transitions.size(); }
+
+	// Unroll the automaton into a layered graph, with one layer per domain. Results are cached, so that graph
+	// constraints instanced over many vertices with the same domains share a single diagram.
+	MDDConstraintDataPtr unroll(const vector<SolverVariableDomain>& domains) const;
+
+	int initialState;
+	// For each state, the next state for each value.
+	vector<hash_map<int, int>> transitions;
+	vector<bool> accepting;
+
+protected:
+	mutable vector<pair<vector<SolverVariableDomain>, MDDConstraintDataPtr>> m_unrolled;
+};
+
+using RegularConstraintDataPtr = shared_ptr<RegularConstraintData>;
+
+// Constraint that ensures the sequence of values of a list of variables is accepted by an automaton.
+//
+// The automaton is unrolled over the variables into a layered graph, where each layer holds the states reachable
+// after that many variables. Each edge is a (state, value) transition, and propagation is the incremental layered-graph
+// propagation of MDDConstraint: a value is removed as soon as none of its transitions lie on a path from the initial
+// state to an accepting state. This replaces sets of overlapping nogoods (e.g. one per window of a forbidden pattern)
+// with a single constraint.
+//
+// To use as a graph constraint, pass the relations for each step of a walk through the topology, e.g. from
+// makeWalkRelations(). Vertices where the walk leaves the topology don't get a constraint.
+//
+class RegularConstraint : public MDDConstraint
+{
+public:
+	RegularConstraint(const ConstraintFactoryParams& params, const RegularConstraintDataPtr& inAutomaton, const MDDConstraintDataPtr& inUnrolled, const vector<VarID>& inVariables);
+
+	struct RegularConstraintFactory
+	{
+		static RegularConstraint* construct(const ConstraintFactoryParams& params, const RegularConstraintDataPtr& automaton, const vector<VarID>& variables);
+	};
+
+	using Factory = RegularConstraintFactory;
+
+	virtual EConstraintType getConstraintType() const override { return EConstraintType::Regular; }
+
+	// Relations for a walk of Length vertices starting at each vertex, moving by Step each time.
+	static vector<IGraphRelationPtr<VarID>> makeWalkRelations(const ITopologyPtr& topo, const shared_ptr<TTopologyVertexData<VarID>>& data, const TopologyLink& step, int length);
+
+	template <typename Topo>
+	static vector<IGraphRelationPtr<VarID>> makeWalkRelations(const shared_ptr<Topo>& topo, const shared_ptr<TTopologyVertexData<VarID>>& data, const TopologyLink& step, int length)
+	{
+		return makeWalkRelations(ITopology::adapt(topo), data, step, length);
+	}
+
+protected:
+	RegularConstraintDataPtr m_automaton;
+};
+
+} // namespace Vertexy
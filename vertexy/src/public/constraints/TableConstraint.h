@@ -6,30 +6,46 @@
 #include "IBacktrackingSolverConstraint.h"
 
 #include "IConstraint.h"
-#include "ds/SparseSet.h"
+#include "ds/ReversibleSparseBitset.h"
 #include "variable/SolverVariableDomain.h"
-#include <EASTL/hash_set.h>
-#include <EASTL/hash_map.h>
+#include <EASTL/tuple.h>
 
 namespace Vertexy
 {
-// Data for a given set of tuples, once the tuples have been established to be arc-consistent.
+// Data derived from a set of tuples, shared between all constraints using the same TableConstraintData.
 struct TableConstraintIntermediateData
 {
+	using WordType = ReversibleSparseBitset::WordType;
+
 	TableConstraintIntermediateData(const vector<vector<int>>& inTupleRows)
 		: tupleRows(inTupleRows)
 	{
 	}
 
-	// Build the supports table, if not built already. The input variables are just used to grab the domains.
-	void buildSupportsIfNeeded(const IVariableDatabase* db, const vector<VarID>& exampleVariables);
+	// Build the support masks, if not built already.
+	void buildSupportsIfNeeded();
 
-	// Valid tuples. Copied from ConstraintData and adjusted to remove any invalid tuples once initial arc consistency pass has finished.
+	// Returns the mask of rows that contain the value for the variable, or nullptr if there are none.
+	inline const WordType* getSupportMask(int variableIndex, int value) const
+	{
+		if (value < 0 || value >= numValues[variableIndex])
+		{
+			return nullptr;
+		}
+		return &supportMasks[(maskOffsets[variableIndex] + value) * numWords];
+	}
+
+	// The tuples, as given by the ConstraintData.
 	const vector<vector<int>>& tupleRows;
 
-	// The support tables. For each variable, for each value, the indices of each tuple in TupleRows that contain that value for that variable.
-	// [VariableIndex][ValueIndex][RowIndex]
-	vector<vector<vector<int>>> supports;
+	// Number of words needed for a bitset with one bit per row.
+	int numWords = 0;
+	// For each variable, one past the highest value that appears in any row.
+	vector<int> numValues;
+	// For each variable, the index of the mask for its first value.
+	vector<int> maskOffsets;
+	// The support masks. For each variable, for each value, a bitset of the rows that contain that value for that variable.
+	vector<WordType> supportMasks;
 };
 
 // Static/immutable data for defining a table constraint
@@ -48,7 +64,8 @@ struct TableConstraintData
 	{
 	}
 
-	// Crete a new set of tuples by converting the domains (which may not be zero-based) into zero-based
+	// Crete a new set of tuples by converting the domains (which may not be zero-based) into zero-based.
+	// The result is cached, so that all constraints with the same domains share the same converted data.
 	shared_ptr<TableConstraintData> convertFromDomains(const vector<SolverVariableDomain>& domains) const;
 
 	void setData(const vector<vector<int>>& inRows);
@@ -62,6 +79,7 @@ struct TableConstraintData
 
 private:
 	mutable shared_ptr<TableConstraintIntermediateData> m_intermediateData;
+	mutable vector<tuple<vector<SolverVariableDomain>, shared_ptr<TableConstraintData>>> m_convertedData;
 };
 
 using TableConstraintDataPtr = shared_ptr<TableConstraintData>;
@@ -69,32 +87,13 @@ using TableConstraintDataPtr = shared_ptr<TableConstraintData>;
 // Constraint that, given a list of variables, and a table of allowed value combinations for each variable, ensures
 // that one of the rows in the table is selected.
 //
-// Uses the Str3 algorithm for maintaining arc consistency.
-// See "A Path-Optimal GAC Algorithm for Table Constraints" Lecoutre et. al.
-// https://citeseerx.ist.psu.edu/viewdoc/download?doi=10.1.1.455.6489&rep=rep1&type=pdf
+// Uses the Compact-Table algorithm for maintaining arc consistency: the set of rows that are still valid is kept
+// as a reversible sparse bitset, which is intersected with the precomputed support masks of each variable's
+// remaining (or removed) values as they are narrowed.
+// See "Compact-Table: Efficiently Filtering Table Constraints with Reversible Sparse Bit-Sets" Demeulenaere et. al.
 //
 class TableConstraint : public IBacktrackingSolverConstraint
 {
-protected:
-	// Stores data to allow for restoration of constraints when backtracking.
-	struct BacktrackData
-	{
-		BacktrackData(int inLevel, int inNumInvalidatedRows)
-			: level(inLevel)
-			, numInvalidatedRows(inNumInvalidatedRows)
-		{
-		}
-
-		// The solver step this backtrack data corresponds to.
-		SolverDecisionLevel level;
-
-		// Number of invalidated rows prior to this step
-		int numInvalidatedRows;
-
-		// Maps (Variable,Value) -> Cursor
-		hash_map<tuple<int, int>, int> cursors;
-	};
-
 public:
 	TableConstraint(const ConstraintFactoryParams& params, const TableConstraintDataPtr& inData, const vector<VarID>& inVariables);
 
@@ -109,13 +108,21 @@ public:
 	virtual vector<VarID> getConstrainingVariables() const override { return m_variables; }
 	virtual bool initialize(IVariableDatabase* db) override;
 	virtual void reset(IVariableDatabase* db) override;
-	virtual void onInitialArcConsistency(IVariableDatabase* db) override;
 	virtual bool onVariableNarrowed(IVariableDatabase* db, VarID variable, const ValueSet& previousValue, bool& removeWatch) override;
+	virtual bool propagate(IVariableDatabase* db) override;
 	virtual bool checkConflicting(IVariableDatabase* db) const override;
+	virtual bool wantsEveryBacktrack() const override { return false; }
 	virtual void backtrack(const IVariableDatabase* db, SolverDecisionLevel level) override;
 
 protected:
-	BacktrackData& getOrCreateBacktrackData(SolverDecisionLevel level, int prevNumInvalidatedRows);
+	// Remove rows that contain any of the removed values of the variable. Returns false if no rows remain.
+	bool updateTable(IVariableDatabase* db, int variableIndex, const ValueSet& prevValues, bool& outChanged);
+	// Remove rows that contain a value the variable no longer has. Returns false if no rows remain.
+	bool resetTable(IVariableDatabase* db, int variableIndex, bool& outChanged);
+	// Remove any values that are no longer supported by a valid row.
+	bool filterDomains(IVariableDatabase* db);
+	// Save the valid rows if this is the first change at this decision level.
+	void recordBacktrackPoint(IVariableDatabase* db);
 
 	// Reference to allowed row data.
 	TableConstraintDataPtr m_constraintData;
@@ -125,20 +132,21 @@ protected:
 	// Watch for each variable
 	vector<WatcherHandle> m_watchers;
 
-	// For each support table, the cursor for each value entry. Row entries beyond this cursor are known to be invalid.
-	vector<vector<int>> m_rowCursors;
-
-	// State for backtracking
-	vector<BacktrackData> m_backtrackStack;
-
-	vector<vector<int>> m_instancedTupleRows;
+	// Shared support masks
 	shared_ptr<TableConstraintIntermediateData> m_intermediateData;
 
-	// The indices in ConstraintData.TupleRows that are currently invalid.
-	TSparseSet<int> m_invalidatedRows;
+	// The rows that are still valid
+	ReversibleSparseBitset m_validRows;
+	// The decision level for each frame pushed onto ValidRows
+	vector<SolverDecisionLevel> m_backtrackLevels;
+
+	// For each variable, the offset into Residues for its first value.
+	vector<int> m_residueOffsets;
+	// For each (variable, value), the word index in ValidRows where a support was last found.
+	vector<int> m_residues;
 
-	// For each row, a set of [variable, value] that depend on that row for support.
-	vector<hash_set<tuple<int, int>>> m_dependencies;
+	// Scratch space
+	ValueSet m_removedValues;
 };
 
 } // namespace Vertexy
\ No newline at end of file
@@ -0,0 +1,144 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#pragma once
+
+#include <EASTL/hash_map.h>
+
+#include "ConstraintTypes.h"
+#include "IBacktrackingSolverConstraint.h"
+#include "topology/GridTopology.h"
+#include "topology/TopologyVertexData.h"
+
+namespace Vertexy
+{
+
+enum class EWindowShape : uint8_t
+{
+	// Every Size x Size window that lies entirely within the grid.
+	Square,
+	// The neighborhood of every cell, extending Size cells in each direction (including diagonally), clipped to
+	// the grid.
+	Radius
+};
+
+/**
+ * Bounds the number of cells in every window of a grid whose variable takes one of a set of values:
+ * MinCount <= Count(cells in window with value in Values) <= MaxCount.
+ *
+ * This is equivalent to a CardinalityConstraint per window, but all windows share one set of counts. Each cell is
+ * either known to be counted, known not to be counted, or undecided. Each window tracks how many of its cells are
+ * known to be counted and how many might be. The counts are built with 2D prefix sums, then updated incrementally
+ * (and restored on backtrack) as cells change state. A cell only touches the windows that contain it.
+ *
+ * Once a window's known count reaches MaxCount, its undecided cells are excluded from Values. Once its possible count
+ * falls to MinCount, its undecided cells are constrained to Values. Explanations only list the window's decided cells.
+ */
+class WindowCardinalityConstraint : public IBacktrackingSolverConstraint
+{
+public:
+	WindowCardinalityConstraint(const ConstraintFactoryParams& params, const shared_ptr<PlanarGridTopology>& grid, const vector<VarID>& cellVariables, const vector<int>& countedValues, EWindowShape shape, int size, int minCount, int maxCount);
+
+	struct WindowCardinalityConstraintFactory
+	{
+		static WindowCardinalityConstraint* construct(const ConstraintFactoryParams& params, const shared_ptr<PlanarGridTopology>& grid, const shared_ptr<TTopologyVertexData<VarID>>& cellVariables, const vector<int>& countedValues, EWindowShape shape, int size, int minCount, int maxCount);
+	};
+
+	using Factory = WindowCardinalityConstraintFactory;
+
+	virtual EConstraintType getConstraintType() const override { return EConstraintType::WindowCardinality; }
+	virtual vector<VarID> getConstrainingVariables() const override;
+	virtual bool initialize(IVariableDatabase* db) override;
+	virtual void reset(IVariableDatabase* db) override;
+	virtual bool onVariableNarrowed(IVariableDatabase* db, VarID variable, const ValueSet& previousValue, bool& removeWatch) override;
+	virtual bool propagate(IVariableDatabase* db) override;
+	virtual bool wantsEveryBacktrack() const override { return false; }
+	virtual void backtrack(const IVariableDatabase* db, SolverDecisionLevel level) override;
+	virtual bool checkConflicting(IVariableDatabase* db) const override;
+	virtual void explain(const NarrowingExplanationParams& params, vector<Literal>& outExplanation) const override;
+
+protected:
+	enum ECellState : uint8_t
+	{
+		NotCounted = 0,
+		Undecided,
+		Counted
+	};
+
+	struct TrailEntry
+	{
+		int cell;
+		ECellState state;
+	};
+
+	struct BacktrackInfo
+	{
+		SolverDecisionLevel level;
+		int trailSize;
+	};
+
+	ECellState getCellState(const IVariableDatabase* db, int cell) const;
+	// Bring the cell's state up to date with the database, updating the windows that contain it.
+	void updateCell(IVariableDatabase* db, int cell);
+	// Update the counts of each window containing the cell for its new state.
+	void setCellState(int cell, ECellState state, bool queueWindows);
+	// Count the definitely/possibly counted cells of every window from scratch, using 2D prefix sums.
+	void computeWindowCounts(const IVariableDatabase* db, vector<int>& outCounted, vector<int>& outPossible) const;
+	void clearPendingWindows();
+
+	// The cells covered by a window, as an inclusive rectangle.
+	void getWindowRect(int window, int& outMinX, int& outMinY, int& outMaxX, int& outMaxY) const;
+	// The windows containing a cell, as an inclusive rectangle of window anchors.
+	bool getWindowsForCell(int cell, int& outMinX, int& outMinY, int& outMaxX, int& outMaxY) const;
+
+	inline bool isViolated(int window) const
+	{
+		return m_countedCells[window] > m_maxCount || m_possibleCells[window] < m_minCount;
+	}
+
+	inline bool isTight(int window) const
+	{
+		return m_possibleCells[window] > m_countedCells[window] &&
+			(m_countedCells[window] == m_maxCount || m_possibleCells[window] == m_minCount);
+	}
+
+	// Add literals for the decided cells of a window that caused it to reach its maximum (Upper=true) or minimum,
+	// skipping the given variable.
+	void explainWindow(const IVariableDatabase* db, int window, bool upper, VarID skipVar, vector<Literal>& outExplanation) const;
+	ExplainerFunction makeExplainer(int window, bool upper);
+
+	shared_ptr<PlanarGridTopology> m_grid;
+	int m_width;
+	int m_height;
+	EWindowShape m_shape;
+	int m_size;
+	int m_minCount;
+	int m_maxCount;
+	// Number of window anchors along each axis
+	int m_numAnchorsX;
+	int m_numAnchorsY;
+
+	// The variable for each cell, indexed by vertex. Cells without a variable are never counted.
+	vector<VarID> m_cellVariables;
+	hash_map<VarID, int> m_variableToCell;
+	vector<WatcherHandle> m_watchers;
+	// For each cell, the index into CountedMasks of the values that are counted, in the cell variable's domain.
+	vector<int> m_cellMasks;
+	vector<ValueSet> m_countedMasks;
+
+	vector<ECellState> m_cellStates;
+	// For each window, the number of cells that are definitely/possibly counted.
+	vector<int> m_countedCells;
+	vector<int> m_possibleCells;
+
+	// Windows that may be able to propagate
+	vector<int> m_pendingWindows;
+	vector<bool> m_windowPending;
+	// The window that was found to be violated, for explanation
+	int m_conflictWindow = -1;
+
+	// Previous cell states, restored on backtrack
+	vector<TrailEntry> m_trail;
+	vector<BacktrackInfo> m_backtrackStack;
+};
+
+} // namespace Vertexy
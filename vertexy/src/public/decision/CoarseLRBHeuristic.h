@@ -45,6 +45,10 @@ public:
 	// Called during backtracking whenever a previously assigned/propagated variable change is un-done
 	virtual void onVariableUnassignment(VarID var, const ValueSet& beforeBacktrack, const ValueSet& afterBacktrack) override;
 
+	virtual bool wantsBatchedNotifications() const override { return true; }
+	virtual void onVariablesAssigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last) override;
+	virtual void onVariablesUnassigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last) override;
+
 	// Called for every variable that is in a learned clause during conflict analysis
 	virtual void onVariableConflictActivity(VarID var, const ValueSet& values, const ValueSet& prevValues) override;
 	// Called for every variable that is in the reason for a conflict.
@@ -61,7 +65,15 @@ public:
 		return m_priorities[varID.raw()];
 	}
 
+	virtual bool getNextDecisionPriority(double& outPriority) override;
+	virtual bool getDecisionCandidates(int maxCandidates, vector<VarID>& outCandidates) override;
+
 protected:
+	// Apply any pending recency decay to the top of the heap, and return the top.
+	uint32_t peekDecayed();
+	void onSolved(VarID var);
+	void onUnsolved(VarID var);
+
 	ConstraintSolver& m_solver;
 
 	vector<float> m_priorities;
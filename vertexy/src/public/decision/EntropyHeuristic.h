@@ -0,0 +1,90 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#pragma once
+#include "ConstraintTypes.h"
+#include "ISolverDecisionHeuristic.h"
+#include "ds/PriorityHeap.h"
+#include "ds/WeightedValueSampler.h"
+
+namespace Vertexy
+{
+
+class ConstraintSolver;
+
+/**
+ * Wave-function-collapse style heuristic: picks the unsolved variable whose remaining values have the lowest
+ * (weighted) Shannon entropy, then samples a value in proportion to the weights of its remaining values.
+ *
+ * Only variables that have been given weights via setVariableWeights are considered. For any other variable (or
+ * once every weighted variable is solved), decisions are deferred to the next heuristic on the solver's stack.
+ */
+class EntropyHeuristic : public ISolverDecisionHeuristic
+{
+protected:
+	struct Comparator
+	{
+		vector<double>& entropies;
+
+		Comparator(vector<double>& entropies)
+			: entropies(entropies)
+		{
+		}
+
+		bool operator()(uint32_t lhs, uint32_t rhs)
+		{
+			return entropies[lhs] < entropies[rhs];
+		}
+	};
+
+	using VariableHeap = TPriorityHeap<uint32_t, Comparator>;
+
+public:
+	EntropyHeuristic(ConstraintSolver& solver);
+
+	// Set the weight of each value of the variable. Weights are indexed by internal value index, and may be shared
+	// between variables. Must be called before solving starts.
+	void setVariableWeights(VarID varID, const shared_ptr<const vector<float>>& weights);
+
+	virtual void initialize() override;
+	virtual bool getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues) override;
+
+	virtual void onVariableAssignment(VarID var, const ValueSet& prevValues, const ValueSet& newValues) override;
+	virtual void onVariableUnassignment(VarID var, const ValueSet& beforeBacktrack, const ValueSet& afterBacktrack) override;
+
+	virtual bool wantsBatchedNotifications() const override { return true; }
+	virtual void onVariablesAssigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last) override;
+	virtual void onVariablesUnassigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last) override;
+	virtual bool wantsConflictActivity() const override { return false; }
+
+	// Lower entropy = higher priority
+	virtual double getPriority(VarID varID, int value) const override
+	{
+		return varID.raw() < m_entropies.size() ? -m_entropies[varID.raw()] : 0.0;
+	}
+
+protected:
+	inline bool isManaged(VarID varID) const { return varID.raw() < m_weights.size() && m_weights[varID.raw()] != nullptr; }
+
+	void addValue(VarID varID, int value, double sign);
+	void updateEntropy(VarID varID);
+
+	ConstraintSolver& m_solver;
+
+	// Per variable: value weights, or null if this variable isn't managed by us.
+	vector<shared_ptr<const vector<float>>> m_weights;
+	// Per variable: sum of weights of potential values
+	vector<double> m_weightSums;
+	// Per variable: sum of w*log(w) of weights of potential values
+	vector<double> m_weightLogWeightSums;
+	// Per variable: small random value to break ties between equal entropies
+	vector<double> m_noise;
+	// Per variable: current entropy (plus noise)
+	vector<double> m_entropies;
+
+	// Unsolved managed variables, lowest entropy first
+	VariableHeap m_heap;
+	// Samples values in proportion to their weights
+	WeightedValueSampler m_sampler;
+};
+
+} // namespace Vertexy
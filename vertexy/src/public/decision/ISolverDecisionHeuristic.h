@@ -6,6 +6,8 @@
 namespace Vertexy
 {
 
+class SolverVariableDatabase;
+
 /** Common interface for solver decision strategies, i.e. what variable/value is chosen next while searching. */
 class ISolverDecisionHeuristic
 {
@@ -35,6 +37,23 @@ public:
 	{
 	}
 
+	// Whether we want to be notified of variable assignments/unassignments at all.
+	virtual bool wantsVariableNotifications() const { return true; }
+	// If true, onVariablesAssigned/onVariablesUnassigned are called instead of onVariableAssignment/onVariableUnassignment.
+	virtual bool wantsBatchedNotifications() const { return false; }
+
+	// Batched version of onVariableAssignment. Called once per propagation round (and before any decision) with the
+	// range of assignment stack entries that were made since the last call. The database reflects the state after
+	// all of the entries.
+	// The default implementation calls onVariableAssignment for each entry.
+	virtual void onVariablesAssigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last);
+	// Batched version of onVariableUnassignment. Called once per backtrack with the range of assignment stack entries
+	// that are about to be un-done. The database reflects the state prior to backtracking.
+	// The default implementation calls onVariableUnassignment for each entry, latest first.
+	virtual void onVariablesUnassigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last);
+
+	// Whether we want onVariableConflictActivity calls.
+	virtual bool wantsConflictActivity() const { return true; }
 	// Called for every variable that is in a learned clause during conflict analysis
 	virtual void onVariableConflictActivity(VarID var, const ValueSet& values, const ValueSet& prevValues)
 	{
@@ -59,6 +78,15 @@ public:
 
 	// Return the priority of the given variable+value
 	virtual double getPriority(VarID varID, int value) const { return 0.0; }
+
+	// Used for partial restarts: get the priority (as returned by getPriority) of the decision that would be made
+	// next. Decisions on the trail with a higher priority would be made again after a restart, so are kept.
+	// Return false if not supported, in which case restarts always backtrack to the root.
+	virtual bool getNextDecisionPriority(double& outPriority) { return false; }
+
+	// Used for lookahead: get up to MaxCandidates unsolved variables that would be decided on next, best first.
+	// Return false if not supported.
+	virtual bool getDecisionCandidates(int maxCandidates, vector<VarID>& outCandidates) { return false; }
 };
 
 } // namespace Vertexy
\ No newline at end of file
@@ -0,0 +1,117 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#pragma once
+#include "ConstraintTypes.h"
+#include "ISolverDecisionHeuristic.h"
+#include "ds/PriorityHeap.h"
+
+namespace Vertexy
+{
+
+class ClauseConstraint;
+class ConstraintSolver;
+
+// Learning-Rate-Based heuristic for choosing variables/values
+// See https://cs.uwaterloo.ca/~ppoupart/publications/sat/learning-rate-branching-heuristic-SAT.pdf
+// Unlike CoarseLRBHeuristic, this version tracks the learning rate of each individual variable+value, so that
+// values that rarely appear in learned clauses are deprioritized. The heap holds a key for each potential value of
+// each unsolved variable, so both the variable and value are chosen with a single heap lookup.
+class LRBHeuristic : public ISolverDecisionHeuristic
+{
+protected:
+	struct Comparator
+	{
+		vector<float>& priorities;
+
+		Comparator(vector<float>& priorities)
+			: priorities(priorities)
+		{
+		}
+
+		bool operator()(uint32_t lhs, uint32_t rhs)
+		{
+			return priorities[lhs] > priorities[rhs];
+		}
+	};
+
+	using LiteralHeap = TPriorityHeap<uint32_t, Comparator>;
+
+public:
+	LRBHeuristic(ConstraintSolver& solver);
+
+	virtual void initialize() override;
+	virtual bool getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues) override;
+
+	// Called every time a variable changes due to a decision or propagation
+	virtual void onVariableAssignment(VarID var, const ValueSet& prevValues, const ValueSet& newValues) override;
+	// Called during backtracking whenever a previously assigned/propagated variable change is un-done
+	virtual void onVariableUnassignment(VarID var, const ValueSet& beforeBacktrack, const ValueSet& afterBacktrack) override;
+
+	virtual bool wantsBatchedNotifications() const override { return true; }
+	virtual void onVariablesAssigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last) override;
+	virtual void onVariablesUnassigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last) override;
+
+	// Called for every variable that is in a learned clause during conflict analysis
+	virtual void onVariableConflictActivity(VarID var, const ValueSet& values, const ValueSet& prevValues) override;
+	// Called for every variable that is in the reason for a conflict.
+	virtual void onVariableReasonActivity(VarID var, const ValueSet& values, const ValueSet& prevValues) override;
+
+	virtual bool wantsReasonActivity() const override { return m_wantReasonActivity; }
+
+	// Called after a search dead-end is reached, after a clause is learned
+	virtual void onClauseLearned() override;
+
+	// Return the priority of the given variable+value
+	virtual double getPriority(VarID varID, int value) const override
+	{
+		return m_priorities[getKey(varID, value)];
+	}
+
+	virtual bool getNextDecisionPriority(double& outPriority) override;
+	virtual bool getDecisionCandidates(int maxCandidates, vector<VarID>& outCandidates) override;
+
+protected:
+	// Apply any pending recency decay to the top of the heap, and return the top.
+	uint32_t peekDecayed();
+	inline uint32_t getKey(VarID varID, int value) const { return m_keyOffsets[varID.raw()] + value; }
+
+	void removeKey(uint32_t key);
+	void restoreKey(uint32_t key);
+
+	ConstraintSolver& m_solver;
+
+	// For each variable, the key of its first value. Keys for each value of the variable are consecutive.
+	vector<uint32_t> m_keyOffsets;
+	// For each key, the variable it belongs to
+	vector<VarID> m_keyToVar;
+
+	vector<float> m_priorities;
+
+	// The priority queue for variable/value selection. Contains every potential value of every unsolved variable.
+	LiteralHeap m_heap;
+	// Scratch space for getDecisionCandidates
+	vector<uint32_t> m_poppedKeys;
+
+	// Whether we want to leverage reason activity.
+	bool m_wantReasonActivity;
+
+	// Controls weights for the exponential moving average (EMA)
+	float m_stepSize;
+	// Incremented each time we reach a dead-end (and hence learn a new clause)
+	int m_learntCounter;
+
+	//
+	// The remainder of these are indexed by key.
+	//
+
+	// How many clauses were learned at the last point this key was put back in the heap
+	vector<uint32_t> m_unassigned;
+	// How many clauses were learned at the point this key was removed from the heap
+	vector<uint32_t> m_assigned;
+	// Count of how many times this value appeared in a learned clause since it was removed from the heap
+	vector<uint32_t> m_participated;
+	// Count of how many times this value was on the "reason side" of a conflict since it was removed from the heap
+	vector<uint32_t> m_reasoned;
+};
+
+} // namespace Vertexy
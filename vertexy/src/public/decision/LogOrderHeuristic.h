@@ -30,6 +30,8 @@ public:
 	{
 	}
 
+	virtual bool wantsVariableNotifications() const override { return false; }
+	virtual bool wantsConflictActivity() const override { return false; }
 	virtual double getPriority(VarID id, int value) const override { return 0; }
 
 protected:
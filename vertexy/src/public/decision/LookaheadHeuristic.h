@@ -0,0 +1,44 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#pragma once
+#include "ConstraintTypes.h"
+#include "ISolverDecisionHeuristic.h"
+
+namespace Vertexy
+{
+
+class ConstraintSolver;
+
+/**
+ * Lookahead heuristic, intended for small, dense problems (e.g. Sudoku or N-Queens style puzzles) where the
+ * extra propagation per decision pays for itself.
+ *
+ * Takes the top candidate variables from the solver's base heuristic, and tentatively propagates each of their
+ * potential values. The variable whose values cause the most propagation overall is chosen, and it is assigned the
+ * value that causes the least (i.e. the one that leaves the most freedom).
+ *
+ * If any tentative value fails propagation, it is immediately returned as the decision. The resulting conflict is
+ * analyzed as normal, so the solver learns a clause excluding it: at the first decision level this is a unit, so
+ * failed literals are removed at the root.
+ */
+class LookaheadHeuristic : public ISolverDecisionHeuristic
+{
+public:
+	LookaheadHeuristic(ConstraintSolver& solver, int numCandidates = 8);
+
+	virtual bool getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues) override;
+
+	virtual bool wantsVariableNotifications() const override { return false; }
+	virtual bool wantsConflictActivity() const override { return false; }
+
+protected:
+	ConstraintSolver& m_solver;
+	// How many variables from the base heuristic to look ahead on
+	int m_numCandidates;
+
+	// Scratch space
+	vector<VarID> m_candidates;
+	ValueSet m_values;
+};
+
+} // namespace Vertexy
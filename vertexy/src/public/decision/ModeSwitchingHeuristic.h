@@ -0,0 +1,47 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#pragma once
+#include "ConstraintTypes.h"
+#include "ISolverDecisionHeuristic.h"
+
+namespace Vertexy
+{
+
+/**
+ * Wraps the heuristics for the solver's focused and stable modes. Both heuristics receive every notification, so
+ * that the inactive one keeps an accurate view of the search (e.g. which variables are unassigned), but only the
+ * active one is asked for decisions.
+ */
+class ModeSwitchingHeuristic : public ISolverDecisionHeuristic
+{
+public:
+	ModeSwitchingHeuristic(const shared_ptr<ISolverDecisionHeuristic>& focused, const shared_ptr<ISolverDecisionHeuristic>& stable);
+
+	void setStableMode(bool stable) { m_active = stable ? m_stable.get() : m_focused.get(); }
+	bool isStableMode() const { return m_active == m_stable.get(); }
+
+	virtual void initialize() override;
+	virtual bool getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues) override;
+	virtual void onVariableAssignment(VarID var, const ValueSet& prevValues, const ValueSet& newValues) override;
+	virtual void onVariableUnassignment(VarID var, const ValueSet& beforeBacktrack, const ValueSet& afterBacktrack) override;
+	virtual bool wantsVariableNotifications() const override;
+	virtual bool wantsBatchedNotifications() const override { return true; }
+	virtual void onVariablesAssigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last) override;
+	virtual void onVariablesUnassigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last) override;
+	virtual bool wantsConflictActivity() const override;
+	virtual void onVariableConflictActivity(VarID var, const ValueSet& values, const ValueSet& prevValues) override;
+	virtual void onVariableReasonActivity(VarID var, const ValueSet& values, const ValueSet& prevValues) override;
+	virtual bool wantsReasonActivity() const override;
+	virtual void onClauseLearned() override;
+	virtual void onRestarted() override;
+	virtual double getPriority(VarID varID, int value) const override { return m_active->getPriority(varID, value); }
+	virtual bool getNextDecisionPriority(double& outPriority) override { return m_active->getNextDecisionPriority(outPriority); }
+	virtual bool getDecisionCandidates(int maxCandidates, vector<VarID>& outCandidates) override { return m_active->getDecisionCandidates(maxCandidates, outCandidates); }
+
+protected:
+	shared_ptr<ISolverDecisionHeuristic> m_focused;
+	shared_ptr<ISolverDecisionHeuristic> m_stable;
+	ISolverDecisionHeuristic* m_active;
+};
+
+} // namespace Vertexy
@@ -0,0 +1,83 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#pragma once
+#include "ConstraintTypes.h"
+
+namespace Vertexy
+{
+
+class ConstraintSolver;
+
+/**
+ * Tracks preferred values ("phases") for each variable, used by decision heuristics to pick which value to try
+ * once they've chosen a variable.
+ *
+ * - The saved phase is the last value the variable was solved to (see SolverVariableDatabase::getLastSolvedValue).
+ * - The target phase is the assignment of the longest conflict-free trail seen since the last rephase.
+ * - The best phase is the assignment of the longest conflict-free trail seen since the last best-rephase.
+ *
+ * Periodically (on restart) the saved phases are overwritten ("rephased") with original, flipped, best, or random
+ * values, which helps the solver escape from areas of the search space it is stuck in.
+ * See "Chasing Target Phases", Biere & Fleury. http://fmv.jku.at/papers/BiereFleury-POS20.pdf
+ */
+class PhaseManager
+{
+public:
+	enum class ERephase : uint8_t
+	{
+		// Forget saved phases, so heuristics use their default value choice
+		Original,
+		// Replace each saved phase with its mirror in the variable's domain (i.e. inverts boolean variables)
+		Flipped,
+		// Replace saved phases with the best phase
+		Best,
+		// Replace saved phases with random values
+		Random
+	};
+
+	explicit PhaseManager(ConstraintSolver& solver);
+
+	// Called when solving starts, after all variables have been created
+	void initialize();
+	// Forget all target and best phases
+	void reset();
+
+	// Called right before backtracking from a conflict. conflictFreeTimestamp is the last timestamp of the trail
+	// that did not lead to the conflict.
+	void onConflict(SolverTimestamp conflictFreeTimestamp);
+	// Called whenever the trail is backtracked, keeping everything up to and including the timestamp.
+	void onBacktrack(SolverTimestamp timestamp);
+	// Called whenever the solver restarts. Rephases if it is time to.
+	void onRestarted();
+
+	// Returns the value the heuristic should pick for this variable, if there is a preference.
+	bool getPreferredValue(VarID varID, const ValueSet& potentialValues, int& outValue) const;
+
+protected:
+	// Record the values at conflictFreeTimestamp of variables solved after validTimestamp. Variables solved
+	// before then can't have changed, so their phases are already up to date.
+	void updatePhases(vector<int>& phases, SolverTimestamp validTimestamp, SolverTimestamp conflictFreeTimestamp);
+	void rephase(ERephase type);
+	bool useTargetPhases() const;
+
+	ConstraintSolver& m_solver;
+
+	// For each variable, if non-zero, the value (+1) of the target phase
+	vector<int> m_targetPhases;
+	// For each variable, if non-zero, the value (+1) of the best phase
+	vector<int> m_bestPhases;
+	// Length of the trail the target/best phases were taken from
+	SolverTimestamp m_targetTrailSize = 0;
+	SolverTimestamp m_bestTrailSize = 0;
+	// The part of the trail (up to and including this timestamp) that is unchanged since the target/best phases
+	// were last updated.
+	SolverTimestamp m_targetValidTimestamp = -1;
+	SolverTimestamp m_bestValidTimestamp = -1;
+
+	// Number of conflicts since the last rephase
+	int m_conflictsSinceRephase = 0;
+	// Number of rephases that have occurred
+	int m_numRephases = 0;
+};
+
+} // namespace Vertexy
@@ -38,6 +38,7 @@ public:
 	virtual bool getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues) override;
 	virtual void onVariableAssignment(VarID var, const ValueSet& prevValues, const ValueSet& newValues) override;
 	virtual void onVariableUnassignment(VarID var, const ValueSet& beforeBacktrack, const ValueSet& afterBacktrack) override;
+	virtual bool wantsConflictActivity() const override { return false; }
 
 	virtual double getPriority(VarID id, int value) const override
 	{
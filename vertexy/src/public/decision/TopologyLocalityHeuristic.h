@@ -0,0 +1,83 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#pragma once
+#include "ConstraintTypes.h"
+#include "ISolverDecisionHeuristic.h"
+#include "ds/PriorityHeap.h"
+
+namespace Vertexy
+{
+
+class ConstraintSolver;
+class CoarseLRBHeuristic;
+
+/**
+ * Orders decisions spatially: prefers unsolved variables whose graph vertex is adjacent to (or shared with) the
+ * most recently decided or propagated graph variable. This keeps the search moving along a frontier, so the
+ * working set of the trail stays small and graph-promoted clauses fire early.
+ *
+ * Ties between equally-recent neighbors are broken by LRB activity. Activity is tracked by an internal
+ * CoarseLRBHeuristic, which is also used for decisions when there is no frontier yet and for variables that aren't
+ * part of any variable graph.
+ */
+class TopologyLocalityHeuristic : public ISolverDecisionHeuristic
+{
+protected:
+	struct Comparator
+	{
+		vector<uint64_t>& recency;
+
+		Comparator(vector<uint64_t>& recency)
+			: recency(recency)
+		{
+		}
+
+		bool operator()(uint32_t lhs, uint32_t rhs)
+		{
+			return recency[lhs] > recency[rhs];
+		}
+	};
+
+	using VariableHeap = TPriorityHeap<uint32_t, Comparator>;
+
+public:
+	TopologyLocalityHeuristic(ConstraintSolver& solver);
+
+	virtual void initialize() override;
+	virtual bool getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues) override;
+
+	virtual void onVariableAssignment(VarID var, const ValueSet& prevValues, const ValueSet& newValues) override;
+	virtual void onVariableUnassignment(VarID var, const ValueSet& beforeBacktrack, const ValueSet& afterBacktrack) override;
+
+	virtual bool wantsBatchedNotifications() const override { return true; }
+	virtual void onVariablesAssigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last) override;
+	virtual void onVariablesUnassigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last) override;
+
+	virtual void onVariableConflictActivity(VarID var, const ValueSet& values, const ValueSet& prevValues) override;
+	virtual void onVariableReasonActivity(VarID var, const ValueSet& values, const ValueSet& prevValues) override;
+	virtual bool wantsReasonActivity() const override;
+	virtual void onClauseLearned() override;
+	virtual void onRestarted() override;
+
+	virtual double getPriority(VarID varID, int value) const override;
+
+protected:
+	// Mark all unsolved graph variables adjacent to the variable's vertex as the most recent frontier.
+	void touchNeighbors(VarID var);
+	void touchVertex(uint32_t graphID, int vertex);
+
+	ConstraintSolver& m_solver;
+	// Tracks activity for tie-breaking, and makes decisions when we have no frontier.
+	shared_ptr<CoarseLRBHeuristic> m_activity;
+
+	// Per variable: the stamp of the last time a neighbor was decided/propagated, or 0 if never.
+	vector<uint64_t> m_recency;
+	uint64_t m_stamp = 0;
+
+	// Unsolved graph variables, most recently touched first
+	VariableHeap m_heap;
+	// Scratch space for collecting variables that tie for the most recent stamp
+	vector<uint32_t> m_ties;
+};
+
+} // namespace Vertexy
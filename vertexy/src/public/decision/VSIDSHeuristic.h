@@ -42,6 +42,10 @@ public:
 	virtual void onVariableAssignment(VarID varID, const ValueSet& prevValues, const ValueSet& newValues) override;
 	// Called during backtracking whenever a previously assigned/propagated variable change is un-done
 	virtual void onVariableUnassignment(VarID varID, const ValueSet& beforeBacktrack, const ValueSet& afterBacktrack) override;
+
+	virtual bool wantsBatchedNotifications() const override { return true; }
+	virtual void onVariablesAssigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last) override;
+	virtual void onVariablesUnassigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last) override;
 	// Called for every variable that is in a learned clause during conflict analysis
 	virtual void onVariableConflictActivity(VarID varID, const ValueSet& values, const ValueSet& prevValues) override;
 
@@ -57,6 +61,9 @@ public:
 		return m_priorities[varID.raw()];
 	}
 
+	virtual bool getNextDecisionPriority(double& outPriority) override;
+	virtual bool getDecisionCandidates(int maxCandidates, vector<VarID>& outCandidates) override;
+
 protected:
 	void increasePriority(VarID varID, double increment);
 
@@ -0,0 +1,204 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ConstraintTypes.h"
+
+namespace Vertexy
+{
+
+/** Reversible sparse bitset, as used by the Compact-Table algorithm.
+ *  See "Compact-Table: Efficiently Filtering Table Constraints with Reversible Sparse Bit-Sets", Demeulenaere et. al.
+ *
+ *  Bits can only be cleared, and only by intersecting with a mask. Words that become zero are swapped out of the
+ *  active index, so that every operation only visits words that still have bits set.
+ *
+ *  State can be saved with pushFrame() and restored with popFrame(). Each word is saved at most once per frame.
+ *  Modifications made while no frame is pushed are permanent.
+ */
+class ReversibleSparseBitset
+{
+public:
+	using WordType = uint64_t;
+	static constexpr int NUM_BITS_PER_WORD = sizeof(WordType) * 8;
+
+	ReversibleSparseBitset()
+	{
+	}
+
+	// Initialize to NumBits bits, all set.
+	void init(int numBits)
+	{
+		const int numWords = (numBits + NUM_BITS_PER_WORD - 1) / NUM_BITS_PER_WORD;
+		m_words.clear();
+		m_words.resize(numWords, ~WordType(0));
+		if (numBits % NUM_BITS_PER_WORD != 0)
+		{
+			m_words.back() = (WordType(1) << (numBits % NUM_BITS_PER_WORD)) - 1;
+		}
+
+		m_index.resize(numWords);
+		for (int i = 0; i < numWords; ++i)
+		{
+			m_index[i] = i;
+		}
+		m_limit = numWords;
+
+		m_mask.clear();
+		m_mask.resize(numWords, 0);
+		m_savedInFrame.clear();
+		m_savedInFrame.resize(numWords, -1);
+		m_trail.clear();
+		m_frames.clear();
+	}
+
+	inline bool isEmpty() const { return m_limit == 0; }
+	inline int getNumWords() const { return m_words.size(); }
+	inline int getNumFrames() const { return m_frames.size(); }
+
+	// Reset the working mask to zero.
+	inline void clearMask()
+	{
+		for (int i = 0; i < m_limit; ++i)
+		{
+			m_mask[m_index[i]] = 0;
+		}
+	}
+
+	// Invert the working mask.
+	inline void reverseMask()
+	{
+		for (int i = 0; i < m_limit; ++i)
+		{
+			const int offset = m_index[i];
+			m_mask[offset] = ~m_mask[offset];
+		}
+	}
+
+	// Union the working mask with Words, which must have getNumWords() entries.
+	inline void addToMask(const WordType* words)
+	{
+		for (int i = 0; i < m_limit; ++i)
+		{
+			const int offset = m_index[i];
+			m_mask[offset] |= words[offset];
+		}
+	}
+
+	// Clear any bits that aren't in the working mask. Returns true if any bits were cleared.
+	bool intersectWithMask()
+	{
+		bool changed = false;
+		for (int i = m_limit - 1; i >= 0; --i)
+		{
+			const int offset = m_index[i];
+			const WordType word = m_words[offset] & m_mask[offset];
+			if (word != m_words[offset])
+			{
+				save(offset);
+				m_words[offset] = word;
+				changed = true;
+				if (word == 0)
+				{
+					m_index[i] = m_index[m_limit - 1];
+					m_index[m_limit - 1] = offset;
+					--m_limit;
+				}
+			}
+		}
+		return changed;
+	}
+
+	// Returns the index of a word where Words and this bitset intersect, or -1 if they don't.
+	inline int intersectIndex(const WordType* words) const
+	{
+		for (int i = 0; i < m_limit; ++i)
+		{
+			const int offset = m_index[i];
+			if ((m_words[offset] & words[offset]) != 0)
+			{
+				return offset;
+			}
+		}
+		return -1;
+	}
+
+	// Whether the given word of this bitset intersects with the same word in Words.
+	inline bool intersectsAt(const WordType* words, int wordIndex) const
+	{
+		return (m_words[wordIndex] & words[wordIndex]) != 0;
+	}
+
+	// Returns the index of each bit that is set.
+	template<typename Visitor>
+	void forEachSetBit(Visitor&& visitor) const
+	{
+		for (int i = 0; i < m_limit; ++i)
+		{
+			const int offset = m_index[i];
+			for (WordType word = m_words[offset]; word != 0; word &= word - 1)
+			{
+				visitor(offset * NUM_BITS_PER_WORD + int(BitUtils::countTrailingZeros(word)));
+			}
+		}
+	}
+
+	// Start recording changes, so they can be undone by popFrame().
+	void pushFrame()
+	{
+		m_frames.push_back({int(m_trail.size()), m_limit});
+	}
+
+	// Undo all changes since the matching pushFrame().
+	void popFrame()
+	{
+		vxy_assert(!m_frames.empty());
+		const Frame& frame = m_frames.back();
+		for (int i = m_trail.size() - 1; i >= frame.trailSize; --i)
+		{
+			m_words[m_trail[i].offset] = m_trail[i].word;
+			// The word may still need to be saved again in the enclosing frame.
+			m_savedInFrame[m_trail[i].offset] = -1;
+		}
+		m_trail.resize(frame.trailSize);
+		m_limit = frame.limit;
+		m_frames.pop_back();
+	}
+
+protected:
+	inline void save(int offset)
+	{
+		const int frame = m_frames.size() - 1;
+		if (frame >= 0 && m_savedInFrame[offset] != frame)
+		{
+			m_savedInFrame[offset] = frame;
+			m_trail.push_back({offset, m_words[offset]});
+		}
+	}
+
+	struct TrailEntry
+	{
+		int offset;
+		WordType word;
+	};
+
+	struct Frame
+	{
+		int trailSize;
+		int limit;
+	};
+
+	vector<WordType> m_words;
+	// Permutation of word indices. The first Limit entries are the words that have any bits set.
+	vector<int> m_index;
+	int m_limit = 0;
+	// Working mask
+	vector<WordType> m_mask;
+
+	// For each word, the frame it was last saved in.
+	vector<int> m_savedInFrame;
+	vector<TrailEntry> m_trail;
+	vector<Frame> m_frames;
+};
+
+} // namespace Vertexy
@@ -0,0 +1,240 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ConstraintTypes.h"
+#include <EASTL/shared_ptr.h>
+
+namespace Vertexy
+{
+
+/** Samples a value from a variable's remaining potential values, in proportion to a per-variable set of weights.
+ *  Each weighted variable keeps a Fenwick (binary indexed) tree over its domain, containing only the weights of
+ *  values that were potential when the variable was last sampled. On each sample the tree is brought up to date by
+ *  diffing the potential values against that set one word at a time, so only values that changed since the last
+ *  sample are touched. Sampling is then a single O(log d) descent of the tree.
+ *
+ *  An alias table would give O(1) sampling, but it can't be updated as values are removed and restored during search.
+ */
+class WeightedValueSampler
+{
+	using WordType = uint64_t;
+	static constexpr int NUM_BITS_PER_WORD = sizeof(WordType) * 8;
+
+	struct Entry
+	{
+		shared_ptr<const vector<float>> weights;
+		// 1-based Fenwick tree of weights of values in Included
+		vector<double> tree;
+		// Values whose weights are currently in Tree
+		ValueSet included;
+	};
+
+public:
+	WeightedValueSampler()
+	{
+	}
+
+	// Set the weight of each value of the variable. Weights are indexed by internal value index, and may be shared
+	// between variables. Negative weights are treated as zero.
+	void setWeights(VarID varID, const shared_ptr<const vector<float>>& weights)
+	{
+		vxy_assert(varID.isValid());
+		vxy_assert(weights != nullptr);
+		if (varID.raw() >= m_entries.size())
+		{
+			m_entries.resize(varID.raw() + 1);
+		}
+
+		Entry& entry = m_entries[varID.raw()];
+		entry.weights = weights;
+		entry.tree.clear();
+		entry.tree.resize(weights->size() + 1, 0.0);
+		entry.included.init(weights->size(), false);
+	}
+
+	inline bool hasWeights(VarID varID) const
+	{
+		return varID.raw() < m_entries.size() && m_entries[varID.raw()].weights != nullptr;
+	}
+
+	inline const shared_ptr<const vector<float>>& getWeights(VarID varID) const
+	{
+		vxy_assert(hasWeights(varID));
+		return m_entries[varID.raw()].weights;
+	}
+
+	// Sample a value from Potentials. RandomUnit should be uniformly distributed in [0, 1).
+	// Values with zero weight are never chosen, unless none of the potential values have positive weight. In that
+	// case (or if the variable has no weights), a potential value is chosen uniformly.
+	int sample(VarID varID, const ValueSet& potentials, float randomUnit)
+	{
+		vxy_assert(!potentials.isZero());
+		if (hasWeights(varID))
+		{
+			Entry& entry = m_entries[varID.raw()];
+			sync(entry, potentials);
+
+			const double total = getTotal(entry);
+			if (total > 0.0)
+			{
+				const int value = findValue(entry, randomUnit * total);
+				if (value < potentials.size() && potentials[value] && getWeight(entry, value) > 0.0)
+				{
+					return value;
+				}
+
+				// Rounding errors accumulated in the tree can make the descent miss. Sample from the weights directly.
+				if (int scanned; sampleLinear(entry, potentials, randomUnit, scanned))
+				{
+					return scanned;
+				}
+			}
+		}
+
+		const int numVals = potentials.getNumSetBits();
+		const int index = min(int(randomUnit * numVals), numVals - 1);
+		return selectNthSetBit(potentials, index);
+	}
+
+	// Returns the index of the Nth set bit, in O(d/64).
+	static int selectNthSetBit(const ValueSet& values, int n)
+	{
+		const WordType* words = values.data();
+		const int numWords = (values.size() + NUM_BITS_PER_WORD - 1) / NUM_BITS_PER_WORD;
+		for (int i = 0; i < numWords; ++i)
+		{
+			WordType word = words[i];
+			const int count = int(BitUtils::countBits(word));
+			if (n >= count)
+			{
+				n -= count;
+				continue;
+			}
+
+			for (; n > 0; --n)
+			{
+				word &= word - 1;
+			}
+			return i * NUM_BITS_PER_WORD + int(BitUtils::countTrailingZeros(word));
+		}
+
+		vxy_fail();
+		return -1;
+	}
+
+protected:
+	static double getWeight(const Entry& entry, int value)
+	{
+		return value < entry.weights->size() ? max(0.0, double((*entry.weights)[value])) : 0.0;
+	}
+
+	// Sample in O(d) by summing the weights of the potential values. Returns false if none have positive weight.
+	static bool sampleLinear(const Entry& entry, const ValueSet& potentials, float randomUnit, int& outValue)
+	{
+		double total = 0.0;
+		for (auto it = potentials.beginSetBits(), itEnd = potentials.endSetBits(); it != itEnd; ++it)
+		{
+			total += getWeight(entry, *it);
+		}
+		if (total <= 0.0)
+		{
+			return false;
+		}
+
+		double target = randomUnit * total;
+		outValue = -1;
+		for (auto it = potentials.beginSetBits(), itEnd = potentials.endSetBits(); it != itEnd; ++it)
+		{
+			const double weight = getWeight(entry, *it);
+			if (weight > 0.0)
+			{
+				// Keep the last positive value, in case rounding leaves Target just above the final weight.
+				outValue = *it;
+				if (target < weight)
+				{
+					break;
+				}
+				target -= weight;
+			}
+		}
+		return true;
+	}
+
+	// Bring the tree up to date with the variable's current potential values.
+	static void sync(Entry& entry, const ValueSet& potentials)
+	{
+		const int numBits = min(potentials.size(), entry.included.size());
+		const int numWords = (numBits + NUM_BITS_PER_WORD - 1) / NUM_BITS_PER_WORD;
+
+		const WordType* potentialWords = potentials.data();
+		WordType* includedWords = entry.included.data();
+		for (int i = 0; i < numWords; ++i)
+		{
+			WordType diff = potentialWords[i] ^ includedWords[i];
+			while (diff != 0)
+			{
+				const int value = i * NUM_BITS_PER_WORD + int(BitUtils::countTrailingZeros(diff));
+				diff &= diff - 1;
+				if (value >= numBits)
+				{
+					break;
+				}
+
+				const double weight = getWeight(entry, value);
+				const bool adding = potentials[value];
+				entry.included[value] = adding;
+				if (weight > 0.0)
+				{
+					addWeight(entry, value, adding ? weight : -weight);
+				}
+			}
+		}
+	}
+
+	static void addWeight(Entry& entry, int value, double delta)
+	{
+		const int size = entry.tree.size();
+		for (int i = value + 1; i < size; i += i & -i)
+		{
+			entry.tree[i] += delta;
+		}
+	}
+
+	static double getTotal(const Entry& entry)
+	{
+		double total = 0.0;
+		for (int i = entry.tree.size() - 1; i > 0; i -= i & -i)
+		{
+			total += entry.tree[i];
+		}
+		return total;
+	}
+
+	// Find the lowest value whose inclusive prefix sum exceeds Target.
+	static int findValue(const Entry& entry, double target)
+	{
+		const int size = entry.tree.size() - 1;
+		int step = 1;
+		while ((step << 1) <= size)
+		{
+			step <<= 1;
+		}
+
+		int pos = 0;
+		for (; step > 0; step >>= 1)
+		{
+			if (pos + step <= size && entry.tree[pos + step] <= target)
+			{
+				pos += step;
+				target -= entry.tree[pos];
+			}
+		}
+		// Pos is the number of values whose cumulative weight is <= target, so it's the 0-based index of the result.
+		return pos;
+	}
+
+	vector<Entry> m_entries;
+};
+
+} // namespace Vertexy
@@ -4,7 +4,11 @@
 #include "ConstraintTypes.h"
 #include "constraints/IConstraint.h"
 #include "constraints/ClauseConstraint.h"
+#include "constraints/ConstraintGraphRelationInfo.h"
+#include "ds/FastLookupSet.h"
 #include "topology/IGraphRelation.h"
+#include "topology/TopologyLink.h"
+#include <EASTL/hash_map.h>
 #include <EASTL/variant.h>
 
 namespace Vertexy
@@ -58,10 +62,70 @@ protected:
 		VarID var;
 		SolverTimestamp time;
 		SolverDecisionLevel level;
-		shared_ptr<TManyToOneGraphRelation<VarID>> multiRelation;
 		ARelation relation;
 	};
 
+	// Operations on graph relations whose results are interned, so that repeated conflicts involving the same
+	// relations share a single immutable instance rather than allocating a new relation each time.
+	enum class EInternedRelationOp : uint8_t
+	{
+		Offset,
+		Invert,
+		Union,
+		Intersection,
+		ManyToOne
+	};
+
+	struct InternedRelationKey
+	{
+		EInternedRelationOp op;
+		const void* first;
+		const void* second;
+		TopologyLink link;
+
+		bool operator==(const InternedRelationKey& rhs) const
+		{
+			return op == rhs.op && first == rhs.first && second == rhs.second && link == rhs.link;
+		}
+
+		size_t hash() const
+		{
+			size_t out = combineHashes(eastl::hash<const void*>()(first), eastl::hash<const void*>()(second));
+			out = combineHashes(out, eastl::hash<int>()(int(op)));
+			return combineHashes(out, link.hash());
+		}
+	};
+
+	template <typename T>
+	struct TInternedRelation
+	{
+		// The inputs are held so their addresses cannot be reused by a different relation while the entry is alive.
+		shared_ptr<const void> first;
+		shared_ptr<const void> second;
+		IGraphRelationPtr<T> result;
+	};
+
+	template <typename T>
+	using TRelationInternTable = hash_map<InternedRelationKey, TInternedRelation<T>, call_hash>;
+
+	// Reusable storage for explanations requested during analysis. Buffers are handed out in stack order, so
+	// that nested requests (e.g. while checking redundancy) each get their own buffer.
+	class ScopedExplanationBuffer
+	{
+	public:
+		explicit ScopedExplanationBuffer(const ConflictAnalyzer& analyzer);
+		~ScopedExplanationBuffer();
+
+		ScopedExplanationBuffer(const ScopedExplanationBuffer&) = delete;
+		ScopedExplanationBuffer& operator=(const ScopedExplanationBuffer&) = delete;
+
+		vector<Literal>& get() { return m_buffer; }
+
+	protected:
+		const ConflictAnalyzer& m_analyzer;
+		vector<Literal>& m_buffer;
+	};
+
 	SolverDecisionLevel searchImplicationGraph(vector<Literal>& explanation, const IConstraint* initialConflict, int conflictTime);
 
 	void markActivity(const vector<Literal>& resolvedExplanation, SolverTimestamp uipTime);
@@ -90,14 +154,63 @@ protected:
 	template <typename T>
 	shared_ptr<const IGraphRelation<T>> createOffsetGraphRelation(int graphNode, const shared_ptr<const IGraphRelation<T>>& inRel);
 
+	// Return the interned result of applying Op to the given inputs, calling Builder to create it if it doesn't exist yet.
+	template <typename T, typename Builder>
+	IGraphRelationPtr<T> internRelation(EInternedRelationOp op, const shared_ptr<const void>& first, const shared_ptr<const void>& second, const TopologyLink& link, Builder&& builder);
+	template <typename T>
+	TRelationInternTable<T>& getInternTable();
+
+	vector<Literal>& acquireExplanationBuffer() const;
+	void releaseExplanationBuffer() const;
+
 	SolverTimestamp findLatestFalseTime(VarID var, const ValueSet& assertingValue, SolverTimestamp latestTime) const;
 
 	int getNodeIndexForVar(VarID var) const;
 	void refreshTopLevel();
 	void refreshTopLevelNodeCount();
 
-	inline static uint32_t getLevelBit(SolverDecisionLevel level) { return 1 << (level & 31); }
-	bool checkRedundant(const vector<Literal>& explanation, int litIndex, uint32_t levelMask) const;
+	// Result of checking whether a fact ("variable has none of these values") is implied by the clause being learned.
+	enum class EFactRedundancy : uint8_t
+	{
+		Redundant,
+		Required,
+		// The fact's modification needs to be explained before we can tell.
+		Expand
+	};
+
+	// Memoized result for whether the modification at a timestamp is implied by the clause being learned.
+	struct RedundancyMemoEntry
+	{
+		bool redundant = false;
+		// The values the modification's explanation allowed for the modified variable.
+		ValueSet pivotValues;
+		GraphVariableRelationPtr pivotRelation;
+	};
+
+	// A modification being explained during minimization, with its reasons in m_minimizationReasons[reasonsBegin, reasonsEnd).
+	struct MinimizationFrame
+	{
+		SolverTimestamp time = -1;
+		int reasonsBegin = 0;
+		int reasonsEnd = 0;
+		int cursor = 0;
+		ValueSet pivotValues;
+		GraphVariableRelationPtr pivotRelation;
+		// The reason at the cursor that is currently being resolved: the values still to be proven false, and
+		// the time at which they became false.
+		ValueSet pendingValues;
+		SolverTimestamp pendingTime = -1;
+	};
+
+	// Conflict clause minimization: remove literals whose falsity is implied by the rest of the clause.
+	void minimizeExplanation(vector<Literal>& explanation);
+	bool isRedundantLiteral(const vector<Literal>& explanation, int litIndex);
+	EFactRedundancy classifyFact(const vector<Literal>& explanation, VarID var, ValueSet& values, SolverTimestamp& time, SolverTimestamp usedBefore, const GraphVariableRelationPtr& relation);
+	bool pushMinimizationFrame(SolverTimestamp time, const GraphVariableRelationPtr& expectedRelation);
+	RedundancyMemoEntry* findRedundancyMemo(SolverTimestamp time);
+	RedundancyMemoEntry& addRedundancyMemo(SolverTimestamp time);
+	void binaryMinimize(vector<Literal>& explanation);
+	void updateBinaryClauseIndex();
 
 	ConstraintSolver& m_solver;
 
@@ -108,12 +221,42 @@ protected:
 	int m_anchorGraphVertex = -1;
 
 	vector<ImplicationNode> m_nodes;
-	unique_ptr<ConstraintGraphRelationInfo> m_resolvedRelationInfo;
+	ConstraintGraphRelationInfo m_conflictRelationInfo;
+	ConstraintGraphRelationInfo m_antecedentRelationInfo;
+	ConstraintGraphRelationInfo m_resolvedRelationInfo;
+	bool m_hasResolvedRelationInfo = false;
 	vector<int> m_variableClauseIndices;
 
-	mutable vector<ImplicationNode> m_redundancyStack;
-	mutable vector<ValueSet> m_redundancyValues;
-	mutable ValueSet m_redundancySeen;
+	// Whether the current minimization must keep the clause valid for every vertex of m_graph.
+	bool m_minimizeForGraph = false;
+	// Stamp for the current minimization. Levels and memo entries marked with this stamp are current.
+	uint32_t m_minimizationStamp = 0;
+	// Exact level abstraction: the decision levels present in the clause being minimized.
+	vector<uint32_t> m_clauseLevelStamps;
+	// Per-timestamp index into m_redundancyMemo, valid when the matching stamp is current.
+	vector<int> m_redundancyMemoIndices;
+	vector<uint32_t> m_redundancyMemoStamps;
+	vector<RedundancyMemoEntry> m_redundancyMemo;
+	int m_numRedundancyMemo = 0;
+	vector<MinimizationFrame> m_minimizationFrames;
+	int m_numMinimizationFrames = 0;
+	vector<Literal> m_minimizationReasons;
+	vector<GraphVariableRelationPtr> m_minimizationReasonRelations;
+	ValueSet m_minimizationRootValues;
+	vector<bool> m_literalIsRedundant;
+	// Permanent learned binary clauses, indexed by variable, for binary implication minimization.
+	vector<vector<ClauseConstraint*>> m_binaryClauses;
+	int m_numIndexedPermanentClauses = 0;
+
+	// Explanation buffers, and how many are currently handed out. See ScopedExplanationBuffer.
+	mutable vector<unique_ptr<vector<Literal>>> m_explanationPool;
+	mutable int m_explanationPoolUsed = 0;
+	// Variables seen while marking activity, indexed by raw VarID.
+	TFastLookupSet<uint32_t> m_activitySeen;
+
+	TRelationInternTable<Literal> m_internedLiteralRelations;
+	TRelationInternTable<VarID> m_internedVariableRelations;
+	TRelationInternTable<bool> m_internedFilterRelations;
 };
 
 } // namespace Vertexy
\ No newline at end of file
@@ -11,6 +11,7 @@ namespace Vertexy
 	using namespace eastl;
 	class Tile;
 	class Prefab;
+	class EntropyHeuristic;
 
 	class TileSolver
 	{
@@ -26,6 +27,10 @@ namespace Vertexy
 		const auto kernelSize() const { return m_kernelSize; };
 		const auto& prefabs() const { return m_prefabs; };
 
+		// Creates a heuristic that solves tiles in lowest-entropy order, weighting each prefab by its frequency
+		// in the input. Should be added to the solver via addDecisionHeuristic before solving.
+		shared_ptr<EntropyHeuristic> createEntropyHeuristic() const;
+
 	private:
 		// Size of the kernel to be used to extract the patterns from the input.
 		int m_kernelSize;
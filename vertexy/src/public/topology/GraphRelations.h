@@ -190,6 +190,56 @@ protected:
 	shared_ptr<const IGraphRelation<T>> m_inner;
 };
 
+// Wraps another relation, returning a fallback value for vertices where the inner relation doesn't resolve.
+template<typename T>
+class TFallbackGraphRelation : public IGraphRelation<T>
+{
+public:
+	TFallbackGraphRelation(const shared_ptr<const IGraphRelation<T>>& inner, const T& fallback)
+		: m_inner(inner)
+		, m_fallback(fallback)
+	{
+	}
+
+	virtual bool getRelation(int vertex, T& out) const override
+	{
+		if (!m_inner->getRelation(vertex, out))
+		{
+			out = m_fallback;
+		}
+		return true;
+	}
+
+	virtual bool equals(const IGraphRelation<T>& rhs) const override
+	{
+		if (this == &rhs)
+		{
+			return true;
+		}
+		if (auto typedRHS = dynamic_cast<const TFallbackGraphRelation<T>*>(&rhs))
+		{
+			return typedRHS->m_fallback == m_fallback && typedRHS->m_inner->equals(*m_inner.get());
+		}
+		return false;
+	}
+
+	virtual size_t hash() const override
+	{
+		return combineHashes(m_inner->hash(), eastl::hash<T>()(m_fallback));
+	}
+
+	virtual wstring toString() const override
+	{
+		wstring out;
+		out.sprintf(TEXT("Fallback(%s)"), m_inner->toString().c_str());
+		return out;
+	}
+
+protected:
+	shared_ptr<const IGraphRelation<T>> m_inner;
+	T m_fallback;
+};
+
 // Given a vertex in a graph, return the corresponding value in a TTopologyVertexData object.
 template <typename T>
 class TVertexToDataGraphRelation : public IGraphRelation<T>
@@ -23,6 +23,8 @@ public:
 		VarID variable;
 		ValueSet previousValue;
 		Timestamp previousVariableAssignment;
+		// The decision level this modification was made on
+		SolverDecisionLevel level;
 		IConstraint* constraint;
 		ExplainerFunction explanation;
 	};
@@ -35,7 +37,7 @@ public:
 	void reset();
 
 	/*** Record a change (narrowing of scope) to a variable. */
-	SolverTimestamp recordChange(VarID variable, const ValueSet& prevValues, SolverTimestamp previousModificationTS, IConstraint* constraint, ExplainerFunction explanation);
+	SolverTimestamp recordChange(VarID variable, const ValueSet& prevValues, SolverTimestamp previousModificationTS, SolverDecisionLevel level, IConstraint* constraint, ExplainerFunction explanation);
 
 	inline const vector<Modification>& getStack() const { return m_stack; }
 
@@ -45,6 +47,12 @@ public:
 		return m_stack[stamp];
 	}
 
+	/** Get the decision level the modification at the given timestamp was made on. */
+	inline SolverDecisionLevel getDecisionLevelAtTime(SolverTimestamp stamp) const
+	{
+		return m_stack[stamp].level;
+	}
+
 	/** Get the most recent timestamp. NOTE will not be valid before PrepareForSolving is called! */
 	SolverTimestamp getMostRecentTimestamp() const { return m_stack.size() - 1; }
 
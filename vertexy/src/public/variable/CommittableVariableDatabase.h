@@ -47,6 +47,9 @@ public:
 		#endif
 	}
 
+	// Reuse this database for a new set of speculative changes, discarding any previous (uncommitted) modifications.
+	void rebind(IVariableDatabase* inParent, IConstraint* outerCons, ICommittableVariableDatabaseOwner* outerSink, int outerSinkID=-1);
+
 	bool commitPastAndFutureChanges();
 	bool hasContradiction() const { return m_hasContradiction; }
 	IVariableDatabase* getParent() const { return m_parent; }
@@ -72,6 +75,7 @@ public:
 	virtual SolverTimestamp getModificationTimePriorTo(VarID variable, SolverTimestamp timestamp) const override;
 	virtual const ConstraintSolver* getSolver() const override { return m_parent->getSolver(); }
 	virtual void markConstraintFullySatisfied(IConstraint* constraint) override;
+	virtual void markConstraintNeedsBacktrack(IConstraint* constraint) override { m_parent->markConstraintNeedsBacktrack(constraint); }
 
 protected:
 	IVariableDatabase* m_parent;
@@ -96,4 +100,57 @@ protected:
 	bool m_committed = false;
 };
 
+// Scratch storage for CommittableVariableDatabases. Rather than constructing a new database (and modification list)
+// for every speculative propagation, databases are reused from the arena. They are handed out in stack order, so
+// constraints nested inside each other each get their own database.
+class CommittableVariableDatabaseArena
+{
+public:
+	// Returns the database to the arena when destroyed.
+	class Scope
+	{
+	public:
+		Scope(CommittableVariableDatabaseArena& arena, CommittableVariableDatabase* db)
+			: m_arena(arena)
+			, m_db(db)
+		{
+		}
+
+		Scope(Scope&& other)
+			: m_arena(other.m_arena)
+			, m_db(other.m_db)
+		{
+			other.m_db = nullptr;
+		}
+
+		~Scope()
+		{
+			if (m_db != nullptr)
+			{
+				m_arena.release(m_db);
+			}
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+		Scope& operator=(Scope&&) = delete;
+
+		inline CommittableVariableDatabase* get() const { return m_db; }
+		inline CommittableVariableDatabase* operator->() const { return m_db; }
+		inline CommittableVariableDatabase& operator*() const { return *m_db; }
+
+	private:
+		CommittableVariableDatabaseArena& m_arena;
+		CommittableVariableDatabase* m_db;
+	};
+
+	Scope acquire(IVariableDatabase* parent, IConstraint* outerCons, ICommittableVariableDatabaseOwner* outerSink, int outerSinkID=-1);
+
+protected:
+	void release(CommittableVariableDatabase* db);
+
+	vector<unique_ptr<CommittableVariableDatabase>> m_databases;
+	int m_numInUse = 0;
+};
+
 } // namespace Vertexy
\ No newline at end of file
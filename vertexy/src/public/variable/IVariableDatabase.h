@@ -74,6 +74,14 @@ public:
 	{
 	}
 
+	/** Called by backtracking constraints that are not notified on every backtrack (see
+	 *  IBacktrackingSolverConstraint::wantsEveryBacktrack) whenever they record state at the current decision level.
+	 *  The constraint's backtrack() will be called once the solver backtracks beyond this level.
+	 */
+	virtual void markConstraintNeedsBacktrack(IConstraint* constraint)
+	{
+	}
+
 	/** Add a watcher for a variable */
 	virtual WatcherHandle addVariableWatch(VarID varID, EVariableWatchType watchType, IVariableWatchSink* sink) = 0;
 
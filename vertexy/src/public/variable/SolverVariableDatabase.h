@@ -30,6 +30,7 @@ public:
 	virtual SolverTimestamp getTimestamp() const override { return m_assignmentStack.getMostRecentTimestamp(); }
 	virtual void onContradiction(VarID varID, IConstraint* constraint, const ExplainerFunction& explainer) override;
 	virtual void queueConstraintPropagation(IConstraint* constraint) override;
+	virtual void markConstraintNeedsBacktrack(IConstraint* constraint) override;
 	virtual WatcherHandle addVariableWatch(VarID var, EVariableWatchType watchType, IVariableWatchSink* sink) override;
 	virtual WatcherHandle addVariableValueWatch(VarID var, const ValueSet& values, IVariableWatchSink* sink) override;
 	virtual void disableWatcherUntilBacktrack(WatcherHandle handle, VarID variable, IVariableWatchSink* sink) override;
@@ -47,6 +48,13 @@ public:
 		return m_variableInfo[variable.raw()].latestModification;
 	}
 
+	// The decision level of the last modification to this variable, or 0 if unmodified.
+	SolverDecisionLevel getLastModificationLevel(VarID variable) const
+	{
+		vxy_assert(variable.isValid());
+		return m_variableInfo[variable.raw()].latestModificationLevel;
+	}
+
 	virtual const ValueSet& getInitialValues(VarID variable) const override
 	{
 		vxy_assert(variable.isValid());
@@ -64,6 +72,12 @@ public:
 	 *  Returns false if this variable has not yet ever been solved.
 	 */
 	bool getLastSolvedValue(VarID varID, int& outValue) const;
+	/** Overwrite the last solved value for the variable. Negative values clear it. */
+	void setLastSolvedValue(VarID varID, int value)
+	{
+		vxy_assert(value < getDomainSize(varID));
+		m_lastSolvedValues[varID.raw()] = value < 0 ? 0 : value + 1;
+	}
 	/** Clears all history of last solved values for all variables */
 	void clearLastSolvedValues();
 
@@ -87,6 +101,8 @@ protected:
 		ValueSet potentialValues;
 		// Last time this variable is modified: index into the assignment stack
 		SolverTimestamp latestModification;
+		// Decision level of LatestModification, or 0 if unmodified
+		SolverDecisionLevel latestModificationLevel;
 	};
 
 	// Stores current (dis)assignments of each variable, and timestamp of last time variable was modified.
@@ -4,11 +4,13 @@
 #include "SolverTest.h"
 
 #include <BasicTests.h>
+#include <ConstraintTests.h>
 #include <NQueens.h>
 #include <EATest/EATest.h>
 #include <Sudoku.h>
 #include <TowersOfHanoi.h>
 #include <PrefabTest.h>
+#include <SearchTests.h>
 #include <TileTests.h>
 
 #include "KnightTourSolver.h"
@@ -34,6 +36,8 @@ int main(int argc, char* argv[])
 	TestApplication Suite("Solver Tests", argc, argv);
 
 	Suite.AddTest("ValueBitset", TestSolvers::bitsetTests);
+	Suite.AddTest("ReversibleSparseBitset", TestSolvers::sparseBitsetTests);
+	Suite.AddTest("WeightedValueSampler", TestSolvers::weightedSamplerTests);
 	Suite.AddTest("Digraph", TestSolvers::digraphTests);
 	Suite.AddTest("RuleSCCs", TestSolvers::ruleSCCTests);
 	Suite.AddTest("Clause-Basic", []() { return TestSolvers::solveClauseBasic(NUM_TIMES, FORCE_SEED, PRINT_VERBOSE); });
@@ -48,11 +52,27 @@ int main(int argc, char* argv[])
 	Suite.AddTest("Rules-BasicGraph", []() { return TestSolvers::solveProgram_graphTests(FORCE_SEED, PRINT_VERBOSE); });
 	Suite.AddTest("Rules-Hamiltonian", []() { return TestSolvers::solveProgram_hamiltonian(FORCE_SEED, PRINT_VERBOSE); });
 	Suite.AddTest("Rules-HamiltonianGraph", []() { return TestSolvers::solveProgram_hamiltonianGraph(FORCE_SEED, PRINT_VERBOSE); });
+	Suite.AddTest("FastLookupSet", TestSolvers::fastLookupSetTests);
+	Suite.AddTest("BacktrackRecords", []() { return TestSolvers::backtrackRecordTests(FORCE_SEED, PRINT_VERBOSE); });
+	Suite.AddTest("ConflictAnalysis", []() { return TestSolvers::conflictAnalysisTests(FORCE_SEED, PRINT_VERBOSE); });
 	Suite.AddTest("Sum-Basic", []() { return TestSolvers::solveSumBasic(NUM_TIMES, FORCE_SEED, PRINT_VERBOSE); });
+	Suite.AddTest("Linear-Basic", []() { return ConstraintTests::linearTests(FORCE_SEED); });
+	Suite.AddTest("Linear-Graph", []() { return ConstraintTests::solveLinearGraph(NUM_TIMES, FORCE_SEED, PRINT_VERBOSE); });
+	Suite.AddTest("Table-Basic", []() { return ConstraintTests::tableTests(FORCE_SEED); });
+	Suite.AddTest("MDD-Basic", []() { return ConstraintTests::mddTests(FORCE_SEED); });
+	Suite.AddTest("AllDifferent-Domain", []() { return ConstraintTests::allDifferentTests(FORCE_SEED); });
+	Suite.AddTest("Regular-Basic", []() { return ConstraintTests::regularTests(FORCE_SEED); });
+	Suite.AddTest("Element-Basic", []() { return ConstraintTests::elementTests(FORCE_SEED); });
+	Suite.AddTest("Difference-Basic", []() { return ConstraintTests::differenceTests(FORCE_SEED); });
+	Suite.AddTest("WindowCardinality-Basic", []() { return ConstraintTests::windowCardinalityTests(FORCE_SEED); });
+	Suite.AddTest("Connected-Basic", []() { return ConstraintTests::connectedTests(FORCE_SEED); });
+	Suite.AddTest("Disjunction-Basic", []() { return ConstraintTests::disjunctionTests(FORCE_SEED); });
 	Suite.AddTest("Sudoku", []() { return SudokuSolver::solve(NUM_TIMES, SUDOKU_STARTING_HINTS, FORCE_SEED, PRINT_VERBOSE); });
+	Suite.AddTest("Sudoku-Lookahead", []() { return SudokuSolver::solveWithLookahead(NUM_TIMES, SUDOKU_STARTING_HINTS, FORCE_SEED, PRINT_VERBOSE); });
 	Suite.AddTest("TowersOfHanoi", []() { return TowersOfHanoiSolver::solve(NUM_TIMES, FORCE_SEED, PRINT_VERBOSE); });
 	Suite.AddTest("KnightTour", []() { return KnightTourSolver::solve(NUM_TIMES, KNIGHT_BOARD_DIM, FORCE_SEED, PRINT_VERBOSE); });
 	Suite.AddTest("NQueens-AllDifferent", []() { return NQueensSolvers::solveUsingAllDifferent(NUM_TIMES, NQUEENS_SIZE, FORCE_SEED, PRINT_VERBOSE); });
+	Suite.AddTest("NQueens-AllDifferentDomain", []() { return NQueensSolvers::solveUsingAllDifferentDomain(NUM_TIMES, NQUEENS_SIZE, FORCE_SEED, PRINT_VERBOSE); });
 	Suite.AddTest("NQueens-Table", []() { return NQueensSolvers::solveUsingTable(NUM_TIMES, NQUEENS_SIZE, FORCE_SEED, PRINT_VERBOSE); });
 	Suite.AddTest("NQueens-Graph", []() { return NQueensSolvers::solveUsingGraph(NUM_TIMES, NQUEENS_SIZE, FORCE_SEED, PRINT_VERBOSE); });
 	Suite.AddTest("PrefabTest-Basic", []() { return PrefabTestSolver::solveBasic(NUM_TIMES, FORCE_SEED, PRINT_VERBOSE); });
@@ -63,5 +83,18 @@ int main(int argc, char* argv[])
 	Suite.AddTest("Maze", []() { return MazeSolver::solveUsingRawConstraints(NUM_TIMES, MAZE_NUM_ROWS, MAZE_NUM_COLS, FORCE_SEED, PRINT_VERBOSE); });
 	Suite.AddTest("TileTest-Basic", []() { return TileTests::solveBasic(NUM_TIMES, FORCE_SEED, PRINT_VERBOSE); });
 	Suite.AddTest("TileTest-Rot/Ref", []() { return TileTests::solveRotationReflection(NUM_TIMES, FORCE_SEED, PRINT_VERBOSE); });
+	Suite.AddTest("TileTest-Entropy", []() { return TileTests::solveEntropy(NUM_TIMES, FORCE_SEED, PRINT_VERBOSE); });
+	Suite.AddTest("Search-ClauseSignature", SearchTests::clauseSignatureTests);
+	Suite.AddTest("Search-ModeSwitching", []() { return SearchTests::modeSwitchingTests(FORCE_SEED); });
+	Suite.AddTest("Search-LRBParticipation", []() { return SearchTests::lrbParticipationTests(FORCE_SEED); });
+	Suite.AddTest("Search-HeuristicNotifications", []() { return SearchTests::heuristicNotificationTests(FORCE_SEED); });
+	Suite.AddTest("Search-TrailReuse", []() { return SearchTests::trailReuseTests(FORCE_SEED); });
+	Suite.AddTest("Search-Lookahead", []() { return SearchTests::lookaheadTests(FORCE_SEED); });
+	Suite.AddTest("Search-Rephase", []() { return SearchTests::rephaseTests(FORCE_SEED); });
+	Suite.AddTest("Search-ClauseMinimization", []() { return SearchTests::solveLearnedClauseMinimization(NUM_TIMES, FORCE_SEED, PRINT_VERBOSE); });
+	Suite.AddTest("Search-Phases", []() { return SearchTests::solveWithPhases(NUM_TIMES, FORCE_SEED, PRINT_VERBOSE); });
+	Suite.AddTest("Search-EntropyIncremental", []() { return SearchTests::solveEntropyIncremental(NUM_TIMES, FORCE_SEED, PRINT_VERBOSE); });
+	Suite.AddTest("Search-TopologyLocality", []() { return SearchTests::solveTopologyLocality(NUM_TIMES, FORCE_SEED, PRINT_VERBOSE); });
+	Suite.AddTest("Search-TrailReuseSolve", []() { return SearchTests::solveWithTrailReuse(NUM_TIMES, FORCE_SEED, PRINT_VERBOSE); });
 	return Suite.Run();
 }
\ No newline at end of file
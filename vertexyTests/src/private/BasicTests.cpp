@@ -3,9 +3,17 @@
 
 #include <EASTL/hash_map.h>
 #include <EASTL/set.h>
+#include <EASTL/sort.h>
 
 #include "ConstraintSolver.h"
+#include "NQueens.h"
+#include "constraints/ClauseConstraint.h"
+#include "constraints/ConstraintFactoryParams.h"
+#include "constraints/IBacktrackingSolverConstraint.h"
 #include "ds/ESTree.h"
+#include "ds/FastLookupSet.h"
+#include "ds/ReversibleSparseBitset.h"
+#include "ds/WeightedValueSampler.h"
 #include "EATest/EATest.h"
 #include "program/ProgramDSL.h"
 #include "rules/RuleDatabase.h"
@@ -19,6 +27,97 @@ using namespace VertexyTests;
 // Whether to write a decision log as DecisionLog.txt
 static constexpr bool WRITE_BREADCRUMB_LOG = false;
 
+namespace
+{
+
+// Constraint that never narrows anything, but records the decision level whenever one of its variables is narrowed,
+// and relies on the solver to only call backtrack() when one of those records needs to be undone.
+class BacktrackRecordingConstraint : public IBacktrackingSolverConstraint
+{
+public:
+	BacktrackRecordingConstraint(const ConstraintFactoryParams& params, const vector<VarID>& variables)
+		: IBacktrackingSolverConstraint(params)
+		, m_variables(variables)
+	{
+	}
+
+	struct BacktrackRecordingConstraintFactory
+	{
+		static BacktrackRecordingConstraint* construct(const ConstraintFactoryParams& params, const vector<VarID>& variables)
+		{
+			return new BacktrackRecordingConstraint(params, variables);
+		}
+	};
+
+	using Factory = BacktrackRecordingConstraintFactory;
+
+	virtual EConstraintType getConstraintType() const override { return EConstraintType::Cardinality; }
+	virtual vector<VarID> getConstrainingVariables() const override { return m_variables; }
+
+	virtual bool initialize(IVariableDatabase* db) override
+	{
+		for (VarID var : m_variables)
+		{
+			m_watchHandles.push_back(db->addVariableWatch(var, EVariableWatchType::WatchModification, this));
+		}
+		return true;
+	}
+
+	virtual void reset(IVariableDatabase* db) override
+	{
+		for (int i = 0; i < m_variables.size(); ++i)
+		{
+			db->removeVariableWatch(m_variables[i], m_watchHandles[i], this);
+		}
+		m_watchHandles.clear();
+	}
+
+	virtual bool onVariableNarrowed(IVariableDatabase* db, VarID variable, const ValueSet& previousValue, bool& removeWatch) override
+	{
+		const SolverDecisionLevel level = db->getDecisionLevel();
+		// Any record above the current level should have been removed when the solver backtracked.
+		if (!m_recordLevels.empty() && m_recordLevels.back() > level)
+		{
+			++numStaleRecords;
+		}
+
+		if (level > 0 && (m_recordLevels.empty() || m_recordLevels.back() < level))
+		{
+			m_recordLevels.push_back(level);
+			db->markConstraintNeedsBacktrack(this);
+		}
+		return true;
+	}
+
+	virtual bool checkConflicting(IVariableDatabase* db) const override { return false; }
+	virtual bool wantsEveryBacktrack() const override { return false; }
+
+	virtual void backtrack(const IVariableDatabase* db, SolverDecisionLevel level) override
+	{
+		++numBacktracks;
+		if (m_recordLevels.empty() || m_recordLevels.back() <= level)
+		{
+			++numUnneededBacktracks;
+		}
+
+		while (!m_recordLevels.empty() && m_recordLevels.back() > level)
+		{
+			m_recordLevels.pop_back();
+		}
+	}
+
+	int numBacktracks = 0;
+	int numUnneededBacktracks = 0;
+	int numStaleRecords = 0;
+
+protected:
+	vector<VarID> m_variables;
+	vector<WatcherHandle> m_watchHandles;
+	vector<SolverDecisionLevel> m_recordLevels;
+};
+
+} // anonymous namespace
+
 int TestSolvers::bitsetTests()
 {
 	int nErrorCount = 0;
@@ -185,6 +284,197 @@ int TestSolvers::bitsetTests()
 	return nErrorCount;
 }
 
+int TestSolvers::sparseBitsetTests()
+{
+	int nErrorCount = 0;
+	using WordType = ReversibleSparseBitset::WordType;
+
+	auto getSetBits = [](const ReversibleSparseBitset& bits)
+	{
+		vector<int> out;
+		bits.forEachSetBit([&](int bit) { out.push_back(bit); });
+		sort(out.begin(), out.end());
+		return out;
+	};
+
+	auto intersect = [](ReversibleSparseBitset& bits, const vector<WordType>& mask)
+	{
+		bits.clearMask();
+		bits.addToMask(mask.data());
+		return bits.intersectWithMask();
+	};
+
+	ReversibleSparseBitset bits;
+	bits.init(200);
+	EATEST_VERIFY(bits.getNumWords() == 4);
+	EATEST_VERIFY(getSetBits(bits).size() == 200);
+
+	const vector<WordType> all(4, ~WordType(0));
+	EATEST_VERIFY(!intersect(bits, all));
+
+	vector<WordType> bit69(4, 0);
+	bit69[1] = WordType(1) << 5;
+
+	// Changes made with no frame pushed are permanent.
+	vector<WordType> mask = all;
+	mask[0] = ~WordType(1);
+	EATEST_VERIFY(intersect(bits, mask));
+	const vector<int> initialBits = getSetBits(bits);
+	EATEST_VERIFY(initialBits.size() == 199 && initialBits[0] == 1);
+
+	// Clear all of word 1 and the upper half of word 2. Word 1 leaves the active words.
+	bits.pushFrame();
+	mask = all;
+	mask[1] = 0;
+	mask[2] = 0xFFFFFFFF;
+	EATEST_VERIFY(intersect(bits, mask));
+	const vector<int> frame1Bits = getSetBits(bits);
+	EATEST_VERIFY(frame1Bits.size() == 199 - 64 - 32);
+	EATEST_VERIFY(bits.intersectIndex(bit69.data()) < 0);
+
+	// Clear everything but bit 128, changing word 2 again in a new frame.
+	bits.pushFrame();
+	mask.clear();
+	mask.resize(4, 0);
+	mask[2] = 1;
+	EATEST_VERIFY(intersect(bits, mask));
+	EATEST_VERIFY(getSetBits(bits) == vector<int>{128});
+
+	bits.pushFrame();
+	EATEST_VERIFY(intersect(bits, vector<WordType>(4, 0)));
+	EATEST_VERIFY(bits.isEmpty());
+	EATEST_VERIFY(bits.getNumFrames() == 3);
+
+	bits.popFrame();
+	EATEST_VERIFY(!bits.isEmpty());
+	EATEST_VERIFY(getSetBits(bits) == vector<int>{128});
+
+	bits.popFrame();
+	EATEST_VERIFY(getSetBits(bits) == frame1Bits);
+	EATEST_VERIFY(bits.intersectIndex(bit69.data()) < 0);
+
+	// Word 2 was restored by the inner frame. Changing it again must still be undone by the outer frame.
+	mask = all;
+	mask[2] = 0xFF;
+	EATEST_VERIFY(intersect(bits, mask));
+	EATEST_VERIFY(getSetBits(bits).size() == 199 - 64 - 56);
+
+	bits.popFrame();
+	EATEST_VERIFY(bits.getNumFrames() == 0);
+	EATEST_VERIFY(getSetBits(bits) == initialBits);
+	EATEST_VERIFY(bits.intersectIndex(bit69.data()) == 1);
+	EATEST_VERIFY(bits.intersectsAt(bit69.data(), 1));
+
+	// Reversing the mask removes just the masked bits.
+	bits.pushFrame();
+	bits.clearMask();
+	bits.addToMask(bit69.data());
+	bits.reverseMask();
+	EATEST_VERIFY(bits.intersectWithMask());
+	EATEST_VERIFY(bits.intersectIndex(bit69.data()) < 0);
+	EATEST_VERIFY(getSetBits(bits).size() == 198);
+
+	bits.popFrame();
+	EATEST_VERIFY(getSetBits(bits) == initialBits);
+
+	return nErrorCount;
+}
+
+int TestSolvers::weightedSamplerTests()
+{
+	int nErrorCount = 0;
+
+	// Spans two words. Every fifth value has zero weight.
+	constexpr int NUM_VALUES = 100;
+	constexpr int NUM_SAMPLES = 20000;
+	auto weights = make_shared<vector<float>>();
+	for (int i = 0; i < NUM_VALUES; ++i)
+	{
+		weights->push_back(float(i % 5));
+	}
+
+	WeightedValueSampler sampler;
+	const VarID var(3);
+	EATEST_VERIFY(!sampler.hasWeights(var));
+	sampler.setWeights(var, weights);
+	EATEST_VERIFY(sampler.hasWeights(var));
+
+	// Sample with evenly spaced random numbers, so the number of times each value is picked should be close to
+	// its share of the total weight.
+	auto checkDistribution = [&](const ValueSet& potentials)
+	{
+		vector<int> counts(NUM_VALUES, 0);
+		for (int i = 0; i < NUM_SAMPLES; ++i)
+		{
+			const int value = sampler.sample(var, potentials, (float(i) + 0.5f) / NUM_SAMPLES);
+			if (value < 0 || value >= NUM_VALUES || !potentials[value])
+			{
+				return false;
+			}
+			++counts[value];
+		}
+
+		double total = 0.0;
+		for (auto it = potentials.beginSetBits(), itEnd = potentials.endSetBits(); it != itEnd; ++it)
+		{
+			total += (*weights)[*it];
+		}
+
+		for (int value = 0; value < NUM_VALUES; ++value)
+		{
+			const double expected = potentials[value] ? NUM_SAMPLES * (*weights)[value] / total : 0.0;
+			if ((expected == 0.0 && counts[value] != 0) || fabs(counts[value] - expected) > 2.0)
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	ValueSet potentials(NUM_VALUES, true);
+	EATEST_VERIFY(checkDistribution(potentials));
+
+	// Remove values in both words, as a constraint would during search.
+	ValueSet narrowed = potentials;
+	for (int i = 0; i < NUM_VALUES; i += 3)
+	{
+		narrowed[i] = false;
+	}
+	narrowed.setRange(60, 70, false);
+	EATEST_VERIFY(checkDistribution(narrowed));
+
+	ValueSet narrowedFurther = narrowed;
+	narrowedFurther.setRange(0, 50, false);
+	EATEST_VERIFY(checkDistribution(narrowedFurther));
+
+	// Backtracking restores the removed values, and their weights.
+	EATEST_VERIFY(checkDistribution(narrowed));
+	EATEST_VERIFY(checkDistribution(potentials));
+
+	// A single positive weight is always chosen over zero weights, even at the top of the range.
+	ValueSet mostlyZero(NUM_VALUES, false);
+	mostlyZero[0] = true;
+	mostlyZero[5] = true;
+	mostlyZero[7] = true;
+	mostlyZero[95] = true;
+	EATEST_VERIFY(sampler.sample(var, mostlyZero, 0.f) == 7);
+	EATEST_VERIFY(sampler.sample(var, mostlyZero, 0.5f) == 7);
+	EATEST_VERIFY(sampler.sample(var, mostlyZero, 0.99999f) == 7);
+
+	// With only zero weights left, potential values are chosen uniformly.
+	mostlyZero[7] = false;
+	EATEST_VERIFY(sampler.sample(var, mostlyZero, 0.f) == 0);
+	EATEST_VERIFY(sampler.sample(var, mostlyZero, 0.4f) == 5);
+	EATEST_VERIFY(sampler.sample(var, mostlyZero, 0.99999f) == 95);
+
+	// Variables without weights are also sampled uniformly.
+	EATEST_VERIFY(sampler.sample(VarID(1), narrowedFurther, 0.f) == narrowedFurther.indexOf(true));
+	EATEST_VERIFY(WeightedValueSampler::selectNthSetBit(narrowed, 0) == 1);
+	EATEST_VERIFY(WeightedValueSampler::selectNthSetBit(narrowedFurther, 1) == 52);
+
+	return nErrorCount;
+}
+
 int TestSolvers::digraphTests()
 {
 	int nErrorCount = 0;
@@ -1100,3 +1390,132 @@ int TestSolvers::solveProgram_hamiltonianGraph(int seed, bool printVerbose)
 	solver.dumpStats(printVerbose);
 	return nErrorCount;
 }
+
+int TestSolvers::fastLookupSetTests()
+{
+	int nErrorCount = 0;
+
+	// The solver uses this as a queue that can check membership, popping from the back.
+	TFastLookupSet<int> set;
+	EATEST_VERIFY(set.empty());
+
+	set.add(5);
+	set.add(70);
+	set.add(3);
+	set.add(70);
+	EATEST_VERIFY(set.size() == 3);
+	EATEST_VERIFY(set.contains(5) && set.contains(70) && set.contains(3));
+	EATEST_VERIFY(!set.contains(4) && !set.contains(1000));
+
+	EATEST_VERIFY(set.back() == 3);
+	EATEST_VERIFY(set.pop() == 3);
+	EATEST_VERIFY(!set.contains(3));
+	set.remove(5);
+	EATEST_VERIFY(!set.contains(5));
+	EATEST_VERIFY(set.size() == 1 && set.back() == 70);
+
+	// Clearing only bumps the stamp: nothing should remain, and everything can be added again.
+	set.clear();
+	EATEST_VERIFY(set.empty());
+	EATEST_VERIFY(!set.contains(5) && !set.contains(70) && !set.contains(3));
+
+	set.add(70);
+	EATEST_VERIFY(set.size() == 1);
+	EATEST_VERIFY(set.contains(70) && !set.contains(5));
+
+	// Growing the index table after a clear must not revive old entries.
+	set.clear();
+	set.add(200);
+	EATEST_VERIFY(set.contains(200));
+	EATEST_VERIFY(!set.contains(70) && !set.contains(199));
+
+	for (int i = 0; i < 10; ++i)
+	{
+		set.clear();
+		set.add(i);
+		EATEST_VERIFY(set.size() == 1 && set.contains(i));
+		EATEST_VERIFY(i == 0 || !set.contains(i-1));
+	}
+
+	return nErrorCount;
+}
+
+int TestSolvers::backtrackRecordTests(int seed, bool printVerbose)
+{
+	int nErrorCount = 0;
+
+	// Pigeonhole problem: can't fit 6 pigeons in 5 holes, so the solver has to backtrack a lot before failing.
+	ConstraintSolver solver(TEXT("BacktrackRecords"), seed);
+	SolverVariableDomain domain(0, 4);
+
+	vector<VarID> pigeons;
+	for (int i = 0; i < 6; ++i)
+	{
+		pigeons.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("Pigeon%d"), i}, domain));
+	}
+
+	for (int i = 0; i < pigeons.size(); ++i)
+	{
+		for (int j = i+1; j < pigeons.size(); ++j)
+		{
+			solver.inequality(pigeons[i], EConstraintOperator::NotEqual, pigeons[j]);
+		}
+	}
+
+	auto recorder = solver.makeConstraint<BacktrackRecordingConstraint>(pigeons);
+
+	solver.solve();
+	solver.dumpStats(printVerbose);
+
+	EATEST_VERIFY(solver.getCurrentStatus() == EConstraintSolverResult::Unsatisfiable);
+	EATEST_VERIFY(recorder->numBacktracks > 0);
+	EATEST_VERIFY(recorder->numUnneededBacktracks == 0);
+	EATEST_VERIFY(recorder->numStaleRecords == 0);
+
+	return nErrorCount;
+}
+
+int TestSolvers::conflictAnalysisTests(int seed, bool printVerbose)
+{
+	int nErrorCount = 0;
+
+	// Graph constraints go through the interned relations when learning, so make sure everything learned along the
+	// way is still consistent with the solution that was found.
+	for (int n : {8, 12})
+	{
+		ConstraintSolver solver(TEXT("ConflictAnalysis"), seed);
+		vector<VarID> queens = NQueensSolvers::createUsingGraph(solver, n);
+
+		solver.solve();
+		solver.dumpStats(printVerbose);
+
+		EATEST_VERIFY(solver.getCurrentStatus() == EConstraintSolverResult::Solved);
+		nErrorCount += NQueensSolvers::check(n, &solver, queens);
+
+		int numUnsatisfied = 0;
+		auto checkClauses = [&](const vector<ClauseConstraint*>& clauses)
+		{
+			for (const ClauseConstraint* clause : clauses)
+			{
+				bool satisfied = false;
+				for (int i = 0; i < clause->getNumLiterals() && !satisfied; ++i)
+				{
+					const Literal& lit = clause->getLiteral(i);
+					int index = solver.getDomain(lit.variable).getIndexForValue(solver.getSolvedValue(lit.variable));
+					satisfied = lit.values[index];
+				}
+
+				if (!satisfied)
+				{
+					++numUnsatisfied;
+				}
+			}
+		};
+
+		checkClauses(solver.getTemporaryLearnedConstraints());
+		checkClauses(solver.getPermanentLearnedConstraints());
+		EATEST_VERIFY(numUnsatisfied == 0);
+	}
+
+	return nErrorCount;
+}
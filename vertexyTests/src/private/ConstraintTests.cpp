@@ -0,0 +1,1444 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#include "ConstraintTests.h"
+
+#include <EASTL/hash_set.h>
+#include <EASTL/set.h>
+
+#include "ConstraintSolver.h"
+#include "EATest/EATest.h"
+#include "constraints/AllDifferentConstraint.h"
+#include "constraints/ClauseConstraint.h"
+#include "constraints/ConnectedConstraint.h"
+#include "constraints/DifferenceConstraint.h"
+#include "constraints/DisjunctionConstraint.h"
+#include "constraints/ElementConstraint.h"
+#include "constraints/InequalityConstraint.h"
+#include "constraints/LinearConstraint.h"
+#include "constraints/MDDConstraint.h"
+#include "constraints/RegularConstraint.h"
+#include "constraints/TableConstraint.h"
+#include "constraints/WindowCardinalityConstraint.h"
+#include "decision/ISolverDecisionHeuristic.h"
+#include "topology/GraphRelations.h"
+#include "topology/GridTopology.h"
+#include "topology/IPlanarTopology.h"
+#include "variable/SolverVariableDomain.h"
+
+using namespace VertexyTests;
+
+static constexpr int LINEAR_GRID_SIZE = 6;
+static constexpr int TABLE_NUM_VARIABLES = 5;
+static constexpr int MDD_NUM_VARIABLES = 7;
+static constexpr int ALLDIFFERENT_NUM_VARIABLES = 5;
+static constexpr int DIFFERENCE_NUM_VARIABLES = 4;
+static constexpr int REGULAR_NUM_VARIABLES = 5;
+static constexpr int REGULAR_GRID_WIDTH = 8;
+static constexpr int REGULAR_GRID_HEIGHT = 2;
+static constexpr int ELEMENT_GRID_SIZE = 3;
+static constexpr int WINDOW_GRID_WIDTH = 4;
+static constexpr int WINDOW_GRID_HEIGHT = 3;
+static constexpr int CONNECTED_LINE_LENGTH = 5;
+static constexpr int CONNECTED_GRID_SIZE = 3;
+
+namespace
+{
+
+using AssignmentCheck = function<bool(const vector<int>&)>;
+
+// Call Callback with every assignment that picks one value from each list.
+template <typename Fn>
+void forEachAssignment(const vector<vector<int>>& valueLists, Fn&& callback)
+{
+	for (auto& values : valueLists)
+	{
+		if (values.empty())
+		{
+			return;
+		}
+	}
+
+	vector<int> indices;
+	indices.resize(valueLists.size(), 0);
+	vector<int> assignment;
+	assignment.reserve(valueLists.size());
+
+	while (true)
+	{
+		assignment.clear();
+		for (int i = 0; i < valueLists.size(); ++i)
+		{
+			assignment.push_back(valueLists[i][indices[i]]);
+		}
+		callback(assignment);
+
+		int i = 0;
+		for (; i < indices.size(); ++i)
+		{
+			if (++indices[i] < valueLists[i].size())
+			{
+				break;
+			}
+			indices[i] = 0;
+		}
+		if (i == indices.size())
+		{
+			break;
+		}
+	}
+}
+
+// The number of assignments of the values that pass Check.
+int countAssignments(const vector<vector<int>>& valueLists, const AssignmentCheck& check)
+{
+	int count = 0;
+	forEachAssignment(valueLists, [&](const vector<int>& assignment)
+	{
+		if (check(assignment))
+		{
+			++count;
+		}
+	});
+	return count;
+}
+
+// Find every solution of the solver, returning how many there were. OutNumInvalid receives the number of solutions
+// that failed Check.
+int enumerateSolutions(ConstraintSolver& solver, const vector<VarID>& vars, const AssignmentCheck& check, int& outNumInvalid)
+{
+	outNumInvalid = 0;
+	int numSolutions = 0;
+
+	vector<int> assignment;
+	while (solver.solve() == EConstraintSolverResult::Solved)
+	{
+		++numSolutions;
+
+		assignment.clear();
+		for (VarID var : vars)
+		{
+			assignment.push_back(solver.getSolvedValue(var));
+		}
+		if (!check(assignment))
+		{
+			++outNumInvalid;
+		}
+	}
+	return numSolutions;
+}
+
+vector<VarID> makeVariables(ConstraintSolver& solver, const vector<vector<int>>& valueLists)
+{
+	vector<VarID> vars;
+	for (int i = 0; i < valueLists.size(); ++i)
+	{
+		vars.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("X%d"), i}, valueLists[i]));
+	}
+	return vars;
+}
+
+int getMinValue(const ConstraintSolver& solver, VarID var)
+{
+	return solver.getDomain(var).getValueForIndex(solver.getVariableDB()->getMinimumPossibleValue(var));
+}
+
+int getMaxValue(const ConstraintSolver& solver, VarID var)
+{
+	return solver.getDomain(var).getValueForIndex(solver.getVariableDB()->getMaximumPossibleValue(var));
+}
+
+// The potential values of the variable, as domain values.
+vector<int> getPotentialValueList(const ConstraintSolver& solver, VarID var)
+{
+	vector<int> out;
+	const ValueSet& values = solver.getVariableDB()->getPotentialValues(var);
+	for (auto it = values.beginSetBits(), itEnd = values.endSetBits(); it != itEnd; ++it)
+	{
+		out.push_back(solver.getDomain(var).getValueForIndex(*it));
+	}
+	return out;
+}
+
+// Decision heuristic that never makes a decision itself. Instead, before each decision, it checks that every potential
+// value of each relation's variables is part of some assignment of the current potential values that passes the
+// relation's Check. This holds for constraints that maintain domain consistency, including after backtracking.
+class SupportCheckingHeuristic : public ISolverDecisionHeuristic
+{
+public:
+	struct Relation
+	{
+		vector<VarID> vars;
+		AssignmentCheck check;
+	};
+
+	SupportCheckingHeuristic(const ConstraintSolver& solver)
+		: m_solver(solver)
+	{
+	}
+
+	virtual bool getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues) override
+	{
+		++numChecks;
+		for (auto& relation : relations)
+		{
+			vector<vector<int>> valueLists;
+			for (VarID relationVar : relation.vars)
+			{
+				valueLists.push_back(getPotentialValueList(m_solver, relationVar));
+			}
+
+			vector<hash_set<int>> supported;
+			supported.resize(relation.vars.size());
+			forEachAssignment(valueLists, [&](const vector<int>& assignment)
+			{
+				if (relation.check(assignment))
+				{
+					for (int i = 0; i < assignment.size(); ++i)
+					{
+						supported[i].insert(assignment[i]);
+					}
+				}
+			});
+
+			for (int i = 0; i < relation.vars.size(); ++i)
+			{
+				if (supported[i].size() != valueLists[i].size())
+				{
+					++numUnsupported;
+				}
+			}
+		}
+		return false;
+	}
+
+	virtual bool wantsVariableNotifications() const override { return false; }
+	virtual bool wantsConflictActivity() const override { return false; }
+
+	vector<Relation> relations;
+	int numChecks = 0;
+	// Number of times a variable was found with a value that has no support
+	int numUnsupported = 0;
+
+protected:
+	const ConstraintSolver& m_solver;
+};
+
+// Decides each scripted variable in order, skipping those that are already solved, then defers to the next heuristic.
+class ScriptedHeuristic : public ISolverDecisionHeuristic
+{
+public:
+	ScriptedHeuristic(const ConstraintSolver& solver)
+		: m_solver(solver)
+	{
+	}
+
+	virtual bool getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues) override
+	{
+		for (auto& [scriptVar, value] : script)
+		{
+			const int valueIndex = m_solver.getDomain(scriptVar).getIndexForValue(value);
+			if (m_solver.isSolved(scriptVar) || !m_solver.getVariableDB()->getPotentialValues(scriptVar)[valueIndex])
+			{
+				continue;
+			}
+
+			var = scriptVar;
+			chosenValues.pad(m_solver.getVariableDB()->getDomainSize(var), false);
+			chosenValues[valueIndex] = true;
+			decided.push_back(var);
+			return true;
+		}
+		return false;
+	}
+
+	virtual bool wantsVariableNotifications() const override { return false; }
+	virtual bool wantsConflictActivity() const override { return false; }
+
+	vector<tuple<VarID, int>> script;
+	// Every variable that was decided, in order
+	vector<VarID> decided;
+
+protected:
+	const ConstraintSolver& m_solver;
+};
+
+// Check that every window of a grid of 0/1 cells (indexed by vertex) has between MinCount and MaxCount 1s, as with
+// WindowCardinalityConstraint.
+AssignmentCheck makeWindowCheck(const shared_ptr<PlanarGridTopology>& grid, EWindowShape shape, int size, int minCount, int maxCount)
+{
+	return [grid, shape, size, minCount, maxCount](const vector<int>& assignment)
+	{
+		const int width = grid->getWidth();
+		const int height = grid->getHeight();
+		const int numAnchorsX = shape == EWindowShape::Square ? width - size + 1 : width;
+		const int numAnchorsY = shape == EWindowShape::Square ? height - size + 1 : height;
+		for (int ay = 0; ay < numAnchorsY; ++ay)
+		{
+			for (int ax = 0; ax < numAnchorsX; ++ax)
+			{
+				const int minX = shape == EWindowShape::Square ? ax : max(0, ax - size);
+				const int minY = shape == EWindowShape::Square ? ay : max(0, ay - size);
+				const int maxX = shape == EWindowShape::Square ? ax + size - 1 : min(width - 1, ax + size);
+				const int maxY = shape == EWindowShape::Square ? ay + size - 1 : min(height - 1, ay + size);
+
+				int count = 0;
+				for (int y = minY; y <= maxY; ++y)
+				{
+					for (int x = minX; x <= maxX; ++x)
+					{
+						count += assignment[grid->coordinateToIndex(x, y)];
+					}
+				}
+				if (count < minCount || count > maxCount)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	};
+}
+
+bool compareLinear(int lhs, EConstraintOperator op, int rhs)
+{
+	switch (op)
+	{
+	case EConstraintOperator::LessThan:
+		return lhs < rhs;
+	case EConstraintOperator::LessThanEq:
+		return lhs <= rhs;
+	case EConstraintOperator::GreaterThan:
+		return lhs > rhs;
+	case EConstraintOperator::GreaterThanEq:
+		return lhs >= rhs;
+	case EConstraintOperator::Equal:
+		return lhs == rhs;
+	default:
+		return lhs != rhs;
+	}
+}
+
+}
+
+int ConstraintTests::linearTests(int seed)
+{
+	int nErrorCount = 0;
+
+	// Initial propagation: 2x - 3y + z <= 1 leaves a slack of 7 above the smallest sum (-6).
+	{
+		ConstraintSolver solver(TEXT("Linear-Propagation"), seed);
+		VarID x = solver.makeVariable(TEXT("X"), SolverVariableDomain(0, 5));
+		VarID y = solver.makeVariable(TEXT("Y"), SolverVariableDomain(0, 2));
+		VarID z = solver.makeVariable(TEXT("Z"), vector{0, 4, 8});
+		solver.linear({x, y, z}, {2, -3, 1}, EConstraintOperator::LessThanEq, 1);
+
+		EATEST_VERIFY(solver.startSolving() == EConstraintSolverResult::Unsolved);
+		EATEST_VERIFY(getMinValue(solver, x) == 0 && getMaxValue(solver, x) == 3);
+		EATEST_VERIFY(getMinValue(solver, y) == 0 && getMaxValue(solver, y) == 2);
+		EATEST_VERIFY(getMinValue(solver, z) == 0 && getMaxValue(solver, z) == 4);
+	}
+
+	// Bounds that can't be met fail before search.
+	{
+		ConstraintSolver solver(TEXT("Linear-Infeasible"), seed);
+		VarID x = solver.makeVariable(TEXT("X"), SolverVariableDomain(0, 5));
+		VarID y = solver.makeVariable(TEXT("Y"), SolverVariableDomain(0, 5));
+		solver.linear({x, y}, {1, 1}, EConstraintOperator::GreaterThanEq, 11);
+		EATEST_VERIFY(solver.startSolving() == EConstraintSolverResult::Unsatisfiable);
+	}
+
+	// Every solution under each operator, with negative coefficients, a domain with holes, and a repeated variable:
+	// 3a - 2b + c - a
+	const vector<vector<int>> valueLists = {
+		{-2, -1, 0, 1, 2, 3},
+		{0, 1, 4, 6},
+		{0, 1, 2, 3}
+	};
+	auto evaluate = [](const vector<int>& assignment)
+	{
+		return 3*assignment[0] - 2*assignment[1] + assignment[2] - assignment[0];
+	};
+
+	const EConstraintOperator ops[] = {
+		EConstraintOperator::LessThan,
+		EConstraintOperator::LessThanEq,
+		EConstraintOperator::GreaterThan,
+		EConstraintOperator::GreaterThanEq,
+		EConstraintOperator::Equal
+	};
+	for (EConstraintOperator op : ops)
+	{
+		ConstraintSolver solver(TEXT("Linear-Operator"), seed);
+		vector<VarID> vars = makeVariables(solver, valueLists);
+		solver.linear({vars[0], vars[1], vars[2], vars[0]}, {3, -2, 1, -1}, op, 1);
+
+		AssignmentCheck check = [&](const vector<int>& assignment) { return compareLinear(evaluate(assignment), op, 1); };
+
+		int numInvalid;
+		const int numSolutions = enumerateSolutions(solver, vars, check, numInvalid);
+		EATEST_VERIFY(numInvalid == 0);
+		EATEST_VERIFY(numSolutions == countAssignments(valueLists, check));
+	}
+
+	// Ranges, including equality.
+	const tuple<int, int> ranges[] = {make_tuple(-3, 2), make_tuple(0, 0), make_tuple(-20, -9)};
+	for (auto& range : ranges)
+	{
+		const int lower = get<0>(range);
+		const int upper = get<1>(range);
+
+		ConstraintSolver solver(TEXT("Linear-Range"), seed);
+		vector<VarID> vars = makeVariables(solver, valueLists);
+		solver.linear({vars[0], vars[1], vars[2], vars[0]}, {3, -2, 1, -1}, lower, upper);
+
+		AssignmentCheck check = [&](const vector<int>& assignment)
+		{
+			const int sum = evaluate(assignment);
+			return sum >= lower && sum <= upper;
+		};
+
+		int numInvalid;
+		const int numSolutions = enumerateSolutions(solver, vars, check, numInvalid);
+		EATEST_VERIFY(numInvalid == 0);
+		EATEST_VERIFY(numSolutions == countAssignments(valueLists, check));
+		EATEST_VERIFY(numSolutions > 0);
+	}
+
+	return nErrorCount;
+}
+
+int ConstraintTests::tableTests(int seed)
+{
+	int nErrorCount = 0;
+
+	// A random table spanning several words of the bitset. Every row is a solution, and every value left after
+	// propagation is supported, no matter which decisions were undone to get there.
+	{
+		ConstraintSolver solver(TEXT("Table-Backtracking"), seed);
+		const vector<vector<int>> valueLists(TABLE_NUM_VARIABLES, vector{0, 1, 2, 3});
+
+		vector<vector<int>> rows;
+		hash_set<int> rowKeys;
+		auto getKey = [](const vector<int>& assignment)
+		{
+			int key = 0;
+			for (int value : assignment)
+			{
+				key = key*4 + value;
+			}
+			return key;
+		};
+		forEachAssignment(valueLists, [&](const vector<int>& assignment)
+		{
+			if (solver.randomFloat() < 0.3f)
+			{
+				rows.push_back(assignment);
+				rowKeys.insert(getKey(assignment));
+			}
+		});
+		EATEST_VERIFY(int(rows.size()) > 2*ReversibleSparseBitset::NUM_BITS_PER_WORD);
+
+		vector<VarID> vars = makeVariables(solver, valueLists);
+		solver.table(make_shared<TableConstraintData>(rows), vars);
+
+		AssignmentCheck check = [&](const vector<int>& assignment) { return rowKeys.find(getKey(assignment)) != rowKeys.end(); };
+
+		auto checker = make_shared<SupportCheckingHeuristic>(solver);
+		checker->relations.push_back({vars, check});
+		solver.addDecisionHeuristic(checker);
+
+		int numInvalid;
+		const int numSolutions = enumerateSolutions(solver, vars, check, numInvalid);
+		EATEST_VERIFY(numInvalid == 0);
+		EATEST_VERIFY(numSolutions == int(rows.size()));
+		EATEST_VERIFY(checker->numChecks > 0);
+		EATEST_VERIFY(checker->numUnsupported == 0);
+	}
+
+	// Several tables sharing one set of rows over variables with the same (non-zero based) domains. They should all use
+	// the same converted rows, and so the same support masks.
+	{
+		ConstraintSolver solver(TEXT("Table-Shared"), seed);
+		const vector<int> domainValues = {1, 2, 3, 4};
+		const SolverVariableDomain domain(1, 4);
+
+		auto allowed = [](int a, int b, int c) { return (a + b + c) % 3 == 0 || a == c; };
+		vector<vector<int>> rows;
+		forEachAssignment(vector<vector<int>>(3, domainValues), [&](const vector<int>& assignment)
+		{
+			if (allowed(assignment[0], assignment[1], assignment[2]))
+			{
+				rows.push_back(assignment);
+			}
+		});
+
+		vector<VarID> vars;
+		for (int i = 0; i < 5; ++i)
+		{
+			vars.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("X%d"), i}, domain));
+		}
+
+		auto data = make_shared<TableConstraintData>(rows);
+		solver.table(data, {vars[0], vars[1], vars[2]});
+		solver.table(data, {vars[2], vars[3], vars[4]});
+		solver.table(data, {vars[4], vars[1], vars[3]});
+
+		auto checker = make_shared<SupportCheckingHeuristic>(solver);
+		AssignmentCheck rowCheck = [&](const vector<int>& assignment) { return allowed(assignment[0], assignment[1], assignment[2]); };
+		checker->relations.push_back({{vars[0], vars[1], vars[2]}, rowCheck});
+		checker->relations.push_back({{vars[2], vars[3], vars[4]}, rowCheck});
+		checker->relations.push_back({{vars[4], vars[1], vars[3]}, rowCheck});
+		solver.addDecisionHeuristic(checker);
+
+		AssignmentCheck check = [&](const vector<int>& assignment)
+		{
+			return allowed(assignment[0], assignment[1], assignment[2]) &&
+				allowed(assignment[2], assignment[3], assignment[4]) &&
+				allowed(assignment[4], assignment[1], assignment[3]);
+		};
+
+		int numInvalid;
+		const int numSolutions = enumerateSolutions(solver, vars, check, numInvalid);
+		EATEST_VERIFY(numInvalid == 0);
+		EATEST_VERIFY(numSolutions == countAssignments(vector<vector<int>>(5, domainValues), check));
+		EATEST_VERIFY(checker->numUnsupported == 0);
+
+		// The converted rows are cached, so the support masks the constraints built are on the cached copy.
+		const vector<SolverVariableDomain> domains(3, domain);
+		auto converted = data->convertFromDomains(domains);
+		EATEST_VERIFY(converted == data->convertFromDomains(domains));
+		EATEST_VERIFY(!converted->getIntermediateData()->supportMasks.empty());
+	}
+
+	return nErrorCount;
+}
+
+int ConstraintTests::mddTests(int seed)
+{
+	int nErrorCount = 0;
+
+	const SolverVariableDomain domain(1, 3);
+	const vector<vector<int>> valueLists(MDD_NUM_VARIABLES, vector{1, 2, 3});
+
+	// Sequences whose sum is divisible by 3, and that never repeat a value twice in a row.
+	AssignmentCheck allowed = [](const vector<int>& assignment)
+	{
+		int sum = 0;
+		for (int i = 0; i < assignment.size(); ++i)
+		{
+			if (i > 0 && assignment[i] == assignment[i-1])
+			{
+				return false;
+			}
+			sum += assignment[i];
+		}
+		return sum % 3 == 0;
+	};
+
+	vector<vector<int>> rows;
+	forEachAssignment(valueLists, [&](const vector<int>& assignment)
+	{
+		if (allowed(assignment))
+		{
+			rows.push_back(assignment);
+		}
+	});
+
+	// The same relation as a state machine: the state holds the sum so far (mod 3), and the previous value (or 0).
+	auto transition = [](int layer, int state, int value, int& outNextState)
+	{
+		if (state % 4 == value)
+		{
+			return false;
+		}
+		outNextState = ((state / 4 + value) % 3) * 4 + value;
+		return true;
+	};
+	auto isAccepting = [](int state) { return state / 4 == 0; };
+
+	auto fromTuples = MDDConstraintData::fromTuples(rows);
+	auto fromTransitions = MDDConstraintData::fromTransitions(vector<SolverVariableDomain>(MDD_NUM_VARIABLES, domain), 0, transition, isAccepting);
+
+	// Both reduce to the same diagram.
+	EATEST_VERIFY(fromTuples->getNumLayers() == MDD_NUM_VARIABLES);
+	EATEST_VERIFY(fromTransitions->getNumLayers() == MDD_NUM_VARIABLES);
+	EATEST_VERIFY(fromTuples->getNumNodes() == fromTransitions->getNumNodes());
+	EATEST_VERIFY(fromTuples->edges.size() == fromTransitions->edges.size());
+
+	// Find every solution using a table with the same tuples, then each of the diagrams. All should match, and every
+	// value should have a support before each decision.
+	vector<set<vector<int>>> solutionSets;
+	for (int mode = 0; mode < 3; ++mode)
+	{
+		ConstraintSolver solver(TEXT("MDD"), seed);
+
+		vector<VarID> vars;
+		for (int i = 0; i < MDD_NUM_VARIABLES; ++i)
+		{
+			vars.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("X%d"), i}, domain));
+		}
+
+		if (mode == 0)
+		{
+			solver.table(make_shared<TableConstraintData>(rows), vars);
+		}
+		else
+		{
+			solver.mdd(mode == 1 ? fromTuples : fromTransitions, vars);
+		}
+
+		auto checker = make_shared<SupportCheckingHeuristic>(solver);
+		checker->relations.push_back({vars, allowed});
+		solver.addDecisionHeuristic(checker);
+
+		set<vector<int>> solutions;
+		AssignmentCheck check = [&](const vector<int>& assignment)
+		{
+			solutions.insert(assignment);
+			return allowed(assignment);
+		};
+
+		int numInvalid;
+		const int numSolutions = enumerateSolutions(solver, vars, check, numInvalid);
+		EATEST_VERIFY(numInvalid == 0);
+		EATEST_VERIFY(numSolutions == int(rows.size()));
+		EATEST_VERIFY(solutions.size() == rows.size());
+		EATEST_VERIFY(checker->numUnsupported == 0);
+
+		solutionSets.push_back(solutions);
+	}
+
+	EATEST_VERIFY(solutionSets[1] == solutionSets[0]);
+	EATEST_VERIFY(solutionSets[2] == solutionSets[0]);
+
+	return nErrorCount;
+}
+
+int ConstraintTests::allDifferentTests(int seed)
+{
+	int nErrorCount = 0;
+
+	const EAllDifferentPropagation modes[] = {EAllDifferentPropagation::Bounds, EAllDifferentPropagation::Domain};
+
+	// Three variables need all of {1, 3, 5}, so the other two can only be 2 or 4. Every variable still spans the whole
+	// range, so there's no Hall interval for bounds consistency to find.
+	for (EAllDifferentPropagation mode : modes)
+	{
+		ConstraintSolver solver(TEXT("AllDifferent-Holes"), seed);
+		const SolverVariableDomain domain(1, 5);
+
+		vector<VarID> vars;
+		for (int i = 0; i < 5; ++i)
+		{
+			vars.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("X%d"), i}, domain, i < 3 ? vector{1, 3, 5} : vector<int>{}));
+		}
+		solver.allDifferent(vars, mode);
+
+		EATEST_VERIFY(solver.startSolving() == EConstraintSolverResult::Unsolved);
+		const vector<int> expected = mode == EAllDifferentPropagation::Domain ? vector{2, 4} : vector{1, 2, 3, 4, 5};
+		EATEST_VERIFY(getPotentialValueList(solver, vars[3]) == expected);
+		EATEST_VERIFY(getPotentialValueList(solver, vars[4]) == expected);
+		EATEST_VERIFY(getPotentialValueList(solver, vars[0]) == vector({1, 3, 5}));
+	}
+
+	// Random domains with holes. Every solution is found with either mode, and in domain mode every remaining value is
+	// part of some solution before each decision.
+	for (EAllDifferentPropagation mode : modes)
+	{
+		ConstraintSolver solver(TEXT("AllDifferent-Random"), seed);
+		const SolverVariableDomain domain(1, 6);
+
+		vector<vector<int>> valueLists;
+		vector<VarID> vars;
+		for (int i = 0; i < ALLDIFFERENT_NUM_VARIABLES; ++i)
+		{
+			vector<int> values;
+			for (int value = domain.getMin(); value <= domain.getMax(); ++value)
+			{
+				if (solver.randomFloat() < 0.6f)
+				{
+					values.push_back(value);
+				}
+			}
+			if (values.empty())
+			{
+				values.push_back(solver.randomRange(domain.getMin(), domain.getMax()));
+			}
+
+			vars.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("X%d"), i}, domain, values));
+			valueLists.push_back(values);
+		}
+		solver.allDifferent(vars, mode);
+
+		AssignmentCheck check = [](const vector<int>& assignment)
+		{
+			for (int i = 0; i < assignment.size(); ++i)
+			{
+				for (int j = i + 1; j < assignment.size(); ++j)
+				{
+					if (assignment[i] == assignment[j])
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		};
+
+		auto checker = make_shared<SupportCheckingHeuristic>(solver);
+		if (mode == EAllDifferentPropagation::Domain)
+		{
+			checker->relations.push_back({vars, check});
+		}
+		solver.addDecisionHeuristic(checker);
+
+		int numInvalid;
+		const int numSolutions = enumerateSolutions(solver, vars, check, numInvalid);
+		EATEST_VERIFY(numInvalid == 0);
+		EATEST_VERIFY(numSolutions == countAssignments(valueLists, check));
+		EATEST_VERIFY(checker->numUnsupported == 0);
+	}
+
+	return nErrorCount;
+}
+
+int ConstraintTests::regularTests(int seed)
+{
+	int nErrorCount = 0;
+
+	// Every solution of a hand-built automaton that accepts sequences with an even number of 1s.
+	{
+		ConstraintSolver solver(TEXT("Regular-Parity"), seed);
+		vector<vector<int>> valueLists;
+		valueLists.resize(REGULAR_NUM_VARIABLES, vector{0, 1, 2});
+		vector<VarID> vars = makeVariables(solver, valueLists);
+
+		auto automaton = make_shared<RegularConstraintData>(2, 0);
+		for (int state = 0; state < 2; ++state)
+		{
+			automaton->addTransition(state, 0, state);
+			automaton->addTransition(state, 1, 1 - state);
+			automaton->addTransition(state, 2, state);
+		}
+		automaton->setAccepting(0);
+		solver.regular(automaton, vars);
+
+		AssignmentCheck check = [](const vector<int>& assignment)
+		{
+			int numOnes = 0;
+			for (int value : assignment)
+			{
+				if (value == 1)
+				{
+					++numOnes;
+				}
+			}
+			return numOnes % 2 == 0;
+		};
+
+		int numInvalid;
+		const int numSolutions = enumerateSolutions(solver, vars, check, numInvalid);
+		EATEST_VERIFY(numInvalid == 0);
+		EATEST_VERIFY(numSolutions == countAssignments(valueLists, check));
+	}
+
+	// No more than 3 walls in a row, along each row of a grid. The walk covers the whole row, so only vertices in the
+	// first column get a constraint. The first row starts with walls at 0-2 and 4-6, which forces floors at 3 and 7.
+	{
+		ConstraintSolver solver(TEXT("Regular-Graph"), seed);
+
+		auto grid = make_shared<PlanarGridTopology>(REGULAR_GRID_WIDTH, REGULAR_GRID_HEIGHT);
+		const SolverVariableDomain domain(0, 1);
+		auto cells = solver.makeVariableGraph(TEXT("Cells"), IPlanarTopology::adapt(grid), domain, TEXT("Cell"));
+
+		auto automaton = RegularConstraintData::maxRunLength(domain, {1}, 3);
+		auto walk = RegularConstraint::makeWalkRelations(grid, cells, PlanarGridTopology::moveRight(1), REGULAR_GRID_WIDTH);
+
+		const int firstConstraint = solver.getNextConstraintID();
+		solver.makeGraphConstraint<RegularConstraint>(grid, automaton, walk);
+		EATEST_VERIFY(solver.getNextConstraintID() - firstConstraint == REGULAR_GRID_HEIGHT);
+
+		for (int x = 0; x < REGULAR_GRID_WIDTH; ++x)
+		{
+			if (x != 3 && x != 7)
+			{
+				solver.setInitialValues(cells->get(grid->coordinateToIndex(x, 0)), {1});
+			}
+		}
+
+		EATEST_VERIFY(solver.startSolving() == EConstraintSolverResult::Unsolved);
+		EATEST_VERIFY(getPotentialValueList(solver, cells->get(grid->coordinateToIndex(3, 0))) == vector{0});
+		EATEST_VERIFY(getPotentialValueList(solver, cells->get(grid->coordinateToIndex(7, 0))) == vector{0});
+		for (int x = 0; x < REGULAR_GRID_WIDTH; ++x)
+		{
+			EATEST_VERIFY(getPotentialValueList(solver, cells->get(grid->coordinateToIndex(x, 1))) == vector({0, 1}));
+		}
+	}
+
+	return nErrorCount;
+}
+
+int ConstraintTests::elementTests(int seed)
+{
+	int nErrorCount = 0;
+
+	// Result = Array[Index], over variables with different domains. Index can also take values that select nothing.
+	// Every solution is found, and every remaining value is part of some solution before each decision.
+	{
+		ConstraintSolver solver(TEXT("Element-Variables"), seed);
+		const vector<vector<int>> valueLists = {
+			{0, 1, 2, 3, 4, 5},
+			{-1, 0, 1, 2, 3, 4},
+			{0, 1},
+			{2, 3},
+			{4, 5, 6},
+			{1, 4}
+		};
+		vector<VarID> vars = makeVariables(solver, valueLists);
+		solver.element(vars[0], vars[1], vector<VarID>{vars[2], vars[3], vars[4], vars[5]});
+
+		AssignmentCheck check = [](const vector<int>& assignment)
+		{
+			const int index = assignment[1];
+			return index >= 0 && index < 4 && assignment[0] == assignment[2 + index];
+		};
+
+		auto checker = make_shared<SupportCheckingHeuristic>(solver);
+		checker->relations.push_back({vars, check});
+		solver.addDecisionHeuristic(checker);
+
+		int numInvalid;
+		const int numSolutions = enumerateSolutions(solver, vars, check, numInvalid);
+		EATEST_VERIFY(numInvalid == 0);
+		EATEST_VERIFY(numSolutions == countAssignments(valueLists, check));
+		EATEST_VERIFY(checker->numChecks > 0);
+		EATEST_VERIFY(checker->numUnsupported == 0);
+	}
+
+	// Result = Constants[Index]. Constants outside of the result's domain can never be selected.
+	{
+		ConstraintSolver solver(TEXT("Element-Constants"), seed);
+		VarID result = solver.makeVariable(TEXT("Result"), SolverVariableDomain(0, 4));
+		VarID index = solver.makeVariable(TEXT("Index"), SolverVariableDomain(0, 4));
+		solver.element(result, index, vector{3, 7, 1, 3, -2});
+
+		EATEST_VERIFY(solver.startSolving() == EConstraintSolverResult::Unsolved);
+		EATEST_VERIFY(getPotentialValueList(solver, index) == vector({0, 2, 3}));
+		EATEST_VERIFY(getPotentialValueList(solver, result) == vector({1, 3}));
+	}
+
+	// Each cell of a grid picks a neighbor, and Result must equal the picked neighbor's value. Neighbors outside of the
+	// grid can't be picked, but every vertex still gets a constraint.
+	{
+		ConstraintSolver solver(TEXT("Element-Graph"), seed);
+
+		auto grid = make_shared<PlanarGridTopology>(ELEMENT_GRID_SIZE, ELEMENT_GRID_SIZE);
+		auto iGrid = IPlanarTopology::adapt(grid);
+		auto cells = solver.makeVariableGraph(TEXT("Cells"), iGrid, SolverVariableDomain(0, 4), TEXT("Cell"));
+		auto picks = solver.makeVariableGraph(TEXT("Picks"), iGrid, SolverVariableDomain(0, 3), TEXT("Pick"));
+		auto results = solver.makeVariableGraph(TEXT("Results"), iGrid, SolverVariableDomain(0, 4), TEXT("Result"));
+
+		const vector<TopologyLink> links = {
+			PlanarGridTopology::moveLeft(1),
+			PlanarGridTopology::moveRight(1),
+			PlanarGridTopology::moveUp(1),
+			PlanarGridTopology::moveDown(1)
+		};
+		const int offsets[][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+		GraphVariableRelationPtr resultRel = make_shared<TTopologyLinkGraphRelation<VarID>>(iGrid, results, TopologyLink::SELF);
+		GraphVariableRelationPtr pickRel = make_shared<TTopologyLinkGraphRelation<VarID>>(iGrid, picks, TopologyLink::SELF);
+		auto neighbors = ElementConstraint::makeNeighborRelations(grid, cells, links);
+
+		const int firstConstraint = solver.getNextConstraintID();
+		solver.makeGraphConstraint<ElementConstraint>(grid, resultRel, pickRel, neighbors);
+		EATEST_VERIFY(solver.getNextConstraintID() - firstConstraint == ELEMENT_GRID_SIZE*ELEMENT_GRID_SIZE);
+
+		// The top-left corner can only pick right or down.
+		EATEST_VERIFY(solver.startSolving() == EConstraintSolverResult::Unsolved);
+		EATEST_VERIFY(getPotentialValueList(solver, picks->get(grid->coordinateToIndex(0, 0))) == vector({1, 3}));
+
+		while (solver.getCurrentStatus() == EConstraintSolverResult::Unsolved)
+		{
+			solver.step();
+		}
+		EATEST_VERIFY(solver.getCurrentStatus() == EConstraintSolverResult::Solved);
+		if (solver.getCurrentStatus() == EConstraintSolverResult::Solved)
+		{
+			for (int y = 0; y < ELEMENT_GRID_SIZE; ++y)
+			{
+				for (int x = 0; x < ELEMENT_GRID_SIZE; ++x)
+				{
+					const int vertex = grid->coordinateToIndex(x, y);
+					const int pick = solver.getSolvedValue(picks->get(vertex));
+					const int nx = x + offsets[pick][0];
+					const int ny = y + offsets[pick][1];
+
+					const bool inGrid = nx >= 0 && nx < ELEMENT_GRID_SIZE && ny >= 0 && ny < ELEMENT_GRID_SIZE;
+					EATEST_VERIFY(inGrid);
+					if (inGrid)
+					{
+						const int neighbor = grid->coordinateToIndex(nx, ny);
+						EATEST_VERIFY(solver.getSolvedValue(results->get(vertex)) == solver.getSolvedValue(cells->get(neighbor)));
+					}
+				}
+			}
+		}
+	}
+
+	return nErrorCount;
+}
+
+int ConstraintTests::windowCardinalityTests(int seed)
+{
+	int nErrorCount = 0;
+
+	// Every solution of square and radius windows over a grid with some cells fixed. Finding every solution
+	// backtracks through each cell state change many times, so the window counts must be restored correctly for the
+	// solutions to match.
+	const EWindowShape shapes[] = {EWindowShape::Square, EWindowShape::Radius};
+	for (EWindowShape shape : shapes)
+	{
+		ConstraintSolver solver(TEXT("WindowCardinality-Shapes"), seed);
+
+		auto grid = make_shared<PlanarGridTopology>(WINDOW_GRID_WIDTH, WINDOW_GRID_HEIGHT);
+		auto cells = solver.makeVariableGraph(TEXT("Cells"), IPlanarTopology::adapt(grid), SolverVariableDomain(0, 1), TEXT("Cell"));
+
+		// A square 2x2 window allows 1-2 counted cells; a radius 1 window (up to 3x3) allows 1-3.
+		const int size = shape == EWindowShape::Square ? 2 : 1;
+		const int maxCount = shape == EWindowShape::Square ? 2 : 3;
+		solver.windowCardinality(grid, cells, {1}, shape, size, 1, maxCount);
+
+		const vector<tuple<int, int, int>> fixedCells = {
+			make_tuple(0, 0, 1), make_tuple(1, 0, 1),
+			make_tuple(2, 1, 0), make_tuple(3, 1, 0), make_tuple(2, 2, 0)
+		};
+
+		vector<VarID> vars;
+		vector<vector<int>> valueLists;
+		for (int vertex = 0; vertex < grid->getNumVertices(); ++vertex)
+		{
+			vars.push_back(cells->get(vertex));
+			valueLists.push_back({0, 1});
+		}
+		for (auto& fixed : fixedCells)
+		{
+			const int vertex = grid->coordinateToIndex(get<0>(fixed), get<1>(fixed));
+			solver.setInitialValues(vars[vertex], {get<2>(fixed)});
+			valueLists[vertex] = {get<2>(fixed)};
+		}
+
+		AssignmentCheck check = makeWindowCheck(grid, shape, size, 1, maxCount);
+		int numInvalid;
+		const int numSolutions = enumerateSolutions(solver, vars, check, numInvalid);
+		EATEST_VERIFY(numInvalid == 0);
+		EATEST_VERIFY(numSolutions == countAssignments(valueLists, check));
+	}
+
+	// The same windows, checking what is propagated before search. In the top-left, a window reaches its maximum and
+	// its remaining cells are excluded. In the bottom-right, a window can only reach its minimum by counting its last
+	// cell.
+	for (EWindowShape shape : shapes)
+	{
+		ConstraintSolver solver(TEXT("WindowCardinality-Tight"), seed);
+
+		auto grid = make_shared<PlanarGridTopology>(WINDOW_GRID_WIDTH, WINDOW_GRID_HEIGHT);
+		auto cells = solver.makeVariableGraph(TEXT("Cells"), IPlanarTopology::adapt(grid), SolverVariableDomain(0, 1), TEXT("Cell"));
+		const int size = shape == EWindowShape::Square ? 2 : 1;
+		const int maxCount = shape == EWindowShape::Square ? 2 : 3;
+		solver.windowCardinality(grid, cells, {1}, shape, size, 1, maxCount);
+
+		auto getCell = [&](int x, int y) { return cells->get(grid->coordinateToIndex(x, y)); };
+		solver.setInitialValues(getCell(0, 0), {1});
+		solver.setInitialValues(getCell(1, 0), {1});
+		if (shape == EWindowShape::Radius)
+		{
+			solver.setInitialValues(getCell(0, 1), {1});
+		}
+		solver.setInitialValues(getCell(2, 1), {0});
+		solver.setInitialValues(getCell(3, 1), {0});
+		solver.setInitialValues(getCell(2, 2), {0});
+
+		EATEST_VERIFY(solver.startSolving() == EConstraintSolverResult::Unsolved);
+		// Maximum reached in the top-left window
+		EATEST_VERIFY(getPotentialValueList(solver, getCell(1, 1)) == vector{0});
+		// Minimum reached in the bottom-right window
+		EATEST_VERIFY(getPotentialValueList(solver, getCell(3, 2)) == vector{1});
+	}
+
+	// A single 2x2 window with at most one counted cell, and the clause A=1 -> B=1. Deciding A=1 counts two cells at
+	// once, before the window can propagate, so the window itself reports the conflict and explains it.
+	{
+		ConstraintSolver solver(TEXT("WindowCardinality-Conflict"), seed);
+
+		auto grid = make_shared<PlanarGridTopology>(2, 2);
+		auto cells = solver.makeVariableGraph(TEXT("Cells"), IPlanarTopology::adapt(grid), SolverVariableDomain(0, 1), TEXT("Cell"));
+		solver.windowCardinality(grid, cells, {1}, EWindowShape::Square, 2, 0, 1);
+
+		vector<VarID> vars;
+		vector<vector<int>> valueLists;
+		for (int vertex = 0; vertex < grid->getNumVertices(); ++vertex)
+		{
+			vars.push_back(cells->get(vertex));
+			valueLists.push_back({0, 1});
+		}
+		solver.clause({SignedClause(vars[0], vector{0}), SignedClause(vars[1], vector{1})});
+
+		auto heuristic = make_shared<ScriptedHeuristic>(solver);
+		heuristic->script = {make_tuple(vars[0], 1)};
+		solver.addDecisionHeuristic(heuristic);
+
+		AssignmentCheck windowCheck = makeWindowCheck(grid, EWindowShape::Square, 2, 0, 1);
+		AssignmentCheck check = [&](const vector<int>& assignment)
+		{
+			return windowCheck(assignment) && (assignment[0] == 0 || assignment[1] == 1);
+		};
+
+		EATEST_VERIFY(solver.solve() == EConstraintSolverResult::Solved);
+		EATEST_VERIFY(!heuristic->decided.empty() && heuristic->decided[0] == vars[0]);
+		EATEST_VERIFY(solver.getStats().numConstraintsLearned > 0);
+		EATEST_VERIFY(solver.getSolvedValue(vars[0]) == 0);
+
+		// The learned constraint must not remove any solutions.
+		int numInvalid;
+		const int numSolutions = 1 + enumerateSolutions(solver, vars, check, numInvalid);
+		EATEST_VERIFY(numInvalid == 0);
+		EATEST_VERIFY(numSolutions == countAssignments(valueLists, check));
+	}
+
+	return nErrorCount;
+}
+
+int ConstraintTests::connectedTests(int seed)
+{
+	int nErrorCount = 0;
+
+	auto makeLine = [](ConstraintSolver& solver)
+	{
+		auto line = make_shared<PlanarGridTopology>(CONNECTED_LINE_LENGTH, 1);
+		auto cells = solver.makeVariableGraph(TEXT("Cells"), IPlanarTopology::adapt(line), SolverVariableDomain(0, 1), TEXT("Cell"));
+		solver.connected(cells, {1});
+		return cells;
+	};
+
+	// On a line with 0 and 2 in the region and 3 out of it, 1 is a cut vertex between them and must join, while 4 can't
+	// be reached and must leave.
+	{
+		ConstraintSolver solver(TEXT("Connected-Propagation"), seed);
+		auto cells = makeLine(solver);
+		solver.setInitialValues(cells->get(0), {1});
+		solver.setInitialValues(cells->get(2), {1});
+		solver.setInitialValues(cells->get(3), {0});
+
+		EATEST_VERIFY(solver.startSolving() == EConstraintSolverResult::Unsolved);
+		EATEST_VERIFY(getPotentialValueList(solver, cells->get(1)) == vector{1});
+		EATEST_VERIFY(getPotentialValueList(solver, cells->get(4)) == vector{0});
+	}
+
+	// Region vertices on either side of a vertex that is out of the region can't be connected.
+	{
+		ConstraintSolver solver(TEXT("Connected-Separated"), seed);
+		auto cells = makeLine(solver);
+		solver.setInitialValues(cells->get(1), {1});
+		solver.setInitialValues(cells->get(2), {0});
+		solver.setInitialValues(cells->get(3), {1});
+
+		EATEST_VERIFY(solver.startSolving() == EConstraintSolverResult::Unsatisfiable);
+	}
+
+	// The first solution removes 2, which cuts off 3 and 4. Finding the next solution backtracks to the start, so the
+	// constraint must rebuild its state before adding 2 and 4 to the region forces 3 to join, rather than treating 3 as
+	// still out of the region.
+	{
+		ConstraintSolver solver(TEXT("Connected-Backtrack"), seed);
+		auto cells = makeLine(solver);
+
+		auto heuristic = make_shared<ScriptedHeuristic>(solver);
+		solver.addDecisionHeuristic(heuristic);
+
+		heuristic->script = {make_tuple(cells->get(2), 0), make_tuple(cells->get(0), 1)};
+		EATEST_VERIFY(solver.solve() == EConstraintSolverResult::Solved);
+		EATEST_VERIFY(heuristic->decided.size() >= 2 && heuristic->decided[0] == cells->get(2) && heuristic->decided[1] == cells->get(0));
+		EATEST_VERIFY(solver.getSolvedValue(cells->get(3)) == 0 && solver.getSolvedValue(cells->get(4)) == 0);
+
+		heuristic->decided.clear();
+		heuristic->script = {make_tuple(cells->get(2), 1), make_tuple(cells->get(4), 1)};
+		EATEST_VERIFY(solver.solve() == EConstraintSolverResult::Solved);
+		EATEST_VERIFY(heuristic->decided.size() >= 2 && heuristic->decided[0] == cells->get(2) && heuristic->decided[1] == cells->get(4));
+		EATEST_VERIFY(solver.getSolvedValue(cells->get(3)) == 1);
+		EATEST_VERIFY(solver.getStats().numConstraintsLearned == 0);
+	}
+
+	// Every connected region of a grid, including the empty one.
+	{
+		ConstraintSolver solver(TEXT("Connected-Enumerate"), seed);
+		auto grid = make_shared<PlanarGridTopology>(CONNECTED_GRID_SIZE, CONNECTED_GRID_SIZE);
+		auto cells = solver.makeVariableGraph(TEXT("Cells"), IPlanarTopology::adapt(grid), SolverVariableDomain(0, 1), TEXT("Cell"));
+		solver.connected(cells, {1});
+
+		vector<VarID> vars;
+		vector<vector<int>> valueLists;
+		for (int vertex = 0; vertex < grid->getNumVertices(); ++vertex)
+		{
+			vars.push_back(cells->get(vertex));
+			valueLists.push_back({0, 1});
+		}
+
+		AssignmentCheck check = [&](const vector<int>& assignment)
+		{
+			// Flood fill from the first region cell, then make sure every region cell was reached.
+			vector<bool> reached;
+			reached.resize(assignment.size(), false);
+			vector<int> stack;
+			for (int vertex = 0; vertex < assignment.size() && stack.empty(); ++vertex)
+			{
+				if (assignment[vertex] == 1)
+				{
+					stack.push_back(vertex);
+					reached[vertex] = true;
+				}
+			}
+
+			const int offsets[][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+			while (!stack.empty())
+			{
+				int x, y;
+				grid->indexToCoordinate(stack.back(), x, y);
+				stack.pop_back();
+				for (auto& offset : offsets)
+				{
+					const int nx = x + offset[0];
+					const int ny = y + offset[1];
+					if (nx < 0 || nx >= CONNECTED_GRID_SIZE || ny < 0 || ny >= CONNECTED_GRID_SIZE)
+					{
+						continue;
+					}
+
+					const int neighbor = grid->coordinateToIndex(nx, ny);
+					if (!reached[neighbor] && assignment[neighbor] == 1)
+					{
+						reached[neighbor] = true;
+						stack.push_back(neighbor);
+					}
+				}
+			}
+
+			for (int vertex = 0; vertex < assignment.size(); ++vertex)
+			{
+				if (assignment[vertex] == 1 && !reached[vertex])
+				{
+					return false;
+				}
+			}
+			return true;
+		};
+
+		int numInvalid;
+		const int numSolutions = enumerateSolutions(solver, vars, check, numInvalid);
+		EATEST_VERIFY(numInvalid == 0);
+		EATEST_VERIFY(numSolutions == countAssignments(valueLists, check));
+	}
+
+	return nErrorCount;
+}
+
+int ConstraintTests::differenceTests(int seed)
+{
+	int nErrorCount = 0;
+
+	// A chain of Xi+1 >= Xi + 2, with Y = X0 + 5. Each variable's bounds come from both ends of the chain.
+	{
+		ConstraintSolver solver(TEXT("Difference-Chain"), seed);
+		vector<VarID> xs;
+		vector<DifferenceEdge> edges;
+		for (int i = 0; i < 5; ++i)
+		{
+			xs.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("X%d"), i}, SolverVariableDomain(0, 20)));
+			if (i > 0)
+			{
+				DifferenceEdge::fromInequality(xs[i], EConstraintOperator::GreaterThanEq, xs[i-1], 2, edges);
+			}
+		}
+		VarID y = solver.makeVariable(TEXT("Y"), SolverVariableDomain(0, 8));
+		DifferenceEdge::fromInequality(y, EConstraintOperator::Equal, xs[0], 5, edges);
+		EATEST_VERIFY(edges.size() == 6);
+		solver.difference(edges);
+
+		EATEST_VERIFY(solver.startSolving() == EConstraintSolverResult::Unsolved);
+		EATEST_VERIFY(getMinValue(solver, xs[0]) == 0 && getMaxValue(solver, xs[0]) == 3);
+		for (int i = 1; i < 5; ++i)
+		{
+			EATEST_VERIFY(getMinValue(solver, xs[i]) == 2*i && getMaxValue(solver, xs[i]) == 12 + 2*i);
+		}
+		EATEST_VERIFY(getMinValue(solver, y) == 5 && getMaxValue(solver, y) == 8);
+	}
+
+	// X < Y <= X is a negative cycle, found when the constraint is created.
+	{
+		ConstraintSolver solver(TEXT("Difference-Cycle"), seed);
+		VarID x = solver.makeVariable(TEXT("X"), SolverVariableDomain(0, 5));
+		VarID y = solver.makeVariable(TEXT("Y"), SolverVariableDomain(0, 5));
+		vector<DifferenceEdge> edges;
+		DifferenceEdge::fromInequality(x, EConstraintOperator::LessThan, y, 0, edges);
+		DifferenceEdge::fromInequality(y, EConstraintOperator::LessThanEq, x, 0, edges);
+		DifferenceConstraint* cons = solver.difference(edges);
+
+		EATEST_VERIFY(cons->getNegativeCycle().size() == 2);
+		EATEST_VERIFY(solver.startSolving() == EConstraintSolverResult::Unsatisfiable);
+	}
+
+	// W <= X, Y >= X + 3, Z >= Y + 1. Y's lower bound of 3 lands in a hole, so it is really 7, and Z's lower bound must
+	// come from that rather than from the path.
+	{
+		ConstraintSolver solver(TEXT("Difference-Holes"), seed);
+		VarID w = solver.makeVariable(TEXT("W"), SolverVariableDomain(0, 10));
+		VarID x = solver.makeVariable(TEXT("X"), SolverVariableDomain(0, 10));
+		VarID y = solver.makeVariable(TEXT("Y"), SolverVariableDomain(0, 10), vector{0, 1, 2, 7, 8, 9, 10});
+		VarID z = solver.makeVariable(TEXT("Z"), SolverVariableDomain(0, 10));
+		vector<DifferenceEdge> edges;
+		DifferenceEdge::fromInequality(w, EConstraintOperator::LessThanEq, x, 0, edges);
+		DifferenceEdge::fromInequality(y, EConstraintOperator::GreaterThanEq, x, 3, edges);
+		DifferenceEdge::fromInequality(z, EConstraintOperator::GreaterThanEq, y, 1, edges);
+		solver.difference(edges);
+
+		EATEST_VERIFY(solver.startSolving() == EConstraintSolverResult::Unsolved);
+		EATEST_VERIFY(getMinValue(solver, y) == 7 && getMaxValue(solver, y) == 9);
+		EATEST_VERIFY(getMinValue(solver, z) == 8);
+		EATEST_VERIFY(getMaxValue(solver, x) == 6 && getMaxValue(solver, w) == 6);
+	}
+
+	// Every solution of one random edge per operator, over domains with holes.
+	{
+		ConstraintSolver solver(TEXT("Difference-Random"), seed);
+		const SolverVariableDomain domain(0, 4);
+		const EConstraintOperator ops[] = {
+			EConstraintOperator::LessThan,
+			EConstraintOperator::LessThanEq,
+			EConstraintOperator::GreaterThan,
+			EConstraintOperator::GreaterThanEq,
+			EConstraintOperator::Equal
+		};
+
+		vector<vector<int>> valueLists;
+		vector<VarID> vars;
+		for (int i = 0; i < DIFFERENCE_NUM_VARIABLES; ++i)
+		{
+			vector<int> values;
+			for (int value = domain.getMin(); value <= domain.getMax(); ++value)
+			{
+				if (solver.randomFloat() < 0.7f)
+				{
+					values.push_back(value);
+				}
+			}
+			if (values.empty())
+			{
+				values.push_back(solver.randomRange(domain.getMin(), domain.getMax()));
+			}
+
+			vars.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("X%d"), i}, domain, values));
+			valueLists.push_back(values);
+		}
+
+		vector<tuple<int, EConstraintOperator, int, int>> relations;
+		vector<DifferenceEdge> edges;
+		for (EConstraintOperator op : ops)
+		{
+			const int left = solver.randomRange(0, DIFFERENCE_NUM_VARIABLES - 1);
+			const int right = (left + solver.randomRange(1, DIFFERENCE_NUM_VARIABLES - 1)) % DIFFERENCE_NUM_VARIABLES;
+			const int delta = solver.randomRange(-2, 2);
+
+			relations.push_back(make_tuple(left, op, right, delta));
+			DifferenceEdge::fromInequality(vars[left], op, vars[right], delta, edges);
+		}
+		solver.difference(edges);
+
+		AssignmentCheck check = [&](const vector<int>& assignment)
+		{
+			for (auto& [left, op, right, delta] : relations)
+			{
+				if (!compareLinear(assignment[left], op, assignment[right] + delta))
+				{
+					return false;
+				}
+			}
+			return true;
+		};
+
+		int numInvalid;
+		const int numSolutions = enumerateSolutions(solver, vars, check, numInvalid);
+		EATEST_VERIFY(numInvalid == 0);
+		EATEST_VERIFY(numSolutions == countAssignments(valueLists, check));
+	}
+
+	// The shared Equal operator is also accepted by the inequality constraint, which propagates its bounds.
+	{
+		ConstraintSolver solver(TEXT("Inequality-Equal"), seed);
+		const vector<vector<int>> valueLists = {{1, 2, 4, 6}, {0, 2, 3, 4, 5}};
+		VarID x = solver.makeVariable(TEXT("X"), SolverVariableDomain(0, 6), valueLists[0]);
+		VarID y = solver.makeVariable(TEXT("Y"), SolverVariableDomain(0, 6), valueLists[1]);
+		solver.inequality(x, EConstraintOperator::Equal, y);
+
+		EATEST_VERIFY(solver.startSolving() == EConstraintSolverResult::Unsolved);
+		EATEST_VERIFY(getMinValue(solver, x) == 2 && getMaxValue(solver, x) == 4);
+		EATEST_VERIFY(getMinValue(solver, y) == 2 && getMaxValue(solver, y) == 4);
+	}
+	{
+		ConstraintSolver solver(TEXT("Inequality-EqualEnumerate"), seed);
+		const vector<vector<int>> valueLists = {{1, 2, 4, 6}, {0, 2, 3, 4, 5}};
+		vector<VarID> vars = {
+			solver.makeVariable(TEXT("X"), SolverVariableDomain(0, 6), valueLists[0]),
+			solver.makeVariable(TEXT("Y"), SolverVariableDomain(0, 6), valueLists[1])
+		};
+		solver.inequality(vars[0], EConstraintOperator::Equal, vars[1]);
+
+		AssignmentCheck check = [](const vector<int>& assignment) { return assignment[0] == assignment[1]; };
+
+		int numInvalid;
+		const int numSolutions = enumerateSolutions(solver, vars, check, numInvalid);
+		EATEST_VERIFY(numInvalid == 0);
+		EATEST_VERIFY(numSolutions == countAssignments(valueLists, check));
+	}
+
+	return nErrorCount;
+}
+
+int ConstraintTests::disjunctionTests(int seed)
+{
+	int nErrorCount = 0;
+
+	// A0 or A1 or A2, where Ai is "Ai = 1". Deciding A0 = 0 then A2 = 0 makes A1 the only alternative left, so it is
+	// rebuilt at decision level 2. Finding the next solution backtracks to level 0, emptying its sentinel slot. The
+	// slot must be refilled as soon as any alternative is notified, so that deciding A1 = 0 then A2 = 0 forces A0 = 1
+	// without it needing to be decided.
+	{
+		ConstraintSolver solver(TEXT("Disjunction-Sentinels"), seed);
+		vector<VarID> vars;
+		vector<IConstraint*> alternatives;
+		for (int i = 0; i < 3; ++i)
+		{
+			vars.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("A%d"), i}, SolverVariableDomain(0, 1)));
+			alternatives.push_back(solver.clause({SignedClause(vars.back(), vector{1})}));
+		}
+		solver.disjunction(alternatives);
+
+		auto heuristic = make_shared<ScriptedHeuristic>(solver);
+		solver.addDecisionHeuristic(heuristic);
+
+		heuristic->script = {make_tuple(vars[0], 0), make_tuple(vars[2], 0)};
+		EATEST_VERIFY(solver.solve() == EConstraintSolverResult::Solved);
+		EATEST_VERIFY(heuristic->decided == vector({vars[0], vars[2]}));
+		EATEST_VERIFY(solver.getSolvedValue(vars[1]) == 1);
+
+		heuristic->decided.clear();
+		heuristic->script = {make_tuple(vars[1], 0), make_tuple(vars[2], 0), make_tuple(vars[0], 0)};
+		EATEST_VERIFY(solver.solve() == EConstraintSolverResult::Solved);
+		EATEST_VERIFY(heuristic->decided == vector({vars[1], vars[2]}));
+		EATEST_VERIFY(solver.getSolvedValue(vars[0]) == 1);
+		EATEST_VERIFY(solver.getStats().numConstraintsLearned == 0);
+	}
+
+	// Every solution of a disjunction with more than two alternatives of different kinds, one of them a nested
+	// disjunction.
+	{
+		ConstraintSolver solver(TEXT("Disjunction-Enumerate"), seed);
+		const vector<vector<int>> valueLists = {
+			{0, 1, 2},
+			{0, 1, 2},
+			{0, 1, 2},
+			{0, 1, 2}
+		};
+		vector<VarID> vars = makeVariables(solver, valueLists);
+
+		solver.disjunction({
+			solver.disjunction(
+				solver.inequality(vars[0], EConstraintOperator::GreaterThan, vars[1]),
+				solver.inequality(vars[1], EConstraintOperator::GreaterThan, vars[2])
+			),
+			solver.inequality(vars[2], EConstraintOperator::GreaterThan, vars[3]),
+			solver.clause({SignedClause(vars[0], vector{2}), SignedClause(vars[3], vector{0})}),
+		});
+
+		AssignmentCheck check = [](const vector<int>& assignment)
+		{
+			return assignment[0] > assignment[1] ||
+				assignment[1] > assignment[2] ||
+				assignment[2] > assignment[3] ||
+				assignment[0] == 2 ||
+				assignment[3] == 0;
+		};
+
+		int numInvalid;
+		const int numSolutions = enumerateSolutions(solver, vars, check, numInvalid);
+		EATEST_VERIFY(numInvalid == 0);
+		EATEST_VERIFY(numSolutions == countAssignments(valueLists, check));
+	}
+
+	return nErrorCount;
+}
+
+int ConstraintTests::solveLinearGraph(int times, int seed, bool printVerbose)
+{
+	int nErrorCount = 0;
+	for (int time = 0; time < times; ++time)
+	{
+		ConstraintSolver solver(TEXT("Linear-Graph"), seed);
+
+		auto grid = make_shared<PlanarGridTopology>(LINEAR_GRID_SIZE, LINEAR_GRID_SIZE);
+		auto iGrid = IPlanarTopology::adapt(grid);
+		auto cells = solver.makeVariableGraph(TEXT("Cells"), iGrid, SolverVariableDomain(0, 3), TEXT("Cell"));
+
+		auto selfRel = make_shared<TTopologyLinkGraphRelation<VarID>>(iGrid, cells, TopologyLink::SELF);
+		auto rightRel = make_shared<TTopologyLinkGraphRelation<VarID>>(iGrid, cells, PlanarGridTopology::moveRight(1));
+		auto downRel = make_shared<TTopologyLinkGraphRelation<VarID>>(iGrid, cells, PlanarGridTopology::moveDown(1));
+
+		// Each cell plus its right and down neighbors sums to at most 4. Cells on the right/bottom edges are skipped.
+		solver.makeGraphConstraint<LinearConstraint>(grid,
+			vector<GraphVariableRelationPtr>{selfRel, rightRel, downRel},
+			EConstraintOperator::LessThanEq,
+			4
+		);
+		// 1 <= 2*cell - right <= 3
+		solver.makeGraphConstraint<LinearConstraint>(grid,
+			vector<GraphVariableRelationPtr>{selfRel, rightRel},
+			vector{2, -1},
+			1,
+			3
+		);
+
+		solver.solve();
+		solver.dumpStats(printVerbose);
+		EATEST_VERIFY(solver.getCurrentStatus() == EConstraintSolverResult::Solved);
+		if (solver.getCurrentStatus() != EConstraintSolverResult::Solved)
+		{
+			continue;
+		}
+
+		for (int y = 0; y < LINEAR_GRID_SIZE; ++y)
+		{
+			wstring row;
+			for (int x = 0; x < LINEAR_GRID_SIZE; ++x)
+			{
+				const int cell = solver.getSolvedValue(cells->get(grid->coordinateToIndex(x, y)));
+				row.append_sprintf(TEXT("%d "), cell);
+
+				if (x + 1 < LINEAR_GRID_SIZE)
+				{
+					const int right = solver.getSolvedValue(cells->get(grid->coordinateToIndex(x + 1, y)));
+					EATEST_VERIFY(2*cell - right >= 1 && 2*cell - right <= 3);
+
+					if (y + 1 < LINEAR_GRID_SIZE)
+					{
+						const int down = solver.getSolvedValue(cells->get(grid->coordinateToIndex(x, y + 1)));
+						EATEST_VERIFY(cell + right + down <= 4);
+					}
+				}
+			}
+			if (printVerbose)
+			{
+				VERTEXY_LOG("%s", row.c_str());
+			}
+		}
+	}
+
+	return nErrorCount;
+}
@@ -52,6 +52,9 @@ public:
 		MazeSolver::print(m_cells, m_edges, m_solver);
 	}
 
+	virtual bool wantsVariableNotifications() const override { return false; }
+	virtual bool wantsConflictActivity() const override { return false; }
+
 protected:
 	shared_ptr<TTopologyVertexData<VarID>> m_cells;
 	shared_ptr<TTopologyVertexData<VarID>> m_edges;
@@ -3,6 +3,7 @@
 
 #include "ConstraintSolver.h"
 #include "EATest/EATest.h"
+#include "constraints/AllDifferentConstraint.h"
 #include "constraints/TableConstraint.h"
 #include "constraints/IffConstraint.h"
 #include "topology/GridTopology.h"
@@ -13,37 +14,23 @@
 using namespace VertexyTests;
 
 int NQueensSolvers::solveUsingAllDifferent(int times, int n, int seed, bool printVerbose)
+{
+	return solveAllDifferent(times, n, seed, EAllDifferentPropagation::Bounds, printVerbose);
+}
+
+int NQueensSolvers::solveUsingAllDifferentDomain(int times, int n, int seed, bool printVerbose)
+{
+	return solveAllDifferent(times, n, seed, EAllDifferentPropagation::Domain, printVerbose);
+}
+
+int NQueensSolvers::solveAllDifferent(int times, int n, int seed, EAllDifferentPropagation propagation, bool printVerbose)
 {
 	int nErrorCount = 0;
 	for (int time = 0; time < times; ++time)
 	{
 		ConstraintSolver solver(TEXT("Queens-AllDifferent"), seed);
 
-		int maxTile = n - 1;
-		SolverVariableDomain domainX(0, maxTile);
-		SolverVariableDomain domainY(-maxTile, maxTile);
-		SolverVariableDomain domainZ(0, maxTile * 2);
-
-		vector<VarID> xs;
-		vector<VarID> ys;
-		vector<VarID> zs;
-
-		for (int i = 0; i < n; ++i)
-		{
-			xs.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("X%d"), i}, domainX));
-			ys.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("Y%d"), i}, domainY));
-			zs.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("Z%d"), i}, domainZ));
-		}
-
-		for (int i = 0; i < n; ++i)
-		{
-			solver.offset(ys[i], xs[i], -1 - i);
-			solver.offset(zs[i], xs[i], i + 1);
-		}
-
-		solver.allDifferent(xs);
-		solver.allDifferent(ys);
-		solver.allDifferent(zs);
+		vector<VarID> xs = createUsingAllDifferent(solver, n, propagation);
 
 		solver.solve();
 		solver.dumpStats(printVerbose);
@@ -136,92 +123,135 @@ int NQueensSolvers::solveUsingGraph(int times, int n, int seed, bool printVerbos
 	{
 		ConstraintSolver solver(TEXT("NQueens-Graph"), seed);
 
-		SolverVariableDomain domain(0, n - 1);
-		auto queenGraph = make_shared<PlanarGridTopology>(1, n);
-		auto queenGraphData = solver.makeVariableGraph(TEXT("Queens"), IPlanarTopology::adapt(queenGraph), domain, TEXT("QueenRow"));
+		vector<VarID> queens = createUsingGraph(solver, n);
+
+		solver.solve();
+		solver.dumpStats(printVerbose);
+
+		EATEST_VERIFY(solver.getCurrentStatus() == EConstraintSolverResult::Solved);
+		if (printVerbose)
+		{
+			print(n, &solver, queens);
+		}
+		nErrorCount += check(n, &solver, queens);
+	}
+	return nErrorCount;
+}
 
-		SolverVariableDomain tileDomain(0, 1);
-		auto tileGrid = make_shared<PlanarGridTopology>(n, n);
-		auto iTileGrid = IPlanarTopology::adapt(tileGrid);
+vector<VarID> NQueensSolvers::createUsingAllDifferent(ConstraintSolver& solver, int n)
+{
+	return createUsingAllDifferent(solver, n, EAllDifferentPropagation::Bounds);
+}
 
-		auto tileGridData = solver.makeVariableGraph(TEXT("Tiles"), iTileGrid, tileDomain, TEXT("Tile"));
-		auto selfRelation = make_shared<TTopologyLinkGraphRelation<VarID>>(iTileGrid, tileGridData, TopologyLink::SELF);
+vector<VarID> NQueensSolvers::createUsingAllDifferent(ConstraintSolver& solver, int n, EAllDifferentPropagation propagation)
+{
+	int maxTile = n - 1;
+	SolverVariableDomain domainX(0, maxTile);
+	SolverVariableDomain domainY(-maxTile, maxTile);
+	SolverVariableDomain domainZ(0, maxTile * 2);
 
-		auto tile_On = vector{1};
+	vector<VarID> xs;
+	vector<VarID> ys;
+	vector<VarID> zs;
 
-		//
-		// Link Tiles to be "on" iff a queen is on them
-		//
+	for (int i = 0; i < n; ++i)
+	{
+		xs.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("X%d"), i}, domainX));
+		ys.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("Y%d"), i}, domainY));
+		zs.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("Z%d"), i}, domainZ));
+	}
 
-		// Encodes relation of a given Tile -> that row's Queen on the tile.
-		class TileQueenRelation : public IGraphRelation<SignedClause>
-		{
-		public:
-			TileQueenRelation(const ConstraintSolver& solver, const shared_ptr<PlanarGridTopology>& topo, const shared_ptr<TTopologyVertexData<VarID>>& queens)
-				: m_solver(solver)
-				, m_topology(topo)
-				, m_queens(queens)
-			{
-			}
+	for (int i = 0; i < n; ++i)
+	{
+		solver.offset(ys[i], xs[i], -1 - i);
+		solver.offset(zs[i], xs[i], i + 1);
+	}
 
-			virtual wstring toString() const override { return TEXT("RowToQueen"); }
+	solver.allDifferent(xs, propagation);
+	solver.allDifferent(ys, propagation);
+	solver.allDifferent(zs, propagation);
 
-			virtual bool getRelation(int sourceNode, SignedClause& out) const override
-			{
-				int col, row;
-				m_topology->indexToCoordinate(sourceNode, col, row);
+	return xs;
+}
 
-				out.variable = m_queens->get(row);
-				out.values = {col};
-				return true;
-			}
+vector<VarID> NQueensSolvers::createUsingGraph(ConstraintSolver& solver, int n)
+{
+	SolverVariableDomain domain(0, n - 1);
+	auto queenGraph = make_shared<PlanarGridTopology>(1, n);
+	auto queenGraphData = solver.makeVariableGraph(TEXT("Queens"), IPlanarTopology::adapt(queenGraph), domain, TEXT("QueenRow"));
 
-			virtual size_t hash() const override { return 0; }
+	SolverVariableDomain tileDomain(0, 1);
+	auto tileGrid = make_shared<PlanarGridTopology>(n, n);
+	auto iTileGrid = IPlanarTopology::adapt(tileGrid);
 
-		protected:
-			const ConstraintSolver& m_solver;
-			shared_ptr<PlanarGridTopology> m_topology;
-			shared_ptr<TTopologyVertexData<VarID>> m_queens;
-		};
+	auto tileGridData = solver.makeVariableGraph(TEXT("Tiles"), iTileGrid, tileDomain, TEXT("Tile"));
+	auto selfRelation = make_shared<TTopologyLinkGraphRelation<VarID>>(iTileGrid, tileGridData, TopologyLink::SELF);
 
-		solver.makeGraphConstraint<IffConstraint>(tileGrid,
-			GraphRelationClause(selfRelation, tile_On),
-			vector<GraphClauseRelationPtr>{make_shared<TileQueenRelation>(solver, tileGrid, queenGraphData)}
-		);
+	auto tile_On = vector{1};
 
-		// board constraints
-		GraphRelationClause self_Off(selfRelation, EClauseSign::Outside, tile_On);
-		for (int i = 1; i < n; ++i)
+	//
+	// Link Tiles to be "on" iff a queen is on them
+	//
+
+	// Encodes relation of a given Tile -> that row's Queen on the tile.
+	class TileQueenRelation : public IGraphRelation<SignedClause>
+	{
+	public:
+		TileQueenRelation(const ConstraintSolver& solver, const shared_ptr<PlanarGridTopology>& topo, const shared_ptr<TTopologyVertexData<VarID>>& queens)
+			: m_solver(solver)
+			, m_topology(topo)
+			, m_queens(queens)
 		{
-			auto upRelation = make_shared<TTopologyLinkGraphRelation<VarID>>(iTileGrid, tileGridData, PlanarGridTopology::moveUp(i));
-			auto downRelation = make_shared<TTopologyLinkGraphRelation<VarID>>(iTileGrid, tileGridData, PlanarGridTopology::moveDown(i));
-			auto downRightRelation = make_shared<TTopologyLinkGraphRelation<VarID>>(iTileGrid, tileGridData, PlanarGridTopology::moveDown(i).combine(PlanarGridTopology::moveRight(i)));
-			auto downLeftRelation = make_shared<TTopologyLinkGraphRelation<VarID>>(iTileGrid, tileGridData, PlanarGridTopology::moveDown(i).combine(PlanarGridTopology::moveLeft(i)));
-
-			solver.makeGraphConstraint<ClauseConstraint>(tileGrid, vector{
-				self_Off, GraphRelationClause(downRelation, EClauseSign::Outside, tile_On)
-			});
-
-			solver.makeGraphConstraint<ClauseConstraint>(tileGrid, vector{
-				self_Off, GraphRelationClause(downRightRelation, EClauseSign::Outside, tile_On)
-			});
-
-			solver.makeGraphConstraint<ClauseConstraint>(tileGrid, vector{
-				self_Off, GraphRelationClause(downLeftRelation, EClauseSign::Outside, tile_On)
-			});
 		}
 
-		solver.solve();
-		solver.dumpStats(printVerbose);
+		virtual wstring toString() const override { return TEXT("RowToQueen"); }
 
-		EATEST_VERIFY(solver.getCurrentStatus() == EConstraintSolverResult::Solved);
-		if (printVerbose)
+		virtual bool getRelation(int sourceNode, SignedClause& out) const override
 		{
-			print(n, &solver, queenGraphData->getData());
+			int col, row;
+			m_topology->indexToCoordinate(sourceNode, col, row);
+
+			out.variable = m_queens->get(row);
+			out.values = {col};
+			return true;
 		}
-		nErrorCount += check(n, &solver, queenGraphData->getData());
+
+		virtual size_t hash() const override { return 0; }
+
+	protected:
+		const ConstraintSolver& m_solver;
+		shared_ptr<PlanarGridTopology> m_topology;
+		shared_ptr<TTopologyVertexData<VarID>> m_queens;
+	};
+
+	solver.makeGraphConstraint<IffConstraint>(tileGrid,
+		GraphRelationClause(selfRelation, tile_On),
+		vector<GraphClauseRelationPtr>{make_shared<TileQueenRelation>(solver, tileGrid, queenGraphData)}
+	);
+
+	// board constraints
+	GraphRelationClause self_Off(selfRelation, EClauseSign::Outside, tile_On);
+	for (int i = 1; i < n; ++i)
+	{
+		auto upRelation = make_shared<TTopologyLinkGraphRelation<VarID>>(iTileGrid, tileGridData, PlanarGridTopology::moveUp(i));
+		auto downRelation = make_shared<TTopologyLinkGraphRelation<VarID>>(iTileGrid, tileGridData, PlanarGridTopology::moveDown(i));
+		auto downRightRelation = make_shared<TTopologyLinkGraphRelation<VarID>>(iTileGrid, tileGridData, PlanarGridTopology::moveDown(i).combine(PlanarGridTopology::moveRight(i)));
+		auto downLeftRelation = make_shared<TTopologyLinkGraphRelation<VarID>>(iTileGrid, tileGridData, PlanarGridTopology::moveDown(i).combine(PlanarGridTopology::moveLeft(i)));
+
+		solver.makeGraphConstraint<ClauseConstraint>(tileGrid, vector{
+			self_Off, GraphRelationClause(downRelation, EClauseSign::Outside, tile_On)
+		});
+
+		solver.makeGraphConstraint<ClauseConstraint>(tileGrid, vector{
+			self_Off, GraphRelationClause(downRightRelation, EClauseSign::Outside, tile_On)
+		});
+
+		solver.makeGraphConstraint<ClauseConstraint>(tileGrid, vector{
+			self_Off, GraphRelationClause(downLeftRelation, EClauseSign::Outside, tile_On)
+		});
 	}
-	return nErrorCount;
+
+	return queenGraphData->getData();
 }
 
 void NQueensSolvers::print(int n, ConstraintSolver* solver, const vector<VarID>& vars)
@@ -0,0 +1,1084 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+#include "SearchTests.h"
+
+#include <EASTL/hash_map.h>
+#include <EASTL/hash_set.h>
+
+#include "ConstraintSolver.h"
+#include "EATest/EATest.h"
+#include "NQueens.h"
+#include "constraints/ClauseConstraint.h"
+#include "constraints/ClauseSignature.h"
+#include "decision/EntropyHeuristic.h"
+#include "decision/LookaheadHeuristic.h"
+#include "topology/TopologyVertexData.h"
+#include "variable/SolverVariableDomain.h"
+
+using namespace VertexyTests;
+
+static constexpr int MINIMIZATION_NQUEENS_SIZE = 20;
+static constexpr int PHASES_NQUEENS_SIZE = 25;
+static constexpr int ENTROPY_NQUEENS_SIZE = 16;
+static constexpr int LOCALITY_NQUEENS_SIZE = 12;
+static constexpr int TRAIL_REUSE_NQUEENS_SIZE = 25;
+
+namespace
+{
+
+// Entropy heuristic that checks, before each decision, that the weight sums it maintained incrementally match a
+// recomputation from the variables' current values.
+class CheckedEntropyHeuristic : public EntropyHeuristic
+{
+public:
+	CheckedEntropyHeuristic(ConstraintSolver& solver)
+		: EntropyHeuristic(solver)
+	{
+	}
+
+	virtual bool getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues) override
+	{
+		auto db = m_solver.getVariableDB();
+		for (int i = 1; i < m_weights.size(); ++i)
+		{
+			const VarID varID(i);
+			if (!isManaged(varID))
+			{
+				continue;
+			}
+
+			double weightSum = 0.0, weightLogWeightSum = 0.0;
+			const ValueSet& potentials = db->getPotentialValues(varID);
+			for (auto it = potentials.beginSetBits(), itEnd = potentials.endSetBits(); it != itEnd; ++it)
+			{
+				const double weight = (*m_weights[i])[*it];
+				weightSum += weight;
+				weightLogWeightSum += weight * log(weight);
+			}
+
+			++numChecks;
+			if (!isClose(weightSum, m_weightSums[i]) || !isClose(weightLogWeightSum, m_weightLogWeightSums[i]))
+			{
+				++numMismatches;
+			}
+
+			const double entropy = log(weightSum) - weightLogWeightSum / weightSum + m_noise[i];
+			if (!isClose(entropy, m_entropies[i]))
+			{
+				++numMismatches;
+			}
+
+			// Every unsolved variable must be in the heap, and none can have lower entropy than the top.
+			if (!potentials.isSingleton())
+			{
+				if (!m_heap.inHeap(i) || m_entropies[i] < m_entropies[m_heap.peek()])
+				{
+					++numMismatches;
+				}
+			}
+		}
+
+		return EntropyHeuristic::getNextDecision(level, var, chosenValues);
+	}
+
+	int numChecks = 0;
+	int numMismatches = 0;
+
+protected:
+	static bool isClose(double a, double b)
+	{
+		return fabs(a - b) <= 1e-6 * max(1.0, fabs(a));
+	}
+};
+
+// Decides on the unsolved variable with the highest fixed priority, choosing its lowest value.
+// Solver must be set before solving starts.
+class FixedPriorityHeuristic : public ISolverDecisionHeuristic
+{
+public:
+	virtual bool getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues) override
+	{
+		if (!getBestUnsolved(var))
+		{
+			return false;
+		}
+
+		auto db = solver->getVariableDB();
+		chosenValues.pad(db->getDomainSize(var), false);
+		chosenValues[db->getPotentialValues(var).indexOf(true)] = true;
+		return true;
+	}
+
+	virtual double getPriority(VarID varID, int value) const override
+	{
+		auto found = priorities.find(varID);
+		return found != priorities.end() ? found->second : 0.0;
+	}
+
+	virtual bool getNextDecisionPriority(double& outPriority) override
+	{
+		VarID var;
+		if (!getBestUnsolved(var))
+		{
+			return false;
+		}
+		outPriority = getPriority(var, 0);
+		return true;
+	}
+
+	ConstraintSolver* solver = nullptr;
+	hash_map<VarID, double> priorities;
+
+protected:
+	bool getBestUnsolved(VarID& outVar) const
+	{
+		auto db = solver->getVariableDB();
+		outVar = VarID::INVALID;
+		for (auto& [var, priority] : priorities)
+		{
+			if (!db->isSolved(var) && (!outVar.isValid() || priority > getPriority(outVar, 0)))
+			{
+				outVar = var;
+			}
+		}
+		return outVar.isValid();
+	}
+};
+
+// Probes a fixed set of decisions at the first decision level, checking that each probe leaves the solver's state as
+// it found it. Defers the actual decision to the rest of the heuristic stack.
+class ProbingHeuristic : public ISolverDecisionHeuristic
+{
+public:
+	ProbingHeuristic(ConstraintSolver& solver)
+		: m_solver(solver)
+	{
+	}
+
+	virtual bool getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues) override
+	{
+		if (probed)
+		{
+			return false;
+		}
+		probed = true;
+
+		auto db = m_solver.getVariableDB();
+		for (auto& [probeVar, probeValue] : probes)
+		{
+			const SolverTimestamp prevTimestamp = db->getTimestamp();
+			vector<ValueSet> prevValues;
+			vector<int> prevPhases;
+			for (int i = 1; i <= db->getNumVariables(); ++i)
+			{
+				prevValues.push_back(db->getPotentialValues(VarID(i)));
+				int phase;
+				prevPhases.push_back(db->getLastSolvedValue(VarID(i), phase) ? phase : -1);
+			}
+
+			int numModifications = 0;
+			results.push_back(m_solver.probeDecision(probeVar, probeValue, numModifications));
+			modifications.push_back(numModifications);
+
+			if (db->getTimestamp() != prevTimestamp || m_solver.getCurrentDecisionLevel() != level)
+			{
+				++numMismatches;
+			}
+			for (int i = 1; i <= db->getNumVariables(); ++i)
+			{
+				int phase;
+				if (db->getPotentialValues(VarID(i)) != prevValues[i-1] ||
+					(db->getLastSolvedValue(VarID(i), phase) ? phase : -1) != prevPhases[i-1])
+				{
+					++numMismatches;
+				}
+			}
+		}
+		return false;
+	}
+
+	virtual bool wantsVariableNotifications() const override { return false; }
+	virtual bool wantsConflictActivity() const override { return false; }
+
+	// Variable + internal value index to probe
+	vector<tuple<VarID, int>> probes;
+	bool probed = false;
+	// Whether each probe succeeded, and how many modifications it made
+	vector<bool> results;
+	vector<int> modifications;
+	int numMismatches = 0;
+
+protected:
+	ConstraintSolver& m_solver;
+};
+
+// Decides on the first variable in the script that is unsolved and can still take the scripted value.
+class ScriptedHeuristic : public ISolverDecisionHeuristic
+{
+public:
+	ScriptedHeuristic(const ConstraintSolver& solver)
+		: m_solver(solver)
+	{
+	}
+
+	virtual bool getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues) override
+	{
+		for (auto& [scriptVar, valueIndex] : script)
+		{
+			if (m_solver.isSolved(scriptVar) || !m_solver.getVariableDB()->getPotentialValues(scriptVar)[valueIndex])
+			{
+				continue;
+			}
+
+			var = scriptVar;
+			chosenValues.pad(m_solver.getVariableDB()->getDomainSize(var), false);
+			chosenValues[valueIndex] = true;
+			return true;
+		}
+		return false;
+	}
+
+	virtual bool wantsVariableNotifications() const override { return false; }
+	virtual bool wantsConflictActivity() const override { return false; }
+
+	// Variable + internal value index to decide on
+	vector<tuple<VarID, int>> script;
+
+protected:
+	const ConstraintSolver& m_solver;
+};
+
+// Never makes decisions, but counts the notifications it receives. If batched, also checks that the ranges reported
+// line up with each other: every assignment is reported once, and only assigned entries are reported as unassigned.
+class CountingHeuristic : public ISolverDecisionHeuristic
+{
+public:
+	CountingHeuristic(bool variableNotifications, bool batched, bool conflictActivity)
+		: m_variableNotifications(variableNotifications)
+		, m_batched(batched)
+		, m_conflictActivity(conflictActivity)
+	{
+	}
+
+	virtual bool getNextDecision(SolverDecisionLevel level, VarID& var, ValueSet& chosenValues) override { return false; }
+
+	virtual void onVariableAssignment(VarID var, const ValueSet& prevValues, const ValueSet& newValues) override
+	{
+		++numAssignments;
+	}
+
+	virtual void onVariableUnassignment(VarID var, const ValueSet& beforeBacktrack, const ValueSet& afterBacktrack) override
+	{
+		++numUnassignments;
+	}
+
+	virtual void onVariablesAssigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last) override
+	{
+		if ((m_reportedUpTo >= -1 && first != m_reportedUpTo+1) || first > last || last > db.getAssignmentStack().getMostRecentTimestamp())
+		{
+			++numBadRanges;
+		}
+		m_reportedUpTo = last;
+		numAssignments += last - first + 1;
+	}
+
+	virtual void onVariablesUnassigned(const SolverVariableDatabase& db, SolverTimestamp first, SolverTimestamp last) override
+	{
+		if ((m_reportedUpTo >= -1 && last != m_reportedUpTo) || first > last)
+		{
+			++numBadRanges;
+		}
+		m_reportedUpTo = first-1;
+		numUnassignments += last - first + 1;
+	}
+
+	virtual void onVariableConflictActivity(VarID var, const ValueSet& values, const ValueSet& prevValues) override
+	{
+		++numConflictActivity;
+	}
+
+	virtual void onClauseLearned() override { ++numClausesLearned; }
+
+	virtual bool wantsVariableNotifications() const override { return m_variableNotifications; }
+	virtual bool wantsBatchedNotifications() const override { return m_batched; }
+	virtual bool wantsConflictActivity() const override { return m_conflictActivity; }
+
+	// The assignment stack is reset after initial arc consistency, so ranges can only be checked after that.
+	void resetRanges() { m_reportedUpTo = -2; }
+
+	int numAssignments = 0;
+	int numUnassignments = 0;
+	int numConflictActivity = 0;
+	int numClausesLearned = 0;
+	int numBadRanges = 0;
+
+protected:
+	bool m_variableNotifications;
+	bool m_batched;
+	bool m_conflictActivity;
+	// Last assignment stack entry reported as assigned, or -2 if nothing has been reported yet.
+	SolverTimestamp m_reportedUpTo = -2;
+};
+
+}
+
+int SearchTests::clauseSignatureTests()
+{
+	int nErrorCount = 0;
+
+	auto makeLiteral = [](uint32_t var, int numValues, int value)
+	{
+		ValueSet values(numValues, false);
+		values[value] = true;
+		return Literal(VarID(var), move(values));
+	};
+
+	vector<Literal> lits = {makeLiteral(3, 4, 1), makeLiteral(1, 4, 2), makeLiteral(2, 8, 7)};
+	vector<Literal> reordered = {lits[2], lits[0], lits[1]};
+
+	ClauseSignature signature(lits);
+	ClauseSignature reorderedSignature(reordered);
+	EATEST_VERIFY(signature == reorderedSignature);
+	EATEST_VERIFY(signature.getHash() == reorderedSignature.getHash());
+	EATEST_VERIFY(signature.getLiterals()[0].variable == VarID(1));
+	EATEST_VERIFY(signature.getLiterals()[2].variable == VarID(3));
+
+	// Hashing unsorted literals directly must agree with the signature, regardless of order.
+	EATEST_VERIFY(ClauseSignature::hashLiterals(lits.data(), lits.size()) == signature.getHash());
+	EATEST_VERIFY(ClauseSignature::hashLiterals(reordered.data(), reordered.size()) == signature.getHash());
+	EATEST_VERIFY(signature.matches(reordered.data(), reordered.size()));
+
+	// Swapping values between variables must change the hash, unlike a sum of per-literal hashes.
+	vector<Literal> swapped = {makeLiteral(3, 4, 2), makeLiteral(1, 4, 1), makeLiteral(2, 8, 7)};
+	ClauseSignature swappedSignature(swapped);
+	EATEST_VERIFY(swappedSignature != signature);
+	EATEST_VERIFY(!signature.matches(swapped.data(), swapped.size()));
+
+	// Literals on the same variable are merged.
+	vector<Literal> split = {makeLiteral(1, 4, 2), makeLiteral(3, 4, 1), makeLiteral(2, 8, 7), makeLiteral(1, 4, 3)};
+	ClauseSignature splitSignature(split);
+	EATEST_VERIFY(splitSignature.size() == 3);
+	EATEST_VERIFY(splitSignature.getLiterals()[0].values[2] && splitSignature.getLiterals()[0].values[3]);
+	EATEST_VERIFY(!signature.matches(split.data(), split.size()));
+
+	// Learned clauses with the same literals in a different order are duplicates.
+	ConstraintSolver solver(TEXT("ClauseSignature"), 0);
+	solver.makeVariable(TEXT("X1"), SolverVariableDomain(0, 3));
+	solver.makeVariable(TEXT("X2"), SolverVariableDomain(0, 3));
+	solver.makeVariable(TEXT("X3"), SolverVariableDomain(0, 7));
+	solver.makeVariable(TEXT("X4"), SolverVariableDomain(0, 7));
+
+	auto clause = solver.makeConstraint<ClauseConstraint>(lits, true);
+	auto reorderedClause = solver.makeConstraint<ClauseConstraint>(reordered, true);
+	auto swappedClause = solver.makeConstraint<ClauseConstraint>(swapped, true);
+	vector<Literal> otherVariable = {makeLiteral(3, 4, 1), makeLiteral(1, 4, 2), makeLiteral(4, 8, 7)};
+	auto otherVariableClause = solver.makeConstraint<ClauseConstraint>(otherVariable, true);
+
+	ConstraintHashFuncs hashFuncs;
+	EATEST_VERIFY(hashFuncs(clause) == hashFuncs(reorderedClause));
+	EATEST_VERIFY(hashFuncs(clause, reorderedClause));
+	EATEST_VERIFY(hashFuncs(reorderedClause, clause));
+	EATEST_VERIFY(!hashFuncs(clause, swappedClause));
+	EATEST_VERIFY(!hashFuncs(clause, otherVariableClause));
+	EATEST_VERIFY(!hashFuncs(otherVariableClause, clause));
+	// Comparisons must not leave anything behind that affects the next one.
+	EATEST_VERIFY(hashFuncs(clause, clause));
+	EATEST_VERIFY(hashFuncs(clause, signature) && hashFuncs(signature, reorderedClause));
+
+	return nErrorCount;
+}
+
+int SearchTests::modeSwitchingTests(int seed)
+{
+	int nErrorCount = 0;
+
+	SolverConfig config;
+	config.enableModeSwitching = true;
+	config.modeSwitchInitialConflicts = 10;
+	config.modeSwitchGrowth = 1.5f;
+
+	// Pigeonhole problem: can't fit 7 pigeons in 6 holes, and proving it takes plenty of conflicts.
+	ConstraintSolver solver(TEXT("ModeSwitching"), seed, nullptr, config);
+	SolverVariableDomain domain(0, 5);
+
+	vector<VarID> pigeons;
+	for (int i = 0; i < 7; ++i)
+	{
+		pigeons.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("Pigeon%d"), i}, domain));
+	}
+
+	for (int i = 0; i < pigeons.size(); ++i)
+	{
+		for (int j = i+1; j < pigeons.size(); ++j)
+		{
+			solver.inequality(pigeons[i], EConstraintOperator::NotEqual, pigeons[j]);
+		}
+	}
+
+	// With no base heuristic given, the first heuristic on the stack switches between the focused/stable ones.
+	auto modeHeuristic = static_cast<const ModeSwitchingHeuristic*>(solver.getDecisionHeuristics()[0].get());
+
+	int numSwitches = 0;
+	int numMismatches = 0;
+	int numEarlySwitches = 0;
+	bool stable = false;
+	float modeLength = float(config.modeSwitchInitialConflicts);
+	uint32_t learnedAtLastSwitch = 0;
+
+	EConstraintSolverResult result = solver.startSolving();
+	EATEST_VERIFY(!solver.isInStableMode());
+	while (result == EConstraintSolverResult::Unsolved)
+	{
+		result = solver.step();
+		if (modeHeuristic->isStableMode() != solver.isInStableMode())
+		{
+			++numMismatches;
+		}
+
+		if (solver.isInStableMode() != stable)
+		{
+			// Every clause learned counts towards the mode's length, so a switch can't happen before that.
+			const uint32_t learned = solver.getStats().numConstraintsLearned;
+			if (float(learned - learnedAtLastSwitch) < modeLength)
+			{
+				++numEarlySwitches;
+			}
+
+			stable = solver.isInStableMode();
+			learnedAtLastSwitch = learned;
+			modeLength *= config.modeSwitchGrowth;
+			++numSwitches;
+		}
+	}
+
+	EATEST_VERIFY(result == EConstraintSolverResult::Unsatisfiable);
+	EATEST_VERIFY(numSwitches >= 2);
+	EATEST_VERIFY(numMismatches == 0);
+	EATEST_VERIFY(numEarlySwitches == 0);
+
+	// Without mode switching, the solver stays in focused mode.
+	ConstraintSolver control(TEXT("ModeSwitchingControl"), seed);
+	SolverVariableDomain controlDomain(0, 3);
+	VarID x = control.makeVariable(TEXT("X"), controlDomain);
+	VarID y = control.makeVariable(TEXT("Y"), controlDomain);
+	control.inequality(x, EConstraintOperator::NotEqual, y);
+
+	result = control.startSolving();
+	while (result == EConstraintSolverResult::Unsolved)
+	{
+		EATEST_VERIFY(!control.isInStableMode());
+		result = control.step();
+	}
+	EATEST_VERIFY(result == EConstraintSolverResult::Solved);
+
+	return nErrorCount;
+}
+
+int SearchTests::lrbParticipationTests(int seed)
+{
+	int nErrorCount = 0;
+
+	ConstraintSolver solver(TEXT("LRB-Participation"), seed);
+	VarID var = solver.makeVariable(TEXT("X"), SolverVariableDomain(0, 2));
+	VarID other = solver.makeVariable(TEXT("Y"), SolverVariableDomain(0, 2));
+
+	LRBHeuristic heuristic(solver);
+	heuristic.initialize();
+
+	double prevPriorities[3];
+	for (int value = 0; value < 3; ++value)
+	{
+		prevPriorities[value] = heuristic.getPriority(var, value);
+	}
+
+	const double prevOtherPriority = heuristic.getPriority(other, 0);
+
+	ValueSet allValues(3, true);
+	ValueSet solvedValues(3, false);
+	solvedValues[1] = true;
+	ValueSet clauseValues(3, false);
+	clauseValues[0] = true;
+	clauseValues[2] = true;
+
+	for (int round = 0; round < 10; ++round)
+	{
+		// Solve X to 1, which takes all of its values out of the heap.
+		heuristic.onVariableAssignment(var, allValues, solvedValues);
+
+		// A learned clause requiring X to be 0 or 2: both values were ruled out, but should be credited.
+		heuristic.onVariableConflictActivity(var, clauseValues, solvedValues);
+		// Y is unassigned, so its values are still in the heap and shouldn't be credited.
+		heuristic.onVariableConflictActivity(other, clauseValues, allValues);
+		heuristic.onClauseLearned();
+
+		// Values only get their new priority when they are put back in the heap.
+		heuristic.onVariableUnassignment(var, solvedValues, allValues);
+
+		EATEST_VERIFY(heuristic.getPriority(var, 0) > prevPriorities[0]);
+		EATEST_VERIFY(heuristic.getPriority(var, 2) > prevPriorities[2]);
+		EATEST_VERIFY(heuristic.getPriority(var, 1) <= prevPriorities[1]);
+		for (int value = 0; value < 3; ++value)
+		{
+			prevPriorities[value] = heuristic.getPriority(var, value);
+		}
+	}
+
+	// After repeatedly participating in conflicts, the credited values must be preferred.
+	EATEST_VERIFY(heuristic.getPriority(var, 0) > heuristic.getPriority(var, 1));
+	EATEST_VERIFY(heuristic.getPriority(var, 2) > heuristic.getPriority(var, 1));
+	EATEST_VERIFY(heuristic.getPriority(other, 0) == prevOtherPriority);
+
+	return nErrorCount;
+}
+
+int SearchTests::heuristicNotificationTests(int seed)
+{
+	int nErrorCount = 0;
+
+	// Pigeonhole problem: can't fit 6 pigeons in 5 holes, so there are plenty of conflicts and backtracks.
+	ConstraintSolver solver(TEXT("HeuristicNotifications"), seed);
+	SolverVariableDomain domain(0, 4);
+
+	vector<VarID> pigeons;
+	for (int i = 0; i < 6; ++i)
+	{
+		pigeons.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("Pigeon%d"), i}, domain));
+	}
+
+	for (int i = 0; i < pigeons.size(); ++i)
+	{
+		for (int j = i+1; j < pigeons.size(); ++j)
+		{
+			solver.inequality(pigeons[i], EConstraintOperator::NotEqual, pigeons[j]);
+		}
+	}
+
+	auto optedOut = make_shared<CountingHeuristic>(false, false, false);
+	auto immediate = make_shared<CountingHeuristic>(true, false, true);
+	auto batched = make_shared<CountingHeuristic>(true, true, false);
+	solver.addDecisionHeuristic(optedOut);
+	solver.addDecisionHeuristic(immediate);
+	solver.addDecisionHeuristic(batched);
+
+	EConstraintSolverResult result = solver.startSolving();
+	batched->resetRanges();
+	while (result == EConstraintSolverResult::Unsolved)
+	{
+		result = solver.step();
+	}
+	EATEST_VERIFY(result == EConstraintSolverResult::Unsatisfiable);
+
+	// Heuristics that opted out of an event must never receive it, but still hear about learned clauses.
+	EATEST_VERIFY(optedOut->numAssignments == 0);
+	EATEST_VERIFY(optedOut->numUnassignments == 0);
+	EATEST_VERIFY(optedOut->numConflictActivity == 0);
+	EATEST_VERIFY(optedOut->numClausesLearned > 0);
+	EATEST_VERIFY(batched->numConflictActivity == 0);
+
+	EATEST_VERIFY(immediate->numAssignments > 0);
+	EATEST_VERIFY(immediate->numUnassignments > 0);
+	EATEST_VERIFY(immediate->numConflictActivity > 0);
+	EATEST_VERIFY(immediate->numClausesLearned == optedOut->numClausesLearned);
+
+	EATEST_VERIFY(batched->numAssignments > 0);
+	EATEST_VERIFY(batched->numUnassignments > 0);
+	EATEST_VERIFY(batched->numBadRanges == 0);
+	// Anything reported as assigned and never unassigned is still on the stack.
+	EATEST_VERIFY(batched->numAssignments >= batched->numUnassignments);
+
+	return nErrorCount;
+}
+
+int SearchTests::trailReuseTests(int seed)
+{
+	int nErrorCount = 0;
+
+	for (bool enableTrailReuse : {false, true})
+	{
+		SolverConfig config;
+		config.enableTrailReuse = enableTrailReuse;
+
+		// Trail reuse is only possible when the base heuristic is the only one.
+		auto heuristic = make_shared<FixedPriorityHeuristic>();
+		ConstraintSolver solver(TEXT("TrailReuse"), seed, heuristic, config);
+		heuristic->solver = &solver;
+
+		// Unconstrained variables, decided in order of priority.
+		vector<VarID> vars;
+		for (int i = 0; i < 5; ++i)
+		{
+			vars.push_back(solver.makeVariable({wstring::CtorSprintf(), TEXT("V%d"), i}, SolverVariableDomain(0, 1)));
+			heuristic->priorities[vars.back()] = double(5 - i);
+		}
+
+		EATEST_VERIFY(solver.startSolving() == EConstraintSolverResult::Unsolved);
+		for (int i = 0; i < 3; ++i)
+		{
+			solver.step();
+		}
+		EATEST_VERIFY(solver.getCurrentDecisionLevel() == 3);
+		EATEST_VERIFY(solver.getVariableDB()->isSolved(vars[0]));
+		EATEST_VERIFY(solver.getVariableDB()->isSolved(vars[2]));
+		EATEST_VERIFY(!solver.getVariableDB()->isSolved(vars[3]));
+
+		// Every decision would be made again before V3, so all are kept.
+		EATEST_VERIFY(solver.getRestartLevel() == (enableTrailReuse ? 3 : 0));
+
+		// V4 would now be picked after V0 but before V1, so only the first decision is kept.
+		heuristic->priorities[vars[4]] = 4.5;
+		EATEST_VERIFY(solver.getRestartLevel() == (enableTrailReuse ? 1 : 0));
+
+		// V4 would now be picked first, so nothing is kept.
+		heuristic->priorities[vars[4]] = 10.0;
+		EATEST_VERIFY(solver.getRestartLevel() == 0);
+
+		while (solver.step() == EConstraintSolverResult::Unsolved)
+		{
+		}
+		EATEST_VERIFY(solver.getCurrentStatus() == EConstraintSolverResult::Solved);
+	}
+
+	return nErrorCount;
+}
+
+int SearchTests::lookaheadTests(int seed)
+{
+	int nErrorCount = 0;
+
+	// A=1 is a failed literal: it implies both B=1 and B=0. C=1 implies D=1.
+	auto createProblem = [](ConstraintSolver& solver, vector<VarID>& outVars)
+	{
+		for (const wchar_t* name : {TEXT("A"), TEXT("B"), TEXT("C"), TEXT("D")})
+		{
+			outVars.push_back(solver.makeBoolean(name));
+		}
+		solver.clause({SignedClause(outVars[0], {0}), SignedClause(outVars[1], {1})});
+		solver.clause({SignedClause(outVars[0], {0}), SignedClause(outVars[1], {0})});
+		solver.clause({SignedClause(outVars[2], {0}), SignedClause(outVars[3], {1})});
+	};
+
+	// Probing must restore the trail, potential values, and saved phases.
+	{
+		ConstraintSolver solver(TEXT("Probe"), seed);
+		vector<VarID> vars;
+		createProblem(solver, vars);
+
+		auto prober = make_shared<ProbingHeuristic>(solver);
+		prober->probes = {{vars[2], 1}, {vars[0], 1}, {vars[0], 0}};
+		solver.addDecisionHeuristic(prober);
+
+		EATEST_VERIFY(solver.startSolving() == EConstraintSolverResult::Unsolved);
+		// A saved phase that a probe assigning D could overwrite
+		solver.getVariableDB()->setLastSolvedValue(vars[3], 0);
+
+		while (solver.step() == EConstraintSolverResult::Unsolved)
+		{
+		}
+		EATEST_VERIFY(solver.getCurrentStatus() == EConstraintSolverResult::Solved);
+
+		EATEST_VERIFY(prober->results.size() == 3);
+		if (prober->results.size() == 3)
+		{
+			EATEST_VERIFY(prober->results[0] && prober->modifications[0] >= 2);
+			EATEST_VERIFY(!prober->results[1]);
+			EATEST_VERIFY(prober->results[2]);
+		}
+		EATEST_VERIFY(prober->numMismatches == 0);
+	}
+
+	// The lookahead heuristic decides on the failed literal, so that it is excluded by a unit clause at the root.
+	{
+		ConstraintSolver solver(TEXT("Lookahead"), seed);
+		vector<VarID> vars;
+		createProblem(solver, vars);
+		solver.addDecisionHeuristic(make_shared<LookaheadHeuristic>(solver));
+
+		EATEST_VERIFY(solver.startSolving() == EConstraintSolverResult::Unsolved);
+		EATEST_VERIFY(!solver.getVariableDB()->isSolved(vars[0]));
+
+		for (int i = 0; i < 4 && !solver.getVariableDB()->isSolved(vars[0]); ++i)
+		{
+			solver.step();
+		}
+		EATEST_VERIFY(solver.getVariableDB()->isSolved(vars[0]));
+		EATEST_VERIFY(solver.getVariableDB()->getLastModificationLevel(vars[0]) == 0);
+		EATEST_VERIFY(solver.getSolvedValue(vars[0]) == 0);
+		EATEST_VERIFY(solver.getStats().numConstraintsLearned > 0);
+
+		while (solver.step() == EConstraintSolverResult::Unsolved)
+		{
+		}
+		EATEST_VERIFY(solver.getCurrentStatus() == EConstraintSolverResult::Solved);
+		EATEST_VERIFY(solver.getSolvedValue(vars[2]) == 0 || solver.getSolvedValue(vars[3]) == 1);
+	}
+
+	return nErrorCount;
+}
+
+int SearchTests::rephaseTests(int seed)
+{
+	int nErrorCount = 0;
+
+	SolverConfig config;
+	config.restartPolicy = ERestartPolicy::None;
+	config.enableRephasing = true;
+	config.rephaseInitialConflicts = 2;
+
+	ConstraintSolver solver(TEXT("Rephase"), seed, nullptr, config);
+	VarID x = solver.makeBoolean(TEXT("X"));
+	VarID y = solver.makeBoolean(TEXT("Y"));
+	VarID z = solver.makeBoolean(TEXT("Z"));
+
+	// A=0 and C=0 are failed literals, so deciding on either leads to a conflict that goes back to the first level.
+	VarID a = solver.makeBoolean(TEXT("A"));
+	VarID b = solver.makeBoolean(TEXT("B"));
+	VarID c = solver.makeBoolean(TEXT("C"));
+	VarID d = solver.makeBoolean(TEXT("D"));
+	solver.clause({SignedClause(a, {1}), SignedClause(b, {1})});
+	solver.clause({SignedClause(a, {1}), SignedClause(b, {0})});
+	solver.clause({SignedClause(c, {1}), SignedClause(d, {1})});
+	solver.clause({SignedClause(c, {1}), SignedClause(d, {0})});
+
+	auto heuristic = make_shared<ScriptedHeuristic>(solver);
+	solver.addDecisionHeuristic(heuristic);
+
+	auto stepUntilConflicts = [&](uint32_t numConflicts)
+	{
+		while (solver.getStats().numConstraintsLearned < numConflicts && solver.step() == EConstraintSolverResult::Unsolved)
+		{
+		}
+	};
+
+	EATEST_VERIFY(solver.startSolving() == EConstraintSolverResult::Unsolved);
+
+	// The first conflict records X=1 in the best phase, from a conflict-free trail of X, Y, and Z. It isn't yet time
+	// to rephase.
+	heuristic->script = {{x, 1}, {y, 1}, {z, 1}, {a, 0}};
+	stepUntilConflicts(1);
+	EATEST_VERIFY(solver.getCurrentDecisionLevel() == 0);
+	EATEST_VERIFY(solver.getVariableDB()->isSolved(a));
+
+	// The second conflict has a shorter conflict-free trail, so the best phase is kept. Phase saving records X=0 when
+	// backtracking, but the rephase to the best phase that follows must win.
+	heuristic->script = {{x, 0}, {c, 0}};
+	stepUntilConflicts(2);
+	EATEST_VERIFY(solver.getCurrentDecisionLevel() == 0);
+	EATEST_VERIFY(solver.getVariableDB()->isSolved(c));
+
+	int phase;
+	EATEST_VERIFY(solver.getVariableDB()->getLastSolvedValue(x, phase) && phase == 1);
+
+	while (solver.step() == EConstraintSolverResult::Unsolved)
+	{
+	}
+	EATEST_VERIFY(solver.getCurrentStatus() == EConstraintSolverResult::Solved);
+
+	return nErrorCount;
+}
+
+int SearchTests::solveLearnedClauseMinimization(int times, int seed, bool printVerbose)
+{
+	int nErrorCount = 0;
+	for (int time = 0; time < times; ++time)
+	{
+		// Run the graph and non-graph version of the problem, since minimization is restricted for clauses that can
+		// be promoted to graph constraints.
+		for (bool useGraph : {false, true})
+		{
+			SolverConfig minimizedConfig;
+			minimizedConfig.minimizeLearnedClauses = true;
+
+			SolverConfig unminimizedConfig;
+			unminimizedConfig.minimizeLearnedClauses = false;
+
+			// Both solvers need the same seed so that they reach the same first conflict.
+			ConstraintSolver minimized(TEXT("Minimize-On"), seed, nullptr, minimizedConfig);
+			ConstraintSolver unminimized(TEXT("Minimize-Off"), minimized.getSeed(), nullptr, unminimizedConfig);
+
+			vector<VarID> minimizedQueens, unminimizedQueens;
+			if (useGraph)
+			{
+				minimizedQueens = NQueensSolvers::createUsingGraph(minimized, MINIMIZATION_NQUEENS_SIZE);
+				unminimizedQueens = NQueensSolvers::createUsingGraph(unminimized, MINIMIZATION_NQUEENS_SIZE);
+			}
+			else
+			{
+				minimizedQueens = NQueensSolvers::createUsingAllDifferent(minimized, MINIMIZATION_NQUEENS_SIZE);
+				unminimizedQueens = NQueensSolvers::createUsingAllDifferent(unminimized, MINIMIZATION_NQUEENS_SIZE);
+			}
+
+			auto getFirstLearned = [](const ConstraintSolver& solver) -> const ClauseConstraint*
+			{
+				if (!solver.getTemporaryLearnedConstraints().empty())
+				{
+					return solver.getTemporaryLearnedConstraints()[0];
+				}
+				if (!solver.getPermanentLearnedConstraints().empty())
+				{
+					return solver.getPermanentLearnedConstraints()[0];
+				}
+				return nullptr;
+			};
+
+			// Step both solvers in lockstep: they make the same decisions until the first clause that minimization
+			// changes is learned.
+			EConstraintSolverResult minimizedResult = minimized.startSolving();
+			EConstraintSolverResult unminimizedResult = unminimized.startSolving();
+			while (minimizedResult == EConstraintSolverResult::Unsolved && unminimizedResult == EConstraintSolverResult::Unsolved)
+			{
+				minimizedResult = minimized.step();
+				unminimizedResult = unminimized.step();
+
+				const ClauseConstraint* unminimizedClause = getFirstLearned(unminimized);
+				if (unminimizedClause == nullptr)
+				{
+					continue;
+				}
+
+				// If minimization reduced the clause to a single literal, it isn't stored.
+				const ClauseConstraint* minimizedClause = getFirstLearned(minimized);
+				if (minimizedClause != nullptr)
+				{
+					EATEST_VERIFY(minimizedClause->getNumLiterals() <= unminimizedClause->getNumLiterals());
+
+					hash_set<VarID> unminimizedVars;
+					for (int i = 0; i < unminimizedClause->getNumLiterals(); ++i)
+					{
+						unminimizedVars.insert(unminimizedClause->getLiteral(i).variable);
+					}
+					for (int i = 0; i < minimizedClause->getNumLiterals(); ++i)
+					{
+						EATEST_VERIFY(unminimizedVars.find(minimizedClause->getLiteral(i).variable) != unminimizedVars.end());
+					}
+				}
+				break;
+			}
+
+			while (minimizedResult == EConstraintSolverResult::Unsolved)
+			{
+				minimizedResult = minimized.step();
+			}
+			while (unminimizedResult == EConstraintSolverResult::Unsolved)
+			{
+				unminimizedResult = unminimized.step();
+			}
+			minimized.dumpStats(printVerbose);
+			unminimized.dumpStats(printVerbose);
+
+			EATEST_VERIFY(minimized.getCurrentStatus() == EConstraintSolverResult::Solved);
+			EATEST_VERIFY(unminimized.getCurrentStatus() == EConstraintSolverResult::Solved);
+			nErrorCount += NQueensSolvers::check(MINIMIZATION_NQUEENS_SIZE, &minimized, minimizedQueens);
+			nErrorCount += NQueensSolvers::check(MINIMIZATION_NQUEENS_SIZE, &unminimized, unminimizedQueens);
+
+			// Minimized clauses must still be implied by the problem.
+			EATEST_VERIFY(countUnsatisfiedLearnedClauses(minimized) == 0);
+			EATEST_VERIFY(countUnsatisfiedLearnedClauses(unminimized) == 0);
+
+			EATEST_VERIFY(unminimized.getStats().numMinimizedLiterals == 0);
+			EATEST_VERIFY(unminimized.getStats().numMinimizedGraphLiterals == 0);
+			EATEST_VERIFY(minimized.getStats().numMinimizedGraphLiterals <= minimized.getStats().numMinimizedLiterals);
+			if (!useGraph)
+			{
+				EATEST_VERIFY(minimized.getStats().numMinimizedGraphLiterals == 0);
+			}
+		}
+	}
+	return nErrorCount;
+}
+
+int SearchTests::solveWithPhases(int times, int seed, bool printVerbose)
+{
+	int nErrorCount = 0;
+	for (int time = 0; time < times; ++time)
+	{
+		for (ETargetPhases targetPhases : {ETargetPhases::StableOnly, ETargetPhases::Always})
+		{
+			for (bool enableModeSwitching : {false, true})
+			{
+				SolverConfig config;
+				config.enableRephasing = true;
+				// Rephase often, so that every kind of rephase happens.
+				config.rephaseInitialConflicts = 5;
+				config.targetPhases = targetPhases;
+				config.enableModeSwitching = enableModeSwitching;
+				config.modeSwitchInitialConflicts = 20;
+
+				ConstraintSolver solver(TEXT("Phases"), seed, nullptr, config);
+				vector<VarID> queens = NQueensSolvers::createUsingAllDifferent(solver, PHASES_NQUEENS_SIZE);
+
+				solver.solve();
+				solver.dumpStats(printVerbose);
+
+				EATEST_VERIFY(solver.getCurrentStatus() == EConstraintSolverResult::Solved);
+				if (printVerbose)
+				{
+					NQueensSolvers::print(PHASES_NQUEENS_SIZE, &solver, queens);
+				}
+				nErrorCount += NQueensSolvers::check(PHASES_NQUEENS_SIZE, &solver, queens);
+			}
+		}
+	}
+	return nErrorCount;
+}
+
+int SearchTests::solveEntropyIncremental(int times, int seed, bool printVerbose)
+{
+	int nErrorCount = 0;
+	for (int time = 0; time < times; ++time)
+	{
+		ConstraintSolver solver(TEXT("Entropy-Incremental"), seed);
+		vector<VarID> queens = NQueensSolvers::createUsingAllDifferent(solver, ENTROPY_NQUEENS_SIZE);
+
+		// Uneven weights, so that entropy differs depending on which values remain.
+		auto weights = make_shared<vector<float>>();
+		for (int i = 0; i < ENTROPY_NQUEENS_SIZE; ++i)
+		{
+			weights->push_back(float(1 + (i * 7) % 5));
+		}
+
+		auto heuristic = make_shared<CheckedEntropyHeuristic>(solver);
+		for (VarID queen : queens)
+		{
+			heuristic->setVariableWeights(queen, weights);
+		}
+		solver.addDecisionHeuristic(heuristic);
+
+		solver.solve();
+		solver.dumpStats(printVerbose);
+
+		EATEST_VERIFY(solver.getCurrentStatus() == EConstraintSolverResult::Solved);
+		nErrorCount += NQueensSolvers::check(ENTROPY_NQUEENS_SIZE, &solver, queens);
+
+		EATEST_VERIFY(heuristic->numChecks > 0);
+		EATEST_VERIFY(heuristic->numMismatches == 0);
+	}
+	return nErrorCount;
+}
+
+int SearchTests::solveTopologyLocality(int times, int seed, bool printVerbose)
+{
+	int nErrorCount = 0;
+	for (int time = 0; time < times; ++time)
+	{
+		SolverConfig config;
+		config.heuristic = EDecisionHeuristic::TopologyLocality;
+
+		ConstraintSolver solver(TEXT("TopologyLocality"), seed, nullptr, config);
+		vector<VarID> queens = NQueensSolvers::createUsingGraph(solver, LOCALITY_NQUEENS_SIZE);
+
+		// A second variable graph over the tile grid must share its graph index.
+		const int numGraphs = solver.getGraphs().size();
+		EATEST_VERIFY(numGraphs == 2);
+
+		int tileGraphID = -1;
+		for (int i = 0; i < numGraphs; ++i)
+		{
+			if (solver.getGraphs()[i]->getNumVertices() == LOCALITY_NQUEENS_SIZE * LOCALITY_NQUEENS_SIZE)
+			{
+				tileGraphID = i;
+			}
+		}
+		EATEST_VERIFY(tileGraphID >= 0);
+		if (tileGraphID < 0)
+		{
+			continue;
+		}
+
+		auto shadowData = solver.makeVariableGraph(TEXT("Shadows"), solver.getGraphs()[tileGraphID], SolverVariableDomain(0, 1), TEXT("Shadow"));
+		EATEST_VERIFY(solver.getGraphs().size() == numGraphs);
+		EATEST_VERIFY(solver.getVariableGraphs(tileGraphID).size() == 2);
+
+		// Variables that aren't part of a graph have no vertex.
+		VarID loose = solver.makeVariable(TEXT("Loose"), SolverVariableDomain(0, 3));
+		EATEST_VERIFY(solver.getVertexForVariable(loose) < 0);
+		EATEST_VERIFY(solver.getGraphsForVariable(loose).empty());
+
+		for (int graphID = 0; graphID < numGraphs; ++graphID)
+		{
+			for (auto& data : solver.getVariableGraphs(graphID))
+			{
+				for (int vertex = 0; vertex < solver.getGraphs()[graphID]->getNumVertices(); ++vertex)
+				{
+					const VarID var = data->get(vertex);
+					EATEST_VERIFY(solver.getVertexForVariable(var) == vertex);
+					EATEST_VERIFY(solver.getGraphsForVariable(var).size() == 1);
+					EATEST_VERIFY(solver.getGraphsForVariable(var)[0] == graphID);
+				}
+			}
+		}
+
+		for (int row = 0; row < LOCALITY_NQUEENS_SIZE; ++row)
+		{
+			EATEST_VERIFY(solver.getVertexForVariable(queens[row]) == row);
+			EATEST_VERIFY(solver.getGraphsForVariable(queens[row])[0] != tileGraphID);
+			EATEST_VERIFY(solver.getVertexForVariable(shadowData->get(row)) == row);
+		}
+
+		solver.solve();
+		solver.dumpStats(printVerbose);
+
+		EATEST_VERIFY(solver.getCurrentStatus() == EConstraintSolverResult::Solved);
+		if (printVerbose)
+		{
+			NQueensSolvers::print(LOCALITY_NQUEENS_SIZE, &solver, queens);
+		}
+		nErrorCount += NQueensSolvers::check(LOCALITY_NQUEENS_SIZE, &solver, queens);
+	}
+	return nErrorCount;
+}
+
+int SearchTests::solveWithTrailReuse(int times, int seed, bool printVerbose)
+{
+	int nErrorCount = 0;
+	for (int time = 0; time < times; ++time)
+	{
+		for (bool enableTrailReuse : {false, true})
+		{
+			SolverConfig config;
+			config.heuristic = EDecisionHeuristic::LRB;
+			config.enableTrailReuse = enableTrailReuse;
+
+			ConstraintSolver solver(TEXT("TrailReuse"), seed, nullptr, config);
+			vector<VarID> queens = NQueensSolvers::createUsingAllDifferent(solver, TRAIL_REUSE_NQUEENS_SIZE);
+
+			solver.solve();
+			solver.dumpStats(printVerbose);
+
+			EATEST_VERIFY(solver.getCurrentStatus() == EConstraintSolverResult::Solved);
+			nErrorCount += NQueensSolvers::check(TRAIL_REUSE_NQUEENS_SIZE, &solver, queens);
+
+			// Restarts always go to the root without trail reuse.
+			if (!enableTrailReuse)
+			{
+				EATEST_VERIFY(solver.getStats().numReusedTrailLevels == 0);
+			}
+		}
+	}
+	return nErrorCount;
+}
+
+int SearchTests::countUnsatisfiedLearnedClauses(const ConstraintSolver& solver)
+{
+	int numUnsatisfied = 0;
+	auto checkClauses = [&](const vector<ClauseConstraint*>& clauses)
+	{
+		for (const ClauseConstraint* clause : clauses)
+		{
+			bool satisfied = false;
+			for (int i = 0; i < clause->getNumLiterals() && !satisfied; ++i)
+			{
+				const Literal& lit = clause->getLiteral(i);
+				int index = solver.getDomain(lit.variable).getIndexForValue(solver.getSolvedValue(lit.variable));
+				satisfied = lit.values[index];
+			}
+
+			if (!satisfied)
+			{
+				++numUnsatisfied;
+			}
+		}
+	};
+
+	checkClauses(solver.getTemporaryLearnedConstraints());
+	checkClauses(solver.getPermanentLearnedConstraints());
+	return numUnsatisfied;
+}
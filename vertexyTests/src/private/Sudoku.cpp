@@ -4,6 +4,7 @@
 #include "ConstraintSolver.h"
 #include "EATest/EATest.h"
 #include "constraints/TableConstraint.h"
+#include "decision/LookaheadHeuristic.h"
 #include "topology/GridTopology.h"
 #include "topology/IPlanarTopology.h"
 #include "util/SolverDecisionLog.h"
@@ -13,8 +14,20 @@ using namespace VertexyTests;
 
 // Whether to write a decision log as DecisionLog.txt
 static constexpr bool WRITE_BREADCRUMB_LOG = false;
+// Whether to choose decisions by lookahead, rather than using the solver's heuristic alone
+static constexpr bool USE_LOOKAHEAD_HEURISTIC = false;
 
 int SudokuSolver::solve(int times, int n, int seed, bool printVerbose)
+{
+	return solvePuzzle(times, n, seed, USE_LOOKAHEAD_HEURISTIC, printVerbose);
+}
+
+int SudokuSolver::solveWithLookahead(int times, int n, int seed, bool printVerbose)
+{
+	return solvePuzzle(times, n, seed, true, printVerbose);
+}
+
+int SudokuSolver::solvePuzzle(int times, int n, int seed, bool useLookahead, bool printVerbose)
 {
 	int nErrorCount = 0;
 
@@ -62,6 +75,11 @@ int SudokuSolver::solve(int times, int n, int seed, bool printVerbose)
 		// Initialize the puzzle
 		initializePuzzle(&solver, variables, printVerbose);
 
+		if (useLookahead)
+		{
+			solver.addDecisionHeuristic(make_shared<LookaheadHeuristic>(solver));
+		}
+
 		shared_ptr<SolverDecisionLog> outputLog;
 		if constexpr (WRITE_BREADCRUMB_LOG)
 		{
@@ -1,6 +1,7 @@
 // Copyright Proletariat, Inc. All Rights Reserved.
 #include "TileTests.h"
 #include "ConstraintSolver.h"
+#include "decision/EntropyHeuristic.h"
 #include "EATest/EATest.h"
 #include "prefab/TileSolver.h"
 #include "prefab/Prefab.h"
@@ -10,13 +11,19 @@
 using namespace VertexyTests;
 
 static constexpr bool WRITE_BREADCRUMB_LOG = false;
+// Whether to pick tiles in lowest-entropy order (wave-function-collapse style), rather than using the solver's heuristic
+static constexpr bool USE_ENTROPY_HEURISTIC = false;
 
-int TileTests::solve(int times, int seed, string input, int kernelSize, bool allowRotation, bool allowReflection, bool printVerbose /*= true*/)
+int TileTests::solve(int times, int seed, string input, int kernelSize, bool allowRotation, bool allowReflection, bool useEntropyHeuristic, bool printVerbose /*= true*/)
 {
 	int nErrorCount = 0;
 	ConstraintSolver solver(TEXT("TileTest"), seed);
 	TileSolver tilingSolver(&solver, 10, 10, kernelSize, allowRotation, allowReflection);
 	tilingSolver.parseJsonString(input);
+	if (useEntropyHeuristic)
+	{
+		solver.addDecisionHeuristic(tilingSolver.createEntropyHeuristic());
+	}
 
 	shared_ptr<SolverDecisionLog> outputLog;
 	if constexpr (WRITE_BREADCRUMB_LOG)
@@ -48,9 +55,9 @@ int TileTests::solve(int times, int seed, string input, int kernelSize, bool all
 	return nErrorCount;
 }
 
-int TileTests::solveBasic(int times, int seed, bool printVerbose /*= true*/)
+static string getBasicInput()
 {
-	string input = R"({
+	return R"({
 		"tile_size": 10,
 		"tiles":[
 		{
@@ -82,7 +89,11 @@ int TileTests::solveBasic(int times, int seed, bool printVerbose /*= true*/)
 			[0,0,0,0]
 		]
 	})";
-	return solve(times, seed, input, 2, false, false, printVerbose);
+}
+
+int TileTests::solveBasic(int times, int seed, bool printVerbose /*= true*/)
+{
+	return solve(times, seed, getBasicInput(), 2, false, false, USE_ENTROPY_HEURISTIC, printVerbose);
 }
 
 int TileTests::solveRotationReflection(int times, int seed, bool printVerbose /*= true*/)
@@ -122,7 +133,12 @@ int TileTests::solveRotationReflection(int times, int seed, bool printVerbose /*
 			[0,0,0,0,0,0,0,0]
 		]
 		})";
-	return solve(times, seed, input, 3, true, true, printVerbose);
+	return solve(times, seed, input, 3, true, true, USE_ENTROPY_HEURISTIC, printVerbose);
+}
+
+int TileTests::solveEntropy(int times, int seed, bool printVerbose /*= true*/)
+{
+	return solve(times, seed, getBasicInput(), 2, false, false, true, printVerbose);
 }
 
 
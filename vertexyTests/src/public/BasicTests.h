@@ -16,6 +16,8 @@ class TestSolvers
 
 public:
 	static int bitsetTests();
+	static int sparseBitsetTests();
+	static int weightedSamplerTests();
 	static int digraphTests();
 	static int ruleSCCTests();
 
@@ -32,6 +34,10 @@ public:
 	static int solveProgram_graphTests(int seed, bool printVerbose = true);
 	static int solveProgram_hamiltonian(int seed, bool printVerbose = true);
 	static int solveProgram_hamiltonianGraph(int seed, bool printVerbose = true);
+
+	static int fastLookupSetTests();
+	static int backtrackRecordTests(int seed, bool printVerbose = true);
+	static int conflictAnalysisTests(int seed, bool printVerbose = true);
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,33 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ConstraintTypes.h"
+
+namespace VertexyTests
+{
+
+using namespace Vertexy;
+
+// Tests for individual constraints: their propagation, and that they stay correct across backtracking.
+class ConstraintTests
+{
+	ConstraintTests()
+	{
+	}
+
+public:
+	static int linearTests(int seed);
+	static int solveLinearGraph(int times, int seed, bool printVerbose = true);
+	static int tableTests(int seed);
+	static int mddTests(int seed);
+	static int allDifferentTests(int seed);
+	static int regularTests(int seed);
+	static int elementTests(int seed);
+	static int differenceTests(int seed);
+	static int windowCardinalityTests(int seed);
+	static int connectedTests(int seed);
+	static int disjunctionTests(int seed);
+};
+
+}
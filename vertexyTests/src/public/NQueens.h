@@ -2,6 +2,11 @@
 #pragma once
 #include "ConstraintTypes.h"
 
+namespace Vertexy
+{
+enum class EAllDifferentPropagation : uint8_t;
+}
+
 namespace VertexyTests
 {
 
@@ -14,11 +19,20 @@ class NQueensSolvers
 
 public:
 	static int solveUsingAllDifferent(int times, int n, int seed, bool printVerbose = true);
+	static int solveUsingAllDifferentDomain(int times, int n, int seed, bool printVerbose = true);
 	static int solveUsingTable(int times, int n, int seed, bool printVerbose = true);
 	static int solveUsingGraph(int times, int n, int seed, bool printVerbose = true);
 
+	// Create the variables and constraints for an N-Queens problem. Returns the variable for the column of each queen.
+	static vector<VarID> createUsingAllDifferent(ConstraintSolver& solver, int n);
+	static vector<VarID> createUsingAllDifferent(ConstraintSolver& solver, int n, EAllDifferentPropagation propagation);
+	static vector<VarID> createUsingGraph(ConstraintSolver& solver, int n);
+
 	static int check(int n, ConstraintSolver* solver, const vector<VarID>& vars);
 	static void print(int n, ConstraintSolver* solver, const vector<VarID>& vars);
+
+protected:
+	static int solveAllDifferent(int times, int n, int seed, EAllDifferentPropagation propagation, bool printVerbose);
 };
 
 }
\ No newline at end of file
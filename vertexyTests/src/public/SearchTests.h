@@ -0,0 +1,38 @@
+// Copyright Proletariat, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "ConstraintTypes.h"
+
+namespace VertexyTests
+{
+
+using namespace Vertexy;
+
+// Tests for the solver's search: conflict learning, heuristics, phases, and restarts.
+class SearchTests
+{
+	SearchTests()
+	{
+	}
+
+public:
+	static int clauseSignatureTests();
+	static int modeSwitchingTests(int seed);
+	static int lrbParticipationTests(int seed);
+	static int heuristicNotificationTests(int seed);
+	static int trailReuseTests(int seed);
+	static int lookaheadTests(int seed);
+	static int rephaseTests(int seed);
+	static int solveLearnedClauseMinimization(int times, int seed, bool printVerbose = true);
+	static int solveWithPhases(int times, int seed, bool printVerbose = true);
+	static int solveEntropyIncremental(int times, int seed, bool printVerbose = true);
+	static int solveTopologyLocality(int times, int seed, bool printVerbose = true);
+	static int solveWithTrailReuse(int times, int seed, bool printVerbose = true);
+
+protected:
+	// Returns the number of learned clauses that are not satisfied by the solver's solution.
+	static int countUnsatisfiedLearnedClauses(const ConstraintSolver& solver);
+};
+
+}
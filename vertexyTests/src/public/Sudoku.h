@@ -14,10 +14,15 @@ class SudokuSolver
 
 public:
 	static int solve(int times, int n, int seed, bool printVerbose = true);
+	// Solve, choosing decisions with LookaheadHeuristic
+	static int solveWithLookahead(int times, int n, int seed, bool printVerbose = true);
 
 	static void initializePuzzle(ConstraintSolver* solver, const vector<VarID>& vars, bool printVerbose);
 	static int check(ConstraintSolver* solver, const vector<VarID>& vars);
 	static void print(ConstraintSolver* solver, const vector<VarID>& vars);
+
+private:
+	static int solvePuzzle(int times, int n, int seed, bool useLookahead, bool printVerbose);
 };
 
 }
\ No newline at end of file
@@ -16,11 +16,13 @@ namespace VertexyTests
 	public:
 		static int solveBasic(int times, int seed, bool printVerbose = true);
 		static int solveRotationReflection(int times, int seed, bool printVerbose = true);
+		// Solve the basic input, picking tiles in lowest-entropy order (see EntropyHeuristic)
+		static int solveEntropy(int times, int seed, bool printVerbose = true);
 		static int check(ConstraintSolver& solver, TileSolver& tileSolver);
 		static void print(ConstraintSolver& solver, TileSolver& tileSolver);
 
 	private:
-		static int solve(int times, int seed, string input, int kernelSize, bool allowRotation, bool allowReflection, bool printVerbose = true);
+		static int solve(int times, int seed, string input, int kernelSize, bool allowRotation, bool allowReflection, bool useEntropyHeuristic, bool printVerbose = true);
 	};
 
 }
\ No newline at end of file